@@ -0,0 +1,61 @@
+#include "alloc_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> g_heap_allocs{0};
+
+void* counted_alloc(std::size_t n) noexcept {
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n ? n : 1);
+}
+
+void* counted_alloc(std::size_t n, std::align_val_t al) noexcept {
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(al);
+    if (align < sizeof(void*))
+        align = sizeof(void*);
+    void* p = nullptr;
+    return posix_memalign(&p, align, n ? n : 1) == 0 ? p : nullptr;
+}
+
+} // namespace
+
+std::size_t heap_allocs() { return g_heap_allocs.load(std::memory_order_relaxed); }
+
+// 普通/数组/对齐/nothrow 各形式一起替换; 对齐分配用 posix_memalign, 同样由 free 释放
+void* operator new(std::size_t n) {
+    if (void* p = counted_alloc(n))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return counted_alloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return counted_alloc(n); }
+void* operator new(std::size_t n, std::align_val_t al) {
+    if (void* p = counted_alloc(n, al))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n, std::align_val_t al) { return operator new(n, al); }
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_alloc(n, al);
+}
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_alloc(n, al);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+
+// 全局堆分配次数 (所有形式的 operator new 都计入), 用于 allocs/op 计数器
+// 替换的 operator new/delete 在 alloc_counter.cc 中: 放在单独的编译单元里, 不会被内联到调用处,
+// 编译器也就看不到 new 与 free 配对 (-Wmismatched-new-delete)
+std::size_t heap_allocs();
@@ -1,23 +1,88 @@
 #include <benchmark/benchmark.h>
 #include "../include/btree.h"
+#include "../include/btree_c.h"
+#include "../include/btree_map.h"
+#include "../include/btree_multiset.h"
+#include "../include/bplus_tree.h"
+#include "../include/compressed_btree.h"
+#include "../include/concurrent_btree.h"
+#include "../include/cow_btree.h"
+#include "../include/disk_btree.h"
+#include "../include/frozen_btree.h"
+#include "alloc_counter.h"
+#include "legacy_btree.h"
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <malloc.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <random>
+#include <string_view>
 
-static void BM_BTreeInsertion(benchmark::State& state) {
-    BTree<int> btree(50); // B-tree with large degree
-    std::mt19937 rng;
-    std::uniform_int_distribution<int> dist(1, 1000000);
+using HeapBTree = BTree<int, std::less<int>, HeapNodeAllocator>;
+
+// 每个基准同时跑当前节点布局(BTree)和旧布局(LegacyBTree: std::vector + shared_ptr)
+// 随机键插入到一棵从空开始的树, 每插入 kInsertionKeys 个键 (计时暂停) 换一棵新树,
+// 树的大小不随迭代次数无限增长, 不同实现的结果可以直接比较
+static constexpr int kInsertionKeys = 1 << 20;
 
+template <typename Tree>
+static void InsertionBenchmark(benchmark::State& state) {
+    static const std::vector<int> keys = [] {
+        std::mt19937 rng;
+        std::uniform_int_distribution<int> dist(1, 1000000);
+        std::vector<int> generated(kInsertionKeys);
+        for (int& key : generated)
+            key = dist(rng);
+        return generated;
+    }();
+    auto btree = std::make_unique<Tree>(50); // B-tree with large degree
+    std::size_t next = 0;
+
+    size_t allocs = 0;
     for (auto _ : state) {
+        if (next == keys.size()) {
+            state.PauseTiming();
+            btree = std::make_unique<Tree>(50);
+            next = 0;
+            state.ResumeTiming();
+        }
         // Benchmark insertion time
-        int key = dist(rng);
-        btree.insert(key);
+        size_t before = heap_allocs();
+        btree->insert(keys[next++]);
+        allocs += heap_allocs() - before;
     }
+    state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+}
+
+static void BM_BTreeInsertion(benchmark::State& state) {
+    InsertionBenchmark<BTree<int>>(state);
+}
+static void BM_OrderStatBTreeInsertion(benchmark::State& state) {
+    InsertionBenchmark<BTree<int, std::less<int>, NodeArena, OrderStatistic>>(state);
+}
+static void BM_AggregateBTreeInsertion(benchmark::State& state) {
+    InsertionBenchmark<BTree<int, std::less<int>, NodeArena, SumOf<long long>>>(state);
+}
+static void BM_HeapBTreeInsertion(benchmark::State& state) {
+    InsertionBenchmark<HeapBTree>(state);
+}
+static void BM_LegacyBTreeInsertion(benchmark::State& state) {
+    InsertionBenchmark<LegacyBTree<int>>(state);
 }
 
 BENCHMARK(BM_BTreeInsertion);
+BENCHMARK(BM_OrderStatBTreeInsertion);
+BENCHMARK(BM_AggregateBTreeInsertion);
+BENCHMARK(BM_HeapBTreeInsertion);
+BENCHMARK(BM_LegacyBTreeInsertion);
 
-static void BM_BTreeSearch(benchmark::State& state) {
-    BTree<int> btree(50);
+template <typename Tree>
+static void SearchBenchmark(benchmark::State& state) {
+    Tree btree(50);
     std::vector<int> keys(state.range(0));
     std::iota(keys.begin(), keys.end(), 0);
 
@@ -36,10 +101,198 @@ static void BM_BTreeSearch(benchmark::State& state) {
     }
 }
 
-BENCHMARK(BM_BTreeSearch)->Range(1<<10, 1<<20);
+static void BM_BTreeSearch(benchmark::State& state) {
+    SearchBenchmark<BTree<int>>(state);
+}
+static void BM_LegacyBTreeSearch(benchmark::State& state) {
+    SearchBenchmark<LegacyBTree<int>>(state);
+}
 
-static void BM_BTreeDeletion(benchmark::State& state) {
+// 同样的键和查找分布, 查询由树构建的静态索引 (Eytzinger 布局, 无分支 + 预取)
+static void BM_StaticIndexSearch(benchmark::State& state) {
     BTree<int> btree(50);
+    for (int key = 0; key < state.range(0); key++) {
+        btree.insert(key);
+    }
+    StaticIndex<int> index = btree.build_static_index();
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(state.range(0)) - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.search(dist(rng)));
+    }
+}
+
+BENCHMARK(BM_BTreeSearch)->RangeMultiplier(4)->Range(1<<10, 1<<24);
+BENCHMARK(BM_StaticIndexSearch)->RangeMultiplier(4)->Range(1<<10, 1<<24);
+BENCHMARK(BM_LegacyBTreeSearch)->Range(1<<10, 1<<20);
+
+// 不同最小度数t下的整树查找, 2^20个键
+static void BM_BTreeSearchDegree(benchmark::State& state) {
+    BTree<int> btree(static_cast<int>(state.range(0)));
+    const int n = 1 << 20;
+    for (int key = 0; key < n; key++) {
+        btree.insert(key);
+    }
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, n - 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(btree.search(dist(rng)));
+    }
+}
+
+BENCHMARK(BM_BTreeSearchDegree)->RangeMultiplier(2)->Range(4, 256);
+
+// 编译期度数 (FixedBTree / CacheSizedBTree) 与运行时度数 BTree<int>(50) 对比, 键与上面的插入/查找基准相同
+// - Insert: 随机键插入, 每 2^20 个键换一棵新树 (计时暂停)
+// - Search: 2^20 个键 (0..2^20-1) 中随机查找
+// - Churn:  2^20 个键的树上交替删除一个键、插入一个新键, 树的大小不变, 频繁触发分裂/借键/合并
+template <typename Tree, typename... Args>
+static void DegreeInsertBenchmark(benchmark::State& state, Args... args) {
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(1, 1000000);
+    std::vector<int> keys(kInsertionKeys);
+    for (int& key : keys)
+        key = dist(rng);
+    auto tree = std::make_unique<Tree>(args...);
+    std::size_t next = 0;
+    for (auto _ : state) {
+        if (next == keys.size()) {
+            state.PauseTiming();
+            tree = std::make_unique<Tree>(args...);
+            next = 0;
+            state.ResumeTiming();
+        }
+        tree->insert(keys[next++]);
+    }
+}
+
+template <typename Tree, typename... Args>
+static void DegreeSearchBenchmark(benchmark::State& state, Args... args) {
+    const int n = 1 << 20;
+    Tree tree(args...);
+    for (int key = 0; key < n; key++)
+        tree.insert(key);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, n - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.search(dist(rng)));
+    }
+}
+
+template <typename Tree, typename... Args>
+static void DegreeChurnBenchmark(benchmark::State& state, Args... args) {
+    const int n = 1 << 20;
+    Tree tree(args...);
+    std::vector<int> live(n);
+    std::iota(live.begin(), live.end(), 0);
+    std::shuffle(live.begin(), live.end(), std::mt19937(7));
+    for (int key : live)
+        tree.insert(key);
+    std::mt19937 rng;
+    int next_key = n;
+    for (auto _ : state) {
+        std::size_t slot = rng() % live.size();
+        tree.remove(live[slot]);
+        live[slot] = next_key++;
+        tree.insert(live[slot]);
+    }
+}
+
+static void BM_RuntimeDegreeInsert(benchmark::State& state) { DegreeInsertBenchmark<BTree<int>>(state, 50); }
+static void BM_FixedDegree16Insert(benchmark::State& state) { DegreeInsertBenchmark<FixedBTree<int, 16>>(state); }
+static void BM_FixedDegree50Insert(benchmark::State& state) { DegreeInsertBenchmark<FixedBTree<int, 50>>(state); }
+static void BM_FixedDegree64Insert(benchmark::State& state) { DegreeInsertBenchmark<FixedBTree<int, 64>>(state); }
+static void BM_CacheSized256Insert(benchmark::State& state) { DegreeInsertBenchmark<CacheSizedBTree<int, 256>>(state); }
+static void BM_CacheSized4KInsert(benchmark::State& state) { DegreeInsertBenchmark<CacheSizedBTree<int, 4096>>(state); }
+
+static void BM_RuntimeDegreeSearch(benchmark::State& state) { DegreeSearchBenchmark<BTree<int>>(state, 50); }
+static void BM_FixedDegree16Search(benchmark::State& state) { DegreeSearchBenchmark<FixedBTree<int, 16>>(state); }
+static void BM_FixedDegree50Search(benchmark::State& state) { DegreeSearchBenchmark<FixedBTree<int, 50>>(state); }
+static void BM_FixedDegree64Search(benchmark::State& state) { DegreeSearchBenchmark<FixedBTree<int, 64>>(state); }
+static void BM_CacheSized256Search(benchmark::State& state) { DegreeSearchBenchmark<CacheSizedBTree<int, 256>>(state); }
+static void BM_CacheSized4KSearch(benchmark::State& state) { DegreeSearchBenchmark<CacheSizedBTree<int, 4096>>(state); }
+
+static void BM_RuntimeDegreeChurn(benchmark::State& state) { DegreeChurnBenchmark<BTree<int>>(state, 50); }
+static void BM_FixedDegree16Churn(benchmark::State& state) { DegreeChurnBenchmark<FixedBTree<int, 16>>(state); }
+static void BM_FixedDegree50Churn(benchmark::State& state) { DegreeChurnBenchmark<FixedBTree<int, 50>>(state); }
+static void BM_FixedDegree64Churn(benchmark::State& state) { DegreeChurnBenchmark<FixedBTree<int, 64>>(state); }
+static void BM_CacheSized256Churn(benchmark::State& state) { DegreeChurnBenchmark<CacheSizedBTree<int, 256>>(state); }
+static void BM_CacheSized4KChurn(benchmark::State& state) { DegreeChurnBenchmark<CacheSizedBTree<int, 4096>>(state); }
+
+BENCHMARK(BM_RuntimeDegreeInsert);
+BENCHMARK(BM_FixedDegree16Insert);
+BENCHMARK(BM_FixedDegree50Insert);
+BENCHMARK(BM_FixedDegree64Insert);
+BENCHMARK(BM_CacheSized256Insert);
+BENCHMARK(BM_CacheSized4KInsert);
+BENCHMARK(BM_RuntimeDegreeSearch);
+BENCHMARK(BM_FixedDegree16Search);
+BENCHMARK(BM_FixedDegree50Search);
+BENCHMARK(BM_FixedDegree64Search);
+BENCHMARK(BM_CacheSized256Search);
+BENCHMARK(BM_CacheSized4KSearch);
+BENCHMARK(BM_RuntimeDegreeChurn);
+BENCHMARK(BM_FixedDegree16Churn);
+BENCHMARK(BM_FixedDegree50Churn);
+BENCHMARK(BM_FixedDegree64Churn);
+BENCHMARK(BM_CacheSized256Churn);
+BENCHMARK(BM_CacheSized4KChurn);
+
+// 单个节点内的查找核心, 节点键数为 2t-1
+enum NodeSearchKind { kLinearScan, kBranchlessBinary, kSimdCount };
+
+template <NodeSearchKind Kind>
+static void NodeSearchBenchmark(benchmark::State& state) {
+    const int n = 2 * static_cast<int>(state.range(0)) - 1;
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = 2 * i;
+    }
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, 2 * n);
+    std::vector<int> probes(4096);
+    for (int& p : probes) {
+        p = dist(rng);
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        int key = probes[i++ & (probes.size() - 1)];
+        int idx;
+        if constexpr (Kind == kLinearScan) {
+            idx = 0;
+            while (idx < n && keys[idx] < key)
+                ++idx;
+        } else if constexpr (Kind == kBranchlessBinary) {
+            idx = btree_search::branchless_bound<false>(keys.data(), n, key);
+        } else {
+            idx = btree_search::node_lower_bound(keys.data(), n, key);
+        }
+        benchmark::DoNotOptimize(idx);
+    }
+}
+
+static void BM_NodeSearchLinear(benchmark::State& state) {
+    NodeSearchBenchmark<kLinearScan>(state);
+}
+static void BM_NodeSearchBranchless(benchmark::State& state) {
+    NodeSearchBenchmark<kBranchlessBinary>(state);
+}
+static void BM_NodeSearchSimd(benchmark::State& state) {
+    NodeSearchBenchmark<kSimdCount>(state);
+}
+
+BENCHMARK(BM_NodeSearchLinear)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK(BM_NodeSearchBranchless)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK(BM_NodeSearchSimd)->RangeMultiplier(2)->Range(4, 256);
+
+template <typename Tree>
+static void DeletionBenchmark(benchmark::State& state) {
+    Tree btree(50);
     std::vector<int> keys(state.range(0));
     std::iota(keys.begin(), keys.end(), 0);
 
@@ -53,22 +306,1046 @@ static void BM_BTreeDeletion(benchmark::State& state) {
 
     auto it = keys.begin();
 
+    size_t allocs = 0;
     for (auto _ : state) {
         if (it == keys.end()) {
-            // Re-initialize B-Tree and iterator
-            btree = BTree<int>(50);
+            // Re-initialize B-Tree and iterator (不计入删除时间)
+            state.PauseTiming();
+            btree = Tree(50);
             for (int key : keys) {
                 btree.insert(key);
             }
             std::shuffle(keys.begin(), keys.end(), std::mt19937{std::random_device{}()});
             it = keys.begin();
+            state.ResumeTiming();
         }
         // Benchmark deletion time
+        size_t before = heap_allocs();
         btree.remove(*it);
+        allocs += heap_allocs() - before;
         ++it;
     }
+    state.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+}
+
+static void BM_BTreeDeletion(benchmark::State& state) {
+    DeletionBenchmark<BTree<int>>(state);
+}
+static void BM_OrderStatBTreeDeletion(benchmark::State& state) {
+    DeletionBenchmark<BTree<int, std::less<int>, NodeArena, OrderStatistic>>(state);
+}
+static void BM_HeapBTreeDeletion(benchmark::State& state) {
+    DeletionBenchmark<HeapBTree>(state);
+}
+static void BM_LegacyBTreeDeletion(benchmark::State& state) {
+    DeletionBenchmark<LegacyBTree<int>>(state);
 }
 
 BENCHMARK(BM_BTreeDeletion)->Range(1<<10, 1<<20);
+BENCHMARK(BM_OrderStatBTreeDeletion)->Range(1<<10, 1<<20);
+BENCHMARK(BM_HeapBTreeDeletion)->Range(1<<10, 1<<20);
+BENCHMARK(BM_LegacyBTreeDeletion)->Range(1<<10, 1<<20);
+
+// 键 -> 64字节记录的映射: 查找返回值指针, 不拷贝记录
+struct Record {
+    int64_t payload[8];
+};
+
+static void BM_BTreeMapFind(benchmark::State& state) {
+    BTreeMap<int, Record> map(50);
+    const int n = static_cast<int>(state.range(0));
+    for (int key = 0; key < n; key++) {
+        map.try_emplace(key, Record{{key}});
+    }
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, n - 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.find(dist(rng)));
+    }
+}
+
+BENCHMARK(BM_BTreeMapFind)->Range(1<<10, 1<<20);
+
+static void BM_BTreeMapUpsert(benchmark::State& state) {
+    BTreeMap<int, Record> map(50);
+    const int n = static_cast<int>(state.range(0));
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, n - 1);
+
+    for (auto _ : state) {
+        map.upsert(dist(rng), [](Record& r) { r.payload[0]++; });
+    }
+}
+
+BENCHMARK(BM_BTreeMapUpsert)->Range(1<<10, 1<<20);
+
+// 整棵树的析构时间: NodeArena 按slab释放, 其余按节点逐个释放
+template <typename Tree>
+static void TeardownBenchmark(benchmark::State& state) {
+    std::vector<int> keys(state.range(0));
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937{42});
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto btree = std::make_unique<Tree>(50);
+        for (int key : keys) {
+            btree->insert(key);
+        }
+        state.ResumeTiming();
+        btree.reset();
+    }
+}
+
+static void BM_BTreeTeardown(benchmark::State& state) {
+    TeardownBenchmark<BTree<int>>(state);
+}
+static void BM_HeapBTreeTeardown(benchmark::State& state) {
+    TeardownBenchmark<HeapBTree>(state);
+}
+static void BM_LegacyBTreeTeardown(benchmark::State& state) {
+    TeardownBenchmark<LegacyBTree<int>>(state);
+}
+
+BENCHMARK(BM_BTreeTeardown)->Range(1<<16, 1<<20)->Iterations(10)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_HeapBTreeTeardown)->Range(1<<16, 1<<20)->Iterations(10)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LegacyBTreeTeardown)->Range(1<<16, 1<<20)->Iterations(10)->Unit(benchmark::kMicrosecond);
+
+// 从有序输入构建 2^20 个键的树: 逐个 insert vs 自底向上 bulk_load
+static void BM_BTreeBuildInsert(benchmark::State& state) {
+    std::vector<int> keys(state.range(0));
+    std::iota(keys.begin(), keys.end(), 0);
+    for (auto _ : state) {
+        BTree<int> tree(50);
+        for (int key : keys) {
+            tree.insert(key);
+        }
+        benchmark::DoNotOptimize(tree.get_root());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_BTreeBulkLoad(benchmark::State& state) {
+    std::vector<int> keys(state.range(0));
+    std::iota(keys.begin(), keys.end(), 0);
+    for (auto _ : state) {
+        BTree<int> tree(50);
+        tree.bulk_load(keys.begin(), keys.end());
+        benchmark::DoNotOptimize(tree.get_root());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// 已有 2^20 个键, 合并一批新键: 逐个 insert vs merge_load
+static void BM_BTreeMergeInsert(benchmark::State& state) {
+    std::vector<int> base(1 << 20), batch(state.range(0));
+    for (int i = 0; i < (1 << 20); i++) base[i] = i * 2;
+    for (int i = 0; i < state.range(0); i++) batch[i] = i * 4 + 1;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BTree<int> tree(50);
+        tree.bulk_load(base.begin(), base.end(), 0.7);
+        state.ResumeTiming();
+        for (int key : batch) {
+            tree.insert(key);
+        }
+        benchmark::DoNotOptimize(tree.get_root());
+        state.PauseTiming();
+        tree = BTree<int>(50);
+        state.ResumeTiming();
+    }
+}
+
+static void BM_BTreeMergeLoad(benchmark::State& state) {
+    std::vector<int> base(1 << 20), batch(state.range(0));
+    for (int i = 0; i < (1 << 20); i++) base[i] = i * 2;
+    for (int i = 0; i < state.range(0); i++) batch[i] = i * 4 + 1;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BTree<int> tree(50);
+        tree.bulk_load(base.begin(), base.end(), 0.7);
+        state.ResumeTiming();
+        tree.merge_load(batch.begin(), batch.end(), 0.7);
+        benchmark::DoNotOptimize(tree.get_root());
+        state.PauseTiming();
+        tree = BTree<int>(50);
+        state.ResumeTiming();
+    }
+}
+
+BENCHMARK(BM_BTreeBuildInsert)->Arg(1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BTreeBulkLoad)->Arg(1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BTreeMergeInsert)->Arg(1<<16)->Arg(1<<19)->Iterations(10)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BTreeMergeLoad)->Arg(1<<16)->Arg(1<<19)->Iterations(10)->Unit(benchmark::kMillisecond);
+
+// 批量接口: 2^20 个键的树上, 每次处理一批 range(0) 个随机键
+constexpr int kBatchTreeKeys = 1 << 20;
+
+static std::vector<int> random_batch(std::mt19937& rng, int n, int range) {
+    std::uniform_int_distribution<int> dist(0, range - 1);
+    std::vector<int> batch(n);
+    for (int& key : batch) key = dist(rng);
+    return batch;
+}
+
+static void BM_BTreeSearchOneByOne(benchmark::State& state) {
+    std::vector<int> keys(kBatchTreeKeys);
+    std::iota(keys.begin(), keys.end(), 0);
+    BTree<int> tree(50);
+    tree.bulk_load(keys.begin(), keys.end(), 0.7);
+    std::mt19937 rng;
+    std::vector<int> batch = random_batch(rng, static_cast<int>(state.range(0)), kBatchTreeKeys * 2);
+    std::unique_ptr<bool[]> found(new bool[batch.size()]);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            found[i] = tree.contains(batch[i]);
+        }
+        benchmark::DoNotOptimize(found.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_BTreeSearchBatch(benchmark::State& state) {
+    std::vector<int> keys(kBatchTreeKeys);
+    std::iota(keys.begin(), keys.end(), 0);
+    BTree<int> tree(50);
+    tree.bulk_load(keys.begin(), keys.end(), 0.7);
+    std::mt19937 rng;
+    std::vector<int> batch = random_batch(rng, static_cast<int>(state.range(0)), kBatchTreeKeys * 2);
+    std::unique_ptr<bool[]> found(new bool[batch.size()]);
+
+    for (auto _ : state) {
+        tree.search_batch(batch.data(), batch.size(), found.get());
+        benchmark::DoNotOptimize(found.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_BTreeInsertOneByOne(benchmark::State& state) {
+    std::vector<int> keys(kBatchTreeKeys);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::mt19937 rng;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BTree<int> tree(50);
+        tree.bulk_load(keys.begin(), keys.end(), 0.7);
+        std::vector<int> batch = random_batch(rng, static_cast<int>(state.range(0)), kBatchTreeKeys);
+        state.ResumeTiming();
+        for (int key : batch) {
+            tree.insert(key);
+        }
+        state.PauseTiming();
+        tree = BTree<int>(50);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_BTreeInsertBatch(benchmark::State& state) {
+    std::vector<int> keys(kBatchTreeKeys);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::mt19937 rng;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BTree<int> tree(50);
+        tree.bulk_load(keys.begin(), keys.end(), 0.7);
+        std::vector<int> batch = random_batch(rng, static_cast<int>(state.range(0)), kBatchTreeKeys);
+        state.ResumeTiming();
+        tree.insert_batch(batch.data(), batch.size());
+        state.PauseTiming();
+        tree = BTree<int>(50);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_BTreeSearchOneByOne)->RangeMultiplier(8)->Range(1<<10, 1<<16);
+BENCHMARK(BM_BTreeSearchBatch)->RangeMultiplier(8)->Range(1<<10, 1<<16);
+BENCHMARK(BM_BTreeInsertOneByOne)->RangeMultiplier(8)->Range(1<<10, 1<<16)->Iterations(20);
+BENCHMARK(BM_BTreeInsertBatch)->RangeMultiplier(8)->Range(1<<10, 1<<16)->Iterations(20);
+
+// 多线程读写: 2^20 个键的共享树, 键从 [0, 2^21) 中均匀选取, 插入与删除各占写操作的一半
+// - MutexBTree:      一把全局锁保护的 BTree (现有做法)
+// - ConcurrentBTree: 乐观锁耦合, 读者不加锁
+struct MutexBTree {
+    explicit MutexBTree(int t) : tree(t) {}
+
+    bool contains(int key) {
+        std::lock_guard<std::mutex> guard(mutex);
+        return tree.contains(key);
+    }
+    void insert(int key) {
+        std::lock_guard<std::mutex> guard(mutex);
+        tree.insert(key);
+    }
+    void remove(int key) {
+        std::lock_guard<std::mutex> guard(mutex);
+        tree.remove(key);
+    }
+
+    BTree<int> tree;
+    std::mutex mutex;
+};
+
+constexpr int kConcurrentKeys = 1 << 20;
+
+template <typename Tree>
+static Tree* g_shared_tree = nullptr;
+
+// ReadPercent: 查找所占的百分比
+template <typename Tree, int ReadPercent>
+static void ConcurrentBenchmark(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_shared_tree<Tree> = new Tree(50);
+        for (int key = 0; key < kConcurrentKeys; key++) {
+            g_shared_tree<Tree>->insert(key * 2);
+        }
+    }
+    std::mt19937 rng(state.thread_index() + 1);
+    std::uniform_int_distribution<int> key_dist(0, kConcurrentKeys * 2 - 1);
+    std::uniform_int_distribution<int> op_dist(0, 99);
+
+    // 所有线程在循环开始处同步, 此时共享树已经建好
+    for (auto _ : state) {
+        Tree& tree = *g_shared_tree<Tree>;
+        int key = key_dist(rng);
+        int op = op_dist(rng);
+        if (op < ReadPercent) {
+            benchmark::DoNotOptimize(tree.contains(key));
+        } else if ((op - ReadPercent) % 2 == 0) {
+            tree.insert(key);
+        } else {
+            tree.remove(key);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        delete g_shared_tree<Tree>;
+        g_shared_tree<Tree> = nullptr;
+    }
+}
+
+static void BM_MutexBTreeReadHeavy(benchmark::State& state) {
+    ConcurrentBenchmark<MutexBTree, 95>(state);
+}
+static void BM_ConcurrentBTreeReadHeavy(benchmark::State& state) {
+    ConcurrentBenchmark<ConcurrentBTree<int>, 95>(state);
+}
+static void BM_MutexBTreeMixed(benchmark::State& state) {
+    ConcurrentBenchmark<MutexBTree, 50>(state);
+}
+static void BM_ConcurrentBTreeMixed(benchmark::State& state) {
+    ConcurrentBenchmark<ConcurrentBTree<int>, 50>(state);
+}
+static void BM_MutexBTreeWriteHeavy(benchmark::State& state) {
+    ConcurrentBenchmark<MutexBTree, 10>(state);
+}
+static void BM_ConcurrentBTreeWriteHeavy(benchmark::State& state) {
+    ConcurrentBenchmark<ConcurrentBTree<int>, 10>(state);
+}
+
+BENCHMARK(BM_MutexBTreeReadHeavy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_ConcurrentBTreeReadHeavy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_MutexBTreeMixed)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_ConcurrentBTreeMixed)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_MutexBTreeWriteHeavy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_ConcurrentBTreeWriteHeavy)->ThreadRange(1, 32)->UseRealTime();
+
+// 范围扫描: 1M个键中读取10k个连续键
+// - BTreeScan:      BTree 迭代器 (中序遍历, 需要在内部节点与叶子之间往返)
+// - BPlusTreeScan:  BPlusTree 沿叶子链表顺序读取
+// - BTreeScanPoint: 对每个键单独 search (没有范围接口时的做法)
+constexpr int kScanKeys = 1 << 20;
+constexpr int kScanLength = 10000;
+
+template <typename Tree>
+static void fill_scan_tree(Tree& tree) {
+    for (int key = 0; key < kScanKeys; key++) {
+        tree.insert(key);
+    }
+}
+
+static void BM_BTreeScan(benchmark::State& state) {
+    BTree<int> tree(50);
+    fill_scan_tree(tree);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, kScanKeys - kScanLength);
+
+    for (auto _ : state) {
+        int lo = dist(rng);
+        long sum = 0;
+        tree.scan(lo, lo + kScanLength - 1, [&](int key) { sum += key; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kScanLength);
+}
+
+static void BM_BPlusTreeScan(benchmark::State& state) {
+    BPlusTree<int> tree(50);
+    fill_scan_tree(tree);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, kScanKeys - kScanLength);
+
+    for (auto _ : state) {
+        int lo = dist(rng);
+        long sum = 0;
+        tree.scan(lo, lo + kScanLength - 1, [&](int key) { sum += key; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kScanLength);
+}
+
+static void BM_BTreeScanPoint(benchmark::State& state) {
+    BTree<int> tree(50);
+    fill_scan_tree(tree);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, kScanKeys - kScanLength);
+
+    for (auto _ : state) {
+        int lo = dist(rng);
+        long sum = 0;
+        for (int key = lo; key < lo + kScanLength; key++) {
+            sum += *tree.search(key);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kScanLength);
+}
+
+BENCHMARK(BM_BTreeScan)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BPlusTreeScan)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BTreeScanPoint)->Unit(benchmark::kMicrosecond);
+
+// 写时复制快照: 2^18 个键的树上随机插入+删除, 同时有 N 个快照打开
+// - 每 kSnapshotEvery 次写入打开一个新快照, 最多保留 N 个 (最旧的关闭), 模拟不断启动的分析任务
+// - N = 0 时没有快照, 所有节点引用数为 1, 与 BTree 的差别只是每层一次引用数检查
+
+constexpr int kSnapshotTreeSize = 1 << 18;
+constexpr int kSnapshotEvery = 1024;
+
+static void BM_BTreeWriteBaseline(benchmark::State& state) {
+    BTree<int> tree(50);
+    std::mt19937 rng(42);
+    for (int i = 0; i < kSnapshotTreeSize; i++)
+        tree.insert(static_cast<int>(rng()));
+
+    for (auto _ : state) {
+        int key = static_cast<int>(rng());
+        tree.insert(key);
+        tree.remove(key);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+static void BM_CowBTreeWriteWithSnapshots(benchmark::State& state) {
+    const std::size_t open = static_cast<std::size_t>(state.range(0));
+    CowBTree<int> tree(50);
+    std::mt19937 rng(42);
+    for (int i = 0; i < kSnapshotTreeSize; i++)
+        tree.insert(static_cast<int>(rng()));
+
+    std::deque<CowBTree<int>::Snapshot> snapshots;
+    long writes = 0;
+    for (auto _ : state) {
+        int key = static_cast<int>(rng());
+        tree.insert(key);
+        tree.remove(key);
+        if (open > 0 && ++writes % kSnapshotEvery == 0) {
+            snapshots.push_back(tree.snapshot());
+            if (snapshots.size() > open)
+                snapshots.pop_front();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+BENCHMARK(BM_BTreeWriteBaseline);
+BENCHMARK(BM_CowBTreeWriteWithSnapshots)->Arg(0)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// 磁盘B树查找: 2^20 个随机 long 键, 4K 页 (约 4000 页, 16MB), 不同缓存池大小
+// - Warm: 先做大量查找让缓存池进入稳定状态, 再计时; hit_rate 为缓存池命中率
+// - Cold: 每轮先清空缓存池并请求内核丢弃文件缓存, 再做 kColdLookups 次查找
+constexpr long kDiskKeys = 1 << 20;
+constexpr int kColdLookups = 100;
+
+static const std::string& disk_bench_file() {
+    static const std::string path = [] {
+        std::string p = "/tmp/btree_benchmark_disk.db";
+        std::remove(p.c_str());
+        DiskBTree<long> tree(p);
+        std::mt19937_64 rng(7);
+        for (long i = 0; i < kDiskKeys; i++)
+            tree.insert(static_cast<long>(rng() % (kDiskKeys * 4)));
+        return p;
+    }();
+    return path;
+}
+
+static void BM_DiskBTreeLookupWarm(benchmark::State& state) {
+    DiskBTree<long>::Options options;
+    options.pool_pages = static_cast<std::size_t>(state.range(0));
+    DiskBTree<long> tree(disk_bench_file(), options);
+    std::mt19937_64 rng(11);
+    for (int i = 0; i < 200000; i++)
+        benchmark::DoNotOptimize(tree.contains(static_cast<long>(rng() % (kDiskKeys * 4))));
+    tree.reset_pool_stats();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.contains(static_cast<long>(rng() % (kDiskKeys * 4))));
+    }
+    const auto& stats = tree.pool_stats();
+    state.counters["hit_rate"] = static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_DiskBTreeLookupCold(benchmark::State& state) {
+    DiskBTree<long>::Options options;
+    options.pool_pages = static_cast<std::size_t>(state.range(0));
+    DiskBTree<long> tree(disk_bench_file(), options);
+    std::mt19937_64 rng(13);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        tree.drop_caches();
+        state.ResumeTiming();
+        for (int i = 0; i < kColdLookups; i++)
+            benchmark::DoNotOptimize(tree.contains(static_cast<long>(rng() % (kDiskKeys * 4))));
+    }
+    state.SetItemsProcessed(state.iterations() * kColdLookups);
+}
+
+BENCHMARK(BM_DiskBTreeLookupWarm)->Arg(16)->Arg(256)->Arg(1024)->Arg(8192);
+BENCHMARK(BM_DiskBTreeLookupCold)->Arg(16)->Arg(256)->Arg(8192)->Unit(benchmark::kMicrosecond);
+
+// 磁盘B树写入吞吐: 随机 long 键插入一棵新树, 参数为日志模式
+//   0: 不开日志 (只在结束时 flush)   1: PerOp   2: PerBatch (每 kIngestBatch 个插入 commit 一次)   3: Async
+// 多线程 PerOp 时等待刷盘的线程共用一次 fdatasync (group commit), log_syncs_per_op 反映合并效果
+constexpr int kIngestBatch = 256;
+static DiskBTree<long>* g_ingest_tree = nullptr;
+
+static void BM_DiskBTreeIngest(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+    if (state.thread_index() == 0) {
+        std::string path = "/tmp/btree_benchmark_ingest.db";
+        std::remove(path.c_str());
+        std::remove((path + "-wal").c_str());
+        DiskBTree<long>::Options options;
+        options.wal = mode != 0;
+        options.sync_mode = mode == 2 ? SyncMode::PerBatch : mode == 3 ? SyncMode::Async : SyncMode::PerOp;
+        g_ingest_tree = new DiskBTree<long>(path, options);
+    }
+    std::mt19937_64 rng(state.thread_index() + 1);
+    long n = 0;
+
+    for (auto _ : state) {
+        g_ingest_tree->insert(static_cast<long>(rng()));
+        if (mode == 2 && ++n % kIngestBatch == 0)
+            g_ingest_tree->commit();
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        double ops = static_cast<double>(g_ingest_tree->size());
+        state.counters["log_syncs_per_op"] = static_cast<double>(g_ingest_tree->log_sync_count()) / ops;
+        delete g_ingest_tree;
+        g_ingest_tree = nullptr;
+    }
+}
+
+BENCHMARK(BM_DiskBTreeIngest)->DenseRange(0, 3)->Threads(1)->Threads(4)->UseRealTime();
+
+// 冻结格式: 服务进程启动时打开已有索引 vs 用 insert 重建
+// - FrozenBTreeOpen:     mmap 打开 2^N 个键的冻结文件并做一次查找 (与键数无关)
+// - BTreeRebuildInsert:  把同样的随机键逐个 insert 进新树
+// - FrozenBTreeSearch:   与 BM_BTreeSearch 相同的键和查找分布, 对比查找延迟
+static const std::string& frozen_bench_file(long n) {
+    static std::map<long, std::string> files;
+    auto it = files.find(n);
+    if (it == files.end()) {
+        std::string path = "/tmp/btree_benchmark_frozen_" + std::to_string(n) + ".idx";
+        BTree<int> tree(50);
+        for (long key = 0; key < n; key++)
+            tree.insert(static_cast<int>(key));
+        tree.freeze(path);
+        it = files.emplace(n, path).first;
+    }
+    return it->second;
+}
+
+static void BM_FrozenBTreeOpen(benchmark::State& state) {
+    const std::string& path = frozen_bench_file(state.range(0));
+    for (auto _ : state) {
+        FrozenBTree<int> frozen(path);
+        benchmark::DoNotOptimize(frozen.contains(static_cast<int>(state.range(0) / 2)));
+    }
+}
+
+static void BM_BTreeRebuildInsert(benchmark::State& state) {
+    std::vector<int> keys(state.range(0));
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(5));
+    for (auto _ : state) {
+        BTree<int> tree(50);
+        for (int key : keys)
+            tree.insert(key);
+        benchmark::DoNotOptimize(tree.contains(static_cast<int>(state.range(0) / 2)));
+    }
+}
+
+static void BM_FrozenBTreeSearch(benchmark::State& state) {
+    FrozenBTree<int> frozen(frozen_bench_file(state.range(0)));
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(state.range(0)) - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(frozen.search(dist(rng)));
+    }
+}
+
+BENCHMARK(BM_FrozenBTreeOpen)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 23)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BTreeRebuildInsert)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 23)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_FrozenBTreeSearch)->Range(1<<10, 1<<20);
+
+// 叶子键压缩: 2^18 个键随机顺序插入 (make_key(2i)), bytes_per_key 为建树前后 glibc 堆占用之差 / 键数,
+// 计时部分为随机 contains (一半命中)
+// - 字符串: 形如 "https://example.com/users/00012345/profile" 的 URL, 对比 BPlusTree<std::string> 与 PrefixBTree
+// - 整数:   间隔约 1000 的递增时间戳, 对比 BPlusTree<int64_t> 与 DeltaBTree<int64_t>
+static constexpr int kCompressionKeys = 1 << 18;
+
+static size_t heap_in_use() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+static std::string url_bench_key(int i) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "https://example.com/users/%08d/profile", i);
+    return buf;
+}
+
+static int64_t timestamp_bench_key(int i) {
+    return 1700000000000LL + static_cast<int64_t>(i) * 500 + (i / 2) % 7;
+}
+
+template <typename Tree, typename Key>
+static void CompressionBenchmark(benchmark::State& state, Key (*make_key)(int)) {
+    std::vector<int> order(kCompressionKeys);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(9));
+
+    size_t heap_before = heap_in_use();
+    auto tree = std::make_unique<Tree>(32);
+    for (int i : order)
+        tree->insert(make_key(2 * i));
+    size_t heap_after = heap_in_use();
+
+    // 插入的是 make_key(偶数), 奇数落在相邻两个键之间, 一半查找命中
+    std::vector<Key> probes;
+    std::mt19937 rng(3);
+    for (int i = 0; i < 4096; i++)
+        probes.push_back(make_key(static_cast<int>(rng() % (2 * kCompressionKeys))));
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree->contains(probes[next++ & 4095]));
+    }
+    state.counters["bytes_per_key"] = static_cast<double>(heap_after - heap_before) / kCompressionKeys;
+}
+
+static void BM_BPlusTreeStringKeys(benchmark::State& state) {
+    CompressionBenchmark<BPlusTree<std::string>>(state, url_bench_key);
+}
+static void BM_PrefixBTreeStringKeys(benchmark::State& state) {
+    CompressionBenchmark<PrefixBTree>(state, url_bench_key);
+}
+static void BM_BPlusTreeIntKeys(benchmark::State& state) {
+    CompressionBenchmark<BPlusTree<int64_t>>(state, timestamp_bench_key);
+}
+static void BM_DeltaBTreeIntKeys(benchmark::State& state) {
+    CompressionBenchmark<DeltaBTree<int64_t>>(state, timestamp_bench_key);
+}
+
+BENCHMARK(BM_BPlusTreeStringKeys);
+BENCHMARK(BM_PrefixBTreeStringKeys);
+BENCHMARK(BM_BPlusTreeIntKeys);
+BENCHMARK(BM_DeltaBTreeIntKeys);
+
+// 字符串键: 键从网络缓冲区中以 std::string_view 的形式得到 (24 字节, 超过 SSO, 构造 std::string 需要一次分配)
+// - StringLookupTemp:  BTree<std::string>, 每次查找先构造临时 std::string
+// - StringLookupView:  BTree<std::string, std::less<>>, 直接用 string_view 查找 (透明比较器)
+// - StringInsertCopy:  先构造 std::string 再 insert(const&), 叶子中再复制一次
+// - StringInsertMove:  emplace(view), 构造一次后移动进叶子
+static constexpr int kStringKeys = 1 << 16;
+
+static std::string session_bench_key(uint64_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "session:%016llx", static_cast<unsigned long long>(i * 0x9E3779B97F4A7C15ULL));
+    return buf;
+}
+
+// 所有键首尾相接放在一个缓冲区中, 模拟收到的请求
+struct StringKeyBuffer {
+    std::string bytes;
+    std::vector<std::string_view> views;
+    explicit StringKeyBuffer(int n) {
+        for (int i = 0; i < n; i++)
+            bytes += session_bench_key(i);
+        std::size_t len = session_bench_key(0).size();
+        for (int i = 0; i < n; i++)
+            views.emplace_back(bytes.data() + i * len, len);
+    }
+};
+
+template <typename Tree, bool View>
+static void StringLookupBenchmark(benchmark::State& state) {
+    StringKeyBuffer buffer(kStringKeys);
+    Tree tree(16);
+    for (int i = 0; i < kStringKeys; i += 2)
+        tree.insert(session_bench_key(i));
+    std::mt19937 rng;
+    size_t allocs = heap_allocs();
+    for (auto _ : state) {
+        std::string_view key = buffer.views[rng() % kStringKeys];
+        if constexpr (View) {
+            benchmark::DoNotOptimize(tree.contains(key));
+        } else {
+            benchmark::DoNotOptimize(tree.contains(std::string(key)));
+        }
+    }
+    state.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(heap_allocs() - allocs),
+        benchmark::Counter::kAvgIterations);
+}
+
+template <bool Move>
+static void StringInsertBenchmark(benchmark::State& state) {
+    StringKeyBuffer buffer(kStringKeys);
+    BTree<std::string, std::less<>> tree(16);
+    size_t next = 0;
+    size_t allocs = heap_allocs();
+    for (auto _ : state) {
+        std::string_view key = buffer.views[next++ % kStringKeys];
+        if constexpr (Move) {
+            tree.emplace(key);
+        } else {
+            std::string copy(key);
+            tree.insert(copy);
+        }
+    }
+    state.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(heap_allocs() - allocs),
+        benchmark::Counter::kAvgIterations);
+}
+
+static void BM_StringLookupTemp(benchmark::State& state) {
+    StringLookupBenchmark<BTree<std::string>, false>(state);
+}
+static void BM_StringLookupView(benchmark::State& state) {
+    StringLookupBenchmark<BTree<std::string, std::less<>>, true>(state);
+}
+static void BM_StringInsertCopy(benchmark::State& state) {
+    StringInsertBenchmark<false>(state);
+}
+static void BM_StringInsertMove(benchmark::State& state) {
+    StringInsertBenchmark<true>(state);
+}
+
+BENCHMARK(BM_StringLookupTemp);
+BENCHMARK(BM_StringLookupView);
+BENCHMARK(BM_StringInsertCopy)->Iterations(1 << 18);
+BENCHMARK(BM_StringInsertMove)->Iterations(1 << 18);
+
+// 区间计数: 2^20 个键 (0..2^20-1) 中随机区间 [lo, lo+len) 的键数
+// - BTreeCountByScan:      scan 逐个计数, O(log n + len)
+// - OrderStatCountRange:   Augment = OrderStatistic, 两次 rank, O(t log n), 与 len 无关
+static constexpr int kRankKeys = 1 << 20;
+
+template <typename Tree>
+static Tree& rank_bench_tree() {
+    static Tree tree = [] {
+        Tree built(50);
+        std::vector<int> keys(kRankKeys);
+        std::iota(keys.begin(), keys.end(), 0);
+        built.bulk_load(keys.begin(), keys.end(), 0.75);
+        return built;
+    }();
+    return tree;
+}
+
+static void BM_BTreeCountByScan(benchmark::State& state) {
+    const auto& tree = rank_bench_tree<BTree<int>>();
+    int len = static_cast<int>(state.range(0));
+    std::mt19937 rng;
+    for (auto _ : state) {
+        int lo = static_cast<int>(rng() % (kRankKeys - len));
+        std::size_t n = 0;
+        tree.scan(lo, lo + len - 1, [&](int) { n++; });
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+static void BM_OrderStatCountRange(benchmark::State& state) {
+    const auto& tree = rank_bench_tree<BTree<int, std::less<int>, NodeArena, OrderStatistic>>();
+    int len = static_cast<int>(state.range(0));
+    std::mt19937 rng;
+    for (auto _ : state) {
+        int lo = static_cast<int>(rng() % (kRankKeys - len));
+        benchmark::DoNotOptimize(tree.count_range(lo, lo + len - 1));
+    }
+}
+
+// 第 k 小的键 (如 p99): 沿子树计数下降, 不需要遍历前 k 个键
+static void BM_OrderStatSelect(benchmark::State& state) {
+    const auto& tree = rank_bench_tree<BTree<int, std::less<int>, NodeArena, OrderStatistic>>();
+    std::mt19937 rng;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(*tree.select(rng() % kRankKeys));
+    }
+}
+
+BENCHMARK(BM_BTreeCountByScan)->RangeMultiplier(100)->Range(10, 100000);
+BENCHMARK(BM_OrderStatCountRange)->RangeMultiplier(100)->Range(10, 100000);
+BENCHMARK(BM_OrderStatSelect);
+
+// 区间求和: 逐个遍历累加 vs 子树缓存的聚合值 (SumOf), 区间长度 10 .. 10^6
+static void BM_BTreeSumByScan(benchmark::State& state) {
+    const auto& tree = rank_bench_tree<BTree<int>>();
+    int len = static_cast<int>(state.range(0));
+    std::mt19937 rng;
+    for (auto _ : state) {
+        int lo = static_cast<int>(rng() % (kRankKeys - len));
+        long long sum = 0;
+        tree.scan(lo, lo + len - 1, [&](int key) { sum += key; });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+static void BM_AggregateReduceSum(benchmark::State& state) {
+    const auto& tree = rank_bench_tree<BTree<int, std::less<int>, NodeArena, SumOf<long long>>>();
+    int len = static_cast<int>(state.range(0));
+    std::mt19937 rng;
+    for (auto _ : state) {
+        int lo = static_cast<int>(rng() % (kRankKeys - len));
+        benchmark::DoNotOptimize(tree.reduce(lo, lo + len - 1));
+    }
+}
+
+BENCHMARK(BM_BTreeSumByScan)->RangeMultiplier(10)->Range(10, 1000000);
+BENCHMARK(BM_AggregateReduceSum)->RangeMultiplier(10)->Range(10, 1000000);
+
+// 偏斜的重复键: 2^20 次插入落在 1000 个不同的键上 (键 = 1000 * u^4, 小键远比大键常见)
+// BTree 中每个副本占一个槽位, BTreeMultiset 中每个不同的键占一个 (键, 次数) 游程
+static constexpr int kSkewInserts = 1 << 20;
+
+static std::vector<int> skewed_keys() {
+    std::mt19937 rng(20);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<int> keys(kSkewInserts);
+    for (int& key : keys) {
+        double x = u(rng);
+        key = static_cast<int>(1000 * x * x * x * x);
+    }
+    return keys;
+}
+
+template <typename Tree>
+static void SkewedInsertBenchmark(benchmark::State& state) {
+    static const std::vector<int> keys = skewed_keys();
+    size_t bytes = 0;
+    for (auto _ : state) {
+        size_t heap_before = heap_in_use();
+        auto tree = std::make_unique<Tree>(32);
+        for (int key : keys)
+            tree->insert(key);
+        bytes = heap_in_use() - heap_before;
+        benchmark::DoNotOptimize(tree->size());
+    }
+    state.counters["bytes/key"] = static_cast<double>(bytes) / kSkewInserts;
+    state.SetItemsProcessed(state.iterations() * kSkewInserts);
+}
+
+static void BM_BTreeSkewedInsert(benchmark::State& state) {
+    SkewedInsertBenchmark<BTree<int>>(state);
+}
+static void BM_MultisetSkewedInsert(benchmark::State& state) {
+    SkewedInsertBenchmark<BTreeMultiset<int>>(state);
+}
+
+// 热点键的次数: BTree 只能逐个遍历相等的键, BTreeMultiset 一次下降
+static void BM_BTreeSkewedCount(benchmark::State& state) {
+    static const std::vector<int> keys = skewed_keys();
+    BTree<int> tree(32);
+    for (int key : keys)
+        tree.insert(key);
+    std::mt19937 rng;
+    for (auto _ : state) {
+        int key = static_cast<int>(rng() % 16);
+        std::size_t n = 0;
+        tree.scan(key, key, [&](int) { n++; });
+        benchmark::DoNotOptimize(n);
+    }
+}
+static void BM_MultisetSkewedCount(benchmark::State& state) {
+    static const std::vector<int> keys = skewed_keys();
+    BTreeMultiset<int> set(32);
+    for (int key : keys)
+        set.insert(key);
+    std::mt19937 rng;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(set.count(static_cast<int>(rng() % 16)));
+    }
+}
+
+BENCHMARK(BM_BTreeSkewedInsert)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MultisetSkewedInsert)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BTreeSkewedCount);
+BENCHMARK(BM_MultisetSkewedCount);
+
+// C 库 (libbtree_c, btree.c) 与 BTree<int64_t> 对比, t = 32, 2^20 个随机 int64 键
+// C 库的记录是 8 字节的字节串, 每次比较经过函数指针; BTree 的比较内联
+// - Insert: 逐个插入到空树     - InsertBatch: 一次批量插入
+// - Search: 随机查找 (全部命中) - Scan: 从随机位置顺序访问 100 个键
+static constexpr int kCKeys = 1 << 20;
+
+static const std::vector<int64_t>& c_bench_keys() {
+    static const std::vector<int64_t> keys = [] {
+        std::mt19937_64 rng(23);
+        std::vector<int64_t> v(kCKeys);
+        for (auto& k : v)
+            k = static_cast<int64_t>(rng() >> 1);
+        return v;
+    }();
+    return keys;
+}
+
+static int compare_int64(const void* a, const void* b, void*) {
+    int64_t x, y;
+    std::memcpy(&x, a, sizeof(x));
+    std::memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+static btree* build_c_tree() {
+    const auto& keys = c_bench_keys();
+    btree* T = btree_create(sizeof(int64_t), 32, compare_int64, nullptr);
+    btree_insert_batch(T, keys.data(), keys.size(), nullptr);
+    return T;
+}
+
+static void BM_CLibInsert(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    for (auto _ : state) {
+        btree* T = btree_create(sizeof(int64_t), 32, compare_int64, nullptr);
+        for (const int64_t& k : keys)
+            btree_insert(T, &k);
+        benchmark::DoNotOptimize(btree_size(T));
+        state.PauseTiming();
+        btree_destroy(T);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kCKeys);
+}
+static void BM_CxxBTreeInsert(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    for (auto _ : state) {
+        auto tree = std::make_unique<BTree<int64_t>>(32);
+        for (int64_t k : keys)
+            tree->insert(k);
+        benchmark::DoNotOptimize(tree->size());
+        state.PauseTiming();
+        tree.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kCKeys);
+}
+
+static void BM_CLibInsertBatch(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    for (auto _ : state) {
+        btree* T = btree_create(sizeof(int64_t), 32, compare_int64, nullptr);
+        benchmark::DoNotOptimize(btree_insert_batch(T, keys.data(), keys.size(), nullptr));
+        state.PauseTiming();
+        btree_destroy(T);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kCKeys);
+}
+static void BM_CxxBTreeInsertBatch(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    for (auto _ : state) {
+        auto tree = std::make_unique<BTree<int64_t>>(32);
+        tree->insert_batch(keys.data(), keys.size());
+        benchmark::DoNotOptimize(tree->size());
+        state.PauseTiming();
+        tree.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kCKeys);
+}
+
+static void BM_CLibSearch(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    btree* T = build_c_tree();
+    std::mt19937 rng;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(btree_find(T, &keys[rng() % kCKeys]));
+    }
+    btree_destroy(T);
+}
+static void BM_CxxBTreeSearch(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    BTree<int64_t> tree(32);
+    tree.insert_batch(keys.data(), keys.size());
+    std::mt19937 rng;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.contains(keys[rng() % kCKeys]));
+    }
+}
+
+static void BM_CLibScan(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    btree* T = build_c_tree();
+    std::mt19937 rng;
+    for (auto _ : state) {
+        btree_iter it;
+        btree_iter_seek(T, &it, &keys[rng() % kCKeys]);
+        int64_t sum = 0;
+        const void* r;
+        for (int n = 0; n < 100 && (r = btree_iter_next(&it)) != nullptr; n++) {
+            int64_t v;
+            std::memcpy(&v, r, sizeof(v));
+            sum += v;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * 100);
+    btree_destroy(T);
+}
+static void BM_CxxBTreeScan(benchmark::State& state) {
+    const auto& keys = c_bench_keys();
+    BTree<int64_t> tree(32);
+    tree.insert_batch(keys.data(), keys.size());
+    std::mt19937 rng;
+    for (auto _ : state) {
+        auto it = tree.lower_bound(keys[rng() % kCKeys]);
+        int64_t sum = 0;
+        for (int n = 0; n < 100 && it != tree.end(); n++, ++it)
+            sum += *it;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * 100);
+}
+
+BENCHMARK(BM_CLibInsert)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CxxBTreeInsert)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CLibInsertBatch)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CxxBTreeInsertBatch)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CLibSearch);
+BENCHMARK(BM_CxxBTreeSearch);
+BENCHMARK(BM_CLibScan);
+BENCHMARK(BM_CxxBTreeScan);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+BENCHMARK_MAIN();
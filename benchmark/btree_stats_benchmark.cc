@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+#include "../include/btree.h"
+#include <random>
+
+// 运行统计的开销: 同一份代码分别以 BTREE_STATS=0 (btree_benchmark_nostats)
+// 和 BTREE_STATS=1 (btree_benchmark_stats) 编译, 对比两者的结果
+static constexpr int kStatsKeys = 1 << 20;
+
+static void BM_StatsInsertion(benchmark::State& state) {
+    BTree<int> btree(50);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(1, 1000000);
+    for (auto _ : state) {
+        btree.insert(dist(rng));
+    }
+    state.SetLabel(BTREE_STATS ? "stats" : "nostats");
+}
+
+static void BM_StatsSearch(benchmark::State& state) {
+    static BTree<int> btree = [] {
+        BTree<int> built(50);
+        std::mt19937 rng(1);
+        for (int i = 0; i < kStatsKeys; i++)
+            built.insert(static_cast<int>(rng() % (4 * kStatsKeys)));
+        return built;
+    }();
+    std::mt19937 rng;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(btree.contains(static_cast<int>(rng() % (4 * kStatsKeys))));
+    }
+    state.SetLabel(BTREE_STATS ? "stats" : "nostats");
+}
+
+// 插入后再删除, 覆盖合并/借键路径
+static void BM_StatsInsertDelete(benchmark::State& state) {
+    BTree<int> btree(50);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> dist(1, 1 << 16);
+    for (auto _ : state) {
+        btree.insert(dist(rng));
+        btree.remove(dist(rng));
+    }
+    state.SetLabel(BTREE_STATS ? "stats" : "nostats");
+}
+
+BENCHMARK(BM_StatsInsertion);
+BENCHMARK(BM_StatsSearch);
+BENCHMARK(BM_StatsInsertDelete);
+
+BENCHMARK_MAIN();
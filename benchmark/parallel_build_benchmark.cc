@@ -0,0 +1,133 @@
+// 并行批量构建与拼接/拆分
+//
+// 输入为 --keys 个打乱顺序的 int64 (默认 1e8), 比较:
+//   build/sequential:       std::sort + bulk_load
+//   build/parallel/threads:N bulk_load_parallel(keys, N), N = 1, 2, 4, 8 以及硬件线程数
+// 加速比 = sequential 的时间 / parallel 的时间; 线程数超过 CPU 核数时不会再变快。
+// 另外测量在整棵树上 split_at 一次再 merge_with 回去的时间: 都是 O(t log n), 与 n 基本无关;
+// NoAugment 时键数推迟到 size() 再数, 循环中不调用 size()。
+//
+// 运行: cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target parallel_build_benchmark
+//       build/benchmark/parallel_build_benchmark --keys=100000000
+#include <benchmark/benchmark.h>
+#include "../include/btree.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::size_t g_keys = 100000000;
+constexpr int kDegree = 64;
+
+const std::vector<int64_t>& shuffled_keys() {
+    static const std::vector<int64_t> keys = [] {
+        std::vector<int64_t> v(g_keys);
+        std::iota(v.begin(), v.end(), 0);
+        std::shuffle(v.begin(), v.end(), std::mt19937_64(25));
+        return v;
+    }();
+    return keys;
+}
+
+void BM_SequentialBuild(benchmark::State& state) {
+    const std::vector<int64_t>& keys = shuffled_keys();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<int64_t> copy = keys;
+        BTree<int64_t> tree(kDegree);
+        state.ResumeTiming();
+        std::sort(copy.begin(), copy.end());
+        tree.bulk_load(copy.begin(), copy.end());
+        benchmark::DoNotOptimize(tree.size());
+        state.PauseTiming();
+        // 析构不计时
+        tree = BTree<int64_t>(kDegree);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(keys.size()));
+}
+
+void BM_ParallelBuild(benchmark::State& state) {
+    const std::vector<int64_t>& keys = shuffled_keys();
+    unsigned threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<int64_t> copy = keys;
+        BTree<int64_t> tree(kDegree);
+        state.ResumeTiming();
+        tree.bulk_load_parallel(std::move(copy), threads);
+        benchmark::DoNotOptimize(tree.size());
+        state.PauseTiming();
+        tree = BTree<int64_t>(kDegree);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(keys.size()));
+}
+
+template <typename Tree>
+void BM_SplitMerge(benchmark::State& state) {
+    Tree tree(kDegree);
+    tree.bulk_load_parallel(shuffled_keys());
+    std::mt19937_64 rng(26);
+    for (auto _ : state) {
+        int64_t pivot = static_cast<int64_t>(rng() % g_keys);
+        Tree upper = tree.split_at(pivot);
+        tree.merge_with(std::move(upper));
+    }
+    if (tree.size() != g_keys)
+        state.SkipWithError("split/merge lost keys");
+}
+
+void register_all() {
+    benchmark::RegisterBenchmark("build/sequential", BM_SequentialBuild)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime()
+        ->Iterations(3);
+    std::vector<int64_t> counts = {1, 2, 4, 8};
+    int64_t hw = std::thread::hardware_concurrency();
+    if (hw > 0 && std::find(counts.begin(), counts.end(), hw) == counts.end())
+        counts.push_back(hw);
+    for (int64_t n : counts) {
+        benchmark::RegisterBenchmark("build/parallel", BM_ParallelBuild)
+            ->ArgName("threads")
+            ->Arg(n)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime()
+            ->Iterations(3);
+    }
+    benchmark::RegisterBenchmark("split_at+merge_with/NoAugment", BM_SplitMerge<BTree<int64_t>>)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("split_at+merge_with/OrderStatistic",
+                                 BM_SplitMerge<BTree<int64_t, std::less<int64_t>, NodeArena, OrderStatistic>>)
+        ->Unit(benchmark::kMicrosecond);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // --keys=N: 构建的键数
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--keys=", 7) == 0) {
+            g_keys = std::strtoull(argv[i] + 7, nullptr, 10);
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+
+    register_all();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
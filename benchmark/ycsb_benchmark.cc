@@ -0,0 +1,446 @@
+// YCSB 风格的负载测试
+//
+// 先按顺序装入 --records 条记录 (键 0..records-1, 值为 8 字节), 然后按负载的比例执行操作:
+//   A: 50% 读  50% 更新            zipfian      (会话存储)
+//   B: 95% 读   5% 更新            zipfian      (照片标签)
+//   C: 100% 读                     zipfian      (用户资料缓存)
+//   D: 95% 读   5% 插入            latest       (状态更新: 读最近插入的)
+//   E: 95% 扫描 5% 插入            zipfian      (会话列表, 每次扫描 1-100 条)
+//   F: 50% 读  50% 读-改-写        zipfian
+// 另外用 C 负载分别跑 uniform / sequential / latest 三种键分布。
+//
+// 键类型: int64、16 字节结构体 (租户号 + 行号)、字符串 ("user" + 16 位数字, 超出短字符串优化)。
+// 对比对象: BTreeMap (t = 8/32/128)、std::map; int64 键另外对比 libbtree_c (btree.c, 键值一起存放在
+// 定长记录中) 和 BTree、std::set (只有键的集合: 更新和读-改-写退化为查找)。
+//
+// 每个操作单独计时, 输出 p50/p99/p99.9 延迟 (含约 20ns 的计时开销)。名字形如
+//   ycsb/A/zipfian/int64/BTreeMap<t=32>
+// 可以用 --benchmark_filter 选择, 例如 --benchmark_filter='ycsb/C/.*/int64/'
+//
+// 运行: cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target ycsb
+#include <benchmark/benchmark.h>
+#include "../include/btree.h"
+#include "../include/btree_map.h"
+#include "../include/btree_c.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::size_t g_records = 1 << 18;
+
+// ---- 键 ----
+
+struct Key16 {
+    uint64_t tenant;
+    uint64_t row;
+    bool operator<(const Key16& other) const {
+        return tenant != other.tenant ? tenant < other.tenant : row < other.row;
+    }
+};
+
+template <typename Key>
+Key make_key(uint64_t i);
+
+template <>
+int64_t make_key<int64_t>(uint64_t i) {
+    return static_cast<int64_t>(i);
+}
+
+template <>
+Key16 make_key<Key16>(uint64_t i) {
+    return Key16{0x5eed, i};
+}
+
+template <>
+std::string make_key<std::string>(uint64_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "user%016llu", static_cast<unsigned long long>(i));
+    return buf;
+}
+
+// ---- 键分布 ----
+
+enum class Dist { Zipfian, Uniform, Sequential, Latest };
+
+const char* dist_name(Dist d) {
+    switch (d) {
+    case Dist::Zipfian:
+        return "zipfian";
+    case Dist::Uniform:
+        return "uniform";
+    case Dist::Sequential:
+        return "sequential";
+    default:
+        return "latest";
+    }
+}
+
+// YCSB 的 Zipf 生成器 (Gray et al., "Quickly Generating Billion-Record Synthetic Databases"),
+// theta = 0.99, 返回 [0, n), 0 最热
+class Zipfian {
+public:
+    explicit Zipfian(uint64_t n, double theta = 0.99) : n(n), theta(theta) {
+        double zeta2 = zeta(2);
+        zetan = zeta(n);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan);
+    }
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zetan;
+        if (uz < 1.0)
+            return 0;
+        if (uz < 1.0 + std::pow(0.5, theta))
+            return 1;
+        return static_cast<uint64_t>(n * std::pow(eta * u - eta + 1, alpha));
+    }
+
+private:
+    uint64_t n;
+    double theta, zetan, alpha, eta;
+
+    double zeta(uint64_t count) const {
+        double sum = 0;
+        for (uint64_t i = 1; i <= count; i++)
+            sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        return sum;
+    }
+};
+
+uint64_t fnv64(uint64_t v) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 8; i++) {
+        h ^= v & 0xff;
+        h *= 0x100000001b3ULL;
+        v >>= 8;
+    }
+    return h;
+}
+
+// 选出下一个操作访问的记录号; 插入会使 records 增长
+class KeyChooser {
+public:
+    KeyChooser(Dist dist, uint64_t records) : dist(dist), zipf(records) {}
+
+    template <typename Rng>
+    uint64_t next(Rng& rng, uint64_t records) {
+        switch (dist) {
+        case Dist::Zipfian:
+            // 打散热点, 避免热键都聚集在键空间的一端 (YCSB ScrambledZipfian)
+            return fnv64(zipf.next(rng)) % records;
+        case Dist::Uniform:
+            return rng() % records;
+        case Dist::Sequential:
+            return cursor++ % records;
+        default: {
+            uint64_t back = zipf.next(rng);
+            return back < records ? records - 1 - back : 0;
+        }
+        }
+    }
+
+private:
+    Dist dist;
+    Zipfian zipf;
+    uint64_t cursor = 0;
+};
+
+// ---- 负载 ----
+
+struct Workload {
+    const char* name;
+    double read, update, insert, scan; // 其余为读-改-写
+    Dist dist;
+};
+
+enum class Op { Read, Update, Insert, Scan, ReadModifyWrite };
+
+// ---- 被测的结构 ----
+// 统一的接口: load/read/update/insert/scan/rmw
+
+template <typename Key>
+struct BTreeMapStore {
+    BTreeMap<Key, uint64_t> map;
+    explicit BTreeMapStore(int t) : map(t) {}
+    void insert(const Key& key, uint64_t value) { map.insert_or_assign(key, value); }
+    bool read(const Key& key) {
+        const uint64_t* v = map.find(key);
+        if (v)
+            benchmark::DoNotOptimize(*v);
+        return v != nullptr;
+    }
+    void update(const Key& key, uint64_t value) { map.insert_or_assign(key, value); }
+    void rmw(const Key& key) { map.upsert(key, [](uint64_t& v) { v++; }); }
+    std::size_t scan(const Key& key, int n) {
+        std::size_t seen = 0;
+        for (auto it = map.lower_bound(key); it != map.end() && seen < static_cast<std::size_t>(n); ++it, ++seen)
+            benchmark::DoNotOptimize(it.value());
+        return seen;
+    }
+};
+
+template <typename Key>
+struct StdMapStore {
+    std::map<Key, uint64_t> map;
+    explicit StdMapStore(int) {}
+    void insert(const Key& key, uint64_t value) { map.insert_or_assign(key, value); }
+    bool read(const Key& key) {
+        auto it = map.find(key);
+        if (it == map.end())
+            return false;
+        benchmark::DoNotOptimize(it->second);
+        return true;
+    }
+    void update(const Key& key, uint64_t value) { map.insert_or_assign(key, value); }
+    void rmw(const Key& key) { map[key]++; }
+    std::size_t scan(const Key& key, int n) {
+        std::size_t seen = 0;
+        for (auto it = map.lower_bound(key); it != map.end() && seen < static_cast<std::size_t>(n); ++it, ++seen)
+            benchmark::DoNotOptimize(it->second);
+        return seen;
+    }
+};
+
+template <typename Key>
+struct BTreeSetStore {
+    BTree<Key> set;
+    explicit BTreeSetStore(int t) : set(t) {}
+    void insert(const Key& key, uint64_t) { set.insert(key); }
+    bool read(const Key& key) { return set.contains(key); }
+    void update(const Key& key, uint64_t) { benchmark::DoNotOptimize(set.contains(key)); }
+    void rmw(const Key& key) { benchmark::DoNotOptimize(set.contains(key)); }
+    std::size_t scan(const Key& key, int n) {
+        std::size_t seen = 0;
+        for (auto it = set.lower_bound(key); it != set.end() && seen < static_cast<std::size_t>(n); ++it, ++seen)
+            benchmark::DoNotOptimize(*it);
+        return seen;
+    }
+};
+
+template <typename Key>
+struct StdSetStore {
+    std::set<Key> set;
+    explicit StdSetStore(int) {}
+    void insert(const Key& key, uint64_t) { set.insert(key); }
+    bool read(const Key& key) { return set.count(key) != 0; }
+    void update(const Key& key, uint64_t) { benchmark::DoNotOptimize(set.count(key)); }
+    void rmw(const Key& key) { benchmark::DoNotOptimize(set.count(key)); }
+    std::size_t scan(const Key& key, int n) {
+        std::size_t seen = 0;
+        for (auto it = set.lower_bound(key); it != set.end() && seen < static_cast<std::size_t>(n); ++it, ++seen)
+            benchmark::DoNotOptimize(*it);
+        return seen;
+    }
+};
+
+// libbtree_c (btree.c): 记录为 {int64 键, 8 字节值}, 比较函数只看键
+struct CBTreeStore {
+    struct Record {
+        int64_t key;
+        uint64_t value;
+    };
+    btree* tree;
+    explicit CBTreeStore(int t) : tree(btree_create(sizeof(Record), t, compare, nullptr)) {}
+    ~CBTreeStore() { btree_destroy(tree); }
+    CBTreeStore(const CBTreeStore&) = delete;
+    CBTreeStore& operator=(const CBTreeStore&) = delete;
+
+    static int compare(const void* a, const void* b, void*) {
+        int64_t x, y;
+        std::memcpy(&x, a, sizeof(x));
+        std::memcpy(&y, b, sizeof(y));
+        return (x > y) - (x < y);
+    }
+
+    void insert(int64_t key, uint64_t value) {
+        Record r{key, value};
+        btree_put(tree, &r);
+    }
+    bool read(int64_t key) {
+        const void* hit = btree_find(tree, &key);
+        benchmark::DoNotOptimize(hit);
+        return hit != nullptr;
+    }
+    void update(int64_t key, uint64_t value) {
+        Record r{key, value};
+        btree_put(tree, &r);
+    }
+    void rmw(int64_t key) {
+        Record r;
+        const void* hit = btree_find(tree, &key);
+        if (!hit)
+            return;
+        std::memcpy(&r, hit, sizeof(r));
+        r.value++;
+        btree_put(tree, &r);
+    }
+    std::size_t scan(int64_t key, int n) {
+        btree_iter it;
+        btree_iter_seek(tree, &it, &key);
+        std::size_t seen = 0;
+        for (const void* r; seen < static_cast<std::size_t>(n) && (r = btree_iter_next(&it)) != nullptr; seen++)
+            benchmark::DoNotOptimize(r);
+        return seen;
+    }
+};
+
+// ---- 驱动 ----
+
+template <typename Store, typename Key>
+void run_workload(benchmark::State& state, const Workload& w, int t) {
+    Store store(t);
+    uint64_t records = g_records;
+    for (uint64_t i = 0; i < records; i++)
+        store.insert(make_key<Key>(i), i);
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> pick(0.0, 1.0);
+    KeyChooser chooser(w.dist, records);
+
+    // 预先生成键, 构造字符串键的时间不计入操作延迟
+    constexpr std::size_t kBatch = 4096;
+    std::vector<Op> ops(kBatch);
+    std::vector<Key> keys(kBatch);
+    std::vector<int> scan_lengths(kBatch);
+    std::size_t next = kBatch;
+
+    std::vector<uint32_t> latencies;
+    latencies.reserve(1 << 20);
+    std::size_t misses = 0;
+
+    for (auto _ : state) {
+        if (next == kBatch) {
+            state.PauseTiming();
+            // 读只选择上一批结束时已经插入的记录
+            uint64_t committed = records;
+            for (std::size_t j = 0; j < kBatch; j++) {
+                double p = pick(rng);
+                if ((p -= w.read) < 0) {
+                    ops[j] = Op::Read;
+                } else if ((p -= w.update) < 0) {
+                    ops[j] = Op::Update;
+                } else if ((p -= w.insert) < 0) {
+                    ops[j] = Op::Insert;
+                } else if ((p -= w.scan) < 0) {
+                    ops[j] = Op::Scan;
+                } else {
+                    ops[j] = Op::ReadModifyWrite;
+                }
+                keys[j] = make_key<Key>(ops[j] == Op::Insert ? records++ : chooser.next(rng, committed));
+                scan_lengths[j] = 1 + static_cast<int>(rng() % 100);
+            }
+            next = 0;
+            state.ResumeTiming();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        const Key& key = keys[next];
+        switch (ops[next]) {
+        case Op::Read:
+            misses += !store.read(key);
+            break;
+        case Op::Update:
+            store.update(key, next);
+            break;
+        case Op::Insert:
+            store.insert(key, next);
+            break;
+        case Op::Scan:
+            benchmark::DoNotOptimize(store.scan(key, scan_lengths[next]));
+            break;
+        case Op::ReadModifyWrite:
+            store.rmw(key);
+            break;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (latencies.size() < latencies.capacity())
+            latencies.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        next++;
+    }
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double q) {
+            return static_cast<double>(latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(q * latencies.size()))]);
+        };
+        state.counters["p50_ns"] = percentile(0.50);
+        state.counters["p99_ns"] = percentile(0.99);
+        state.counters["p999_ns"] = percentile(0.999);
+    }
+    if (misses)
+        state.counters["read_misses"] = static_cast<double>(misses);
+    state.SetItemsProcessed(state.iterations());
+}
+
+const Workload kWorkloads[] = {
+    {"A", 0.50, 0.50, 0.00, 0.00, Dist::Zipfian},
+    {"B", 0.95, 0.05, 0.00, 0.00, Dist::Zipfian},
+    {"C", 1.00, 0.00, 0.00, 0.00, Dist::Zipfian},
+    {"D", 0.95, 0.00, 0.05, 0.00, Dist::Latest},
+    {"E", 0.00, 0.00, 0.05, 0.95, Dist::Zipfian},
+    {"F", 0.50, 0.00, 0.00, 0.00, Dist::Zipfian},
+    // 只读负载下对比键分布
+    {"C", 1.00, 0.00, 0.00, 0.00, Dist::Uniform},
+    {"C", 1.00, 0.00, 0.00, 0.00, Dist::Sequential},
+    {"C", 1.00, 0.00, 0.00, 0.00, Dist::Latest},
+};
+
+template <typename Store, typename Key>
+void register_store(const char* key_name, const std::string& store_name, int t) {
+    for (const Workload& w : kWorkloads) {
+        std::string name = std::string("ycsb/") + w.name + "/" + dist_name(w.dist) + "/" + key_name + "/" + store_name;
+        benchmark::RegisterBenchmark(name.c_str(), [w, t](benchmark::State& state) {
+            run_workload<Store, Key>(state, w, t);
+        });
+    }
+}
+
+template <typename Key>
+void register_maps(const char* key_name) {
+    for (int t : {8, 32, 128})
+        register_store<BTreeMapStore<Key>, Key>(key_name, "BTreeMap<t=" + std::to_string(t) + ">", t);
+    register_store<StdMapStore<Key>, Key>(key_name, "std::map", 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // --records=N: 预先装入的记录数
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--records=", 10) == 0) {
+            g_records = std::strtoull(argv[i] + 10, nullptr, 10);
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+
+    register_maps<int64_t>("int64");
+    register_store<BTreeSetStore<int64_t>, int64_t>("int64", "BTree<t=32>", 32);
+    register_store<StdSetStore<int64_t>, int64_t>("int64", "std::set", 0);
+    register_store<CBTreeStore, int64_t>("int64", "btree_c<t=32>", 32);
+    register_maps<Key16>("key16");
+    register_maps<std::string>("string");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,391 +1,528 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include <assert.h>
+#include "btree_c.h"
 
+// libbtree_c 的实现, 接口说明见 include/btree_c.h
+//
+// 记录是 record_size 字节的定长数据, 由用户的比较函数排序, 键唯一。
+// 每个节点一次分配, 叶子不分配子节点指针:
+//   内部节点: [btree_node | children[2t] | records[2t-1]]
+//   叶子节点: [btree_node | records[2t-1]]
+// 插入和删除都是一次自顶向下的循环: 插入时预先分裂满节点, 删除时预先补足子节点 (借键或合并),
+// 不需要回溯到父节点。
 
-
-// 这里定义了B树节点btree_node和B树btree的结构体。
-#define DEGREE		3
-typedef int KEY_VALUE;
-// btree_node包含键值数组keys、子节点指针数组childrens、存储键值的数量num和是否为叶子节点的标志leaf。
-typedef struct _btree_node {
-	KEY_VALUE *keys;
-	struct _btree_node **childrens;
+// btree_node 只有头部, 子节点指针和记录紧跟在后面
+struct btree_node {
 	int num;
 	int leaf;
-} btree_node;
-// btree结构体则包含一个指向根节点的指针root和树的度t。
-typedef struct _btree {
+};
+
+struct btree {
 	btree_node *root;
 	int t;
-} btree;
+	size_t record_size;
+	size_t count;
+	btree_compare_fn cmp;
+	void *ctx;
+};
+
+static btree_node **btree_childrens(const btree_node *x) {
+	return (btree_node **)(x + 1);
+}
+
+static char *btree_record(const btree *T, const btree_node *x, int i) {
+	char *base = (char *)(x + 1);
+	if (!x->leaf) base += 2 * T->t * sizeof(btree_node *);
+	return base + (size_t)i * T->record_size;
+}
+
+static int btree_compare(const btree *T, const void *a, const void *b) {
+	return T->cmp(a, b, T->ctx);
+}
 
 //节点创建和销毁
-btree_node *btree_create_node(int t, int leaf) {
+static btree_node *btree_create_node(const btree *T, int leaf) {
+	size_t bytes = sizeof(btree_node) + (size_t)(2 * T->t - 1) * T->record_size;
+	if (!leaf) bytes += 2 * T->t * sizeof(btree_node *);
 
-	btree_node *node = (btree_node*)calloc(1, sizeof(btree_node));
-	if (node == NULL) assert(0);
+	btree_node *node = (btree_node *)malloc(bytes);
+	if (node == NULL) return NULL;
 
-	node->leaf = leaf;
-	node->keys = (KEY_VALUE*)calloc(1, (2*t-1)*sizeof(KEY_VALUE));
-	node->childrens = (btree_node**)calloc(1, (2*t) * sizeof(btree_node*));
 	node->num = 0;
-
+	node->leaf = leaf;
 	return node;
 }
 
-void btree_destroy_node(btree_node *node) {
-
-	assert(node);
-
-	free(node->childrens);
-	free(node->keys);
+static void btree_destroy_node(btree_node *node) {
 	free(node);
-	
 }
 
-
-void btree_create(btree *T, int t) {
-	T->t = t;
-	
-	btree_node *x = btree_create_node(t, 1);
-	T->root = x;
-	
+static void btree_destroy_subtree(btree_node *x) {
+	int i;
+	if (!x->leaf) {
+		for (i = 0; i <= x->num; i++)
+			btree_destroy_subtree(btree_childrens(x)[i]);
+	}
+	btree_destroy_node(x);
 }
 
-// 节点分裂，当节点键值数量达到最大时，需要分裂节点。这个函数处理分裂逻辑。
-void btree_split_child(btree *T, btree_node *x, int i) {
-	int t = T->t;
-
-	btree_node *y = x->childrens[i];
-	btree_node *z = btree_create_node(t, y->leaf);
-
-	z->num = t - 1;
+btree *btree_create(size_t record_size, int t, btree_compare_fn cmp, void *ctx) {
+	if (record_size == 0 || t < 2 || cmp == NULL) return NULL;
 
-	int j = 0;
-	for (j = 0;j < t-1;j ++) {
-		z->keys[j] = y->keys[j+t];
-	}
-	if (y->leaf == 0) {
-		for (j = 0;j < t;j ++) {
-			z->childrens[j] = y->childrens[j+t];
-		}
+	btree *T = (btree *)malloc(sizeof(btree));
+	if (T == NULL) return NULL;
+	T->t = t;
+	T->record_size = record_size;
+	T->count = 0;
+	T->cmp = cmp;
+	T->ctx = ctx;
+
+	T->root = btree_create_node(T, 1);
+	if (T->root == NULL) {
+		free(T);
+		return NULL;
 	}
+	return T;
+}
 
-	y->num = t - 1;
-	for (j = x->num;j >= i+1;j --) {
-		x->childrens[j+1] = x->childrens[j];
-	}
+void btree_destroy(btree *T) {
+	if (T == NULL) return;
+	btree_destroy_subtree(T->root);
+	free(T);
+}
 
-	x->childrens[i+1] = z;
+size_t btree_size(const btree *T) {
+	return T->count;
+}
 
-	for (j = x->num-1;j >= i;j --) {
-		x->keys[j+1] = x->keys[j];
-	}
-	x->keys[i] = y->keys[t-1];
-	x->num += 1;
-	
+size_t btree_record_size(const btree *T) {
+	return T->record_size;
 }
-//插入
-void btree_insert_nonfull(btree *T, btree_node *x, KEY_VALUE k) {
 
-	int i = x->num - 1;
+//二分搜索 辅助函数: 节点中第一条 >= key 的记录的下标, 都小于 key 时返回 num
+static int btree_bin_search(const btree *T, const btree_node *node, const void *key) {
+	int low = 0, high = node->num;
 
-	if (x->leaf == 1) {
-		
-		while (i >= 0 && x->keys[i] > k) {
-			x->keys[i+1] = x->keys[i];
-			i --;
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (btree_compare(T, btree_record(T, node, mid), key) < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
 		}
-		x->keys[i+1] = k;
-		x->num += 1;
-		
-	} else {
-		while (i >= 0 && x->keys[i] > k) i --;
+	}
 
-		if (x->childrens[i+1]->num == (2*(T->t))-1) {
-			btree_split_child(T, x, i+1);
-			if (k > x->keys[i+1]) i++;
-		}
+	return low;
+}
 
-		btree_insert_nonfull(T, x->childrens[i+1], k);
-	}
+// 节点内的记录/子节点平移
+static void btree_move_records(const btree *T, btree_node *dst, int di, const btree_node *src, int si, int n) {
+	if (n > 0) memmove(btree_record(T, dst, di), btree_record(T, src, si), (size_t)n * T->record_size);
 }
 
-void btree_insert(btree *T, KEY_VALUE key) {
-	//int t = T->t;
+static void btree_move_childrens(btree_node *dst, int di, const btree_node *src, int si, int n) {
+	if (n > 0) memmove(btree_childrens(dst) + di, btree_childrens(src) + si, (size_t)n * sizeof(btree_node *));
+}
 
-	btree_node *r = T->root;
-	if (r->num == 2 * T->t - 1) {
-		
-		btree_node *node = btree_create_node(T->t, 0);
-		T->root = node;
+// 节点分裂: x 的第 i 个子节点 y 已满 (2t-1 条), 中位记录上移到 x, 后 t-1 条移到新节点 z
+/*
+	x: [.. A ..]              x: [.. A  M ..]
+	        |          =>             /    \
+	   y: [L M R]              y: [L]    z: [R]
+*/
+static int btree_split_child(btree *T, btree_node *x, int i) {
+	int t = T->t;
+	btree_node *y = btree_childrens(x)[i];
+	btree_node *z = btree_create_node(T, y->leaf);
+	if (z == NULL) return BTREE_ENOMEM;
 
-		node->childrens[0] = r;
+	z->num = t - 1;
+	btree_move_records(T, z, 0, y, t, t - 1);
+	if (!y->leaf) btree_move_childrens(z, 0, y, t, t);
+	y->num = t - 1;
 
-		btree_split_child(T, node, 0);
+	btree_move_childrens(x, i + 2, x, i + 1, x->num - i);
+	btree_childrens(x)[i + 1] = z;
+	btree_move_records(T, x, i + 1, x, i, x->num - i);
+	memcpy(btree_record(T, x, i), btree_record(T, y, t - 1), T->record_size);
+	x->num += 1;
+	return BTREE_OK;
+}
 
-		int i = 0;
-		if (node->keys[0] < key) i++;
-		btree_insert_nonfull(T, node->childrens[i], key);
-		
-	} else {
-		btree_insert_nonfull(T, r, key);
+// 根节点已满时先分裂根节点, 树高加一
+static int btree_grow_root(btree *T) {
+	if (T->root->num < 2 * T->t - 1) return BTREE_OK;
+
+	btree_node *node = btree_create_node(T, 0);
+	if (node == NULL) return BTREE_ENOMEM;
+	btree_childrens(node)[0] = T->root;
+	if (btree_split_child(T, node, 0) != BTREE_OK) {
+		btree_destroy_node(node);
+		return BTREE_ENOMEM;
 	}
+	T->root = node;
+	return BTREE_OK;
 }
-// 遍历和打印
-void btree_traverse(btree_node *x) {
-	int i = 0;
 
-	for (i = 0;i < x->num;i ++) {
-		if (x->leaf == 0) 
-			btree_traverse(x->childrens[i]);
-		printf("%c ", x->keys[i]);
+// 下降到 key 应插入的叶子, 沿途预先分裂满节点, 返回的叶子一定不满
+// 在内部节点遇到相等的记录时返回 NULL 并写入 *existing; 分配失败时返回 NULL 并写入 *err
+// *fence: 叶子的右边界 (路径上最近的、位于所走子树右侧的记录), 最右路径上为 NULL
+static btree_node *btree_descend_insert(btree *T, const void *key, const char **fence, char **existing, int *err) {
+	*fence = NULL;
+	*existing = NULL;
+	*err = btree_grow_root(T);
+	if (*err != BTREE_OK) return NULL;
+
+	btree_node *x = T->root;
+	while (!x->leaf) {
+		int i = btree_bin_search(T, x, key);
+		if (i < x->num && btree_compare(T, btree_record(T, x, i), key) == 0) {
+			*existing = btree_record(T, x, i);
+			return NULL;
+		}
+		if (btree_childrens(x)[i]->num == 2 * T->t - 1) {
+			*err = btree_split_child(T, x, i);
+			if (*err != BTREE_OK) return NULL;
+			// 上移的中位记录可能正好等于 key
+			int c = btree_compare(T, key, btree_record(T, x, i));
+			if (c == 0) {
+				*existing = btree_record(T, x, i);
+				return NULL;
+			}
+			if (c > 0) i++;
+		}
+		if (i < x->num) *fence = btree_record(T, x, i);
+		x = btree_childrens(x)[i];
 	}
+	return x;
+}
 
-	if (x->leaf == 0) btree_traverse(x->childrens[i]);
+// 在不满的叶子中插入; 已有相等的记录时返回它
+static char *btree_leaf_insert(btree *T, btree_node *leaf, const void *record, int *inserted) {
+	int i = btree_bin_search(T, leaf, record);
+	*inserted = 0;
+	if (i < leaf->num && btree_compare(T, btree_record(T, leaf, i), record) == 0)
+		return btree_record(T, leaf, i);
+
+	btree_move_records(T, leaf, i + 1, leaf, i, leaf->num - i);
+	memcpy(btree_record(T, leaf, i), record, T->record_size);
+	leaf->num += 1;
+	T->count++;
+	*inserted = 1;
+	return btree_record(T, leaf, i);
 }
 
-void btree_print(btree *T, btree_node *node, int layer)
-{
-	btree_node* p = node;
-	int i;
-	if(p){
-		printf("\nlayer = %d keynum = %d is_leaf = %d\n", layer, p->num, p->leaf);
-		for(i = 0; i < node->num; i++)
-			printf("%c ", p->keys[i]);
-		printf("\n");
-#if 0
-		printf("%p\n", p);
-		for(i = 0; i <= 2 * T->t; i++)
-			printf("%p ", p->childrens[i]);
-		printf("\n");
-#endif
-		layer++;
-		for(i = 0; i <= p->num; i++)
-			if(p->childrens[i])
-				btree_print(T, p->childrens[i], layer);
+//插入
+static int btree_insert_record(btree *T, const void *record, int replace) {
+	const char *fence;
+	char *existing;
+	int err, inserted;
+
+	btree_node *leaf = btree_descend_insert(T, record, &fence, &existing, &err);
+	if (leaf == NULL && existing == NULL) return err;
+	if (leaf != NULL) {
+		existing = btree_leaf_insert(T, leaf, record, &inserted);
+		if (inserted) return BTREE_OK;
 	}
-	else printf("the tree is empty\n");
+	if (replace) memcpy(existing, record, T->record_size);
+	return BTREE_EXISTS;
 }
 
-//二分搜索 辅助函数。用于在B树节点的键值数组中使用二分搜索找到给定键值的位置。
-int btree_bin_search(btree_node *node, int low, int high, KEY_VALUE key) {
-	int mid;
-	if (low > high || low < 0 || high < 0) {
-		return -1;
-	}
+int btree_insert(btree *T, const void *record) {
+	return btree_insert_record(T, record, 0);
+}
 
-	while (low <= high) {
-		mid = (low + high) / 2;
-		if (key > node->keys[mid]) {
-			low = mid + 1;
-		} else {
-			high = mid - 1;
+int btree_put(btree *T, const void *record) {
+	return btree_insert_record(T, record, 1);
+}
+
+// 有序批量插入用的归并排序 (qsort 不能传比较函数的上下文)
+static void btree_sort_records(const btree *T, const char **items, const char **tmp, size_t n) {
+	size_t width, i;
+	for (width = 1; width < n; width *= 2) {
+		for (i = 0; i < n; i += 2 * width) {
+			size_t mid = i + width < n ? i + width : n;
+			size_t end = i + 2 * width < n ? i + 2 * width : n;
+			size_t a = i, b = mid, k = i;
+			while (a < mid && b < end)
+				tmp[k++] = btree_compare(T, items[b], items[a]) < 0 ? items[b++] : items[a++];
+			while (a < mid) tmp[k++] = items[a++];
+			while (b < end) tmp[k++] = items[b++];
 		}
+		memcpy(items, tmp, n * sizeof(*items));
 	}
-
-	return low;
 }
 
-// 节点合并， 当一个节点的键值数量少于最小数量时，可能需要将其与兄弟节点合并。这个函数处理节点合并的逻辑。
-//{child[idx], key[idx], child[idx+1]} 
-void btree_merge(btree *T, btree_node *node, int idx) {
-
-	btree_node *left = node->childrens[idx];
-	btree_node *right = node->childrens[idx+1];
-
-	int i = 0;
-
-	/////data merge
-	left->keys[T->t-1] = node->keys[idx];
-	for (i = 0;i < T->t-1;i ++) {
-		left->keys[T->t+i] = right->keys[i];
+// 批量插入: 排序后依次插入, 相邻的记录落在同一个叶子 (小于 fence 且叶子未满) 时不再从根节点下降
+/*
+	依次插入 42 44 47 52:
+	              [30        60]
+	             /      |       \
+	           ...   [40 50]    ...
+	                /   |   \
+	          [31 35] [41 45] [51 55]
+	  42: 从根下降到叶子 [41 45], fence = 50
+	  44, 47: 仍 < 50 且叶子未满, 直接插入同一个叶子
+	  52: >= fence, 重新从根下降
+*/
+size_t btree_insert_batch(btree *T, const void *records, size_t n, int *err) {
+	size_t inserted = 0, j;
+	int status = BTREE_OK;
+
+	if (err) *err = BTREE_OK;
+	if (n == 0) return 0;
+
+	const char **items = (const char **)malloc(2 * n * sizeof(const char *));
+	if (items == NULL) {
+		if (err) *err = BTREE_ENOMEM;
+		return 0;
 	}
-	if (!left->leaf) {
-		for (i = 0;i < T->t;i ++) {
-			left->childrens[T->t+i] = right->childrens[i];
+	for (j = 0; j < n; j++)
+		items[j] = (const char *)records + j * T->record_size;
+	btree_sort_records(T, items, items + n, n);
+
+	btree_node *leaf = NULL;
+	const char *fence = NULL;
+	for (j = 0; j < n; j++) {
+		const char *record = items[j];
+		if (leaf == NULL || leaf->num == 2 * T->t - 1 || (fence && btree_compare(T, record, fence) >= 0)) {
+			char *existing;
+			leaf = btree_descend_insert(T, record, &fence, &existing, &status);
+			if (leaf == NULL) {
+				if (existing) continue;
+				break;
+			}
 		}
+		int added;
+		btree_leaf_insert(T, leaf, record, &added);
+		inserted += (size_t)added;
 	}
-	left->num += T->t;
 
-	//destroy right
-	btree_destroy_node(right);
+	free(items);
+	if (err) *err = status;
+	return inserted;
+}
 
-	//node 
-	for (i = idx+1;i < node->num;i ++) {
-		node->keys[i-1] = node->keys[i];
-		node->childrens[i] = node->childrens[i+1];
-	}
-	node->childrens[i+1] = NULL;
-	node->num -= 1;
+// 查找
+const void *btree_find(const btree *T, const void *key) {
+	const btree_node *x = T->root;
 
-	if (node->num == 0) {
-		T->root = left;
-		btree_destroy_node(node);
+	while (1) {
+		int i = btree_bin_search(T, x, key);
+		if (i < x->num && btree_compare(T, btree_record(T, x, i), key) == 0)
+			return btree_record(T, x, i);
+		if (x->leaf) return NULL;
+		x = btree_childrens(x)[i];
 	}
 }
 
-void btree_delete_key(btree *T, btree_node *node, KEY_VALUE key) {
-
-	if (node == NULL) return ;
+// 节点合并: {childrens[idx], records[idx], childrens[idx+1]} 合并到 childrens[idx]
+static void btree_merge(btree *T, btree_node *node, int idx) {
+	btree_node *left = btree_childrens(node)[idx];
+	btree_node *right = btree_childrens(node)[idx + 1];
 
-	int idx = 0, i;
+	memcpy(btree_record(T, left, left->num), btree_record(T, node, idx), T->record_size);
+	btree_move_records(T, left, left->num + 1, right, 0, right->num);
+	if (!left->leaf) btree_move_childrens(left, left->num + 1, right, 0, right->num + 1);
+	left->num += right->num + 1;
 
-	while (idx < node->num && key > node->keys[idx]) {
-		idx ++;
-	}
+	btree_move_records(T, node, idx, node, idx + 1, node->num - idx - 1);
+	btree_move_childrens(node, idx + 1, node, idx + 2, node->num - idx - 1);
+	node->num -= 1;
 
-	if (idx < node->num && key == node->keys[idx]) {
+	btree_destroy_node(right);
+}
 
-		if (node->leaf) {
-			
-			for (i = idx;i < node->num-1;i ++) {
-				node->keys[i] = node->keys[i+1];
-			}
+// 从左兄弟借一条记录: 父节点的分隔记录下移到 child 最前, 左兄弟的最后一条上移
+static void btree_borrow_from_prev(btree *T, btree_node *node, int idx) {
+	btree_node *child = btree_childrens(node)[idx];
+	btree_node *left = btree_childrens(node)[idx - 1];
 
-			node->keys[node->num - 1] = 0;
-			node->num--;
-			
-			if (node->num == 0) { //root
-				free(node);
-				T->root = NULL;
-			}
-
-			return ;
-		} else if (node->childrens[idx]->num >= T->t) {
+	btree_move_records(T, child, 1, child, 0, child->num);
+	memcpy(btree_record(T, child, 0), btree_record(T, node, idx - 1), T->record_size);
+	if (!child->leaf) {
+		btree_move_childrens(child, 1, child, 0, child->num + 1);
+		btree_childrens(child)[0] = btree_childrens(left)[left->num];
+	}
+	child->num += 1;
 
-			btree_node *left = node->childrens[idx];
-			node->keys[idx] = left->keys[left->num - 1];
+	memcpy(btree_record(T, node, idx - 1), btree_record(T, left, left->num - 1), T->record_size);
+	left->num -= 1;
+}
 
-			btree_delete_key(T, left, left->keys[left->num - 1]);
-			
-		} else if (node->childrens[idx+1]->num >= T->t) {
+// 从右兄弟借一条记录: 父节点的分隔记录下移到 child 末尾, 右兄弟的第一条上移
+static void btree_borrow_from_next(btree *T, btree_node *node, int idx) {
+	btree_node *child = btree_childrens(node)[idx];
+	btree_node *right = btree_childrens(node)[idx + 1];
 
-			btree_node *right = node->childrens[idx+1];
-			node->keys[idx] = right->keys[0];
+	memcpy(btree_record(T, child, child->num), btree_record(T, node, idx), T->record_size);
+	if (!child->leaf) btree_childrens(child)[child->num + 1] = btree_childrens(right)[0];
+	child->num += 1;
 
-			btree_delete_key(T, right, right->keys[0]);
-			
-		} else {
+	memcpy(btree_record(T, node, idx), btree_record(T, right, 0), T->record_size);
+	btree_move_records(T, right, 0, right, 1, right->num - 1);
+	if (!right->leaf) btree_move_childrens(right, 0, right, 1, right->num);
+	right->num -= 1;
+}
 
-			btree_merge(T, node, idx);
-			btree_delete_key(T, node->childrens[idx], key);
-			
-		}
-		
+// 进入 childrens[idx] 之前保证它至少有 t 条记录, 返回之后应进入的子节点下标
+static int btree_fill(btree *T, btree_node *node, int idx) {
+	btree_node **c = btree_childrens(node);
+	if (c[idx]->num >= T->t) return idx;
+
+	if (idx > 0 && c[idx - 1]->num >= T->t) {
+		btree_borrow_from_prev(T, node, idx);
+	} else if (idx < node->num && c[idx + 1]->num >= T->t) {
+		btree_borrow_from_next(T, node, idx);
+	} else if (idx < node->num) {
+		btree_merge(T, node, idx);
 	} else {
+		btree_merge(T, node, idx - 1);
+		idx--;
+	}
+	return idx;
+}
 
-		btree_node *child = node->childrens[idx];
-		if (child == NULL) {
-			printf("Cannot del key = %d\n", key);
-			return ;
-		}
+// 沿最右 (rightmost) 或最左路径下降到叶子, 沿途保证每个子节点至少有 t 条记录
+static btree_node *btree_descend_filled(btree *T, btree_node *x, int rightmost) {
+	while (!x->leaf) {
+		int idx = btree_fill(T, x, rightmost ? x->num : 0);
+		x = btree_childrens(x)[idx];
+	}
+	return x;
+}
 
-		if (child->num == T->t - 1) {
-
-			btree_node *left = NULL;
-			btree_node *right = NULL;
-			if (idx - 1 >= 0)
-				left = node->childrens[idx-1];
-			if (idx + 1 <= node->num) 
-				right = node->childrens[idx+1];
-
-			if ((left && left->num >= T->t) ||
-				(right && right->num >= T->t)) {
-
-				int richR = 0;
-				if (right) richR = 1;
-				if (left && right) richR = (right->num > left->num) ? 1 : 0;
-
-				if (right && right->num >= T->t && richR) { //borrow from next
-					child->keys[child->num] = node->keys[idx];
-					child->childrens[child->num+1] = right->childrens[0];
-					child->num ++;
-
-					node->keys[idx] = right->keys[0];
-					for (i = 0;i < right->num - 1;i ++) {
-						right->keys[i] = right->keys[i+1];
-						right->childrens[i] = right->childrens[i+1];
-					}
-
-					right->keys[right->num-1] = 0;
-					right->childrens[right->num-1] = right->childrens[right->num];
-					right->childrens[right->num] = NULL;
-					right->num --;
-					
-				} else { //borrow from prev
-
-					for (i = child->num;i > 0;i --) {
-						child->keys[i] = child->keys[i-1];
-						child->childrens[i+1] = child->childrens[i];
-					}
-
-					child->childrens[1] = child->childrens[0];
-					child->childrens[0] = left->childrens[left->num];
-					child->keys[0] = node->keys[idx-1];
-					
-					child->num ++;
-
-					node->keys[idx-1] = left->keys[left->num-1];
-					left->keys[left->num-1] = 0;
-					left->childrens[left->num] = NULL;
-					left->num --;
-				}
-
-			} else if ((!left || (left->num == T->t - 1))
-				&& (!right || (right->num == T->t - 1))) {
-
-				if (left && left->num == T->t - 1) {
-					btree_merge(T, node, idx-1);					
-					child = left;
-				} else if (right && right->num == T->t - 1) {
-					btree_merge(T, node, idx);
-				}
+// 删除: 一次自顶向下的循环
+/*
+	记录在当前节点 x[idx] 时:
+	1. x 是叶子: 直接删除
+	2. 左子树至少有 t 条: 沿左子树最右路径下降, 用前驱替换 x[idx] 并从叶子中删除前驱
+	3. 右子树至少有 t 条: 对称地用后继替换
+	4. 两边都只有 t-1 条: 合并后在合并的子节点中继续
+	不在当前节点时, 先补足要进入的子节点 (btree_fill) 再下降
+*/
+static int btree_delete_key(btree *T, const void *key) {
+	btree_node *x = T->root;
+
+	while (1) {
+		int idx = btree_bin_search(T, x, key);
+
+		if (idx < x->num && btree_compare(T, btree_record(T, x, idx), key) == 0) {
+			if (x->leaf) {
+				btree_move_records(T, x, idx, x, idx + 1, x->num - idx - 1);
+				x->num -= 1;
+				return BTREE_OK;
+			}
+			btree_node *left = btree_childrens(x)[idx];
+			btree_node *right = btree_childrens(x)[idx + 1];
+			if (left->num >= T->t) {
+				btree_node *leaf = btree_descend_filled(T, left, 1);
+				memcpy(btree_record(T, x, idx), btree_record(T, leaf, leaf->num - 1), T->record_size);
+				leaf->num -= 1;
+				return BTREE_OK;
+			}
+			if (right->num >= T->t) {
+				btree_node *leaf = btree_descend_filled(T, right, 0);
+				memcpy(btree_record(T, x, idx), btree_record(T, leaf, 0), T->record_size);
+				btree_move_records(T, leaf, 0, leaf, 1, leaf->num - 1);
+				leaf->num -= 1;
+				return BTREE_OK;
 			}
+			btree_merge(T, x, idx);
+			x = left;
+			continue;
 		}
 
-		btree_delete_key(T, child, key);
+		if (x->leaf) return BTREE_NOT_FOUND;
+		idx = btree_fill(T, x, idx);
+		x = btree_childrens(x)[idx];
 	}
-	
 }
 
+int btree_delete(btree *T, const void *key) {
+	int status = btree_delete_key(T, key);
+	if (status == BTREE_OK) T->count--;
 
-int btree_delete(btree *T, KEY_VALUE key) {
-	if (!T->root) return -1;
-
-	btree_delete_key(T, T->root, key);
-	return 0;
+	// 根节点被合并空时树高减一
+	if (T->root->num == 0 && !T->root->leaf) {
+		btree_node *old = T->root;
+		T->root = btree_childrens(old)[0];
+		btree_destroy_node(old);
+	}
+	return status;
 }
 
+// 遍历
+// 栈中每一层 {node, idx}: 栈顶为当前记录 node[idx]; 祖先的 idx 为下降时进入的子节点,
+// 回到该层时下一条记录就是 node[idx]
+static void btree_iter_push_leftmost(btree_iter *it, const btree_node *x) {
+	while (1) {
+		it->path[it->depth].node = x;
+		it->path[it->depth].idx = 0;
+		it->depth++;
+		if (x->leaf) break;
+		x = btree_childrens(x)[0];
+	}
+}
 
-int main() {
-	btree T = {0};
+// 栈顶已经走完: 向上回到第一个还有记录没访问的祖先
+static void btree_iter_pop_exhausted(btree_iter *it) {
+	it->depth--;
+	while (it->depth > 0 && it->path[it->depth - 1].idx == it->path[it->depth - 1].node->num)
+		it->depth--;
+}
 
-	btree_create(&T, 3);
-	srand(48);
+void btree_iter_first(const btree *T, btree_iter *it) {
+	it->tree = T;
+	it->depth = 0;
+	if (T->root->num == 0) return;
+	btree_iter_push_leftmost(it, T->root);
+}
 
-	int i = 0;
-	char key[26] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-	for (i = 0;i < 26;i ++) {
-		//key[i] = rand() % 1000;
-		printf("%c ", key[i]);
-		btree_insert(&T, key[i]);
+void btree_iter_seek(const btree *T, btree_iter *it, const void *key) {
+	const btree_node *x = T->root;
+	it->tree = T;
+	it->depth = 0;
+
+	while (1) {
+		int i = btree_bin_search(T, x, key);
+		it->path[it->depth].node = x;
+		it->path[it->depth].idx = i;
+		it->depth++;
+		if (x->leaf) break;
+		x = btree_childrens(x)[i];
 	}
+	// 叶子中的记录都小于 key: 下一条记录在祖先中
+	if (it->path[it->depth - 1].idx == x->num) btree_iter_pop_exhausted(it);
+}
+
+const void *btree_iter_next(btree_iter *it) {
+	if (it->depth == 0) return NULL;
 
-	btree_print(&T, T.root, 0);
+	const btree_node *x = it->path[it->depth - 1].node;
+	int idx = it->path[it->depth - 1].idx;
+	const void *record = btree_record(it->tree, x, idx);
 
-	for (i = 0;i < 26;i ++) {
-		printf("\n---------------------------------\n");
-		btree_delete(&T, key[25-i]);
-		//btree_traverse(T.root);
-		btree_print(&T, T.root, 0);
+	if (!x->leaf) {
+		// 下一条是右侧子树 childrens[idx+1] 的最左记录
+		it->path[it->depth - 1].idx = idx + 1;
+		btree_iter_push_leftmost(it, btree_childrens(x)[idx + 1]);
+	} else if (++it->path[it->depth - 1].idx == x->num) {
+		btree_iter_pop_exhausted(it);
 	}
-	
+	return record;
 }
 
+size_t btree_range(const btree *T, const void *lo, const void *hi, btree_visit_fn visit, void *ctx) {
+	btree_iter it;
+	const void *record;
+	size_t visited = 0;
 
-
-
+	btree_iter_seek(T, &it, lo);
+	while ((record = btree_iter_next(&it)) != NULL && btree_compare(T, record, hi) <= 0) {
+		visited++;
+		if (!visit(record, ctx)) break;
+	}
+	return visited;
+}
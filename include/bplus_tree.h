@@ -0,0 +1,716 @@
+#pragma once
+#include "btree.h"
+
+namespace btree_detail {
+
+// B+树的公共实现: 所有记录都在叶子中, 叶子通过 prev/next 串成双向链表;
+// 内部节点只存放路由键(separator), 不存放记录
+/*
+                [30 | 60]                    内部节点: 路由键
+               /    |    \
+     [10 20] <-> [30 40 50] <-> [60 70]      叶子: 记录 + 兄弟指针
+
+child[i] 中的键 k 满足 sep[i-1] <= k < sep[i]
+范围扫描只需一次下降找到起点叶子, 之后沿 next 指针顺序访问叶子, 不再回到根节点
+*/
+//
+// 节点布局(一次分配):
+//   叶子:     [Node头 | keys[2t-1] | values[2t-1]]
+//   内部节点: [Node头 | keys[2t-1] | children[2t]]
+// 键唯一; 插入时自顶向下预先分裂满节点, 删除时自顶向下预先补足(借键或合并)
+template <typename K, typename V, typename Compare, typename Allocator>
+class BPlusTreeBase {
+public:
+    struct Node {
+        int n;                            // 当前键数量
+        bool leaf;                        // 是否为叶子节点
+        Node* prev;                       // 前一个叶子 (仅叶子使用)
+        Node* next;                       // 后一个叶子 (仅叶子使用)
+
+        explicit Node(bool leaf) : n(0), leaf(leaf), prev(nullptr), next(nullptr) {}
+
+        static constexpr std::size_t keys_offset() {
+            return (sizeof(Node) + alignof(K) - 1) / alignof(K) * alignof(K);
+        }
+
+        K* keys() {
+            return reinterpret_cast<K*>(reinterpret_cast<char*>(this) + keys_offset());
+        }
+        const K* keys() const {
+            return reinterpret_cast<const K*>(reinterpret_cast<const char*>(this) + keys_offset());
+        }
+
+        int num_keys() const { return n; }
+        bool is_leaf() const { return leaf; }
+        const K& key(int i) const { return keys()[i]; }
+    };
+
+protected:
+    static constexpr bool kHasValues = !std::is_void_v<V>;
+    using value_storage = std::conditional_t<kHasValues, V, char>;
+
+    static_assert(alignof(K) <= alignof(std::max_align_t), "over-aligned key types are not supported");
+    static_assert(alignof(value_storage) <= alignof(std::max_align_t), "over-aligned value types are not supported");
+
+    Node* root;                  // 根节点
+    Node* head;                  // 最左叶子
+    Node* tail;                  // 最右叶子
+    int t;                       // 最小度数(minimum degree)
+    std::size_t count;           // 记录总数
+    std::size_t values_offset;   // 叶子中值数组的偏移
+    std::size_t children_offset; // 内部节点中子节点指针数组的偏移
+    std::size_t leaf_bytes;      // 叶子节点的分配大小
+    std::size_t internal_bytes;  // 内部节点的分配大小
+    Compare comp;                // 键比较器
+    Allocator alloc;             // 节点分配器
+
+    static std::size_t align_up(std::size_t offset, std::size_t align) {
+        return (offset + align - 1) / align * align;
+    }
+
+    void init_layout() {
+        std::size_t keys_end = Node::keys_offset() + (2 * t - 1) * sizeof(K);
+        values_offset = align_up(keys_end, alignof(value_storage));
+        leaf_bytes = kHasValues ? values_offset + (2 * t - 1) * sizeof(value_storage) : keys_end;
+        children_offset = align_up(keys_end, alignof(Node*));
+        internal_bytes = children_offset + 2 * t * sizeof(Node*);
+    }
+
+    static K* keys(Node* node) { return node->keys(); }
+
+    value_storage* values(Node* leaf) const {
+        return reinterpret_cast<value_storage*>(reinterpret_cast<char*>(leaf) + values_offset);
+    }
+    Node** children(Node* node) const {
+        return reinterpret_cast<Node**>(reinterpret_cast<char*>(node) + children_offset);
+    }
+    Node* const* children(const Node* node) const {
+        return reinterpret_cast<Node* const*>(reinterpret_cast<const char*>(node) + children_offset);
+    }
+
+    int lower_bound_in(const Node* node, const K& key) const {
+        return btree_search::node_lower_bound(node->keys(), node->n, key, comp);
+    }
+    int upper_bound_in(const Node* node, const K& key) const {
+        return btree_search::node_upper_bound(node->keys(), node->n, key, comp);
+    }
+
+    Node* create_node(bool leaf) {
+        void* mem = alloc.allocate(leaf ? leaf_bytes : internal_bytes);
+        return new (mem) Node(leaf);
+    }
+
+    void destroy_node(Node* node) {
+        bool leaf = node->leaf;
+        std::destroy_n(node->keys(), node->n);
+        if constexpr (kHasValues) {
+            if (leaf)
+                std::destroy_n(values(node), node->n);
+        }
+        node->~Node();
+        alloc.deallocate(node, leaf ? leaf_bytes : internal_bytes);
+    }
+
+    void destroy_subtree(Node* node) {
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++)
+                destroy_subtree(children(node)[i]);
+        }
+        destroy_node(node);
+    }
+
+    void destroy_tree() {
+        if constexpr (!(Allocator::bulk_release && std::is_trivially_destructible_v<K> &&
+                        std::is_trivially_destructible_v<value_storage>)) {
+            if (root)
+                destroy_subtree(root);
+        }
+        root = head = tail = nullptr;
+        count = 0;
+    }
+
+    void reset_root() {
+        root = head = tail = create_node(true);
+    }
+
+    // ---- 叶子记录操作 ----
+
+    // 值的构造可能抛出异常时先构造到局部变量 (同 BTreeBase::insert_slot)
+    template <typename KArg, typename... VArgs>
+    void leaf_insert(Node* leaf, int idx, KArg&& key, VArgs&&... value_args) {
+        if constexpr (kHasValues && !std::is_nothrow_constructible_v<value_storage, VArgs&&...>) {
+            value_storage value(std::forward<VArgs>(value_args)...);
+            array_insert(keys(leaf), leaf->n, idx, std::forward<KArg>(key));
+            array_insert(values(leaf), leaf->n, idx, std::move(value));
+        } else {
+            array_insert(keys(leaf), leaf->n, idx, std::forward<KArg>(key));
+            if constexpr (kHasValues) {
+                array_insert(values(leaf), leaf->n, idx, std::forward<VArgs>(value_args)...);
+            }
+        }
+        leaf->n++;
+    }
+
+    void leaf_erase(Node* leaf, int idx) {
+        array_erase(keys(leaf), leaf->n, idx);
+        if constexpr (kHasValues) {
+            array_erase(values(leaf), leaf->n, idx);
+        }
+        leaf->n--;
+    }
+
+    // 把 src[from, from+len) 的记录移动构造到 dst 未初始化的 [to, to+len), 并析构源记录
+    void leaf_move(Node* dst, int to, Node* src, int from, int len) {
+        std::uninitialized_move_n(keys(src) + from, len, keys(dst) + to);
+        std::destroy_n(keys(src) + from, len);
+        if constexpr (kHasValues) {
+            std::uninitialized_move_n(values(src) + from, len, values(dst) + to);
+            std::destroy_n(values(src) + from, len);
+        }
+    }
+
+    // 在叶子链表中把 right 接到 left 之后
+    void link_after(Node* left, Node* right) {
+        right->prev = left;
+        right->next = left->next;
+        if (left->next)
+            left->next->prev = right;
+        else
+            tail = right;
+        left->next = right;
+    }
+
+    // 从叶子链表中摘除 right (right 是 left 的后继)
+    void unlink_after(Node* left, Node* right) {
+        left->next = right->next;
+        if (right->next)
+            right->next->prev = left;
+        else
+            tail = left;
+    }
+
+    // ---- 内部节点操作 ----
+
+    void insert_child(Node* node, int idx, Node* child) {
+        Node** c = children(node);
+        std::memmove(c + idx + 1, c + idx, (node->n + 1 - idx) * sizeof(Node*));
+        c[idx] = child;
+    }
+
+    void erase_child(Node* node, int idx) {
+        Node** c = children(node);
+        std::memmove(c + idx, c + idx + 1, (node->n - idx) * sizeof(Node*));
+    }
+
+    // 分裂满子节点
+    /*
+    叶子(t=3):    [A B C D E]  ->  [A B C] <-> [D E],   路由键 D (复制一份上移)
+    内部节点:     [A B C D E]  ->  [A B]  C  [D E],     C 上移
+    */
+    void split_child(Node* parent, int index) {
+        Node* child = children(parent)[index];
+        Node* right = create_node(child->leaf);
+
+        if (child->leaf) {
+            leaf_move(right, 0, child, t, t - 1);
+            right->n = t - 1;
+            child->n = t;
+            link_after(child, right);
+
+            insert_child(parent, index + 1, right);
+            array_insert(keys(parent), parent->n, index, keys(right)[0]);
+            parent->n++;
+        } else {
+            std::uninitialized_move_n(keys(child) + t, t - 1, keys(right));
+            std::memcpy(children(right), children(child) + t, t * sizeof(Node*));
+            right->n = t - 1;
+
+            insert_child(parent, index + 1, right);
+            array_insert(keys(parent), parent->n, index, std::move(keys(child)[t - 1]));
+            parent->n++;
+
+            std::destroy_n(keys(child) + t - 1, t);
+            child->n = t - 1;
+        }
+    }
+
+    // 唯一键插入: 一次自顶向下的下降, 沿途预先分裂满节点
+    // 返回 {叶子, 下标, 是否插入}
+    struct LeafSlot {
+        Node* leaf;
+        int idx;
+    };
+
+    template <typename KArg, typename... VArgs>
+    std::pair<LeafSlot, bool> insert_unique(KArg&& key, VArgs&&... value_args) {
+        if (!root)
+            reset_root();
+        if (root->n == 2 * t - 1) {
+            Node* new_root = create_node(false);
+            children(new_root)[0] = root;
+            root = new_root;
+            split_child(root, 0);
+        }
+
+        Node* node = root;
+        while (!node->leaf) {
+            int i = upper_bound_in(node, key);
+            if (children(node)[i]->n == 2 * t - 1) {
+                split_child(node, i);
+                if (!comp(key, keys(node)[i]))
+                    i++;
+            }
+            node = children(node)[i];
+        }
+
+        int i = lower_bound_in(node, key);
+        if (i < node->n && !comp(key, keys(node)[i]))
+            return {LeafSlot{node, i}, false};
+        leaf_insert(node, i, std::forward<KArg>(key), std::forward<VArgs>(value_args)...);
+        count++;
+        return {LeafSlot{node, i}, true};
+    }
+
+    LeafSlot find_leaf_slot(const K& key) const {
+        Node* node = root;
+        if (!node)
+            return LeafSlot{nullptr, 0};
+        while (!node->leaf)
+            node = children(node)[upper_bound_in(node, key)];
+        int i = lower_bound_in(node, key);
+        if (i < node->n && !comp(key, keys(node)[i]))
+            return LeafSlot{node, i};
+        return LeafSlot{nullptr, 0};
+    }
+
+    void borrow_from_prev(Node* parent, int idx) {
+        Node* child = children(parent)[idx];
+        Node* sibling = children(parent)[idx - 1];
+        K* sep = keys(parent);
+
+        if (child->leaf) {
+            int last = sibling->n - 1;
+            if constexpr (kHasValues) {
+                leaf_insert(child, 0, std::move(keys(sibling)[last]), std::move(values(sibling)[last]));
+            } else {
+                leaf_insert(child, 0, std::move(keys(sibling)[last]));
+            }
+            leaf_erase(sibling, last);
+            sep[idx - 1] = keys(child)[0];
+        } else {
+            insert_child(child, 0, children(sibling)[sibling->n]);
+            array_insert(keys(child), child->n, 0, std::move(sep[idx - 1]));
+            child->n++;
+            sep[idx - 1] = std::move(keys(sibling)[sibling->n - 1]);
+            std::destroy_at(keys(sibling) + sibling->n - 1);
+            sibling->n--;
+        }
+    }
+
+    void borrow_from_next(Node* parent, int idx) {
+        Node* child = children(parent)[idx];
+        Node* sibling = children(parent)[idx + 1];
+        K* sep = keys(parent);
+
+        if (child->leaf) {
+            if constexpr (kHasValues) {
+                leaf_insert(child, child->n, std::move(keys(sibling)[0]), std::move(values(sibling)[0]));
+            } else {
+                leaf_insert(child, child->n, std::move(keys(sibling)[0]));
+            }
+            leaf_erase(sibling, 0);
+            sep[idx] = keys(sibling)[0];
+        } else {
+            children(child)[child->n + 1] = children(sibling)[0];
+            array_insert(keys(child), child->n, child->n, std::move(sep[idx]));
+            child->n++;
+            sep[idx] = std::move(keys(sibling)[0]);
+            erase_child(sibling, 0);
+            array_erase(keys(sibling), sibling->n, 0);
+            sibling->n--;
+        }
+    }
+
+    // 合并 children[idx] 与 children[idx+1]
+    void merge(Node* parent, int idx) {
+        Node* child = children(parent)[idx];
+        Node* sibling = children(parent)[idx + 1];
+
+        if (child->leaf) {
+            leaf_move(child, child->n, sibling, 0, sibling->n);
+            child->n += sibling->n;
+            sibling->n = 0;
+            unlink_after(child, sibling);
+        } else {
+            new (keys(child) + child->n) K(std::move(keys(parent)[idx]));
+            std::uninitialized_move_n(keys(sibling), sibling->n, keys(child) + child->n + 1);
+            std::memcpy(children(child) + child->n + 1, children(sibling), (sibling->n + 1) * sizeof(Node*));
+            child->n += sibling->n + 1;
+        }
+
+        erase_child(parent, idx + 1);
+        array_erase(keys(parent), parent->n, idx);
+        parent->n--;
+
+        destroy_node(sibling);
+    }
+
+    // 保证 children[idx] 至少有 t 个键, 返回之后应当下降的子节点下标
+    int fill(Node* parent, int idx) {
+        Node** c = children(parent);
+        if (idx != 0 && c[idx - 1]->n >= t) {
+            borrow_from_prev(parent, idx);
+        } else if (idx != parent->n && c[idx + 1]->n >= t) {
+            borrow_from_next(parent, idx);
+        } else if (idx != parent->n) {
+            merge(parent, idx);
+        } else {
+            merge(parent, idx - 1);
+            idx--;
+        }
+        return idx;
+    }
+
+    bool erase_key(const K& key) {
+        if (!root)
+            return false;
+
+        Node* node = root;
+        while (!node->leaf) {
+            int i = upper_bound_in(node, key);
+            if (children(node)[i]->n < t)
+                i = fill(node, i);
+            node = children(node)[i];
+        }
+
+        bool removed = false;
+        int i = lower_bound_in(node, key);
+        if (i < node->n && !comp(key, keys(node)[i])) {
+            leaf_erase(node, i);
+            count--;
+            removed = true;
+        }
+
+        // 根节点为空时收缩树高 (预先补足保证每次最多收缩一层)
+        if (!root->leaf && root->n == 0) {
+            Node* old_root = root;
+            root = children(root)[0];
+            destroy_node(old_root);
+        }
+        return removed;
+    }
+
+    BPlusTreeBase(int min_degree, Compare compare, Allocator allocator)
+        : root(nullptr), head(nullptr), tail(nullptr), t(min_degree), count(0),
+          comp(std::move(compare)), alloc(std::move(allocator)) {
+        if (min_degree < 2) {
+            throw std::invalid_argument("Minimum degree must be at least 2");
+        }
+        init_layout();
+        reset_root();
+    }
+
+    BPlusTreeBase(BPlusTreeBase&& other) noexcept
+        : root(other.root), head(other.head), tail(other.tail), t(other.t), count(other.count),
+          values_offset(other.values_offset), children_offset(other.children_offset),
+          leaf_bytes(other.leaf_bytes), internal_bytes(other.internal_bytes),
+          comp(std::move(other.comp)), alloc(std::move(other.alloc)) {
+        other.root = other.head = other.tail = nullptr;
+        other.count = 0;
+    }
+
+    BPlusTreeBase& operator=(BPlusTreeBase&& other) noexcept {
+        if (this != &other) {
+            destroy_tree();
+            root = other.root;
+            head = other.head;
+            tail = other.tail;
+            t = other.t;
+            count = other.count;
+            values_offset = other.values_offset;
+            children_offset = other.children_offset;
+            leaf_bytes = other.leaf_bytes;
+            internal_bytes = other.internal_bytes;
+            comp = std::move(other.comp);
+            alloc = std::move(other.alloc);
+            other.root = other.head = other.tail = nullptr;
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    ~BPlusTreeBase() {
+        destroy_tree();
+    }
+
+public:
+    // 双向迭代器: {叶子, 下标}, 沿叶子链表移动; leaf == nullptr 表示 end()
+    // 任何插入/删除之后, 已有的迭代器全部失效
+    template <bool Const>
+    class basic_iterator {
+        friend class BPlusTreeBase;
+        template <bool> friend class basic_iterator;
+        using tree_pointer = std::conditional_t<Const, const BPlusTreeBase*, BPlusTreeBase*>;
+        using value_reference = std::conditional_t<Const, const value_storage&, value_storage&>;
+
+        tree_pointer tree = nullptr;
+        Node* leaf = nullptr;
+        int idx = 0;
+
+        basic_iterator(tree_pointer tree, Node* leaf, int idx) : tree(tree), leaf(leaf), idx(idx) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::conditional_t<kHasValues, std::pair<const K, value_storage>, K>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<kHasValues, std::pair<const K&, value_reference>, const K&>;
+        using pointer = void;
+
+        basic_iterator() = default;
+
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other)
+            : tree(other.tree), leaf(other.leaf), idx(other.idx) {}
+
+        const K& key() const { return leaf->keys()[idx]; }
+
+        value_reference value() const {
+            static_assert(kHasValues, "value() is only available on maps");
+            return tree->values(leaf)[idx];
+        }
+
+        reference operator*() const {
+            if constexpr (kHasValues) {
+                return reference(key(), value());
+            } else {
+                return key();
+            }
+        }
+
+        basic_iterator& operator++() {
+            if (++idx == leaf->n) {
+                leaf = leaf->next;
+                idx = 0;
+            }
+            return *this;
+        }
+
+        basic_iterator& operator--() {
+            if (!leaf) {
+                leaf = tree->tail;
+                idx = leaf->n - 1;
+            } else if (idx > 0) {
+                idx--;
+            } else {
+                leaf = leaf->prev;
+                idx = leaf->n - 1;
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        basic_iterator operator--(int) {
+            basic_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) {
+            return a.leaf == b.leaf && a.idx == b.idx;
+        }
+
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) {
+            return !(a == b);
+        }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+protected:
+    template <typename It, typename Tree>
+    static It bound(Tree* tree, const K& key, bool upper) {
+        Node* node = tree->root;
+        if (!node)
+            return It(tree, nullptr, 0);
+        while (!node->leaf)
+            node = tree->children(node)[tree->upper_bound_in(node, key)];
+        int i = upper ? tree->upper_bound_in(node, key) : tree->lower_bound_in(node, key);
+        if (i == node->n)
+            return It(tree, node->next, 0);
+        return It(tree, node, i);
+    }
+
+    template <typename It, typename Tree>
+    static It first(Tree* tree) {
+        return It(tree, tree->count ? tree->head : nullptr, 0);
+    }
+
+    template <typename F, typename... Args>
+    static bool invoke_scan(F& fn, Args&&... args) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, Args...>, bool>) {
+            return fn(std::forward<Args>(args)...);
+        } else {
+            fn(std::forward<Args>(args)...);
+            return true;
+        }
+    }
+
+    // 一次下降定位起点, 之后按叶子顺序扫描, 每个叶子内连续访问
+    template <typename It, typename Tree, typename F>
+    static void scan_range(Tree* tree, const K& lo, const K& hi, F& fn) {
+        It it = bound<It>(tree, lo, false);
+        for (Node* leaf = it.leaf; leaf; leaf = leaf->next) {
+            const K* k = leaf->keys();
+            for (int i = (leaf == it.leaf ? it.idx : 0); i < leaf->n; i++) {
+                if (tree->comp(hi, k[i]))
+                    return;
+                bool go_on;
+                if constexpr (kHasValues) {
+                    go_on = invoke_scan(fn, k[i], tree->values(leaf)[i]);
+                } else {
+                    go_on = invoke_scan(fn, k[i]);
+                }
+                if (!go_on)
+                    return;
+            }
+        }
+    }
+
+public:
+    BPlusTreeBase(const BPlusTreeBase&) = delete;
+    BPlusTreeBase& operator=(const BPlusTreeBase&) = delete;
+
+    iterator begin() { return first<iterator>(this); }
+    iterator end() { return iterator(this, nullptr, 0); }
+    const_iterator begin() const { return first<const_iterator>(this); }
+    const_iterator end() const { return const_iterator(this, nullptr, 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // 第一个 >= key 的位置
+    iterator lower_bound(const K& key) { return bound<iterator>(this, key, false); }
+    const_iterator lower_bound(const K& key) const { return bound<const_iterator>(this, key, false); }
+
+    // 第一个 > key 的位置
+    iterator upper_bound(const K& key) { return bound<iterator>(this, key, true); }
+    const_iterator upper_bound(const K& key) const { return bound<const_iterator>(this, key, true); }
+
+    // 按顺序访问闭区间 [lo, hi] 内的所有记录, O(log n + k)
+    // 集合: fn(const K&); 映射: fn(const K&, V&)。fn 返回 bool 时, 返回 false 提前结束
+    template <typename F>
+    void scan(const K& lo, const K& hi, F&& fn) {
+        scan_range<iterator>(this, lo, hi, fn);
+    }
+    template <typename F>
+    void scan(const K& lo, const K& hi, F&& fn) const {
+        scan_range<const_iterator>(this, lo, hi, fn);
+    }
+
+    bool contains(const K& key) const {
+        return find_leaf_slot(key).leaf != nullptr;
+    }
+
+    const Node* get_root() const { return root; }
+    const Allocator& get_allocator() const { return alloc; }
+    const Compare& key_comp() const { return comp; }
+    int get_min_degree() const { return t; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+} // namespace btree_detail
+
+// 只存储键的B+树, 键唯一
+template <typename T, typename Compare = std::less<T>, typename Allocator = NodeArena>
+class BPlusTree : public btree_detail::BPlusTreeBase<T, void, Compare, Allocator> {
+    using Base = btree_detail::BPlusTreeBase<T, void, Compare, Allocator>;
+
+public:
+    BPlusTree(int min_degree, Compare compare = Compare(), Allocator allocator = Allocator())
+        : Base(min_degree, std::move(compare), std::move(allocator)) {}
+
+    BPlusTree(int min_degree, Allocator allocator)
+        : Base(min_degree, Compare(), std::move(allocator)) {}
+
+    BPlusTree(BPlusTree&&) noexcept = default;
+    BPlusTree& operator=(BPlusTree&&) noexcept = default;
+
+    // 插入键, 已存在时返回 false
+    bool insert(const T& key) {
+        return this->insert_unique(key).second;
+    }
+
+    std::optional<T> search(const T& key) const {
+        auto slot = this->find_leaf_slot(key);
+        if (!slot.leaf)
+            return std::nullopt;
+        return slot.leaf->key(slot.idx);
+    }
+
+    bool erase(const T& key) {
+        return this->erase_key(key);
+    }
+};
+
+// 键 -> 值 的B+树, 接口与 BTreeMap 一致
+template <typename K, typename V, typename Compare = std::less<K>, typename Allocator = NodeArena>
+class BPlusTreeMap : public btree_detail::BPlusTreeBase<K, V, Compare, Allocator> {
+    using Base = btree_detail::BPlusTreeBase<K, V, Compare, Allocator>;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+
+    BPlusTreeMap(int min_degree, Compare compare = Compare(), Allocator allocator = Allocator())
+        : Base(min_degree, std::move(compare), std::move(allocator)) {}
+
+    BPlusTreeMap(int min_degree, Allocator allocator)
+        : Base(min_degree, Compare(), std::move(allocator)) {}
+
+    BPlusTreeMap(BPlusTreeMap&&) noexcept = default;
+    BPlusTreeMap& operator=(BPlusTreeMap&&) noexcept = default;
+
+    V* find(const K& key) {
+        auto slot = this->find_leaf_slot(key);
+        return slot.leaf ? &this->values(slot.leaf)[slot.idx] : nullptr;
+    }
+
+    const V* find(const K& key) const {
+        auto slot = this->find_leaf_slot(key);
+        return slot.leaf ? &this->values(slot.leaf)[slot.idx] : nullptr;
+    }
+
+    template <typename... Args>
+    std::pair<V*, bool> try_emplace(const K& key, Args&&... args) {
+        auto [slot, inserted] = this->insert_unique(key, std::forward<Args>(args)...);
+        return {&this->values(slot.leaf)[slot.idx], inserted};
+    }
+
+    template <typename M>
+    std::pair<V*, bool> insert_or_assign(const K& key, M&& value) {
+        auto [slot, inserted] = this->insert_unique(key, std::forward<M>(value));
+        V* v = &this->values(slot.leaf)[slot.idx];
+        if (!inserted) {
+            *v = std::forward<M>(value);
+        }
+        return {v, inserted};
+    }
+
+    template <typename F>
+    V& upsert(const K& key, F&& fn) {
+        auto [slot, inserted] = this->insert_unique(key);
+        V& v = this->values(slot.leaf)[slot.idx];
+        std::forward<F>(fn)(v);
+        return v;
+    }
+
+    bool erase(const K& key) {
+        return this->erase_key(key);
+    }
+};
@@ -3,31 +3,583 @@
 #include <memory>
 #include <optional>
 #include <algorithm>
+#include <atomic>
 #include <stdexcept> // Added this line
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <type_traits>
+#include "node_arena.h"
+#include "btree_search.h"
+#include "btree_stats.h"
+#include "static_index.h"
 
+// 节点增强策略 (BTree/BTreeMap 的 Augment 参数)
+//   NoAugment:       不维护额外信息 (默认), 节点布局与各操作的代码都不变
+//   OrderStatistic:  内部节点为每个子节点记录子树中的键数, 支持 rank/select/count_range, O(t log n)
+//   幺半群 (monoid): 在子树键数之外, 再为每个子节点缓存子树的聚合值, 支持 reduce(lo, hi), O(t log n)
+/*
+              [30          60]           counts = [3, 2, 3]
+             /       |       \
+      [10 20 25]  [40 50]  [70 80 90]
+  rank(55): 根中 < 55 的键 2 个 + 前两个子树 3+2, 再在 [40 50] 中 < 55 的 2 个 = 9
+*/
+// 幺半群策略的接口 (见下面的 SumOf/MinOf/MaxOf):
+//   using value_type                             聚合值类型, 需要可平凡复制
+//   static value_type identity()                 单位元
+//   static value_type combine(a, b)              结合律; 按键的顺序组合, 不要求交换律
+//   static value_type lift(const K&)             集合 (BTree) 中一个键的聚合值
+//   static value_type lift(const K&, const V&)   映射 (BTreeMap) 中一个键值对的聚合值
+struct NoAugment {};
+struct OrderStatistic {};
+
+// 键 (集合) 或值 (映射) 的和
 template <typename T>
-class BTree {
-private:
+struct SumOf {
+    using value_type = T;
+    static T identity() { return T{}; }
+    static T combine(const T& a, const T& b) { return a + b; }
+    template <typename K>
+    static T lift(const K& key) { return static_cast<T>(key); }
+    template <typename K, typename V>
+    static T lift(const K&, const V& value) { return static_cast<T>(value); }
+};
+
+// 键 (集合) 或值 (映射) 的最小值, 空区间为 numeric_limits<T>::max()
+template <typename T>
+struct MinOf {
+    using value_type = T;
+    static T identity() { return std::numeric_limits<T>::max(); }
+    static T combine(const T& a, const T& b) { return b < a ? b : a; }
+    template <typename K>
+    static T lift(const K& key) { return static_cast<T>(key); }
+    template <typename K, typename V>
+    static T lift(const K&, const V& value) { return static_cast<T>(value); }
+};
+
+// 键 (集合) 或值 (映射) 的最大值, 空区间为 numeric_limits<T>::lowest()
+template <typename T>
+struct MaxOf {
+    using value_type = T;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    static T combine(const T& a, const T& b) { return a < b ? b : a; }
+    template <typename K>
+    static T lift(const K& key) { return static_cast<T>(key); }
+    template <typename K, typename V>
+    static T lift(const K&, const V& value) { return static_cast<T>(value); }
+};
+
+namespace btree_detail {
+
+// Augment 是否为幺半群策略 (有 value_type)
+template <typename Augment, typename = void>
+struct augment_traits {
+    static constexpr bool aggregated = false;
+    using value_type = char;
+};
+
+template <typename Augment>
+struct augment_traits<Augment, std::void_t<typename Augment::value_type>> {
+    static constexpr bool aggregated = true;
+    using value_type = typename Augment::value_type;
+};
+
+// 最小度数 t: Degree > 0 时是编译期常量 (2t-1、t-1 等边界和节点布局都在编译期确定),
+// Degree == 0 时为构造时给定的 int。两者都可以隐式转换为 int, 树的代码不区分
+template <int Degree>
+struct MinDegree {
+    static_assert(Degree >= 2, "Minimum degree must be at least 2");
+    explicit MinDegree(int) {}
+    constexpr operator int() const { return Degree; }
+};
+
+template <>
+struct MinDegree<0> {
+    int value;
+    explicit MinDegree(int t) : value(t) {}
+    operator int() const { return value; }
+};
+
+// 分配器是否有 fork() (见 node_arena.h), 有时并行构建可以在多个线程上分配节点
+template <typename A, typename = void>
+struct has_fork : std::false_type {};
+
+template <typename A>
+struct has_fork<A, std::void_t<decltype(std::declval<const A&>().fork())>> : std::true_type {};
+
+// 并行排序: 分成 threads 段各自 std::sort, 再逐轮两两归并 (每轮的各次归并并行)
+template <typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp, unsigned threads) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    if (threads <= 1 || n < (std::size_t(1) << 16)) {
+        std::sort(first, last, comp);
+        return;
+    }
+    std::vector<std::size_t> bounds(threads + 1);
+    for (unsigned i = 0; i <= threads; i++)
+        bounds[i] = n * i / threads;
+
+    auto run = [](std::size_t tasks, auto&& task) {
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(tasks);
+        for (std::size_t i = 0; i < tasks; i++) {
+            workers.emplace_back([&, i] {
+                try {
+                    task(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        for (std::exception_ptr& e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+    };
+
+    run(threads, [&](std::size_t i) { std::sort(first + bounds[i], first + bounds[i + 1], comp); });
+    for (std::size_t width = 1; width < threads; width *= 2) {
+        std::size_t pairs = (threads + 2 * width - 1) / (2 * width);
+        run(pairs, [&](std::size_t p) {
+            std::size_t lo = p * 2 * width;
+            std::size_t mid = std::min<std::size_t>(lo + width, threads);
+            std::size_t hi = std::min<std::size_t>(lo + 2 * width, threads);
+            if (mid < hi)
+                std::inplace_merge(first + bounds[lo], first + bounds[mid], first + bounds[hi], comp);
+        });
+    }
+}
+
+// 冻结格式的写入, 定义在 frozen_btree.h
+template <typename T, typename Compare>
+struct FrozenWriter;
+
+// 键数组的插入/删除辅助函数: 只对 [0, n) 范围内已构造的元素做移动
+// 新元素在移动数组之前构造, 构造抛出异常时数组保持不变 (移动假定不抛出异常)
+template <typename U, typename... Args>
+void array_insert(U* a, int n, int idx, Args&&... args) {
+    if (idx == n) {
+        new (a + idx) U(std::forward<Args>(args)...);
+        return;
+    }
+    if constexpr (sizeof...(Args) == 1 && (std::is_same_v<Args, U> && ...)) {
+        new (a + n) U(std::move(a[n - 1]));
+        std::move_backward(a + idx, a + n - 1, a + n);
+        a[idx] = (std::forward<Args>(args), ...);
+    } else {
+        array_insert(a, n, idx, U(std::forward<Args>(args)...));
+    }
+}
+
+template <typename U>
+void array_erase(U* a, int n, int idx) {
+    std::move(a + idx + 1, a + n, a + idx);
+    std::destroy_at(a + n - 1);
+}
+
+// B树的公共实现: BTree(只有键) 与 BTreeMap(键 + 值) 共用的分裂/合并/借键逻辑
+//
+// 节点布局(一次分配):
+//   [Node头 | keys[2t-1] | values[2t-1] | children[2t]]
+// 键数组和值数组分开存放, 比较时不会把值带进cache; V 为 void 时没有值数组;
+// 叶子节点不分配children部分。子节点使用裸指针, 由树负责释放。
+// Augment 不是 NoAugment 时, 内部节点在 children 之后还有 counts[2t] (每个子树的键数);
+// 幺半群 Augment 时再跟一个 aggs[2t] (每个子树的聚合值)。
+// Degree > 0 时 t 固定为 Degree, 各数组的偏移和节点大小都是编译期常量; 0 表示构造时给定。
+template <typename K, typename V, typename Compare, typename Allocator, typename Augment = NoAugment, int Degree = 0>
+class BTreeBase {
+public:
     struct Node {
-        std::vector<T> keys;              // 存储键值
-        std::vector<std::shared_ptr<Node>> children; // 存储子节点指针
+        int n;                            // 当前键值数量
         bool leaf;                        // 是否为叶子节点
-        
-        Node(bool leaf = true) : leaf(leaf) {}
+
+        explicit Node(bool leaf = true) : n(0), leaf(leaf) {}
+
+        static constexpr std::size_t keys_offset() {
+            return (sizeof(Node) + alignof(K) - 1) / alignof(K) * alignof(K);
+        }
+
+        K* keys() {
+            return reinterpret_cast<K*>(reinterpret_cast<char*>(this) + keys_offset());
+        }
+        const K* keys() const {
+            return reinterpret_cast<const K*>(reinterpret_cast<const char*>(this) + keys_offset());
+        }
+
+        int num_keys() const { return n; }
+        bool is_leaf() const { return leaf; }
+        const K& key(int i) const { return keys()[i]; }
 
         // 检查节点是否已满(2t-1个键)
         bool is_full(int t) const {
-            return keys.size() == 2 * t - 1;
+            return n == 2 * t - 1;
         }
 
         // 检查节点是否处于最小键值数(t-1个键)
         bool is_minimum(int t) const {
-            return keys.size() == t - 1;
+            return n == t - 1;
+        }
+    };
+
+    // 树高上限: t>=2 时高度为40的树至少需要 2^39 个键
+    static constexpr int kMaxHeight = 40;
+
+protected:
+    static constexpr bool kHasValues = !std::is_void_v<V>;
+    static constexpr bool kCounted = !std::is_same_v<Augment, NoAugment>;
+    static constexpr bool kAggregated = augment_traits<Augment>::aggregated;
+    using value_storage = std::conditional_t<kHasValues, V, char>;
+    using agg_type = typename augment_traits<Augment>::value_type;
+    static constexpr bool kStats = BTREE_STATS != 0;
+
+    static_assert(std::is_trivially_copyable_v<agg_type>, "Augment::value_type must be trivially copyable");
+    static_assert(alignof(agg_type) <= alignof(std::max_align_t), "over-aligned aggregate types are not supported");
+
+    static_assert(alignof(K) <= alignof(std::max_align_t), "over-aligned key types are not supported");
+    static_assert(alignof(value_storage) <= alignof(std::max_align_t), "over-aligned value types are not supported");
+
+    // 节点内某个键(以及对应值)的位置
+    struct Slot {
+        Node* node;
+        int idx;
+    };
+
+    // 插入/删除的下降路径 {内部节点, 进入的子节点下标}, 只在 kCounted 时记录;
+    // 键确实插入/删除之后, add 把路径上每一层的子树计数加上 delta,
+    // kAggregated 时再自底向上重新计算路径上每个子树的聚合值
+    struct CountedPath {
+        Slot frames[kMaxHeight];
+        int depth = 0;
+        void push(Node* node, int idx) { frames[depth++] = Slot{node, idx}; }
+        void add(const BTreeBase* tree, int delta) const {
+            for (int i = 0; i < depth; i++)
+                tree->counts(frames[i].node)[frames[i].idx] += static_cast<std::size_t>(delta);
+            if constexpr (kAggregated) {
+                for (int i = depth - 1; i >= 0; i--)
+                    tree->refresh_agg(frames[i].node, frames[i].idx);
+            }
         }
     };
-    
-    std::shared_ptr<Node> root;  // 根节点
-    int t;                       // 最小度数(minimum degree)
+    struct NoPath {
+        void push(Node*, int) {}
+        void add(const BTreeBase*, int) const {}
+    };
+    using DescentPath = std::conditional_t<kCounted, CountedPath, NoPath>;
+
+    // 事件计数只在 BTREE_STATS 时存在, 否则是一个空结构
+    struct NoStats {};
+    using StatsHolder = std::conditional_t<kStats, std::unique_ptr<StatsCounters>, NoStats>;
+
+    // 节点内各数组的偏移和两种节点的分配大小, 由 t 决定
+    struct Layout {
+        std::size_t values_offset;   // 值数组在节点内的偏移
+        std::size_t children_offset; // 子节点指针数组在节点内的偏移
+        std::size_t counts_offset;   // 子树键数数组在内部节点内的偏移 (kCounted)
+        std::size_t aggs_offset;     // 子树聚合值数组在内部节点内的偏移 (kAggregated)
+        std::size_t leaf_bytes;      // 叶子节点的分配大小
+        std::size_t internal_bytes;  // 内部节点的分配大小
+    };
+
+    // stale_base 尚未数出
+    static constexpr std::size_t kUnknownSize = std::numeric_limits<std::size_t>::max();
+
+    Node* root;                  // 根节点
+    MinDegree<Degree> t;         // 最小度数(minimum degree)
+    std::size_t count;           // 键值总数; count_stale 时为标记之后插入/删除的净变化量 (按 2^64 取模)
+    bool count_stale = false;    // NoAugment 的树拆分/拼接后不知道键数
+    // count_stale 时标记那一刻的键数, 由 size() 第一次调用时数出; 多个线程同时调用 const 的 size()
+    // 时可能各数一遍, 写入的值相同 (只有这个成员在 const 方法中被写入, 所以是原子的)
+    mutable std::atomic<std::size_t> stale_base{kUnknownSize};
+    Layout node_layout;          // 节点布局 (Degree > 0 时不使用, 见 layout())
+    Compare comp;                // 键比较器
+    Allocator alloc;             // 节点分配器
+    StatsHolder stats_counters;  // 事件计数 (BTREE_STATS)
+
+    void record(StatEvent event) const {
+        if constexpr (kStats) {
+            if (stats_counters)
+                stats_counters->add(event);
+        }
+    }
+
+    // 一次查找访问了 visited 个节点, 比较了 compared 次
+    void record_search(uint64_t visited, uint64_t compared) const {
+        if constexpr (kStats) {
+            if (stats_counters) {
+                StatsCounters::Shard* shard = stats_counters->local();
+                shard->add(kStatSearch);
+                shard->add(kStatSearchNode, visited);
+                shard->add(kStatSearchComparison, compared);
+            }
+        }
+    }
+
+    // n 个键中二分查找的比较次数: floor(log2 n) + 1
+    static uint64_t binary_search_comparisons(int n) {
+        return n > 0 ? 32 - __builtin_clz(static_cast<unsigned>(n)) : 0;
+    }
+
+    static constexpr std::size_t align_up(std::size_t offset, std::size_t align) {
+        return (offset + align - 1) / align * align;
+    }
+
+    static constexpr Layout make_layout(std::size_t t) {
+        Layout l{};
+        std::size_t end = Node::keys_offset() + (2 * t - 1) * sizeof(K);
+        if constexpr (kHasValues) {
+            l.values_offset = align_up(end, alignof(V));
+            end = l.values_offset + (2 * t - 1) * sizeof(V);
+        } else {
+            l.values_offset = end;
+        }
+        l.children_offset = align_up(end, alignof(Node*));
+        l.leaf_bytes = end;
+        l.internal_bytes = l.children_offset + 2 * t * sizeof(Node*);
+        l.counts_offset = l.internal_bytes;
+        if constexpr (kCounted) {
+            l.counts_offset = align_up(l.internal_bytes, alignof(std::size_t));
+            l.internal_bytes = l.counts_offset + 2 * t * sizeof(std::size_t);
+        }
+        l.aggs_offset = l.internal_bytes;
+        if constexpr (kAggregated) {
+            l.aggs_offset = align_up(l.internal_bytes, alignof(agg_type));
+            l.internal_bytes = l.aggs_offset + 2 * t * sizeof(agg_type);
+        }
+        return l;
+    }
+
+    // Degree > 0 时返回编译期常量, 访问各数组不需要读取树的成员
+    Layout layout() const {
+        if constexpr (Degree > 0) {
+            constexpr Layout fixed = make_layout(Degree);
+            return fixed;
+        } else {
+            return node_layout;
+        }
+    }
+
+    static K* keys(Node* node) { return node->keys(); }
+    static const K* keys(const Node* node) { return node->keys(); }
+
+    value_storage* values(Node* node) const {
+        return reinterpret_cast<value_storage*>(reinterpret_cast<char*>(node) + layout().values_offset);
+    }
+    const value_storage* values(const Node* node) const {
+        return reinterpret_cast<const value_storage*>(reinterpret_cast<const char*>(node) + layout().values_offset);
+    }
+
+    Node** children(Node* node) const {
+        return reinterpret_cast<Node**>(reinterpret_cast<char*>(node) + layout().children_offset);
+    }
+    Node* const* children(const Node* node) const {
+        return reinterpret_cast<Node* const*>(reinterpret_cast<const char*>(node) + layout().children_offset);
+    }
+
+    // counts(node)[i]: 子树 children[i] 中的键数, 只在内部节点且 kCounted 时存在
+    std::size_t* counts(Node* node) const {
+        return reinterpret_cast<std::size_t*>(reinterpret_cast<char*>(node) + layout().counts_offset);
+    }
+    const std::size_t* counts(const Node* node) const {
+        return reinterpret_cast<const std::size_t*>(reinterpret_cast<const char*>(node) + layout().counts_offset);
+    }
+
+    // 以 node 为根的子树中的键数, O(t)
+    std::size_t subtree_size(const Node* node) const {
+        std::size_t size = node->n;
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++)
+                size += counts(node)[i];
+        }
+        return size;
+    }
+
+    // aggs(node)[i]: 子树 children[i] 的聚合值, 只在内部节点且 kAggregated 时存在
+    agg_type* aggs(Node* node) const {
+        return reinterpret_cast<agg_type*>(reinterpret_cast<char*>(node) + layout().aggs_offset);
+    }
+    const agg_type* aggs(const Node* node) const {
+        return reinterpret_cast<const agg_type*>(reinterpret_cast<const char*>(node) + layout().aggs_offset);
+    }
+
+    agg_type lift_slot(const Node* node, int i) const {
+        if constexpr (kHasValues) {
+            return Augment::lift(keys(node)[i], values(node)[i]);
+        } else {
+            return Augment::lift(keys(node)[i]);
+        }
+    }
+
+    // 以 node 为根的子树的聚合值: 按顺序组合子树和键, O(t)
+    agg_type node_agg(const Node* node) const {
+        agg_type acc = Augment::identity();
+        for (int i = 0; i < node->n; i++) {
+            if (!node->leaf)
+                acc = Augment::combine(acc, aggs(node)[i]);
+            acc = Augment::combine(acc, lift_slot(node, i));
+        }
+        if (!node->leaf)
+            acc = Augment::combine(acc, aggs(node)[node->n]);
+        return acc;
+    }
+
+    // 重新计算 node 中子树 children[idx] 的聚合值
+    void refresh_agg(Node* node, int idx) const {
+        if constexpr (kAggregated) {
+            aggs(node)[idx] = node_agg(children(node)[idx]);
+        }
+    }
+
+    template <typename Key>
+    bool key_equal(const K& a, const Key& b) const {
+        return !comp(a, b) && !comp(b, a);
+    }
+
+    // 查找类操作的 key 可以是 K 以外的类型 (比较器为透明比较器时, 见 BTree::search)
+    template <typename Key>
+    int lower_bound_in(const Node* node, const Key& key) const {
+        return btree_search::node_lower_bound(node->keys(), node->n, key, comp);
+    }
+    template <typename Key>
+    int upper_bound_in(const Node* node, const Key& key) const {
+        return btree_search::node_upper_bound(node->keys(), node->n, key, comp);
+    }
+
+    Node* create_node(bool leaf) {
+        return create_node_in(alloc, leaf);
+    }
+
+    // 从指定的分配器分配节点 (并行构建时每个线程一个分配器)
+    Node* create_node_in(Allocator& a, bool leaf) const {
+        void* mem = a.allocate(leaf ? layout().leaf_bytes : layout().internal_bytes);
+        return new (mem) Node(leaf);
+    }
+
+    // 只释放节点本身(析构其中仍存活的键和值), 不处理子节点
+    void destroy_node(Node* node) {
+        bool leaf = node->leaf;
+        destroy_slots(node, 0, node->n);
+        node->~Node();
+        alloc.deallocate(node, leaf ? layout().leaf_bytes : layout().internal_bytes);
+    }
+
+    void destroy_subtree(Node* node) {
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++)
+                destroy_subtree(children(node)[i]);
+        }
+        destroy_node(node);
+    }
+
+    // 释放整棵树. 分配器支持整体释放且键值无需析构时, 节点随分配器一起回收, 不必逐个遍历
+    void destroy_tree() {
+        if constexpr (!(Allocator::bulk_release && std::is_trivially_destructible_v<K> &&
+                        std::is_trivially_destructible_v<value_storage>)) {
+            if (root)
+                destroy_subtree(root);
+        }
+        root = nullptr;
+        count = 0;
+        count_stale = false;
+    }
+
+    // ---- 槽位(键 + 值)操作 ----
+
+    // 在idx处插入新的键值, 后面的槽位整体右移一位
+    // 值的构造可能抛出异常时先构造到局部变量, 键数组移动之后再放入, 异常时节点保持不变
+    template <typename KArg, typename... VArgs>
+    void insert_slot(Node* node, int idx, KArg&& key, VArgs&&... value_args) {
+        if constexpr (kHasValues && !std::is_nothrow_constructible_v<value_storage, VArgs&&...>) {
+            value_storage value(std::forward<VArgs>(value_args)...);
+            array_insert(keys(node), node->n, idx, std::forward<KArg>(key));
+            array_insert(values(node), node->n, idx, std::move(value));
+        } else {
+            array_insert(keys(node), node->n, idx, std::forward<KArg>(key));
+            if constexpr (kHasValues) {
+                array_insert(values(node), node->n, idx, std::forward<VArgs>(value_args)...);
+            }
+        }
+        node->n++;
+    }
+
+    // 把 src 的槽位移动到 dst 的idx处 (src槽位保留为已移动状态)
+    void insert_slot_from(Node* dst, int idx, Node* src, int src_idx) {
+        if constexpr (kHasValues) {
+            insert_slot(dst, idx, std::move(keys(src)[src_idx]), std::move(values(src)[src_idx]));
+        } else {
+            insert_slot(dst, idx, std::move(keys(src)[src_idx]));
+        }
+    }
+
+    // 删除idx处的槽位, 后面的槽位整体左移一位
+    void erase_slot(Node* node, int idx) {
+        array_erase(keys(node), node->n, idx);
+        if constexpr (kHasValues) {
+            array_erase(values(node), node->n, idx);
+        }
+        node->n--;
+    }
+
+    // 用 src 的槽位覆盖 dst 中已存在的槽位
+    void assign_slot(Node* dst, int idx, Node* src, int src_idx) {
+        keys(dst)[idx] = std::move(keys(src)[src_idx]);
+        if constexpr (kHasValues) {
+            values(dst)[idx] = std::move(values(src)[src_idx]);
+        }
+    }
+
+    // 把 src[from, from+len) 移动构造到 dst 未初始化的 [to, to+len)
+    void move_slots(Node* dst, int to, Node* src, int from, int len) {
+        std::uninitialized_move_n(keys(src) + from, len, keys(dst) + to);
+        if constexpr (kHasValues) {
+            std::uninitialized_move_n(values(src) + from, len, values(dst) + to);
+        }
+    }
+
+    void destroy_slots(Node* node, int from, int len) {
+        std::destroy_n(keys(node) + from, len);
+        if constexpr (kHasValues) {
+            std::destroy_n(values(node) + from, len);
+        }
+    }
+
+    // 在children[idx]处插入子节点指针 (调用时node->n仍为插入键之前的值)
+    // kCounted 时 counts 同样右移, counts[idx] 由调用者设置
+    void insert_child(Node* node, int idx, Node* child) {
+        Node** c = children(node);
+        std::memmove(c + idx + 1, c + idx, (node->n + 1 - idx) * sizeof(Node*));
+        c[idx] = child;
+        if constexpr (kCounted) {
+            std::size_t* cnt = counts(node);
+            std::memmove(cnt + idx + 1, cnt + idx, (node->n + 1 - idx) * sizeof(std::size_t));
+        }
+        if constexpr (kAggregated) {
+            agg_type* agg = aggs(node);
+            std::memmove(agg + idx + 1, agg + idx, (node->n + 1 - idx) * sizeof(agg_type));
+        }
+    }
+
+    // 删除children[idx] (调用时node->n仍为删除键之前的值)
+    void erase_child(Node* node, int idx) {
+        Node** c = children(node);
+        std::memmove(c + idx, c + idx + 1, (node->n - idx) * sizeof(Node*));
+        if constexpr (kCounted) {
+            std::size_t* cnt = counts(node);
+            std::memmove(cnt + idx, cnt + idx + 1, (node->n - idx) * sizeof(std::size_t));
+        }
+        if constexpr (kAggregated) {
+            agg_type* agg = aggs(node);
+            std::memmove(agg + idx, agg + idx + 1, (node->n - idx) * sizeof(agg_type));
+        }
+    }
 
     // 分裂子节点的关键操作
     /*
@@ -36,256 +588,1732 @@ private:
            /     \
         [A B]   [D E]
     */
-    void split_child(std::shared_ptr<Node>& parent, int index) {
+    void split_child(Node* parent, int index) {
         if (!parent) {
             throw std::runtime_error("Null parent in split_child");
         }
+        record(kStatSplit);
 
-        // Make a copy of the child
-        auto child = parent->children[index];
+        Node* child = children(parent)[index];
         if (!child) {
             throw std::runtime_error("Null child in split_child");
         }
 
-        auto new_node = std::make_shared<Node>(child->leaf);
-
-        new_node->keys.reserve(t - 1);
-        if (!child->leaf) {
-            new_node->children.reserve(t);
-        }
+        Node* new_node = create_node(child->leaf);
 
-        // Copy the last (t - 1) keys of child to new_node
-        for (int j = 0; j < t - 1; j++) {
-            new_node->keys.push_back(child->keys[j + t]);
-        }
+        // Move the last (t - 1) keys of child to new_node
+        move_slots(new_node, 0, child, t, t - 1);
+        new_node->n = t - 1;
 
-        // If child is not leaf, copy its last t children to new_node
+        // If child is not leaf, move its last t children to new_node
         if (!child->leaf) {
-            for (int j = 0; j < t; j++) {
-                new_node->children.push_back(child->children[j + t]);
+            std::memcpy(children(new_node), children(child) + t, t * sizeof(Node*));
+            if constexpr (kCounted) {
+                std::memcpy(counts(new_node), counts(child) + t, t * sizeof(std::size_t));
+            }
+            if constexpr (kAggregated) {
+                std::memcpy(aggs(new_node), aggs(child) + t, t * sizeof(agg_type));
             }
         }
 
+        // Insert new key and child into parent
+        insert_child(parent, index + 1, new_node);
+        insert_slot_from(parent, index, child, t - 1);
+
         // Reduce the number of keys in child
-        child->keys.resize(t - 1);
-        if (!child->leaf) {
-            child->children.resize(t);
+        destroy_slots(child, t - 1, t);
+        child->n = t - 1;
+
+        if constexpr (kCounted) {
+            counts(parent)[index] = subtree_size(child);
+            counts(parent)[index + 1] = subtree_size(new_node);
         }
+        refresh_agg(parent, index);
+        refresh_agg(parent, index + 1);
+    }
 
-        // Insert new key and child into parent
-        parent->keys.insert(parent->keys.begin() + index, child->keys[t - 1]);
-        parent->children.insert(parent->children.begin() + index + 1, new_node);
+    // 根节点已满时先分裂根节点, 树高加一
+    void grow_root_if_full() {
+        if (!root) {
+            root = create_node(true);
+        }
+        if (root->n == 2 * t - 1) {
+            record(kStatRootGrow);
+            Node* new_root = create_node(false);
+            children(new_root)[0] = root;
+            root = new_root;
+            split_child(root, 0);
+        }
     }
+
     // 向非满节点插入键值
     /*
     示例: 插入40到节点 [10,20,30,50]
     结果: [10,20,30,40,50]
     */
-    void insert_non_full(std::shared_ptr<Node>& node, const T& key) {
+    // 一次自顶向下的循环, 沿途预先分裂满子节点, 不递归
+    // key 只在叶子中构造槽位时转发一次 (右值时移动), 沿途只用于比较
+    template <typename KArg>
+    void insert_non_full(Node* node, KArg&& key) {
         if (!node) {
             throw std::runtime_error("Null node in insert_non_full");
         }
 
-        int i = static_cast<int>(node->keys.size()) - 1;
-
-        if (node->leaf) {
-            node->keys.reserve(node->keys.size() + 1);
-            while (i >= 0 && key < node->keys[i]) {
-                i--;
+        DescentPath path;
+        while (true) {
+            // 插入到相等键之后: 第一个 > key 的位置
+            int i = upper_bound_in(node, key);
+            if (node->leaf) {
+                insert_slot(node, i, std::forward<KArg>(key));
+                // 允许重复键时一定会插入; 聚合值要在叶子写入之后才能自底向上重算
+                path.add(this, 1);
+                return;
             }
-            node->keys.insert(node->keys.begin() + i + 1, key);
-        } else {
-            while (i >= 0 && key < node->keys[i]) {
-                i--;
+            if (children(node)[i]->n == 2 * t - 1) {
+                split_child(node, i);
+                if (comp(keys(node)[i], key)) {
+                    i++;
+                }
             }
-            i++;
+            path.push(node, i);
+            node = children(node)[i];
+        }
+    }
 
-            if (i >= node->children.size()) {
-                throw std::runtime_error("Invalid child index in insert_non_full");
+    // 唯一键插入: 一次自顶向下的下降, 沿途预先分裂满节点
+    // 键已存在时返回 {已有槽位, false}, 否则在叶子中构造新槽位并返回 {新槽位, true}
+    template <typename KArg, typename... VArgs>
+    std::pair<Slot, bool> insert_unique(KArg&& key, VArgs&&... value_args) {
+        grow_root_if_full();
+        DescentPath path;
+        Node* node = root;
+        while (true) {
+            int i = lower_bound_in(node, key);
+            if (i < node->n && !comp(key, keys(node)[i])) {
+                return {Slot{node, i}, false};
+            }
+            if (node->leaf) {
+                insert_slot(node, i, std::forward<KArg>(key), std::forward<VArgs>(value_args)...);
+                count++;
+                path.add(this, 1);
+                return {Slot{node, i}, true};
+            }
+            if (children(node)[i]->n == 2 * t - 1) {
+                split_child(node, i);
+                // 上移的中位键可能正好是要找的键
+                if (!comp(key, keys(node)[i])) {
+                    if (!comp(keys(node)[i], key)) {
+                        return {Slot{node, i}, false};
+                    }
+                    i++;
+                }
             }
+            path.push(node, i);
+            node = children(node)[i];
+        }
+    }
 
-            if (node->children[i]->keys.size() == 2 * t - 1) {
+    // ---- 批量插入/查找 ----
+
+    // 下降到 key 应插入的叶子, 沿途预先分裂满节点
+    // fence 记录叶子的右边界: 路径上最近的、位于所走子树右侧的键 (最右路径上为 nullptr)。
+    // 比 key 大且小于 fence 的键都属于同一个叶子。
+    // Unique 时在内部节点遇到相等的键返回 nullptr, 并把该槽位写入 existing
+    // path 记录下降路径, 之后插入到该叶子的每个键都沿它计数
+    template <bool Unique>
+    Node* descend_to_leaf(const K& key, const K*& fence, Slot& existing, DescentPath& path) {
+        grow_root_if_full();
+        fence = nullptr;
+        path = DescentPath();
+        Node* node = root;
+        while (true) {
+            // 唯一键: 第一个 >= key 的位置; 允许重复: 插入到相等键之后
+            int i = Unique ? lower_bound_in(node, key) : upper_bound_in(node, key);
+            if (Unique && i < node->n && !comp(key, keys(node)[i])) {
+                existing = Slot{node, i};
+                return nullptr;
+            }
+            if (node->leaf)
+                return node;
+            if (children(node)[i]->n == 2 * t - 1) {
                 split_child(node, i);
-                if (key > node->keys[i]) {
+                if (!comp(key, keys(node)[i])) {
+                    if (Unique && !comp(keys(node)[i], key)) {
+                        existing = Slot{node, i};
+                        return nullptr;
+                    }
                     i++;
                 }
             }
-            insert_non_full(node->children[i], key);
+            if (i < node->n)
+                fence = &keys(node)[i];
+            path.push(node, i);
+            node = children(node)[i];
         }
     }
-    // 在节点中搜索键值
+
+    // 按序插入 n 个元素: 相邻的键落在同一个叶子时直接插入该叶子, 不再从根节点下降
     /*
-    示例搜索: 在 [10,20,30] 中搜索25
-    过程: 10<25, 20<25, 30>25
-    结果: 在20和30之间的子树中继续搜索
+    示例: 依次插入 42 44 47 52
+                  [30        60]
+                 /      |       \
+               ...   [40 50]    ...
+                    /   |   \
+              [31 35] [41 45] [51 55]
+      42: 从根下降到叶子 [41 45], fence = 50 (路径上最近的右侧键)
+      44, 47: 仍 < 50 且叶子未满, 直接插入同一个叶子
+      52: >= fence, 重新从根下降
     */
-    std::optional<T> search_internal(const std::shared_ptr<Node>& node, const T& key) const {
-        if (!node) {
-            return std::nullopt;
+    // key_at(j): 第 j 个键 (非降序); emplace(leaf, idx, j): 在叶子 idx 处构造第 j 个元素
+    // found(slot, j): Unique 时第 j 个键已存在
+    template <bool Unique, typename KeyAt, typename Emplace, typename Found>
+    void insert_sorted(std::size_t n, KeyAt key_at, Emplace emplace, Found found) {
+        Node* leaf = nullptr;
+        const K* fence = nullptr;
+        DescentPath path;
+        for (std::size_t j = 0; j < n; j++) {
+            const K& key = key_at(j);
+            if (!leaf || leaf->n == 2 * t - 1 || (fence && !comp(key, *fence))) {
+                Slot existing{nullptr, 0};
+                leaf = descend_to_leaf<Unique>(key, fence, existing, path);
+                if (!leaf) {
+                    found(existing, j);
+                    continue;
+                }
+            }
+            int i = Unique ? lower_bound_in(leaf, key) : upper_bound_in(leaf, key);
+            if (Unique && i < leaf->n && !comp(key, keys(leaf)[i])) {
+                found(Slot{leaf, i}, j);
+                continue;
+            }
+            emplace(leaf, i, j);
+            count++;
+            path.add(this, 1);
+        }
+    }
+
+    // 把节点头部和键数组所在的cache line预取进来 (最多 kPrefetchLines 行)
+    static constexpr std::size_t kPrefetchLines = 8;
+
+    void prefetch_node(const Node* node) const {
+        const char* p = reinterpret_cast<const char*>(node);
+        std::size_t bytes = Node::keys_offset() + (2 * t - 1) * sizeof(K);
+        std::size_t lines = std::min((bytes + 63) / 64, kPrefetchLines);
+        for (std::size_t i = 0; i < lines; i++)
+            __builtin_prefetch(p + i * 64);
+    }
+
+    // 批量查找时落入同一个子节点的一段有序键
+    struct SearchGroup {
+        const Node* child;
+        std::size_t lo;
+        std::size_t hi;
+    };
+
+    // 有序批量查找: 同一段键共享从根开始的路径, 每个节点只读一次
+    // 先把这一段键按子节点分组, 并预取所有要访问的子节点, 再依次进入子树,
+    // 这样兄弟子树的内存访问可以重叠
+    // key_at(j): 第 j 个键 (非降序); report(j, node, idx): 第 j 个键的结果, 未找到时 node 为 nullptr
+    template <typename KeyAt, typename Report>
+    void search_sorted(const Node* node, std::size_t lo, std::size_t hi, KeyAt& key_at, Report& report,
+                       std::vector<SearchGroup>& groups) const {
+        std::size_t base = groups.size();
+        int pos = 0;
+        for (std::size_t j = lo; j < hi; j++) {
+            const K& key = key_at(j);
+            // 键有序, 位置单调不减, 只需在 [pos, n) 中查找
+            pos += btree_search::node_lower_bound(keys(node) + pos, node->n - pos, key, comp);
+            if (pos < node->n && !comp(key, keys(node)[pos])) {
+                report(j, node, pos);
+            } else if (node->leaf) {
+                report(j, static_cast<const Node*>(nullptr), 0);
+            } else {
+                const Node* child = children(node)[pos];
+                if (groups.size() > base && groups.back().child == child) {
+                    groups.back().hi = j + 1;
+                } else {
+                    prefetch_node(child);
+                    groups.push_back(SearchGroup{child, j, j + 1});
+                }
+            }
+        }
+        for (std::size_t g = base; g < groups.size(); g++) {
+            SearchGroup group = groups[g];
+            search_sorted(group.child, group.lo, group.hi, key_at, report, groups);
         }
+        groups.resize(base);
+    }
 
-        int i = 0;
-        while (i < node->keys.size() && key > node->keys[i]) {
-            i++;
+    // 批量接口的公共部分: 按键排序得到下标顺序 (相等键保持原顺序)
+    // 整数键且比较器为 std::less 时用基数排序, 其余情况用 stable_sort
+    template <typename KeyOf>
+    std::vector<std::size_t> sorted_order(std::size_t n, KeyOf key_of) const {
+        std::vector<std::size_t> order(n);
+        if constexpr (std::is_integral_v<K> && btree_search::simd_compare_v<K, Compare>) {
+            radix_order(n, key_of, order);
+        } else {
+            for (std::size_t i = 0; i < n; i++)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                return comp(key_of(a), key_of(b));
+            });
         }
+        return order;
+    }
+
+    // LSD基数排序, 每轮8位; 所有键在某一轮的字节都相同时跳过该轮
+    template <typename KeyOf>
+    static void radix_order(std::size_t n, KeyOf& key_of, std::vector<std::size_t>& order) {
+        using U = std::make_unsigned_t<K>;
+        constexpr U sign = std::is_signed_v<K> ? U(U(1) << (sizeof(K) * 8 - 1)) : U(0);
+        std::vector<std::pair<U, std::size_t>> cur(n), tmp(n);
+        for (std::size_t i = 0; i < n; i++)
+            cur[i] = {static_cast<U>(key_of(i)) ^ sign, i};
 
-        if (i < node->keys.size() && key == node->keys[i]) {
-            return node->keys[i];
+        for (std::size_t shift = 0; shift < sizeof(K) * 8; shift += 8) {
+            std::size_t counts[257] = {};
+            for (const auto& e : cur)
+                counts[((e.first >> shift) & 0xff) + 1]++;
+            if (n == 0 || counts[((cur[0].first >> shift) & 0xff) + 1] == n)
+                continue;
+            for (int d = 0; d < 256; d++)
+                counts[d + 1] += counts[d];
+            for (const auto& e : cur)
+                tmp[counts[(e.first >> shift) & 0xff]++] = e;
+            cur.swap(tmp);
         }
+        for (std::size_t i = 0; i < n; i++)
+            order[i] = cur[i].second;
+    }
 
-        if (node->leaf) {
-            return std::nullopt;
+    template <typename KeyAt, typename Report>
+    void search_batch_impl(std::size_t n, KeyAt key_at, Report report) const {
+        if (!root) {
+            for (std::size_t j = 0; j < n; j++)
+                report(j, static_cast<const Node*>(nullptr), 0);
+            return;
         }
+        if (n == 0)
+            return;
+        std::vector<SearchGroup> groups;
+        search_sorted(root, 0, n, key_at, report, groups);
+    }
 
-        return search_internal(node->children[i], key);
+    // 在节点中搜索键值
+    /*
+    示例搜索: 在 [10,20,30] 中搜索25
+    过程: 10<25, 20<25, 30>25
+    结果: 在20和30之间的子树中继续搜索
+    */
+    template <typename Key>
+    const Node* search_internal(const Node* node, const Key& key, int& idx) const {
+        [[maybe_unused]] uint64_t visited = 0, compared = 0;
+        const Node* found = nullptr;
+        while (node) {
+            int i = lower_bound_in(node, key);
+            if constexpr (kStats) {
+                visited++;
+                compared += binary_search_comparisons(node->n) + (i < node->n ? 1 : 0);
+            }
+            if (i < node->n && !comp(key, keys(node)[i])) {
+                idx = i;
+                found = node;
+                break;
+            }
+            if (node->leaf) {
+                break;
+            }
+            node = children(node)[i];
+        }
+        record_search(visited, compared);
+        return found;
     }
-    // 从B树中删除键值的内部实现
+    // 从B树中删除键值的内部实现: 一次自顶向下的循环, 不递归
     /*
-    删除情况:
-    1. 从叶子节点删除
-    2. 从内部节点删除
-    3. 需要合并节点的情况
+    进入每个子节点之前保证它至少有 t 个键 (不够时借键或合并, 见 fill),
+    这样在叶子中删除一个键不会使任何节点低于 t-1 个键, 不需要回溯。
+    键在当前节点 node[idx] 时:
+    1. node 是叶子: 直接删除
+    2. 左子树足够 (>= t 个键): 沿左子树最右路径下降 (沿途同样保证 >= t 个键),
+       把前驱从叶子中移到 node[idx], 一次下降完成, 不需要先找前驱再按值删除
+    3. 右子树足够: 对称地用后继替换
+    4. 两个子节点都只有 t-1 个键: 合并后 key 落在合并后的子节点中, 继续下降
     */
-    bool remove_internal(std::shared_ptr<Node>& node, const T& key) {
-        int idx = find_key(node, key);
+    // kCounted 时记录下降路径, 确实删除了键之后再把路径上的计数减一
+    template <typename Key>
+    bool remove_internal(Node* node, const Key& key) {
+        DescentPath path;
+        while (true) {
+            int idx = find_key(node, key);
+
+            if (idx < node->n && key_equal(keys(node)[idx], key)) {
+                // The key is in this node
+                if (node->leaf) {
+                    remove_from_leaf(node, idx);
+                    path.add(this, -1);
+                    return true;
+                }
+                Node** c = children(node);
+                if (c[idx]->n >= t) {
+                    path.push(node, idx);
+                    Node* leaf = descend_filled(c[idx], true, path);
+                    assign_slot(node, idx, leaf, leaf->n - 1);
+                    erase_slot(leaf, leaf->n - 1);
+                    path.add(this, -1);
+                    return true;
+                }
+                if (c[idx + 1]->n >= t) {
+                    path.push(node, idx + 1);
+                    Node* leaf = descend_filled(c[idx + 1], false, path);
+                    assign_slot(node, idx, leaf, 0);
+                    erase_slot(leaf, 0);
+                    path.add(this, -1);
+                    return true;
+                }
+                merge(node, idx);
+                path.push(node, idx);
+                node = c[idx];
+                continue;
+            }
 
-        if (idx < node->keys.size() && node->keys[idx] == key) {
-            // The key is in this node
-            if (node->leaf)
-                remove_from_leaf(node, idx);
-            else
-                remove_from_non_leaf(node, idx);
-        }
-        else {
             // The key is not in this node
             if (node->leaf) {
                 // The key is not present
                 return false;
             }
 
-            bool flag = ((idx == node->keys.size()) ? true : false);
+            bool last = idx == node->n;
 
             // If the child where the key should exist has fewer than t keys, fill it
-            if (node->children[idx]->keys.size() < t)
+            if (children(node)[idx]->n < t)
                 fill(node, idx);
 
-            // After filling, the child might have been merged, so we need to decide where to recurse
-            if (flag && idx > node->keys.size())
-                remove_internal(node->children[idx - 1], key);
-            else
-                remove_internal(node->children[idx], key);
+            // 最后一个子节点与左兄弟合并后, 下降到合并后的节点
+            if (last && idx > node->n)
+                idx--;
+            path.push(node, idx);
+            node = children(node)[idx];
         }
-        return true;
-    }
-    int find_key(std::shared_ptr<Node>& node, const T& key) {
-        int idx = 0;
-        while (idx < node->keys.size() && node->keys[idx] < key)
-            ++idx;
-        return idx;
     }
 
-    void remove_from_leaf(std::shared_ptr<Node>& node, int idx) {
-        node->keys.erase(node->keys.begin() + idx);
-    }
-    void remove_from_non_leaf(std::shared_ptr<Node>& node, int idx) {
-        T key = node->keys[idx];
-
-        // If the child before the key has at least t keys
-        if (node->children[idx]->keys.size() >= t) {
-            T pred = get_predecessor(node->children[idx]);
-            node->keys[idx] = pred;
-            remove_internal(node->children[idx], pred);
-        }
-        // If the child after the key has at least t keys
-        else if (node->children[idx + 1]->keys.size() >= t) {
-            T succ = get_successor(node->children[idx + 1]);
-            node->keys[idx] = succ;
-            remove_internal(node->children[idx + 1], succ);
-        }
-        // If both children have less than t keys
-        else {
-            merge(node, idx);
-            remove_internal(node->children[idx], key);
+    // 沿最右 (rightmost) 或最左路径下降到叶子, 下降前保证每个子节点至少有 t 个键
+    // 起点 node 自身已有 >= t 个键
+    Node* descend_filled(Node* node, bool rightmost, DescentPath& path) {
+        while (!node->leaf) {
+            int idx = rightmost ? node->n : 0;
+            if (children(node)[idx]->n < t) {
+                fill(node, idx);
+                // 最右子节点与左兄弟合并时, 合并结果在 idx-1 处
+                if (idx > node->n)
+                    idx = node->n;
+            }
+            path.push(node, idx);
+            node = children(node)[idx];
         }
+        return node;
     }
-    T get_predecessor(std::shared_ptr<Node> node) {
-        while (!node->leaf)
-            node = node->children.back();
-        return node->keys.back();
+
+    template <typename Key>
+    int find_key(const Node* node, const Key& key) const {
+        return lower_bound_in(node, key);
     }
 
-    T get_successor(std::shared_ptr<Node> node) {
-        while (!node->leaf)
-            node = node->children.front();
-        return node->keys.front();
+    void remove_from_leaf(Node* node, int idx) {
+        erase_slot(node, idx);
     }
-    void fill(std::shared_ptr<Node>& node, int idx) {
-        if (idx != 0 && node->children[idx - 1]->keys.size() >= t)
+
+    void fill(Node* node, int idx) {
+        Node** c = children(node);
+        if (idx != 0 && c[idx - 1]->n >= t)
             borrow_from_prev(node, idx);
-        else if (idx != node->keys.size() && node->children[idx + 1]->keys.size() >= t)
+        else if (idx != node->n && c[idx + 1]->n >= t)
             borrow_from_next(node, idx);
         else {
-            if (idx != node->keys.size())
+            if (idx != node->n)
                 merge(node, idx);
             else
                 merge(node, idx - 1);
         }
     }
-    void borrow_from_prev(std::shared_ptr<Node>& node, int idx) {
-        auto child = node->children[idx];
-        auto sibling = node->children[idx - 1];
+    void borrow_from_prev(Node* node, int idx) {
+        Node* child = children(node)[idx];
+        Node* sibling = children(node)[idx - 1];
+        record(kStatBorrowPrev);
+
+        if constexpr (kCounted) {
+            std::size_t moved = 1;
+            if (!child->leaf) {
+                moved += counts(sibling)[sibling->n];
+                insert_child(child, 0, children(sibling)[sibling->n]);
+                counts(child)[0] = counts(sibling)[sibling->n];
+                if constexpr (kAggregated) {
+                    aggs(child)[0] = aggs(sibling)[sibling->n];
+                }
+            }
+            counts(node)[idx] += moved;
+            counts(node)[idx - 1] -= moved;
+        } else if (!child->leaf) {
+            insert_child(child, 0, children(sibling)[sibling->n]);
+        }
+        insert_slot_from(child, 0, node, idx - 1);
+
+        assign_slot(node, idx - 1, sibling, sibling->n - 1);
 
-        child->keys.insert(child->keys.begin(), node->keys[idx - 1]);
+        destroy_slots(sibling, sibling->n - 1, 1);
+        sibling->n--;
+        refresh_agg(node, idx - 1);
+        refresh_agg(node, idx);
+    }
+    void borrow_from_next(Node* node, int idx) {
+        Node* child = children(node)[idx];
+        Node* sibling = children(node)[idx + 1];
+        record(kStatBorrowNext);
 
         if (!child->leaf)
-            child->children.insert(child->children.begin(), sibling->children.back());
+            children(child)[child->n + 1] = children(sibling)[0];
+        if constexpr (kCounted) {
+            std::size_t moved = 1;
+            if (!child->leaf) {
+                moved += counts(sibling)[0];
+                counts(child)[child->n + 1] = counts(sibling)[0];
+                if constexpr (kAggregated) {
+                    aggs(child)[child->n + 1] = aggs(sibling)[0];
+                }
+            }
+            counts(node)[idx] += moved;
+            counts(node)[idx + 1] -= moved;
+        }
+        insert_slot_from(child, child->n, node, idx);
 
-        node->keys[idx - 1] = sibling->keys.back();
+        assign_slot(node, idx, sibling, 0);
 
-        sibling->keys.pop_back();
         if (!sibling->leaf)
-            sibling->children.pop_back();
+            erase_child(sibling, 0);
+        erase_slot(sibling, 0);
+        refresh_agg(node, idx);
+        refresh_agg(node, idx + 1);
     }
-    void borrow_from_next(std::shared_ptr<Node>& node, int idx) {
-        auto child = node->children[idx];
-        auto sibling = node->children[idx + 1];
+    void merge(Node* node, int idx) {
+        Node* child = children(node)[idx];
+        Node* sibling = children(node)[idx + 1];
+        record(kStatMerge);
 
-        child->keys.push_back(node->keys[idx]);
+        move_slots(child, child->n, node, idx, 1);
+        move_slots(child, child->n + 1, sibling, 0, sibling->n);
 
-        if (!child->leaf)
-            child->children.push_back(sibling->children.front());
+        if (!child->leaf) {
+            std::memcpy(children(child) + child->n + 1, children(sibling), (sibling->n + 1) * sizeof(Node*));
+            if constexpr (kCounted) {
+                std::memcpy(counts(child) + child->n + 1, counts(sibling), (sibling->n + 1) * sizeof(std::size_t));
+            }
+            if constexpr (kAggregated) {
+                std::memcpy(aggs(child) + child->n + 1, aggs(sibling), (sibling->n + 1) * sizeof(agg_type));
+            }
+        }
+        child->n += sibling->n + 1;
+        if constexpr (kCounted) {
+            counts(node)[idx] += 1 + counts(node)[idx + 1];
+        }
 
-        node->keys[idx] = sibling->keys.front();
+        erase_child(node, idx + 1);
+        erase_slot(node, idx);
+        refresh_agg(node, idx);
 
-        sibling->keys.erase(sibling->keys.begin());
-        if (!sibling->leaf)
-            sibling->children.erase(sibling->children.begin());
+        destroy_node(sibling);
     }
-    void merge(std::shared_ptr<Node>& node, int idx) {
-        auto child = node->children[idx];
-        auto sibling = node->children[idx + 1];
 
-        child->keys.push_back(node->keys[idx]);
-        child->keys.insert(child->keys.end(), sibling->keys.begin(), sibling->keys.end());
+    template <typename Key>
+    bool erase_key(const Key& key) {
+        if (!root)
+            return false;
 
-        if (!child->leaf)
-            child->children.insert(child->children.end(), sibling->children.begin(), sibling->children.end());
+        bool removed = remove_internal(root, key);
+        if (removed)
+            count--;
 
-        node->keys.erase(node->keys.begin() + idx);
-        node->children.erase(node->children.begin() + idx + 1);
+        // 根节点为空时收缩树高; 空的叶子根节点保留, 以便后续继续插入
+        if (root->n == 0 && !root->leaf) {
+            record(kStatRootShrink);
+            Node* old_root = root;
+            root = children(root)[0];
+            destroy_node(old_root);
+        }
+        return removed;
     }
-public:
-    BTree(int min_degree) : t(min_degree) {
+
+    // ---- 自底向上批量构建 ----
+
+    // 每层的节点划分: 把 units 个单位分给 count 个节点, 前 extra 个节点各多分一个
+    // 叶子层的单位是"键 + 其后的分隔键"(共 n+1 个), 内部层的单位是子节点
+    struct LevelShape {
+        std::size_t count;
+        std::size_t base;
+        std::size_t extra;
+        std::size_t next; // 构建时下一个要创建的节点序号
+    };
+
+    // 每个节点的单位数必须落在 [t, 2t] (即键数在 [t-1, 2t-1]); 在此范围内尽量接近 per_node
+    LevelShape level_shape(std::size_t units, std::size_t per_node) const {
+        std::size_t count = (units + per_node - 1) / per_node;
+        count = std::min(count, units / t);
+        count = std::max<std::size_t>(count, 1);
+        return LevelShape{count, units / count, units % count, 0};
+    }
+
+    // 按中序消费输入: 子树之间的元素成为内部节点的键, 每个元素只移动/拷贝一次
+    template <typename It, typename Put>
+    Node* build_node(std::vector<LevelShape>& levels, std::size_t level, It& it, Put& put) {
+        return build_node_in(alloc, levels, level, it, put);
+    }
+
+    template <typename It, typename Put>
+    Node* build_node_in(Allocator& a, std::vector<LevelShape>& levels, std::size_t level, It& it, Put& put) {
+        LevelShape& shape = levels[level];
+        std::size_t units = shape.base + (shape.next < shape.extra ? 1 : 0);
+        shape.next++;
+
+        Node* node = create_node_in(a, level == 0);
+        if (level == 0) {
+            for (std::size_t i = 0; i + 1 < units; i++, ++it)
+                put(node, *it);
+        } else {
+            for (std::size_t i = 0; i < units; i++) {
+                children(node)[i] = build_node_in(a, levels, level - 1, it, put);
+                if constexpr (kCounted) {
+                    counts(node)[i] = subtree_size(children(node)[i]);
+                }
+                refresh_agg(node, static_cast<int>(i));
+                if (i + 1 < units) {
+                    put(node, *it);
+                    ++it;
+                }
+            }
+        }
+        return node;
+    }
+
+    // 用有序序列 [first, first+n) 替换树的全部内容, put(node, elem) 把元素追加到节点末尾
+    /*
+    示例: t=2, fill_factor=1.0 (每个节点3个键), 1..11
+      叶子层 12 个单位 -> 3 个叶子, 每个 4 个单位(3个键 + 1个分隔键):
+                       [4       8]
+                      /     |     \
+               [1 2 3]  [5 6 7]  [9 10 11]
+    */
+    template <typename It, typename Put>
+    void build_from_sorted(It first, std::size_t n, double fill_factor, Put put) {
+        std::vector<LevelShape> levels = plan_levels(n, fill_factor);
+
+        // 旧节点逐个归还分配器, 新树可以复用
+        if (root)
+            destroy_subtree(root);
+        root = nullptr;
+        count = 0;
+        count_stale = false;
+
+        root = build_node(levels, levels.size() - 1, first, put);
+        count = n;
+    }
+
+    // n 个元素自底向上构建时每层的划分, levels[0] 为叶子层, 最后一层只有根节点
+    std::vector<LevelShape> plan_levels(std::size_t n, double fill_factor) const {
+        if (!(fill_factor > 0.0 && fill_factor <= 1.0)) {
+            throw std::invalid_argument("Fill factor must be in (0, 1]");
+        }
+        std::size_t max_keys = 2 * t - 1;
+        std::size_t per_node = static_cast<std::size_t>(fill_factor * max_keys + 0.5);
+        per_node = std::clamp<std::size_t>(per_node, t - 1, max_keys);
+
+        std::vector<LevelShape> levels{level_shape(n + 1, per_node + 1)};
+        while (levels.back().count > 1)
+            levels.push_back(level_shape(levels.back().count, per_node + 1));
+        return levels;
+    }
+
+    // 第 level 层第 j 个节点的子节点在下一层中的起始序号
+    static std::size_t first_child_index(const LevelShape& shape, std::size_t j) {
+        return j * shape.base + std::min(j, shape.extra);
+    }
+
+    // 并行构建: 节点划分与顺序构建完全相同, 只是把第 stop 层的各棵子树分给多个线程
+    /*
+      第 stop 层的第 j 棵子树覆盖叶子 [a, b), 它的第一个元素在输入中的位置是前 a 个叶子的单位数之和,
+      其后的分隔键位于第 b 个叶子的第一个元素之前。各层的起始序号由 first_child_index 逐层向下得到,
+      所以每个线程可以独立定位自己的输入区间和各层的 next:
+
+                         [ 上层: 当前线程 ]
+                        /        |        \
+         stop 层:   [子树 0]  [子树 1]  [子树 2]     <- 线程 0 / 1 / 2, 各用 fork() 出的分配器
+                    a0 ... b0 a1 ... b1 a2 ... b2    <- 叶子
+    */
+    template <typename It, typename Put>
+    void build_from_sorted_parallel(It first, std::size_t n, double fill_factor, unsigned threads, Put put) {
+        std::vector<LevelShape> levels = plan_levels(n, fill_factor);
+        std::size_t top = levels.size() - 1;
+
+        // 选最高的一层, 使每个线程至少分到 4 棵子树 (负载更均匀)
+        std::size_t stop = top;
+        for (std::size_t l = top; l-- > 0;) {
+            if (levels[l].count >= 4 * static_cast<std::size_t>(threads)) {
+                stop = l;
+                break;
+            }
+        }
+        if constexpr (btree_detail::has_fork<Allocator>::value) {
+            if (threads > 1 && stop < top) {
+                build_parallel_levels(first, levels, stop, threads, put);
+                count = n;
+                return;
+            }
+        }
+        build_from_sorted(first, n, fill_factor, put);
+    }
+
+    template <typename It, typename Put>
+    void build_parallel_levels(It first, std::vector<LevelShape>& levels, std::size_t stop, unsigned threads,
+                               Put& put) {
+        std::size_t subtrees = levels[stop].count;
+        // 每棵子树在各层的起始序号, 以及其后分隔键在输入中的位置
+        std::vector<std::vector<std::size_t>> starts(subtrees, std::vector<std::size_t>(stop + 1));
+        std::vector<std::size_t> seps(subtrees);
+        auto leaf_offset = [&](std::size_t leaf) { return first_child_index(levels[0], leaf); };
+        for (std::size_t j = 0; j < subtrees; j++) {
+            starts[j][stop] = j;
+            for (std::size_t l = stop; l > 0; l--)
+                starts[j][l - 1] = first_child_index(levels[l], starts[j][l]);
+        }
+        for (std::size_t j = 0; j + 1 < subtrees; j++)
+            seps[j] = leaf_offset(starts[j + 1][0]) - 1;
+
+        if (root)
+            destroy_subtree(root);
+        root = nullptr;
+        count = 0;
+        count_stale = false;
+
+        std::vector<Node*> built(subtrees, nullptr);
+        std::vector<Allocator> allocators;
+        for (unsigned w = 0; w < threads; w++)
+            allocators.push_back(alloc.fork());
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> workers;
+        for (unsigned w = 0; w < threads; w++) {
+            workers.emplace_back([&, w] {
+                try {
+                    std::size_t lo = subtrees * w / threads, hi = subtrees * (w + 1) / threads;
+                    for (std::size_t j = lo; j < hi; j++) {
+                        std::vector<LevelShape> local(levels.begin(), levels.begin() + stop + 1);
+                        for (std::size_t l = 0; l <= stop; l++)
+                            local[l].next = starts[j][l];
+                        It it = first + leaf_offset(starts[j][0]);
+                        built[j] = build_node_in(allocators[w], local, stop, it, put);
+                    }
+                } catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        // 各线程分配的节点从此归这棵树的分配器持有
+        for (Allocator& a : allocators)
+            a.share(alloc);
+        for (std::exception_ptr& e : errors) {
+            if (e) {
+                for (Node* node : built) {
+                    if (node)
+                        destroy_subtree(node);
+                }
+                root = create_node(true);
+                std::rethrow_exception(e);
+            }
+        }
+
+        std::size_t next_subtree = 0;
+        root = build_upper(levels, levels.size() - 1, stop, built.data(), seps.data(), next_subtree, first, put);
+    }
+
+    // 并行构建的上层: 第 stop 层的子树已经建好, 依次取用, 子树之间的分隔键按位置从输入中取
+    template <typename It, typename Put>
+    Node* build_upper(std::vector<LevelShape>& levels, std::size_t level, std::size_t stop, Node* const* built,
+                      const std::size_t* seps, std::size_t& next_subtree, It first, Put& put) {
+        LevelShape& shape = levels[level];
+        std::size_t units = shape.base + (shape.next < shape.extra ? 1 : 0);
+        shape.next++;
+
+        Node* node = create_node(false);
+        for (std::size_t i = 0; i < units; i++) {
+            if (level - 1 == stop)
+                children(node)[i] = built[next_subtree++];
+            else
+                children(node)[i] = build_upper(levels, level - 1, stop, built, seps, next_subtree, first, put);
+            if constexpr (kCounted) {
+                counts(node)[i] = subtree_size(children(node)[i]);
+            }
+            refresh_agg(node, static_cast<int>(i));
+            if (i + 1 < units)
+                put(node, first[seps[next_subtree - 1]]);
+        }
+        return node;
+    }
+
+    bool validate_node(const Node* node, int depth, const K* lo, const K* hi, int& leaf_depth,
+                       std::size_t& total) const {
+        if (node->n > 2 * t - 1 || (node != root && node->n < t - 1) || (!node->leaf && node->n == 0))
+            return false;
+        for (int i = 0; i < node->n; i++) {
+            const K& key = keys(node)[i];
+            if ((i > 0 && comp(key, keys(node)[i - 1])) || (lo && comp(key, *lo)) || (hi && comp(*hi, key)))
+                return false;
+        }
+        total += node->n;
+        if (node->leaf) {
+            if (leaf_depth < 0)
+                leaf_depth = depth;
+            return leaf_depth == depth;
+        }
+        for (int i = 0; i <= node->n; i++) {
+            std::size_t before = total;
+            const K* child_lo = i > 0 ? &keys(node)[i - 1] : lo;
+            const K* child_hi = i < node->n ? &keys(node)[i] : hi;
+            if (!validate_node(children(node)[i], depth + 1, child_lo, child_hi, leaf_depth, total))
+                return false;
+            if constexpr (kCounted) {
+                if (counts(node)[i] != total - before)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // ---- 拼接与拆分 ----
+
+    // 一棵独立的子树: 根节点、高度 (叶子为 0, 空树为 -1) 和键数
+    // 键数只在 kCounted 时可靠, 其他情况下可能无效 (见 count_stale)
+    struct Piece {
+        Node* root;
+        int height;
+        std::size_t size;
+    };
+
+    static constexpr Piece empty_piece() { return Piece{nullptr, -1, 0}; }
+
+    int node_height(const Node* node) const {
+        int h = 0;
+        for (; !node->leaf; h++)
+            node = children(node)[0];
+        return h;
+    }
+
+    // 键数未知但 size() 已经数过时, 换回确定的键数
+    void settle_count() {
+        std::size_t base = stale_base.load(std::memory_order_relaxed);
+        if (count_stale && base != kUnknownSize) {
+            count += base;
+            count_stale = false;
+        }
+    }
+
+    // 取出整棵树作为 Piece, 树变为没有根节点的状态 (之后用 put_piece 放回); count_stale 时 size 无效
+    Piece take_piece() {
+        settle_count();
+        Piece p = empty_piece();
+        if (root && !empty()) {
+            p = Piece{root, node_height(root), count};
+        } else if (root) {
+            destroy_node(root);
+        }
+        root = nullptr;
+        count = 0;
+        count_stale = false;
+        return p;
+    }
+
+    // stale: 键数未知 (忽略 size), 之后由 size() 再数
+    void put_piece(const Piece& p, std::size_t size, bool stale = false) {
+        root = p.root ? p.root : create_node(true);
+        count_stale = stale && p.root;
+        count = count_stale ? 0 : size;
+        stale_base.store(kUnknownSize, std::memory_order_relaxed);
+    }
+
+    // 以 node 为根 (高度 h) 的子树作为 Piece; 没有键的根节点被释放 (内部节点则换成唯一的子节点)
+    Piece piece_of(Node* node, int h) {
+        while (node->n == 0) {
+            Node* child = node->leaf ? nullptr : children(node)[0];
+            destroy_node(node);
+            if (!child)
+                return empty_piece();
+            node = child;
+            h--;
+        }
+        std::size_t size = 0;
+        if constexpr (kCounted) {
+            size = subtree_size(node);
+        }
+        return Piece{node, h, size};
+    }
+
+    // children[idx] 的键数少于 t-1 (它原来是另一棵树的根) 时, 反复向相邻的兄弟借键, 两者合起来
+    // 放得下一个节点时直接合并; 返回是否发生了合并
+    bool repair_child(Node* node, int idx) {
+        while (children(node)[idx]->n < t - 1) {
+            int left = idx == node->n ? idx - 1 : idx;
+            if (children(node)[left]->n + children(node)[left + 1]->n + 1 <= 2 * t - 1) {
+                merge(node, left);
+                return true;
+            }
+            if (left < idx)
+                borrow_from_prev(node, idx);
+            else
+                borrow_from_next(node, idx);
+        }
+        return false;
+    }
+
+    // 拼接: left 中的键 <= 分隔键 (src 的第 sidx 个槽位, 移出后由调用者析构) <= right 中的键
+    /*
+      较矮的一棵接到较高一棵靠近它的一侧, 高度差为 d 时只访问较高一棵的 d 层:
+      沿较高一棵的右 (左) 边下降到比较矮一棵高一层的节点 x, 沿途预先分裂满节点 (同插入),
+      把分隔键和较矮一棵的根追加到 x 的末尾 (开头)。较矮一棵的根可能少于 t-1 个键, 向相邻的兄弟借键或合并。
+      两棵等高时先在左边一棵上面加一个空的根。
+
+         left (高 2)            right (高 0)              [A        K]
+           [A]                                           /    |      \
+          /   \       K       [R1 R2]       =>        ...  [P Q]    [R1 R2]
+        ...  [P Q]                                                  (不足 t-1 个键时向 [P Q] 借键)
+    */
+    Piece join_pieces(Piece left, Node* src, int sidx, Piece right) {
+        bool grow_left = left.height >= right.height;
+        Piece& big = grow_left ? left : right;
+        Piece& small = grow_left ? right : left;
+        std::size_t size = left.size + right.size + 1;
+
+        if (big.height == small.height) {
+            Node* top = create_node(big.height < 0);
+            if (big.root) {
+                children(top)[0] = big.root;
+                if constexpr (kCounted) {
+                    counts(top)[0] = big.size;
+                }
+                refresh_agg(top, 0);
+            }
+            big.root = top;
+            big.height++;
+        }
+        if (big.root->n == 2 * t - 1) {
+            Node* top = create_node(false);
+            children(top)[0] = big.root;
+            if constexpr (kCounted) {
+                counts(top)[0] = big.size;
+            }
+            refresh_agg(top, 0);
+            split_child(top, 0);
+            big.root = top;
+            big.height++;
+        }
+
+        DescentPath path;
+        Node* x = big.root;
+        for (int h = big.height; h > small.height + 1; h--) {
+            int idx = grow_left ? x->n : 0;
+            if (children(x)[idx]->n == 2 * t - 1) {
+                split_child(x, idx);
+                idx = grow_left ? x->n : 0;
+            }
+            path.push(x, idx);
+            x = children(x)[idx];
+        }
+
+        if (x->leaf) {
+            insert_slot_from(x, grow_left ? x->n : 0, src, sidx);
+        } else {
+            int cidx = grow_left ? x->n + 1 : 0;
+            insert_child(x, cidx, small.root);
+            if constexpr (kCounted) {
+                counts(x)[cidx] = small.size;
+            }
+            insert_slot_from(x, grow_left ? x->n : 0, src, sidx);
+            refresh_agg(x, cidx);
+            // 等高拼接时另一侧也是原来的根, 同样可能不足 t-1 个键
+            if (!repair_child(x, cidx))
+                repair_child(x, grow_left ? cidx - 1 : cidx + 1);
+        }
+        path.add(this, static_cast<int>(small.size + 1));
+
+        Piece out{big.root, big.height, size};
+        if (out.root->n == 0) {
+            Node* child = children(out.root)[0];
+            destroy_node(out.root);
+            out = Piece{child, out.height - 1, size};
+        }
+        return out;
+    }
+
+    // 拆分: 以 x 为根 (高度 h) 的子树拆成 < key 和 >= key 两部分, x 中的节点被拆开复用
+    // scratch: 一个空的叶子, 暂存移出的分隔键 (分隔键所在的节点会参与拼接)
+    /*
+      x = [k0 .. k(i-1) | ki .. ], 子节点 ci 中再递归拆成 (lc, rc):
+        左: join([k0 .. k(i-2)] 及其子树, k(i-1), lc)
+        右: join(rc, ki, [k(i+1) ..] 及其子树)
+      每层的拼接代价与两边的高度差成正比, 高度差逐层累加不超过树高, 总共 O(t log n)
+    */
+    template <typename Key>
+    std::pair<Piece, Piece> split_piece(Node* x, int h, const Key& key, Node* scratch) {
+        int i = lower_bound_in(x, key);
+        if (x->leaf) {
+            Node* r = create_node(true);
+            move_slots(r, 0, x, i, x->n - i);
+            r->n = x->n - i;
+            destroy_slots(x, i, x->n - i);
+            x->n = i;
+            return {piece_of(x, 0), piece_of(r, 0)};
+        }
+
+        auto [lc, rc] = split_piece(children(x)[i], h - 1, key, scratch);
+
+        Piece right = rc;
+        if (i < x->n) {
+            int rn = x->n - i - 1;
+            Node* r = create_node(false);
+            move_slots(r, 0, x, i + 1, rn);
+            std::memcpy(children(r), children(x) + i + 1, (rn + 1) * sizeof(Node*));
+            if constexpr (kCounted) {
+                std::memcpy(counts(r), counts(x) + i + 1, (rn + 1) * sizeof(std::size_t));
+            }
+            if constexpr (kAggregated) {
+                std::memcpy(aggs(r), aggs(x) + i + 1, (rn + 1) * sizeof(agg_type));
+            }
+            r->n = rn;
+            destroy_slots(x, i + 1, rn);
+            move_slots(scratch, 0, x, i, 1);
+            destroy_slots(x, i, 1);
+            x->n = i;
+            right = join_pieces(rc, scratch, 0, piece_of(r, h));
+            destroy_slots(scratch, 0, 1);
+        }
+
+        Piece left = lc;
+        if (i > 0) {
+            move_slots(scratch, 0, x, i - 1, 1);
+            destroy_slots(x, i - 1, 1);
+            x->n = i - 1;
+            left = join_pieces(piece_of(x, h), scratch, 0, lc);
+            destroy_slots(scratch, 0, 1);
+        } else {
+            destroy_node(x);
+        }
+        return {left, right};
+    }
+
+    // 子树中的键数, 只数每个节点的 n, O(节点数)
+    std::size_t count_keys(const Node* node) const {
+        if (!node)
+            return 0;
+        std::size_t size = node->n;
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++)
+                size += count_keys(children(node)[i]);
+        }
+        return size;
+    }
+
+    // 移除最小 (max = false) 或最大的键, 移到 scratch 的 0 号槽位; 树非空
+    void pop_edge(bool max, Node* scratch) {
+        DescentPath path;
+        Node* leaf = descend_filled(root, max, path);
+        int idx = max ? leaf->n - 1 : 0;
+        move_slots(scratch, 0, leaf, idx, 1);
+        scratch->n = 1;
+        erase_slot(leaf, idx);
+        path.add(this, -1);
+        count--;
+        if (root->n == 0 && !root->leaf) {
+            Node* old_root = root;
+            root = children(root)[0];
+            destroy_node(old_root);
+        }
+    }
+
+    const K* edge_key(bool max) const {
+        if (empty())
+            return nullptr;
+        const Node* node = root;
+        while (!node->leaf)
+            node = children(node)[max ? node->n : 0];
+        return &keys(node)[max ? node->n - 1 : 0];
+    }
+
+    // 新的一棵树 (split_at 的结果) 使用的分配器
+    Allocator sibling_allocator() const {
+        if constexpr (btree_detail::has_fork<Allocator>::value) {
+            return alloc.fork();
+        } else {
+            return alloc;
+        }
+    }
+
+    // 本树的节点已经全部转移走: 换用新的分配器, 旧分配器的 slab 只由接收节点的树继续持有
+    // (否则反复拆分/合并时, 每次都会在对方那里留下一个只装着空根节点的 slab)
+    void renew_allocator() {
+        if constexpr (btree_detail::has_fork<Allocator>::value) {
+            alloc = alloc.fork();
+        }
+    }
+
+    void check_joinable(const BTreeBase& other) const {
+        if (static_cast<int>(t) != static_cast<int>(other.t)) {
+            throw std::invalid_argument("trees must have the same minimum degree");
+        }
+    }
+
+    // 把 other 整棵拼到本树的一侧: other 中的键都 >= 本树的键 (或都 <=), 否则抛出 std::invalid_argument
+    // other 的一个边界键作为分隔键, O(t log n)
+    void merge_tree(BTreeBase& other) {
+        check_joinable(other);
+        if (other.empty())
+            return;
+        bool other_right;
+        if (empty() || !comp(*other.edge_key(false), *edge_key(true))) {
+            other_right = true;
+        } else if (!comp(*edge_key(false), *other.edge_key(true))) {
+            other_right = false;
+        } else {
+            throw std::invalid_argument("merge_with requires key-disjoint trees");
+        }
+        other.alloc.share(alloc);
+
+        Node* scratch = create_node(true);
+        other.pop_edge(!other_right, scratch);
+        settle_count();
+        other.settle_count();
+        bool stale = count_stale || other.count_stale;
+        Piece mine = take_piece();
+        Piece theirs = other.take_piece();
+        std::size_t size = mine.size + theirs.size + 1;
+        Piece joined = other_right ? join_pieces(mine, scratch, 0, theirs) : join_pieces(theirs, scratch, 0, mine);
+        destroy_node(scratch);
+        put_piece(joined, size, stale);
+        other.renew_allocator();
+        other.put_piece(empty_piece(), 0);
+    }
+
+    // 拼接: 本树 + scratch 的 0 号槽位 + right, 顺序由调用者保证; 结果留在本树, right 变为空树
+    void join_tree(Node* scratch, BTreeBase& right) {
+        check_joinable(right);
+        right.alloc.share(alloc);
+        settle_count();
+        right.settle_count();
+        bool stale = count_stale || right.count_stale;
+        Piece mine = take_piece();
+        Piece theirs = right.take_piece();
+        std::size_t size = mine.size + theirs.size + 1;
+        put_piece(join_pieces(mine, scratch, 0, theirs), size, stale);
+        right.renew_allocator();
+        right.put_piece(empty_piece(), 0);
+    }
+
+    // 拆分: >= key 的键移到 right (一棵空树), 本树保留 < key 的键, O(t log n)
+    // 没有子树计数 (NoAugment) 时两边的键数都未知, 标记为 count_stale, 推迟到 size() 时再数
+    template <typename Key>
+    void split_tree(const Key& key, BTreeBase& right) {
+        check_joinable(right);
+        right.destroy_tree();
+        right.renew_allocator();
+        alloc.share(right.alloc);
+        settle_count();
+        std::size_t total = count;
+        bool stale = count_stale;
+        Piece whole = take_piece();
+        if (!whole.root) {
+            put_piece(whole, 0);
+            right.put_piece(whole, 0);
+            return;
+        }
+        Node* scratch = create_node(true);
+        auto [left_part, right_part] = split_piece(whole.root, whole.height, key, scratch);
+        destroy_node(scratch);
+
+        if constexpr (kCounted) {
+            std::size_t right_size = right_part.root ? right_part.size : 0;
+            put_piece(left_part, total - right_size);
+            right.put_piece(right_part, right_size);
+        } else {
+            // 一侧为空时另一侧就是原来的全部键
+            put_piece(left_part, right_part.root ? 0 : total, stale || right_part.root);
+            right.put_piece(right_part, left_part.root ? 0 : total, stale || left_part.root);
+        }
+    }
+
+    template <typename Out>
+    void drain_sorted(Out& out) {
+        if (root) {
+            drain_subtree(root, out);
+            destroy_subtree(root);
+        }
+        root = create_node(true);
+        count = 0;
+        count_stale = false;
+    }
+
+    template <typename Out>
+    void drain_subtree(Node* node, Out& out) {
+        for (int i = 0; i < node->n; i++) {
+            if (!node->leaf)
+                drain_subtree(children(node)[i], out);
+            if constexpr (kHasValues) {
+                out(std::move(keys(node)[i]), std::move(values(node)[i]));
+            } else {
+                out(std::move(keys(node)[i]));
+            }
+        }
+        if (!node->leaf)
+            drain_subtree(children(node)[node->n], out);
+    }
+
+    BTreeBase(int min_degree, Compare compare, Allocator allocator)
+        : root(nullptr), t(min_degree), count(0), comp(std::move(compare)), alloc(std::move(allocator)) {
         if (min_degree < 2) {
             throw std::invalid_argument("Minimum degree must be at least 2");
         }
-        root = std::make_shared<Node>();
+        if (Degree > 0 && min_degree != Degree) {
+            throw std::invalid_argument("Minimum degree must match the compile-time Degree");
+        }
+        node_layout = make_layout(min_degree);
+        if constexpr (kStats) {
+            stats_counters = std::make_unique<StatsCounters>();
+        }
+        root = create_node(true);
+    }
+
+    BTreeBase(BTreeBase&& other) noexcept
+        : root(other.root), t(other.t), count(other.count), count_stale(other.count_stale),
+          stale_base(other.stale_base.load(std::memory_order_relaxed)), node_layout(other.node_layout),
+          comp(std::move(other.comp)), alloc(std::move(other.alloc)), stats_counters(std::move(other.stats_counters)) {
+        other.root = nullptr;
+        other.count = 0;
+        other.count_stale = false;
+    }
+
+    BTreeBase& operator=(BTreeBase&& other) noexcept {
+        if (this != &other) {
+            destroy_tree();
+            root = other.root;
+            t = other.t;
+            count = other.count;
+            count_stale = other.count_stale;
+            stale_base.store(other.stale_base.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            node_layout = other.node_layout;
+            comp = std::move(other.comp);
+            alloc = std::move(other.alloc);
+            stats_counters = std::move(other.stats_counters);
+            other.root = nullptr;
+            other.count = 0;
+            other.count_stale = false;
+        }
+        return *this;
+    }
+
+    ~BTreeBase() {
+        destroy_tree();
+    }
+
+public:
+    // 双向迭代器, 用一个显式的路径栈记录从根到当前节点的下降路径, 不需要父指针
+    /*
+    栈中每一层 {node, idx}:
+      - 栈顶: 当前键 node->keys[idx]
+      - 祖先: 下降时进入的子节点下标 idx; 回到该层时下一个键就是 keys[idx]
+    depth == 0 表示 end()
+    任何插入/删除之后, 已有的迭代器全部失效
+    */
+    template <bool Const>
+    class basic_iterator {
+        friend class BTreeBase;
+        template <bool> friend class basic_iterator;
+        using tree_pointer = std::conditional_t<Const, const BTreeBase*, BTreeBase*>;
+        using value_reference = std::conditional_t<Const, const value_storage&, value_storage&>;
+
+        struct Frame {
+            Node* node;
+            int idx;
+        };
+
+        tree_pointer tree = nullptr;
+        int depth = 0;
+        Frame path[kMaxHeight];
+
+        explicit basic_iterator(tree_pointer tree) : tree(tree) {}
+
+        Frame& top() { return path[depth - 1]; }
+        const Frame& top() const { return path[depth - 1]; }
+
+        void push_leftmost(Node* node) {
+            while (true) {
+                path[depth++] = Frame{node, 0};
+                if (node->leaf)
+                    break;
+                node = tree->children(node)[0];
+            }
+        }
+
+        void push_rightmost(Node* node) {
+            while (!node->leaf) {
+                path[depth++] = Frame{node, node->n};
+                node = tree->children(node)[node->n];
+            }
+            path[depth++] = Frame{node, node->n - 1};
+        }
+
+        // 栈顶叶子已经走完: 向上回到第一个还有键没访问的祖先
+        void pop_exhausted() {
+            --depth;
+            while (depth > 0 && top().idx == top().node->n)
+                --depth;
+        }
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::conditional_t<kHasValues, std::pair<const K, value_storage>, K>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<kHasValues, std::pair<const K&, value_reference>, const K&>;
+        using pointer = void;
+
+        basic_iterator() = default;
+
+        // iterator -> const_iterator
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other) : tree(other.tree), depth(other.depth) {
+            for (int i = 0; i < depth; i++)
+                path[i] = Frame{other.path[i].node, other.path[i].idx};
+        }
+
+        const K& key() const { return top().node->keys()[top().idx]; }
+
+        value_reference value() const {
+            static_assert(kHasValues, "value() is only available on maps");
+            return tree->values(top().node)[top().idx];
+        }
+
+        reference operator*() const {
+            if constexpr (kHasValues) {
+                return reference(key(), value());
+            } else {
+                return key();
+            }
+        }
+
+        basic_iterator& operator++() {
+            Frame& f = top();
+            if (!f.node->leaf) {
+                // 下一个键是右侧子树 children[idx+1] 的最左键
+                f.idx++;
+                push_leftmost(tree->children(f.node)[f.idx]);
+            } else if (++f.idx == f.node->n) {
+                pop_exhausted();
+            }
+            return *this;
+        }
+
+        basic_iterator& operator--() {
+            if (depth == 0) {
+                // --end(): 最后一个键
+                if (tree->root && tree->root->n > 0)
+                    push_rightmost(tree->root);
+                return *this;
+            }
+            Frame& f = top();
+            if (!f.node->leaf) {
+                // 上一个键是左侧子树 children[idx] 的最右键
+                push_rightmost(tree->children(f.node)[f.idx]);
+            } else if (f.idx > 0) {
+                f.idx--;
+            } else {
+                --depth;
+                while (depth > 0 && top().idx == 0)
+                    --depth;
+                if (depth > 0)
+                    top().idx--;
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        basic_iterator operator--(int) {
+            basic_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) {
+            if (a.depth != b.depth)
+                return false;
+            return a.depth == 0 || (a.top().node == b.top().node && a.top().idx == b.top().idx);
+        }
+
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) {
+            return !(a == b);
+        }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+protected:
+    // 自顶向下定位第一个 >= key (Upper: > key) 的位置, 沿途记录路径
+    template <typename It, typename Tree, typename Key>
+    static It bound(Tree* tree, const Key& key, bool upper) {
+        It it(tree);
+        Node* node = tree->root;
+        if (!node)
+            return it;
+        while (true) {
+            int i = upper ? tree->upper_bound_in(node, key) : tree->lower_bound_in(node, key);
+            it.path[it.depth++] = typename It::Frame{node, i};
+            if (node->leaf)
+                break;
+            node = tree->children(node)[i];
+        }
+        if (it.top().idx == it.top().node->n)
+            it.pop_exhausted();
+        return it;
+    }
+
+    // 第 k 小的键 (从0开始) 的位置, 沿子树计数下降; k >= size() 时返回 end()
+    template <typename It, typename Tree>
+    static It select_at(Tree* tree, std::size_t k) {
+        It it(tree);
+        if (k >= tree->count)
+            return it;
+        Node* node = tree->root;
+        while (!node->leaf) {
+            const std::size_t* c = tree->counts(node);
+            int j = 0;
+            while (k >= c[j]) {
+                k -= c[j];
+                if (k == 0) {
+                    it.path[it.depth++] = typename It::Frame{node, j};
+                    return it;
+                }
+                k--;
+                j++;
+            }
+            it.path[it.depth++] = typename It::Frame{node, j};
+            node = tree->children(node)[j];
+        }
+        it.path[it.depth++] = typename It::Frame{node, static_cast<int>(k)};
+        return it;
+    }
+
+    // 小于 key (Upper: 不大于 key) 的键数
+    template <bool Upper, typename Key>
+    std::size_t rank_impl(const Key& key) const {
+        std::size_t r = 0;
+        const Node* node = root;
+        while (node) {
+            int i = Upper ? upper_bound_in(node, key) : lower_bound_in(node, key);
+            r += static_cast<std::size_t>(i);
+            if (node->leaf)
+                break;
+            const std::size_t* c = counts(node);
+            for (int j = 0; j < i; j++)
+                r += c[j];
+            node = children(node)[i];
+        }
+        return r;
+    }
+
+    // 闭区间 [lo, hi] 在子树 node 中的聚合值; lo/hi 为 nullptr 表示该侧不受限
+    // 区间完全覆盖的子树直接使用缓存的聚合值, 只沿左右两条边界路径下降
+    /*
+    示例: reduce(25, 75)
+              [30          60]
+             /       |       \
+      [10 20 25]  [40 50]  [70 80 90]
+      根: i_lo = 0, i_hi = 2
+      结果 = reduce([10 20 25], lo=25) + 30 + aggs[1] + 60 + reduce([70 80 90], hi=75)
+    */
+    agg_type reduce_in(const Node* node, const K* lo, const K* hi) const {
+        int i_lo = lo ? lower_bound_in(node, *lo) : 0;
+        int i_hi = hi ? upper_bound_in(node, *hi) : node->n;
+        agg_type acc = Augment::identity();
+        if (node->leaf) {
+            for (int i = i_lo; i < i_hi; i++)
+                acc = Augment::combine(acc, lift_slot(node, i));
+            return acc;
+        }
+        const Node* const* c = children(node);
+        if (i_lo == i_hi)
+            return reduce_in(c[i_lo], lo, hi);
+        acc = lo ? reduce_in(c[i_lo], lo, nullptr) : aggs(node)[i_lo];
+        for (int i = i_lo; i < i_hi; i++) {
+            acc = Augment::combine(acc, lift_slot(node, i));
+            if (i + 1 < i_hi)
+                acc = Augment::combine(acc, aggs(node)[i + 1]);
+        }
+        return Augment::combine(acc, hi ? reduce_in(c[i_hi], nullptr, hi) : aggs(node)[i_hi]);
+    }
+
+    // 就地修改了 key 所在槽位的值之后, 重新计算从根到该槽位路径上的聚合值
+    void refresh_aggregates(const K& key) {
+        if constexpr (kAggregated) {
+            DescentPath path;
+            Node* node = root;
+            while (node) {
+                int i = lower_bound_in(node, key);
+                if ((i < node->n && key_equal(keys(node)[i], key)) || node->leaf)
+                    break;
+                path.push(node, i);
+                node = children(node)[i];
+            }
+            path.add(this, 0);
+        }
     }
 
-    const std::shared_ptr<Node>& get_root() const { return root; }
+    template <typename It, typename Tree>
+    static It first(Tree* tree) {
+        It it(tree);
+        if (tree->root && tree->root->n > 0)
+            it.push_leftmost(tree->root);
+        return it;
+    }
+
+    // scan 回调返回 bool 时, 返回 false 表示提前结束
+    template <typename F, typename... Args>
+    static bool invoke_scan(F& fn, Args&&... args) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, Args...>, bool>) {
+            return fn(std::forward<Args>(args)...);
+        } else {
+            fn(std::forward<Args>(args)...);
+            return true;
+        }
+    }
+
+    template <typename It, typename Tree, typename Key, typename F>
+    static void scan_range(Tree* tree, const Key& lo, const Key& hi, F& fn) {
+        It last(tree);
+        for (It it = bound<It>(tree, lo, false); it != last && !tree->comp(hi, it.key()); ++it) {
+            bool go_on;
+            if constexpr (kHasValues) {
+                go_on = invoke_scan(fn, it.key(), it.value());
+            } else {
+                go_on = invoke_scan(fn, it.key());
+            }
+            if (!go_on)
+                break;
+        }
+    }
+
+public:
+    BTreeBase(const BTreeBase&) = delete;
+    BTreeBase& operator=(const BTreeBase&) = delete;
+
+    iterator begin() { return first<iterator>(this); }
+    iterator end() { return iterator(this); }
+    const_iterator begin() const { return first<const_iterator>(this); }
+    const_iterator end() const { return const_iterator(this); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // 第一个 >= key 的位置
+    iterator lower_bound(const K& key) { return bound<iterator>(this, key, false); }
+    const_iterator lower_bound(const K& key) const { return bound<const_iterator>(this, key, false); }
+
+    // 第一个 > key 的位置
+    iterator upper_bound(const K& key) { return bound<iterator>(this, key, true); }
+    const_iterator upper_bound(const K& key) const { return bound<const_iterator>(this, key, true); }
+
+    // 比较器声明了 is_transparent (如 std::less<>) 时, 可以直接用能与 K 比较的类型查找, 不构造临时的 K
+    /*
+    示例:
+      BTree<std::string, std::less<>> tree(16);
+      std::string_view name = ...;              // 指向网络缓冲区
+      tree.contains(name); tree.lower_bound(name); tree.remove(name);
+    */
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const Key& key) { return bound<iterator>(this, key, false); }
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator lower_bound(const Key& key) const { return bound<const_iterator>(this, key, false); }
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const Key& key) { return bound<iterator>(this, key, true); }
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator upper_bound(const Key& key) const { return bound<const_iterator>(this, key, true); }
+
+    // 按顺序访问闭区间 [lo, hi] 内的所有键, O(log n + k), 不递归
+    // 集合: fn(const K&); 映射: fn(const K&, V&)。fn 返回 bool 时, 返回 false 提前结束
+    template <typename F>
+    void scan(const K& lo, const K& hi, F&& fn) {
+        scan_range<iterator>(this, lo, hi, fn);
+    }
+    template <typename F>
+    void scan(const K& lo, const K& hi, F&& fn) const {
+        scan_range<const_iterator>(this, lo, hi, fn);
+    }
+    template <typename Key, typename F, typename C = Compare, typename = typename C::is_transparent>
+    void scan(const Key& lo, const Key& hi, F&& fn) {
+        scan_range<iterator>(this, lo, hi, fn);
+    }
+    template <typename Key, typename F, typename C = Compare, typename = typename C::is_transparent>
+    void scan(const Key& lo, const Key& hi, F&& fn) const {
+        scan_range<const_iterator>(this, lo, hi, fn);
+    }
+
+    // ---- 顺序统计 (Augment = OrderStatistic), 每个 O(t log n) ----
+
+    // 小于 key 的键数, 即 lower_bound(key) 在有序序列中的下标
+    std::size_t rank(const K& key) const {
+        static_assert(kCounted, "rank() needs an Augment (OrderStatistic or a monoid)");
+        return rank_impl<false>(key);
+    }
+
+    // 第 k 小的键 (从0开始) 的位置, k >= size() 时返回 end()
+    iterator select(std::size_t k) {
+        static_assert(kCounted, "select() needs an Augment (OrderStatistic or a monoid)");
+        return select_at<iterator>(this, k);
+    }
+    const_iterator select(std::size_t k) const {
+        static_assert(kCounted, "select() needs an Augment (OrderStatistic or a monoid)");
+        return select_at<const_iterator>(this, k);
+    }
+
+    // 闭区间 [lo, hi] 内的键数, hi < lo 时为 0
+    std::size_t count_range(const K& lo, const K& hi) const {
+        static_assert(kCounted, "count_range() needs an Augment (OrderStatistic or a monoid)");
+        if (comp(hi, lo))
+            return 0;
+        return rank_impl<true>(hi) - rank_impl<false>(lo);
+    }
+
+    // 闭区间 [lo, hi] 内所有键 (BTreeMap 中为键值对) 的聚合值, hi < lo 时为单位元
+    // 需要幺半群 Augment (如 SumOf/MinOf/MaxOf), O(t log n), 与区间长度无关
+    agg_type reduce(const K& lo, const K& hi) const {
+        static_assert(kAggregated, "reduce() needs a monoid Augment such as SumOf<T>");
+        if (!root || comp(hi, lo))
+            return Augment::identity();
+        return reduce_in(root, &lo, &hi);
+    }
+
+    // 整棵树的聚合值, O(t)
+    agg_type aggregate() const {
+        static_assert(kAggregated, "aggregate() needs a monoid Augment such as SumOf<T>");
+        return root ? node_agg(root) : Augment::identity();
+    }
+
+    // 运行统计: 事件计数 (BTREE_STATS 时) + 遍历整棵树得到的结构信息, O(节点数)
+    /*
+    示例:
+      auto s = tree.stats();
+      std::puts(s.to_json().c_str());
+      // {"enabled":true,"splits":2043,"merges":0,...,"height":4,"nodes":2046,...,"fill_histogram":[0,0,0,0,2045,0,...]}
+    */
+    BTreeStats stats() const {
+        BTreeStats s;
+        s.enabled = kStats;
+        if constexpr (kStats) {
+            if (stats_counters) {
+                s.splits = stats_counters->total(kStatSplit);
+                s.merges = stats_counters->total(kStatMerge);
+                s.borrows_prev = stats_counters->total(kStatBorrowPrev);
+                s.borrows_next = stats_counters->total(kStatBorrowNext);
+                s.root_grows = stats_counters->total(kStatRootGrow);
+                s.root_shrinks = stats_counters->total(kStatRootShrink);
+                s.searches = stats_counters->total(kStatSearch);
+                s.search_nodes = stats_counters->total(kStatSearchNode);
+                s.search_comparisons = stats_counters->total(kStatSearchComparison);
+            }
+        }
+        if (!root)
+            return s;
+        for (const Node* node = root;; node = children(node)[0]) {
+            s.height++;
+            if (node->leaf)
+                break;
+        }
+        std::vector<const Node*> stack = {root};
+        while (!stack.empty()) {
+            const Node* node = stack.back();
+            stack.pop_back();
+            s.nodes++;
+            s.size += node->n;  // 不用 size(): 拆分后键数未知时会另外遍历一次
+            s.bytes += node->leaf ? layout().leaf_bytes : layout().internal_bytes;
+            int bucket = node->n * BTreeStats::kFillBuckets / (2 * t - 1);
+            s.fill_histogram[std::min(bucket, BTreeStats::kFillBuckets - 1)]++;
+            if (node->leaf) {
+                s.leaves++;
+            } else {
+                for (int i = 0; i <= node->n; i++)
+                    stack.push_back(children(node)[i]);
+            }
+        }
+        return s;
+    }
+
+    // 检查B树的性质, 用于测试和调试, O(n): 非根节点的键数在 [t-1, 2t-1], 键有序 (包括相对父节点的分隔键),
+    // 叶子在同一层, 键数与 size() 一致, kCounted 时子树计数正确
+    bool validate() const {
+        if (!root)
+            return count == 0;
+        int leaf_depth = -1;
+        std::size_t total = 0;
+        return validate_node(root, 0, nullptr, nullptr, leaf_depth, total) && total == size();
+    }
+
+    const Node* get_root() const { return root; }
+    const Allocator& get_allocator() const { return alloc; }
+    const Compare& key_comp() const { return comp; }
     int get_min_degree() const { return t; }
     int get_max_keys() const { return 2 * t - 1; }
     int get_min_keys() const { return t - 1; }
+    // O(1); 拆分/拼接后的 NoAugment 树第一次调用时数一遍键数, O(节点数)
+    // 不修改树的结构, 多个线程可以同时调用
+    std::size_t size() const {
+        if (!count_stale)
+            return count;
+        std::size_t base = stale_base.load(std::memory_order_relaxed);
+        if (base == kUnknownSize) {
+            base = count_keys(root) - count;
+            stale_base.store(base, std::memory_order_relaxed);
+        }
+        return base + count;
+    }
+    // 非空的树的根节点至少有一个键
+    bool empty() const { return count_stale ? root->n == 0 : count == 0; }
+};
+
+} // namespace btree_detail
+
+// 只存储键的B树, 允许重复键 (每个副本占一个槽位; 需要按次数计数的重复键见 btree_multiset.h)
+// Compare:   键比较器, 默认 std::less<T>
+// Allocator: 节点分配器, 接口见 node_arena.h; 默认每棵树一个 NodeArena
+// Augment:   节点增强策略, 默认 NoAugment; OrderStatistic 时支持 rank/select/count_range,
+//            SumOf/MinOf/MaxOf 等幺半群时另外支持 reduce(lo, hi)
+// Degree:    编译期的最小度数, 默认 0 表示由构造函数给定; 通常经由 FixedBTree / CacheSizedBTree 使用
+template <typename T, typename Compare = std::less<T>, typename Allocator = NodeArena, typename Augment = NoAugment,
+          int Degree = 0>
+class BTree : public btree_detail::BTreeBase<T, void, Compare, Allocator, Augment, Degree> {
+    using Base = btree_detail::BTreeBase<T, void, Compare, Allocator, Augment, Degree>;
+    using Node = typename Base::Node;
+
+public:
+    BTree(int min_degree, Compare compare = Compare(), Allocator allocator = Allocator())
+        : Base(min_degree, std::move(compare), std::move(allocator)) {}
+
+    BTree(int min_degree, Allocator allocator)
+        : Base(min_degree, Compare(), std::move(allocator)) {}
+
+    // 编译期度数的树不需要再给出 min_degree
+    template <int D = Degree, typename = std::enable_if_t<(D > 0)>>
+    explicit BTree(Compare compare = Compare(), Allocator allocator = Allocator())
+        : Base(Degree, std::move(compare), std::move(allocator)) {}
+
+    BTree(BTree&&) noexcept = default;
+    BTree& operator=(BTree&&) noexcept = default;
+
     // 插入操作
     /*
     示例插入过程:
@@ -294,32 +2322,202 @@ public:
     3. 向下递归插入新键
     */
     void insert(const T& key) {
-        if (root->keys.size() == 2 * t - 1) {
-            auto new_root = std::make_shared<Node>(false);
-            new_root->children.push_back(root);
-            root = new_root;
-            split_child(root, 0); // Updated call without child parameter
-            insert_non_full(root, key);
-        } else {
-            insert_non_full(root, key);
-        }
+        this->grow_root_if_full();
+        this->insert_non_full(this->root, key);
+        this->count++;
+    }
+
+    // 右值键直接移动进叶子, 不复制
+    void insert(T&& key) {
+        this->grow_root_if_full();
+        this->insert_non_full(this->root, std::move(key));
+        this->count++;
+    }
+
+    // 用 args 构造键后插入 (构造一次, 之后只移动)
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        insert(T(std::forward<Args>(args)...));
     }
 
     std::optional<T> search(const T& key) const {
-        return search_internal(root, key);
+        return search_impl(key);
     }
-    
+
+    bool contains(const T& key) const {
+        int idx;
+        return this->search_internal(this->root, key, idx) != nullptr;
+    }
+
     void remove(const T& key) {
-        if (!root)
-            return;
+        this->erase_key(key);
+    }
 
-        remove_internal(root, key);
+    // 透明比较器 (Compare::is_transparent) 时的异构查找/删除, key 为任何能与 T 比较的类型
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    std::optional<T> search(const Key& key) const {
+        return search_impl(key);
+    }
 
-        if (root->keys.empty()) {
-            if (root->leaf)
-                root.reset();
-            else
-                root = root->children[0];
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    bool contains(const Key& key) const {
+        int idx;
+        return this->search_internal(this->root, key, idx) != nullptr;
+    }
+
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    void remove(const Key& key) {
+        this->erase_key(key);
+    }
+
+    // 批量插入: 先排序, 落在同一个叶子的相邻键共用一次从根开始的下降
+    // 相等的键按它们在批量中的顺序排在已有键之后, 与逐个 insert 一致
+    void insert_batch(const T* keys, std::size_t n) {
+        auto order = this->sorted_order(n, [&](std::size_t i) -> const T& { return keys[i]; });
+        this->template insert_sorted<false>(
+            n, [&](std::size_t j) -> const T& { return keys[order[j]]; },
+            [&](Node* leaf, int idx, std::size_t j) { this->insert_slot(leaf, idx, keys[order[j]]); },
+            [](auto, std::size_t) {});
+    }
+
+    // 批量查找: found[i] 表示 keys[i] 是否存在
+    // 按键排序后分组下降, 上层节点每批只读一次, 并预取下一层要访问的节点
+    void search_batch(const T* keys, std::size_t n, bool* found) const {
+        auto order = this->sorted_order(n, [&](std::size_t i) -> const T& { return keys[i]; });
+        this->search_batch_impl(
+            n, [&](std::size_t j) -> const T& { return keys[order[j]]; },
+            [&](std::size_t j, const Node* node, int) { found[order[j]] = node != nullptr; });
+    }
+
+    // 用有序(非降序)序列替换树的全部内容, 自底向上逐层构建, O(n), 每个节点分配一次
+    // fill_factor: 每个节点的装填比例 (0, 1], 1.0 表示装满 2t-1 个键;
+    //              之后还有大量插入时取较小值, 避免刚建好就分裂
+    // 输入无序时抛出 std::invalid_argument
+    template <typename ForwardIt>
+    void bulk_load(ForwardIt first, ForwardIt last, double fill_factor = 1.0) {
+        if (!std::is_sorted(first, last, this->comp)) {
+            throw std::invalid_argument("bulk_load input must be sorted");
         }
+        std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+        this->build_from_sorted(first, n, fill_factor, [this](Node* node, auto&& key) {
+            this->insert_slot(node, node->n, std::forward<decltype(key)>(key));
+        });
     }
-};
\ No newline at end of file
+
+    // 把一批有序键合并进已有的树: 线性归并后整体重建, O(size() + batch)
+    // 批量较大时比逐个 insert 快; 相等的键排在原有键之后, 与 insert 一致
+    template <typename ForwardIt>
+    void merge_load(ForwardIt first, ForwardIt last, double fill_factor = 1.0) {
+        if (!std::is_sorted(first, last, this->comp)) {
+            throw std::invalid_argument("merge_load input must be sorted");
+        }
+        std::vector<T> existing;
+        existing.reserve(this->size());
+        auto out = [&](T&& key) { existing.push_back(std::move(key)); };
+        this->drain_sorted(out);
+
+        std::vector<T> merged;
+        merged.reserve(existing.size() + static_cast<std::size_t>(std::distance(first, last)));
+        std::merge(std::make_move_iterator(existing.begin()), std::make_move_iterator(existing.end()),
+                   first, last, std::back_inserter(merged), this->comp);
+        existing.clear();
+        bulk_load(std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()), fill_factor);
+    }
+
+    // 并行批量构建: 用 keys (可以无序) 替换树的全部内容, 结果与排序后 bulk_load 相同
+    // 先并行排序, 再把下层的子树分给 threads 个线程各自构建, 上面几层在当前线程上连接
+    // threads = 0 时使用全部硬件线程; 分配器没有 fork() 时 (如 NodeArenaRef) 只有排序是并行的
+    void bulk_load_parallel(std::vector<T> keys, unsigned threads = 0, double fill_factor = 1.0) {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        btree_detail::parallel_sort(keys.begin(), keys.end(), this->comp, threads);
+        this->build_from_sorted_parallel(std::make_move_iterator(keys.begin()), keys.size(), fill_factor, threads,
+                                         [this](Node* node, auto&& key) {
+                                             this->insert_slot(node, node->n, std::forward<decltype(key)>(key));
+                                         });
+    }
+
+    // ---- 拼接与拆分: 节点直接在树之间转移, 不复制键, O(t log n) ----
+    // 两棵树的最小度数必须相同, 否则抛出 std::invalid_argument; 转移后的节点由两边的分配器
+    // 共同持有 (见 node_arena.h 中的 share), NodeArenaRef 要求引用同一个 arena
+
+    // 拼接: left 中的键 <= key <= right 中的键, 否则抛出 std::invalid_argument; right 变为空树
+    static BTree join(BTree&& left, T key, BTree&& right) {
+        if ((!left.empty() && left.comp(key, *left.edge_key(true))) ||
+            (!right.empty() && left.comp(*right.edge_key(false), key))) {
+            throw std::invalid_argument("join requires left <= key <= right");
+        }
+        Node* scratch = left.create_node(true);
+        left.insert_slot(scratch, 0, std::move(key));
+        try {
+            left.join_tree(scratch, right);
+        } catch (...) {
+            left.destroy_node(scratch);
+            throw;
+        }
+        left.destroy_node(scratch);
+        return std::move(left);
+    }
+
+    // 合并一棵键区间不相交的树: other 的键都 >= 本树的键 (或都 <=), 否则抛出 std::invalid_argument
+    // other 的一个边界键取出来作为分隔键, 然后与 join 相同; other 变为空树
+    void merge_with(BTree&& other) {
+        this->merge_tree(other);
+    }
+
+    // 拆分: 返回 >= key 的键组成的树, 本树保留 < key 的键, O(t log n)
+    // Augment = NoAugment 时两棵树的键数推迟到第一次调用 size() 时再数, O(节点数)
+    BTree split_at(const T& key) {
+        BTree right(this->t, this->comp, this->sibling_allocator());
+        this->split_tree(key, right);
+        return right;
+    }
+
+    // 用当前内容构建只读的静态索引 (Eytzinger 布局, 无分支查找), O(n)
+    // (拆分后键数未知的 NoAugment 树先数一遍键数, 同样是 O(n))
+    // 之后对树的修改不会反映到索引中
+    StaticIndex<T, Compare> build_static_index() const {
+        return StaticIndex<T, Compare>(this->begin(), this->size(), this->comp);
+    }
+
+    // 把当前内容写成只读的冻结格式文件, 之后用 FrozenBTree<T, Compare> 映射打开 (需要包含 frozen_btree.h)
+    // node_keys: 冻结文件中每个节点的键数, 0 表示一个节点占 64 字节
+    // 先写 path + ".tmp" 再 rename, 已经打开旧文件的 FrozenBTree 继续看到旧内容
+    // (拆分后键数未知的 NoAugment 树先数一遍键数, 同样是 O(n))
+    void freeze(const std::string& path, int node_keys = 0) const {
+        btree_detail::FrozenWriter<T, Compare>::write(path, this->begin(), this->end(), this->size(), node_keys);
+    }
+
+private:
+    template <typename Key>
+    std::optional<T> search_impl(const Key& key) const {
+        int idx;
+        const Node* node = this->search_internal(this->root, key, idx);
+        if (!node) {
+            return std::nullopt;
+        }
+        return node->key(idx);
+    }
+};
+
+// 编译期度数的 BTree: FixedBTree<int, 32> 与 BTree<int>(32) 的结构和行为相同,
+// 但 2t-1、t-1 等边界和节点内各数组的偏移都是常量, 不需要从树中读取
+template <typename T, int Degree, typename Compare = std::less<T>, typename Allocator = NodeArena,
+          typename Augment = NoAugment>
+using FixedBTree = BTree<T, Compare, Allocator, Augment, Degree>;
+
+// 叶子节点 (键数组连同节点头) 不超过 node_bytes 字节的最大度数, 至少为 2
+// 叶子占节点总数的绝大部分, 查找也总是结束在叶子上, 因此按叶子的大小选取;
+// 内部节点另外带 2t 个子节点指针, 会比 node_bytes 大
+template <typename T>
+constexpr int degree_for_node_bytes(std::size_t node_bytes) {
+    using Node = typename btree_detail::BTreeBase<T, void, std::less<T>, NodeArena>::Node;
+    if (node_bytes <= Node::keys_offset())
+        return 2;
+    std::size_t max_keys = (node_bytes - Node::keys_offset()) / sizeof(T);
+    return std::max(2, static_cast<int>((max_keys + 1) / 2));
+}
+
+// 按节点字节数 (如 256 = 4 条 cache line, 4096 = 一页) 选取编译期度数的 BTree
+template <typename T, std::size_t NodeBytes, typename Compare = std::less<T>, typename Allocator = NodeArena>
+using CacheSizedBTree = FixedBTree<T, degree_for_node_bytes<T>(NodeBytes), Compare, Allocator>;
@@ -0,0 +1,97 @@
+#ifndef BTREE_C_H
+#define BTREE_C_H
+/*
+ * libbtree_c: 记录为定长字节串的 B 树 (C99), 实现见仓库根目录的 btree.c
+ *
+ * 记录是 record_size 字节的任意数据, 由用户的比较函数排序; 比较函数可以只看记录的前缀
+ * (键), 其余字节作为值随记录一起存放:
+ *
+ *     struct row { int64_t id; double score; };
+ *     static int by_id(const void *a, const void *b, void *ctx) {
+ *         int64_t x, y;
+ *         memcpy(&x, a, sizeof x); memcpy(&y, b, sizeof y);
+ *         return (x > y) - (x < y);
+ *     }
+ *     btree *T = btree_create(sizeof(struct row), 32, by_id, NULL);
+ *     struct row r = {42, 1.5};
+ *     btree_insert(T, &r);
+ *     const struct row *hit = btree_find(T, &r);    // 只比较 id
+ *
+ * 键唯一。每个节点一次分配: [头部 | 子节点指针[2t] (仅内部节点) | 记录[2t-1]]。
+ * 记录在节点内按 record_size 紧密排列, 不保证按记录类型对齐, 比较函数应当用 memcpy 读取字段。
+ * 返回的记录指针和迭代器在下一次修改树 (插入/删除) 之前有效。
+ * 树本身不加锁; 没有写者时多个线程可以同时读。
+ */
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 返回值 */
+enum {
+    BTREE_OK = 0,
+    BTREE_EXISTS = 1,     /* 插入时已有相等的记录 */
+    BTREE_NOT_FOUND = 2,  /* 删除时没有相等的记录 */
+    BTREE_ENOMEM = -1     /* 分配失败, 树中的记录不变 */
+};
+
+/* 迭代器路径栈的最大深度; t >= 2 时 64 层足以容纳 2^64 条记录 */
+#define BTREE_MAX_HEIGHT 64
+
+/* 返回 <0 / 0 / >0 表示 a 小于 / 等于 / 大于 b */
+typedef int (*btree_compare_fn)(const void *a, const void *b, void *ctx);
+
+/* 范围扫描的回调, 返回 0 提前结束 */
+typedef int (*btree_visit_fn)(const void *record, void *ctx);
+
+typedef struct btree btree;
+typedef struct btree_node btree_node;
+
+/* 迭代器: 从根到当前记录的路径, 可以放在栈上 */
+typedef struct btree_iter {
+    const btree *tree;
+    int depth; /* 0 表示已经走完 */
+    struct {
+        const btree_node *node;
+        int idx;
+    } path[BTREE_MAX_HEIGHT];
+} btree_iter;
+
+/* 创建一棵空树; record_size > 0, t (最小度数) >= 2, 参数非法或分配失败时返回 NULL */
+btree *btree_create(size_t record_size, int t, btree_compare_fn cmp, void *ctx);
+void btree_destroy(btree *T);
+
+size_t btree_size(const btree *T);
+size_t btree_record_size(const btree *T);
+
+/* 插入一条记录 (拷贝 record_size 字节); 已有相等的记录时不修改, 返回 BTREE_EXISTS */
+int btree_insert(btree *T, const void *record);
+/* 插入或覆盖: 已有相等的记录时用 record 覆盖它并返回 BTREE_EXISTS */
+int btree_put(btree *T, const void *record);
+/* 删除与 key 相等的记录 */
+int btree_delete(btree *T, const void *key);
+
+/* 与 key 相等的记录, 不存在时返回 NULL (不叫 btree_search: 与 C++ 的 btree_search 命名空间同时包含时会冲突) */
+const void *btree_find(const btree *T, const void *key);
+
+/*
+ * 批量插入 n 条连续存放的记录 (records 为 n * record_size 字节), 返回新插入的条数;
+ * 先按比较函数排序, 落在同一个叶子中的相邻记录只下降一次。
+ * 分配失败时返回已插入的条数, 并把 *err (可为 NULL) 设为 BTREE_ENOMEM。
+ */
+size_t btree_insert_batch(btree *T, const void *records, size_t n, int *err);
+
+/* 按顺序遍历: first 定位到最小的记录, seek 定位到第一条 >= key 的记录; next 返回当前记录并前进, 走完时返回 NULL */
+void btree_iter_first(const btree *T, btree_iter *it);
+void btree_iter_seek(const btree *T, btree_iter *it, const void *key);
+const void *btree_iter_next(btree_iter *it);
+
+/* 按顺序访问闭区间 [lo, hi] 内的记录, 返回访问的条数 (含让 visit 返回 0 的那一条) */
+size_t btree_range(const btree *T, const void *lo, const void *hi, btree_visit_fn visit, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BTREE_C_H */
@@ -0,0 +1,198 @@
+#pragma once
+#include "btree.h"
+
+// 键 -> 值 的B树, 键唯一
+//
+// 与 BTree 共用 btree_detail::BTreeBase 的分裂/合并/借键逻辑; 节点内键数组与值数组分开存放,
+// 下降过程中的比较只访问键数组。
+//
+// find/try_emplace/upsert 返回的指针指向节点内的值, 在下一次修改树(插入/删除)之前有效。
+// Augment 含义同 BTree (OrderStatistic 时支持 rank/select/count_range; 幺半群时另外支持 reduce,
+// lift(key, value) 由键值对计算聚合值)。insert_or_assign/upsert 会更新聚合值,
+// 通过 find/try_emplace 返回的指针直接修改值则不会, 之后 reduce 的结果不再准确。
+template <typename K, typename V, typename Compare = std::less<K>, typename Allocator = NodeArena,
+          typename Augment = NoAugment>
+class BTreeMap : public btree_detail::BTreeBase<K, V, Compare, Allocator, Augment> {
+    using Base = btree_detail::BTreeBase<K, V, Compare, Allocator, Augment>;
+    using Node = typename Base::Node;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+
+    BTreeMap(int min_degree, Compare compare = Compare(), Allocator allocator = Allocator())
+        : Base(min_degree, std::move(compare), std::move(allocator)) {}
+
+    BTreeMap(int min_degree, Allocator allocator)
+        : Base(min_degree, Compare(), std::move(allocator)) {}
+
+    BTreeMap(BTreeMap&&) noexcept = default;
+    BTreeMap& operator=(BTreeMap&&) noexcept = default;
+
+    // 查找键对应的值, 不存在时返回 nullptr
+    V* find(const K& key) {
+        int idx;
+        Node* node = const_cast<Node*>(this->search_internal(this->root, key, idx));
+        return node ? &this->values(node)[idx] : nullptr;
+    }
+
+    const V* find(const K& key) const {
+        int idx;
+        const Node* node = this->search_internal(this->root, key, idx);
+        return node ? &this->values(node)[idx] : nullptr;
+    }
+
+    bool contains(const K& key) const {
+        return find(key) != nullptr;
+    }
+
+    // 键不存在时用 args 原地构造值; 已存在时不做任何修改
+    // 返回 {值指针, 是否插入}
+    template <typename... Args>
+    std::pair<V*, bool> try_emplace(const K& key, Args&&... args) {
+        auto [slot, inserted] = this->insert_unique(key, std::forward<Args>(args)...);
+        return {&this->values(slot.node)[slot.idx], inserted};
+    }
+
+    template <typename... Args>
+    std::pair<V*, bool> try_emplace(K&& key, Args&&... args) {
+        auto [slot, inserted] = this->insert_unique(std::move(key), std::forward<Args>(args)...);
+        return {&this->values(slot.node)[slot.idx], inserted};
+    }
+
+    // 插入或覆盖
+    template <typename M>
+    std::pair<V*, bool> insert_or_assign(const K& key, M&& value) {
+        auto [slot, inserted] = this->insert_unique(key, std::forward<M>(value));
+        V* v = &this->values(slot.node)[slot.idx];
+        if (!inserted) {
+            *v = std::forward<M>(value);
+            this->refresh_aggregates(key);
+        }
+        return {v, inserted};
+    }
+
+    // 一次下降完成"读-改-写": 键不存在时先值初始化 V{}, 然后调用 fn(V&)
+    /*
+    示例: 计数
+      counts.upsert(word, [](int& c) { c++; });
+    */
+    template <typename F>
+    V& upsert(const K& key, F&& fn) {
+        auto [slot, inserted] = this->insert_unique(key);
+        V& v = this->values(slot.node)[slot.idx];
+        std::forward<F>(fn)(v);
+        this->refresh_aggregates(key);
+        return v;
+    }
+
+    // 删除键, 返回是否存在
+    bool erase(const K& key) {
+        return this->erase_key(key);
+    }
+
+    // 透明比较器 (Compare::is_transparent) 时, 用任何能与 K 比较的类型查找/删除, 不构造临时的 K
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    V* find(const Key& key) {
+        int idx;
+        Node* node = const_cast<Node*>(this->search_internal(this->root, key, idx));
+        return node ? &this->values(node)[idx] : nullptr;
+    }
+
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    const V* find(const Key& key) const {
+        int idx;
+        const Node* node = this->search_internal(this->root, key, idx);
+        return node ? &this->values(node)[idx] : nullptr;
+    }
+
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    bool contains(const Key& key) const {
+        return find(key) != nullptr;
+    }
+
+    template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+    bool erase(const Key& key) {
+        return this->erase_key(key);
+    }
+
+    // 批量查找: out[i] 为 keys[i] 对应的值指针, 不存在时为 nullptr
+    // 按键排序后分组下降, 上层节点每批只读一次, 并预取下一层要访问的节点
+    void find_batch(const K* keys, std::size_t n, V** out) {
+        auto order = this->sorted_order(n, [&](std::size_t i) -> const K& { return keys[i]; });
+        this->search_batch_impl(
+            n, [&](std::size_t j) -> const K& { return keys[order[j]]; },
+            [&](std::size_t j, const Node* node, int idx) {
+                out[order[j]] = node ? &this->values(const_cast<Node*>(node))[idx] : nullptr;
+            });
+    }
+
+    void find_batch(const K* keys, std::size_t n, const V** out) const {
+        auto order = this->sorted_order(n, [&](std::size_t i) -> const K& { return keys[i]; });
+        this->search_batch_impl(
+            n, [&](std::size_t j) -> const K& { return keys[order[j]]; },
+            [&](std::size_t j, const Node* node, int idx) {
+                out[order[j]] = node ? &this->values(node)[idx] : nullptr;
+            });
+    }
+
+    // 批量插入 (键, 值), 语义同 try_emplace: 键已存在时不修改
+    // inserted[i] 表示 entries[i] 是否被插入 (可以传 nullptr); 批量内的重复键只有第一个生效
+    void insert_batch(const std::pair<K, V>* entries, std::size_t n, bool* inserted = nullptr) {
+        auto order = this->sorted_order(n, [&](std::size_t i) -> const K& { return entries[i].first; });
+        this->template insert_sorted<true>(
+            n, [&](std::size_t j) -> const K& { return entries[order[j]].first; },
+            [&](Node* leaf, int idx, std::size_t j) {
+                this->insert_slot(leaf, idx, entries[order[j]].first, entries[order[j]].second);
+                if (inserted)
+                    inserted[order[j]] = true;
+            },
+            [&](auto, std::size_t j) {
+                if (inserted)
+                    inserted[order[j]] = false;
+            });
+    }
+
+    // 用按键严格递增的 (键, 值) 序列替换全部内容, 自底向上构建, O(n)
+    // fill_factor 含义同 BTree::bulk_load; 键重复或无序时抛出 std::invalid_argument
+    template <typename ForwardIt>
+    void bulk_load(ForwardIt first, ForwardIt last, double fill_factor = 1.0) {
+        auto not_increasing = [this](const auto& a, const auto& b) { return !this->comp(a.first, b.first); };
+        if (std::adjacent_find(first, last, not_increasing) != last) {
+            throw std::invalid_argument("bulk_load input must be sorted by unique keys");
+        }
+        std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+        this->build_from_sorted(first, n, fill_factor, [this](Node* node, auto&& entry) {
+            using Entry = decltype(entry);
+            this->insert_slot(node, node->n, std::forward<Entry>(entry).first, std::forward<Entry>(entry).second);
+        });
+    }
+
+    // 把一批按键严格递增的 (键, 值) 合并进已有的映射, 线性归并后整体重建
+    // 键已存在时批量中的值覆盖原值, 与 insert_or_assign 一致
+    template <typename ForwardIt>
+    void merge_load(ForwardIt first, ForwardIt last, double fill_factor = 1.0) {
+        auto not_increasing = [this](const auto& a, const auto& b) { return !this->comp(a.first, b.first); };
+        if (std::adjacent_find(first, last, not_increasing) != last) {
+            throw std::invalid_argument("merge_load input must be sorted by unique keys");
+        }
+        std::vector<std::pair<K, V>> existing;
+        existing.reserve(this->count);
+        auto out = [&](K&& key, V&& value) { existing.emplace_back(std::move(key), std::move(value)); };
+        this->drain_sorted(out);
+
+        std::vector<std::pair<K, V>> merged;
+        merged.reserve(existing.size() + static_cast<std::size_t>(std::distance(first, last)));
+        auto old = existing.begin();
+        for (; first != last; ++first) {
+            while (old != existing.end() && this->comp(old->first, first->first))
+                merged.push_back(std::move(*old++));
+            if (old != existing.end() && !this->comp(first->first, old->first))
+                ++old; // 被批量中的值覆盖
+            merged.emplace_back(first->first, first->second);
+        }
+        std::move(old, existing.end(), std::back_inserter(merged));
+        existing.clear();
+        bulk_load(std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()), fill_factor);
+    }
+};
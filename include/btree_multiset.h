@@ -0,0 +1,201 @@
+#pragma once
+#include "btree_map.h"
+
+// 允许重复键的有序集合, 每个不同的键只占一个槽位
+//
+// BTree 本身也允许重复键, 但每个副本占一个槽位: 同一个键重复 10^6 次就是 10^6 个槽位,
+// 而且 search/remove 命中的是哪一个副本没有约定。BTreeMultiset 把相等的键存成一个
+// (键, 次数) 的游程, 底层是 BTreeMap<K, std::size_t>:
+/*
+  插入 5 5 7 5 9 9 之后:
+      BTree:          [5 5 5 7 9 9]          6 个槽位
+      BTreeMultiset:  [5:3  7:1  9:2]        3 个槽位
+*/
+// 相等 (!comp(a, b) && !comp(b, a)) 的键视为同一个值: 游程只保留第一次插入的那个键对象,
+// 之后插入的相等键只增加次数。遍历时每个键按次数重复出现, 相等的键之间顺序不变;
+// erase 每次删除一个副本, erase_all 一次删除整个游程。
+// count/contains/erase/erase_all 都是一次下降 O(log n), 与重复次数无关; n 为不同键的个数。
+template <typename K, typename Compare = std::less<K>, typename Allocator = NodeArena>
+class BTreeMultiset {
+    using Runs = BTreeMap<K, std::size_t, Compare, Allocator>;
+    using RunIterator = typename Runs::const_iterator;
+
+public:
+    using key_type = K;
+    using size_type = std::size_t;
+
+    // 只读的双向迭代器: 当前游程 + 游程内的序号
+    class const_iterator {
+        friend class BTreeMultiset;
+
+        const Runs* runs = nullptr;
+        RunIterator run;
+        std::size_t offset = 0;
+
+        const_iterator(const Runs* runs, RunIterator run, std::size_t offset)
+            : runs(runs), run(run), offset(offset) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = K;
+        using difference_type = std::ptrdiff_t;
+        using reference = const K&;
+        using pointer = const K*;
+
+        const_iterator() = default;
+
+        const K& operator*() const { return run.key(); }
+        const K* operator->() const { return &run.key(); }
+
+        // 当前游程中相等键的总数
+        std::size_t run_length() const { return run.value(); }
+
+        const_iterator& operator++() {
+            if (++offset == run.value()) {
+                ++run;
+                offset = 0;
+            }
+            return *this;
+        }
+
+        const_iterator& operator--() {
+            if (offset == 0) {
+                --run;
+                offset = run.value() - 1;
+            } else {
+                offset--;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) {
+            return a.run == b.run && a.offset == b.offset;
+        }
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return !(a == b); }
+    };
+    using iterator = const_iterator;
+
+    explicit BTreeMultiset(int min_degree, Compare compare = Compare(), Allocator allocator = Allocator())
+        : runs(min_degree, std::move(compare), std::move(allocator)) {}
+
+    BTreeMultiset(int min_degree, Allocator allocator)
+        : runs(min_degree, Compare(), std::move(allocator)) {}
+
+    BTreeMultiset(BTreeMultiset&&) noexcept = default;
+    BTreeMultiset& operator=(BTreeMultiset&&) noexcept = default;
+
+    // 插入 copies 个 key, 返回插入后 key 的次数; 已有相等的键时只增加次数, 不占新的槽位
+    std::size_t insert(const K& key, std::size_t copies = 1) {
+        if (copies == 0)
+            return count(key);
+        total += copies;
+        return runs.upsert(key, [copies](std::size_t& c) { c += copies; });
+    }
+
+    // 与 key 相等的键的个数
+    std::size_t count(const K& key) const {
+        const std::size_t* c = runs.find(key);
+        return c ? *c : 0;
+    }
+
+    bool contains(const K& key) const {
+        return runs.contains(key);
+    }
+
+    // 删除一个与 key 相等的键, 返回是否存在; 次数减到 0 时删除整个游程
+    bool erase(const K& key) {
+        std::size_t* c = runs.find(key);
+        if (!c)
+            return false;
+        total--;
+        if (--*c == 0)
+            runs.erase(key);
+        return true;
+    }
+
+    // 删除所有与 key 相等的键, 返回删除的个数
+    std::size_t erase_all(const K& key) {
+        std::size_t* c = runs.find(key);
+        if (!c)
+            return 0;
+        std::size_t removed = *c;
+        runs.erase(key);
+        total -= removed;
+        return removed;
+    }
+
+    // 第一个 >= key / > key 的位置
+    const_iterator lower_bound(const K& key) const {
+        return const_iterator(&runs, runs.lower_bound(key), 0);
+    }
+    const_iterator upper_bound(const K& key) const {
+        return const_iterator(&runs, runs.upper_bound(key), 0);
+    }
+
+    // 与 key 相等的所有键 [first, last), 长度即 count(key)
+    std::pair<const_iterator, const_iterator> equal_range(const K& key) const {
+        RunIterator first = runs.lower_bound(key);
+        RunIterator last = first;
+        if (last != runs.end() && !runs.key_comp()(key, last.key()))
+            ++last;
+        return {const_iterator(&runs, first, 0), const_iterator(&runs, last, 0)};
+    }
+
+    const_iterator begin() const { return const_iterator(&runs, runs.begin(), 0); }
+    const_iterator end() const { return const_iterator(&runs, runs.end(), 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // 按顺序访问每个不同的键及其次数: fn(const K&, std::size_t)
+    template <typename F>
+    void for_each_run(F&& fn) const {
+        for (RunIterator it = runs.begin(); it != runs.end(); ++it)
+            fn(it.key(), it.value());
+    }
+
+    // 用非降序序列 [first, last) 替换全部内容: 相邻的相等键先合并成游程, 再自底向上构建, O(n)
+    // 无序时抛出 std::invalid_argument
+    template <typename ForwardIt>
+    void bulk_load(ForwardIt first, ForwardIt last, double fill_factor = 1.0) {
+        const Compare& comp = runs.key_comp();
+        std::vector<std::pair<K, std::size_t>> grouped;
+        std::size_t n = 0;
+        for (; first != last; ++first, ++n) {
+            if (!grouped.empty() && !comp(grouped.back().first, *first)) {
+                if (comp(*first, grouped.back().first))
+                    throw std::invalid_argument("bulk_load input must be sorted");
+                grouped.back().second++;
+            } else {
+                grouped.emplace_back(*first, 1);
+            }
+        }
+        runs.bulk_load(std::make_move_iterator(grouped.begin()), std::make_move_iterator(grouped.end()),
+                       fill_factor);
+        total = n;
+    }
+
+    // 键的总数 (含重复)
+    std::size_t size() const { return total; }
+    // 不同键的个数, 即占用的槽位数
+    std::size_t distinct_size() const { return runs.size(); }
+    bool empty() const { return total == 0; }
+
+    const Compare& key_comp() const { return runs.key_comp(); }
+    int get_min_degree() const { return runs.get_min_degree(); }
+
+private:
+    Runs runs;
+    std::size_t total = 0;
+};
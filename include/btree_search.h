@@ -0,0 +1,214 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BTREE_SEARCH_X86 1
+#endif
+
+// 节点内的键查找
+//
+//   node_lower_bound(keys, n, key): 第一个 !(keys[i] < key) 的位置
+//   node_upper_bound(keys, n, key): 第一个 key < keys[i] 的位置
+//
+// 返回值范围 [0, n], 可以直接作为子节点下标使用。"<"由比较器comp给出。
+// key 可以是与 T 不同的类型 (透明比较器, 如 std::less<> 比较 std::string 与 std::string_view), 此时只走二分。
+// - 32/64位整数和浮点数, 且比较器为 std::less: SIMD 比较 + movemask 计数 (SSE2/AVX2, 运行时选择)
+// - 其他情况: 无分支二分查找 (同 btree.c 中的 btree_bin_search, 但循环内没有分支)
+namespace btree_search {
+
+// 无分支二分查找
+/*
+示例: 在 [10,20,30,40] 中查找 lower_bound(25)
+  len=4: base[2]=30 < 25? 否 -> base不动, len=2
+  len=2: base[1]=20 < 25? 是 -> base+=1,   len=1
+  结束:  base[0]=20 < 25? 是 -> 结果 1+1 = 2
+*/
+template <bool Upper, typename T, typename Key, typename Compare = std::less<T>>
+inline int branchless_bound(const T* keys, int n, const Key& key, Compare comp = Compare()) {
+    if (n == 0)
+        return 0;
+    const T* base = keys;
+    int len = n;
+    while (len > 1) {
+        int half = len / 2;
+        bool right = Upper ? !comp(key, base[half]) : comp(base[half], key);
+        base = right ? base + half : base;
+        len -= half;
+    }
+    bool right = Upper ? !comp(key, *base) : comp(*base, key);
+    return static_cast<int>(base - keys) + right;
+}
+
+template <bool Upper, typename T>
+inline int scalar_count(const T* keys, int n, T key) {
+    int count = 0;
+    for (int i = 0; i < n; i++)
+        count += Upper ? !(key < keys[i]) : (keys[i] < key);
+    return count;
+}
+
+template <typename T>
+constexpr bool simd_key_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                            (sizeof(T) == 4 || sizeof(T) == 8);
+
+// 只有比较器等价于内置"<"时才能走SIMD
+template <typename T, typename Compare>
+constexpr bool simd_compare_v = simd_key_v<T> &&
+    (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>>);
+
+#ifdef BTREE_SEARCH_X86
+
+#ifdef __AVX2__
+inline bool cpu_has_avx2() { return true; }
+#else
+inline const bool avx2_supported = __builtin_cpu_supports("avx2");
+inline bool cpu_has_avx2() { return avx2_supported; }
+#endif
+
+// 无符号整数翻转符号位后可以用有符号比较
+template <typename T>
+inline auto signed_bias(T v) {
+    using S = std::make_signed_t<T>;
+    if constexpr (std::is_signed_v<T>) {
+        return v;
+    } else {
+        return static_cast<S>(v ^ (T(1) << (sizeof(T) * 8 - 1)));
+    }
+}
+
+// 统计 keys[0, n) 中 < key (Upper: <= key) 的个数
+template <bool Upper, typename T>
+__attribute__((target("avx2"))) inline int avx2_count(const T* keys, int n, T key) {
+    int count = 0;
+    int i = 0;
+    if constexpr (std::is_same_v<T, float>) {
+        __m256 k = _mm256_set1_ps(key);
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(keys + i);
+            __m256 m = Upper ? _mm256_cmp_ps(v, k, _CMP_LE_OQ) : _mm256_cmp_ps(v, k, _CMP_LT_OQ);
+            count += __builtin_popcount(_mm256_movemask_ps(m));
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        __m256d k = _mm256_set1_pd(key);
+        for (; i + 4 <= n; i += 4) {
+            __m256d v = _mm256_loadu_pd(keys + i);
+            __m256d m = Upper ? _mm256_cmp_pd(v, k, _CMP_LE_OQ) : _mm256_cmp_pd(v, k, _CMP_LT_OQ);
+            count += __builtin_popcount(_mm256_movemask_pd(m));
+        }
+    } else if constexpr (sizeof(T) == 4) {
+        const __m256i bias = _mm256_set1_epi32(std::is_signed_v<T> ? 0 : INT32_MIN);
+        __m256i k = _mm256_set1_epi32(signed_bias(key));
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), bias);
+            // Upper: 统计 v > key 再取反
+            __m256i m = Upper ? _mm256_cmpgt_epi32(v, k) : _mm256_cmpgt_epi32(k, v);
+            int c = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+            count += Upper ? 8 - c : c;
+        }
+    } else {
+        const __m256i bias = _mm256_set1_epi64x(std::is_signed_v<T> ? 0 : INT64_MIN);
+        __m256i k = _mm256_set1_epi64x(signed_bias(key));
+        for (; i + 4 <= n; i += 4) {
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), bias);
+            __m256i m = Upper ? _mm256_cmpgt_epi64(v, k) : _mm256_cmpgt_epi64(k, v);
+            int c = __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+            count += Upper ? 4 - c : c;
+        }
+    }
+    return count + scalar_count<Upper>(keys + i, n - i, key);
+}
+
+template <bool Upper, typename T>
+inline int sse2_count(const T* keys, int n, T key) {
+    int count = 0;
+    int i = 0;
+    if constexpr (std::is_same_v<T, float>) {
+        __m128 k = _mm_set1_ps(key);
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(keys + i);
+            __m128 m = Upper ? _mm_cmple_ps(v, k) : _mm_cmplt_ps(v, k);
+            count += __builtin_popcount(_mm_movemask_ps(m));
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        __m128d k = _mm_set1_pd(key);
+        for (; i + 2 <= n; i += 2) {
+            __m128d v = _mm_loadu_pd(keys + i);
+            __m128d m = Upper ? _mm_cmple_pd(v, k) : _mm_cmplt_pd(v, k);
+            count += __builtin_popcount(_mm_movemask_pd(m));
+        }
+    } else if constexpr (sizeof(T) == 4) {
+        const __m128i bias = _mm_set1_epi32(std::is_signed_v<T> ? 0 : INT32_MIN);
+        __m128i k = _mm_set1_epi32(signed_bias(key));
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), bias);
+            __m128i m = Upper ? _mm_cmpgt_epi32(v, k) : _mm_cmpgt_epi32(k, v);
+            int c = __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(m)));
+            count += Upper ? 4 - c : c;
+        }
+    }
+    // 64位整数比较需要 SSE4.2/AVX2, SSE2 下走标量
+    return count + scalar_count<Upper>(keys + i, n - i, key);
+}
+
+template <bool Upper, typename T>
+inline int simd_count(const T* keys, int n, T key) {
+    if (cpu_has_avx2())
+        return avx2_count<Upper>(keys, n, key);
+    return sse2_count<Upper>(keys, n, key);
+}
+
+#else
+
+template <bool Upper, typename T>
+inline int simd_count(const T* keys, int n, T key) {
+    return scalar_count<Upper>(keys, n, key);
+}
+
+#endif
+
+// SIMD计数窗口: 一个cache line的键 (16个32位键 / 8个64位键)
+template <typename T>
+constexpr int simd_window_v = 64 / sizeof(T);
+
+/*
+先用无分支二分把结果范围缩小到不超过一个窗口, 再把窗口对齐到数组内部的
+W个键上做一次SIMD计数(没有尾部标量循环):
+  keys:  [....................|<----- W ----->|.....]
+                            start  结果必定落在窗口内
+*/
+template <bool Upper, typename T, typename Key, typename Compare>
+inline int node_bound(const T* keys, int n, const Key& key, Compare comp) {
+    if constexpr (simd_compare_v<T, Compare> && std::is_same_v<Key, T>) {
+        constexpr int W = simd_window_v<T>;
+        if (n < W)
+            return branchless_bound<Upper>(keys, n, key);
+        const T* base = keys;
+        int len = n;
+        while (len > W) {
+            int half = len / 2;
+            bool right = Upper ? !(key < base[half]) : (base[half] < key);
+            base = right ? base + half : base;
+            len -= half;
+        }
+        int start = static_cast<int>(base - keys);
+        start = start < n - W ? start : n - W;
+        return start + simd_count<Upper>(keys + start, W, key);
+    } else {
+        return branchless_bound<Upper>(keys, n, key, comp);
+    }
+}
+
+template <typename T, typename Key, typename Compare = std::less<T>>
+inline int node_lower_bound(const T* keys, int n, const Key& key, Compare comp = Compare()) {
+    return node_bound<false>(keys, n, key, comp);
+}
+
+template <typename T, typename Key, typename Compare = std::less<T>>
+inline int node_upper_bound(const T* keys, int n, const Key& key, Compare comp = Compare()) {
+    return node_bound<true>(keys, n, key, comp);
+}
+
+} // namespace btree_search
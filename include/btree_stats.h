@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+// B树的运行统计
+//
+// 编译时用 -DBTREE_STATS=1 打开 (CMake: -DBTREE_STATS=ON); 默认关闭, 此时热路径上没有任何统计代码,
+// 树中也不占空间。stats() 在两种情况下都可用:
+//   - 结构信息 (节点数、高度、填充率直方图、字节数) 在读取时遍历整棵树得到, 不需要打开 BTREE_STATS
+//   - 事件计数 (分裂、合并、借键、根节点增高/降低、查找) 只在 BTREE_STATS 时记录, 否则为 0
+//
+// 事件计数按线程分开记录: 每个线程写自己的一条记录 (独占 cache line, 普通的 relaxed 读写,
+// 没有原子读-改-写), 读取时把所有线程的记录加起来。树的修改仍要求单线程,
+// 但多个线程可以同时调用 search/contains/find, 它们的计数互不干扰。
+#ifndef BTREE_STATS
+#define BTREE_STATS 0
+#endif
+
+// stats() 返回的快照
+struct BTreeStats {
+    static constexpr int kFillBuckets = 10;
+
+    bool enabled = false;              // 编译时是否打开了 BTREE_STATS
+
+    // 事件计数
+    uint64_t splits = 0;               // split_child (含根节点分裂)
+    uint64_t merges = 0;               // merge
+    uint64_t borrows_prev = 0;         // borrow_from_prev
+    uint64_t borrows_next = 0;         // borrow_from_next
+    uint64_t root_grows = 0;           // 根节点分裂, 树高加一
+    uint64_t root_shrinks = 0;         // 根节点被合并空, 树高减一
+    uint64_t searches = 0;             // search/contains/find (批量查找不计入)
+    uint64_t search_nodes = 0;         // 查找访问的节点数
+    uint64_t search_comparisons = 0;   // 查找的键比较次数 (按节点内二分查找计: 每个节点 floor(log2 n) + 2 次)
+
+    // 结构
+    std::size_t size = 0;              // 键数
+    std::size_t height = 0;            // 层数, 只有根叶子时为 1
+    std::size_t nodes = 0;
+    std::size_t leaves = 0;
+    std::size_t bytes = 0;             // 节点占用的字节数 (不含分配器的空闲空间)
+    // 按 n / (2t-1) 分成 kFillBuckets 档: [0, 10%), [10%, 20%) ... [90%, 100%]
+    std::size_t fill_histogram[kFillBuckets] = {};
+
+    double comparisons_per_search() const {
+        return searches ? static_cast<double>(search_comparisons) / searches : 0.0;
+    }
+
+    // 一行 JSON
+    std::string to_json() const {
+        char buf[768];
+        int len = std::snprintf(
+            buf, sizeof(buf),
+            "{\"enabled\":%s,\"splits\":%llu,\"merges\":%llu,\"borrows_prev\":%llu,\"borrows_next\":%llu,"
+            "\"root_grows\":%llu,\"root_shrinks\":%llu,\"searches\":%llu,\"search_nodes\":%llu,"
+            "\"search_comparisons\":%llu,\"comparisons_per_search\":%.3f,"
+            "\"size\":%zu,\"height\":%zu,\"nodes\":%zu,\"leaves\":%zu,\"bytes\":%zu,\"fill_histogram\":[",
+            enabled ? "true" : "false", ull(splits), ull(merges), ull(borrows_prev), ull(borrows_next),
+            ull(root_grows), ull(root_shrinks), ull(searches), ull(search_nodes), ull(search_comparisons),
+            comparisons_per_search(), size, height, nodes, leaves, bytes);
+        std::string out(buf, static_cast<std::size_t>(len));
+        for (int i = 0; i < kFillBuckets; i++) {
+            if (i)
+                out += ',';
+            out += std::to_string(fill_histogram[i]);
+        }
+        out += "]}";
+        return out;
+    }
+
+private:
+    static unsigned long long ull(uint64_t v) { return static_cast<unsigned long long>(v); }
+};
+
+namespace btree_detail {
+
+enum StatEvent : int {
+    kStatSplit,
+    kStatMerge,
+    kStatBorrowPrev,
+    kStatBorrowNext,
+    kStatRootGrow,
+    kStatRootShrink,
+    kStatSearch,
+    kStatSearchNode,
+    kStatSearchComparison,
+    kStatEvents
+};
+
+// 一棵树的事件计数, 每个线程一条记录; 记录的登记方式与 EpochManager 相同
+class StatsCounters {
+public:
+    // 每个线程一条记录; 线程退出后记录保留, 之后获得相同 thread::id 的线程会接着使用
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counters[kStatEvents] = {};
+        std::thread::id owner;
+        Shard* next = nullptr;
+
+        // 只有所属线程写, 不需要原子读-改-写
+        void add(StatEvent event, uint64_t n = 1) {
+            std::atomic<uint64_t>& c = counters[event];
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    };
+
+    StatsCounters() : id(next_id()) {}
+    StatsCounters(const StatsCounters&) = delete;
+    StatsCounters& operator=(const StatsCounters&) = delete;
+
+    ~StatsCounters() {
+        Shard* s = shards.load(std::memory_order_relaxed);
+        while (s) {
+            Shard* next = s->next;
+            delete s;
+            s = next;
+        }
+    }
+
+    Shard* local() {
+        // 每个线程缓存最近使用的一棵树的记录, 同一棵树上的连续操作不用查找
+        thread_local uint64_t cached_id = 0;
+        thread_local Shard* cached = nullptr;
+        if (cached_id == id)
+            return cached;
+
+        std::thread::id self = std::this_thread::get_id();
+        Shard* s = shards.load(std::memory_order_acquire);
+        while (s && s->owner != self)
+            s = s->next;
+        if (!s) {
+            s = new Shard;
+            s->owner = self;
+            s->next = shards.load(std::memory_order_relaxed);
+            while (!shards.compare_exchange_weak(s->next, s, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+        cached_id = id;
+        cached = s;
+        return s;
+    }
+
+    void add(StatEvent event, uint64_t n = 1) { local()->add(event, n); }
+
+    // 所有线程的记录之和
+    uint64_t total(StatEvent event) const {
+        uint64_t sum = 0;
+        for (const Shard* s = shards.load(std::memory_order_acquire); s; s = s->next)
+            sum += s->counters[event].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    std::atomic<Shard*> shards{nullptr};
+    const uint64_t id;
+
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+};
+
+} // namespace btree_detail
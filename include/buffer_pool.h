@@ -0,0 +1,240 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "pager.h"
+
+// 页缓存: 固定数量的页帧(frame), 用 CLOCK 算法选择被替换的页
+//
+// fetch()/create() 返回 PageRef, 存在期间页被钉住(pin), 不会被替换; PageRef 析构时解除钉住。
+// 修改页内容后调用 mark_dirty(), 页被替换或 flush_all() 时写回文件。
+/*
+  CLOCK: 每个帧一个访问位, 命中时置 1; 需要空闲帧时指针循环扫描:
+    被钉住 -> 跳过;  访问位为 1 -> 清 0 后跳过 (第二次机会);  访问位为 0 -> 替换
+
+     hand
+      v
+   [p7 ref=0] [p3 ref=1] [p9 pinned] [p2 ref=0] ...
+*/
+// no-steal 模式 (配合预写日志使用): 脏页不会被替换出去, 只能由 flush_all() 写回,
+// 因此文件中始终是上一次 flush_all() 时的状态。
+// 不是线程安全的。
+class BufferPool {
+public:
+    using PageId = Pager::PageId;
+
+    struct Stats {
+        uint64_t hits = 0;         // fetch 时页已在缓存中
+        uint64_t misses = 0;       // fetch 时需要从文件读取
+        uint64_t evictions = 0;    // 被替换出去的页
+        uint64_t writebacks = 0;   // 写回文件的脏页
+    };
+
+private:
+    struct Frame {
+        PageId page = 0;
+        int pins = 0;
+        bool valid = false;        // 帧中是否有页
+        bool dirty = false;
+        bool referenced = false;   // CLOCK 访问位
+    };
+
+public:
+    // 钉住一页的句柄, 只能移动
+    class PageRef {
+    public:
+        PageRef() = default;
+        PageRef(PageRef&& other) noexcept : pool(other.pool), frame(other.frame) { other.pool = nullptr; }
+        PageRef& operator=(PageRef&& other) noexcept {
+            if (this != &other) {
+                reset();
+                pool = other.pool;
+                frame = other.frame;
+                other.pool = nullptr;
+            }
+            return *this;
+        }
+        PageRef(const PageRef&) = delete;
+        PageRef& operator=(const PageRef&) = delete;
+        ~PageRef() { reset(); }
+
+        char* data() const { return pool->frame_data(frame); }
+        PageId id() const { return pool->frames[frame].page; }
+        void mark_dirty() const { pool->set_dirty(frame); }
+        explicit operator bool() const { return pool != nullptr; }
+
+        // 提前解除钉住
+        void reset() {
+            if (pool) {
+                pool->frames[frame].pins--;
+                pool = nullptr;
+            }
+        }
+
+    private:
+        friend class BufferPool;
+        PageRef(BufferPool* pool, std::size_t frame) : pool(pool), frame(frame) {
+            pool->frames[frame].pins++;
+        }
+
+        BufferPool* pool = nullptr;
+        std::size_t frame = 0;
+    };
+
+    BufferPool(Pager& pager, std::size_t capacity)
+        : pager(pager), frames(capacity), hand(0) {
+        if (capacity == 0) {
+            throw std::invalid_argument("buffer pool needs at least one frame");
+        }
+        memory = static_cast<char*>(::operator new(capacity * pager.page_size(), std::align_val_t(pager.page_size())));
+        table.reserve(capacity);
+    }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 析构时不写回脏页; 需要持久化时先调用 flush_all()
+    ~BufferPool() {
+        ::operator delete(memory, std::align_val_t(pager.page_size()));
+    }
+
+    // 钉住页 id, 不在缓存中时从文件读取
+    PageRef fetch(PageId id) {
+        auto it = table.find(id);
+        if (it != table.end()) {
+            counters.hits++;
+            frames[it->second].referenced = true;
+            return PageRef(this, it->second);
+        }
+        counters.misses++;
+        std::size_t f = take_frame(id);
+        try {
+            pager.read(id, frame_data(f));
+        } catch (...) {
+            table.erase(id);
+            frames[f].valid = false;
+            throw;
+        }
+        return PageRef(this, f);
+    }
+
+    // 钉住一个新分配的页: 内容清零并标记为脏, 不读文件
+    PageRef create(PageId id) {
+        std::size_t f;
+        auto it = table.find(id);
+        if (it != table.end()) {
+            f = it->second;
+        } else {
+            f = take_frame(id);
+        }
+        std::memset(frame_data(f), 0, pager.page_size());
+        set_dirty(f);
+        return PageRef(this, f);
+    }
+
+    // 写回所有脏页 (包括被钉住的页)
+    void flush_all() {
+        for (std::size_t f = 0; f < frames.size(); f++) {
+            if (frames[f].valid && frames[f].dirty)
+                write_back(f);
+        }
+    }
+
+    // 丢弃所有未钉住的页 (脏页先写回), 之后的访问都会重新读文件
+    void clear() {
+        for (std::size_t f = 0; f < frames.size(); f++) {
+            if (frames[f].valid && frames[f].pins == 0) {
+                if (frames[f].dirty)
+                    write_back(f);
+                table.erase(frames[f].page);
+                frames[f].valid = false;
+            }
+        }
+    }
+
+    // 按帧顺序访问所有脏页: fn(PageId, const char* data)
+    template <typename F>
+    void for_each_dirty(F&& fn) const {
+        for (std::size_t f = 0; f < frames.size(); f++) {
+            if (frames[f].valid && frames[f].dirty)
+                fn(frames[f].page, static_cast<const char*>(frame_data(f)));
+        }
+    }
+
+    void set_no_steal(bool enabled) { no_steal = enabled; }
+    std::size_t dirty_count() const { return dirty_pages; }
+    std::size_t capacity() const { return frames.size(); }
+    const Stats& stats() const { return counters; }
+    void reset_stats() { counters = Stats{}; }
+    Pager& get_pager() { return pager; }
+
+private:
+    char* frame_data(std::size_t f) const {
+        return memory + f * pager.page_size();
+    }
+
+    void set_dirty(std::size_t f) {
+        if (!frames[f].dirty) {
+            frames[f].dirty = true;
+            dirty_pages++;
+        }
+    }
+
+    void write_back(std::size_t f) {
+        pager.write(frames[f].page, frame_data(f));
+        frames[f].dirty = false;
+        dirty_pages--;
+        counters.writebacks++;
+    }
+
+    // 为页 id 找一个帧 (必要时替换), 登记到页表中
+    std::size_t take_frame(PageId id) {
+        std::size_t f = find_victim();
+        Frame& frame = frames[f];
+        if (frame.valid) {
+            if (frame.dirty)
+                write_back(f);
+            table.erase(frame.page);
+            counters.evictions++;
+        }
+        frame.page = id;
+        frame.valid = true;
+        frame.dirty = false;
+        frame.referenced = true;
+        table.emplace(id, f);
+        return f;
+    }
+
+    // CLOCK 扫描; 两圈都找不到说明所有帧都被钉住
+    std::size_t find_victim() {
+        for (std::size_t step = 0; step < 2 * frames.size(); step++) {
+            std::size_t f = hand;
+            hand = (hand + 1) % frames.size();
+            Frame& frame = frames[f];
+            if (!frame.valid)
+                return f;
+            if (frame.pins > 0 || (no_steal && frame.dirty))
+                continue;
+            if (frame.referenced) {
+                frame.referenced = false;
+                continue;
+            }
+            return f;
+        }
+        throw std::runtime_error("buffer pool exhausted: all frames are pinned or dirty");
+    }
+
+    Pager& pager;
+    std::vector<Frame> frames;
+    std::unordered_map<PageId, std::size_t> table;   // 页号 -> 帧
+    char* memory;                                    // capacity 个页, 按页大小对齐
+    std::size_t hand;                                // CLOCK 指针
+    std::size_t dirty_pages = 0;
+    bool no_steal = false;
+    Stats counters;
+};
@@ -0,0 +1,924 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "btree_search.h"
+
+namespace btree_detail {
+
+// ---- 叶子中键的压缩表示 (CompressedBTree 的 Block 参数) ----
+//
+// 接口:
+//   key_type
+//   int size() const
+//   int lower_bound(const key_type&) const           在压缩形式上直接查找
+//   bool equals(int i, const key_type&) const
+//   key_type key(int i) const;  void decode_into(int i, key_type& out) const
+//   void insert(int i, const key_type&);  void erase(int i)
+//   void split(int from, Block& right)                [from, n) 移到空的 right 中
+//   void merge(Block& right)                          right 的键 (都大于本块的键) 追加到末尾, right 变为空
+//   static key_type separator(const Block& left, const Block& right)
+//                                                     left 的最大键 < 结果 <= right 的最小键
+//   std::size_t encoded_bytes() const                 压缩后键占用的字节数
+
+inline std::size_t common_prefix(std::string_view a, std::string_view b) {
+    std::size_t n = std::min(a.size(), b.size());
+    std::size_t i = 0;
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+// 字符串: 块内所有键的公共前缀只存一次, 后缀首尾相接存放在一个缓冲区中
+/*
+  键:    "user:1001"  "user:1002"  "user:1077"
+  prefix = "user:10"   bytes = "01" "02" "77"   ends = [2, 4, 6]
+*/
+// 有序块的公共前缀 = 第一个键和最后一个键的公共前缀, 所以只有在两端插入时前缀才可能变短。
+// 查找先把 key 与前缀比较一次: 不以前缀开头时结果是 0 或 n, 否则只在后缀上二分, 不再重复比较前缀。
+class PrefixKeys {
+public:
+    using key_type = std::string;
+
+    int size() const { return static_cast<int>(ends.size()); }
+
+    int lower_bound(std::string_view key) const {
+        int c = against_prefix(key);
+        if (c != 0)
+            return c < 0 ? 0 : size();
+        std::string_view rest = key.substr(prefix.size());
+        int lo = 0, len = size();
+        while (len > 0) {
+            int half = len / 2;
+            if (suffix(lo + half) < rest) {
+                lo += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return lo;
+    }
+
+    bool equals(int i, std::string_view key) const {
+        return against_prefix(key) == 0 && key.substr(prefix.size()) == suffix(i);
+    }
+
+    std::string key(int i) const {
+        std::string out;
+        decode_into(i, out);
+        return out;
+    }
+
+    void decode_into(int i, std::string& out) const {
+        std::string_view s = suffix(i);
+        out.assign(prefix);
+        out.append(s.data(), s.size());
+    }
+
+    void insert(int i, std::string_view key) {
+        if (ends.empty()) {
+            prefix.assign(key.data(), key.size());
+            bytes.clear();
+            ends.assign(1, 0);
+            return;
+        }
+        std::size_t shared = common_prefix(prefix, key);
+        if (shared < prefix.size())
+            shorten_prefix(shared);
+        std::string_view rest = key.substr(prefix.size());
+        uint32_t begin = start(i);
+        bytes.insert(begin, rest.data(), rest.size());
+        for (std::size_t j = i; j < ends.size(); j++)
+            ends[j] += static_cast<uint32_t>(rest.size());
+        ends.insert(ends.begin() + i, begin + static_cast<uint32_t>(rest.size()));
+    }
+
+    void erase(int i) {
+        uint32_t begin = start(i);
+        uint32_t len = ends[i] - begin;
+        bytes.erase(begin, len);
+        ends.erase(ends.begin() + i);
+        for (std::size_t j = i; j < ends.size(); j++)
+            ends[j] -= len;
+        if (ends.empty()) {
+            prefix.clear();
+            bytes.clear();
+        }
+    }
+
+    void split(int from, PrefixKeys& right) {
+        int n = size();
+        std::size_t ext = common_prefix(suffix(from), suffix(n - 1));
+        right.prefix = prefix;
+        right.prefix.append(suffix(from).substr(0, ext));
+        for (int j = from; j < n; j++) {
+            std::string_view s = suffix(j).substr(ext);
+            right.bytes.append(s.data(), s.size());
+            right.ends.push_back(static_cast<uint32_t>(right.bytes.size()));
+        }
+        bytes.resize(start(from));
+        ends.resize(from);
+        lengthen_prefix();
+    }
+
+    void merge(PrefixKeys& right) {
+        std::vector<std::string> keys;
+        keys.reserve(ends.size() + right.ends.size());
+        for (int j = 0; j < size(); j++)
+            keys.push_back(key(j));
+        for (int j = 0; j < right.size(); j++)
+            keys.push_back(right.key(j));
+        assign(keys);
+        right.assign({});
+    }
+
+    // 后缀截断: right 最小键中刚好能与 left 最大键区分开的最短前缀
+    /*
+      left 最大键 "user:1077", right 最小键 "user:2001" -> 路由键 "user:2"
+    */
+    static std::string separator(const PrefixKeys& left, const PrefixKeys& right) {
+        std::string last = left.key(left.size() - 1);
+        std::string first = right.key(0);
+        first.resize(common_prefix(last, first) + 1);
+        return first;
+    }
+
+    std::size_t encoded_bytes() const {
+        return prefix.size() + bytes.size() + ends.size() * sizeof(uint32_t);
+    }
+
+private:
+    std::string prefix;
+    std::string bytes;              // 所有后缀首尾相接
+    std::vector<uint32_t> ends;     // ends[i]: 第 i 个后缀在 bytes 中的结束位置
+
+    uint32_t start(int i) const { return i == 0 ? 0 : ends[i - 1]; }
+
+    std::string_view suffix(int i) const {
+        uint32_t begin = start(i);
+        return std::string_view(bytes.data() + begin, ends[i] - begin);
+    }
+
+    // key 与前缀比较: < 0 表示 key 小于块中所有键, > 0 表示大于所有键, 0 表示 key 以前缀开头
+    int against_prefix(std::string_view key) const {
+        std::size_t m = std::min(key.size(), prefix.size());
+        int c = key.substr(0, m).compare(std::string_view(prefix).substr(0, m));
+        if (c != 0)
+            return c;
+        return key.size() < prefix.size() ? -1 : 0;
+    }
+
+    // 用有序键重新编码: 前缀取第一个键和最后一个键的公共前缀
+    void assign(const std::vector<std::string>& keys) {
+        prefix.clear();
+        bytes.clear();
+        ends.clear();
+        if (keys.empty())
+            return;
+        std::size_t len = common_prefix(keys.front(), keys.back());
+        prefix.assign(keys.front(), 0, len);
+        for (const std::string& key : keys) {
+            bytes.append(key, len, std::string::npos);
+            ends.push_back(static_cast<uint32_t>(bytes.size()));
+        }
+    }
+
+    // 前缀缩短为 len 个字符, 去掉的部分补到每个后缀前面
+    void shorten_prefix(std::size_t len) {
+        std::string_view moved = std::string_view(prefix).substr(len);
+        std::string rebuilt;
+        rebuilt.reserve(bytes.size() + moved.size() * ends.size());
+        uint32_t begin = 0;
+        for (uint32_t& end : ends) {
+            rebuilt.append(moved.data(), moved.size());
+            rebuilt.append(bytes, begin, end - begin);
+            begin = end;
+            end = static_cast<uint32_t>(rebuilt.size());
+        }
+        bytes.swap(rebuilt);
+        prefix.resize(len);
+    }
+
+    // 分裂后剩下的键可能有更长的公共前缀
+    void lengthen_prefix() {
+        if (ends.empty())
+            return;
+        std::size_t ext = common_prefix(suffix(0), suffix(size() - 1));
+        if (ext == 0)
+            return;
+        prefix.append(bytes, 0, ext);
+        std::string rebuilt;
+        rebuilt.reserve(bytes.size() - ext * ends.size());
+        uint32_t begin = 0;
+        for (uint32_t& end : ends) {
+            rebuilt.append(bytes, begin + ext, end - begin - ext);
+            begin = end;
+            end = static_cast<uint32_t>(rebuilt.size());
+        }
+        bytes.swap(rebuilt);
+    }
+};
+
+// 整数: frame-of-reference, 块内存放最小键 base 和每个键与 base 的差, 差值宽度取能放下最大差值的
+// 1/2/4/8 字节。查找时把 key 转换成差值, 直接在窄整数数组上查找 (4/8 字节时走 SIMD)。
+/*
+  键:  1000000 1000003 1000150      base = 1000000, width = 1, deltas = [0, 3, 150]
+*/
+template <typename T>
+class DeltaKeys {
+    static_assert(std::is_integral_v<T>, "DeltaKeys needs integer keys");
+    using U = std::make_unsigned_t<T>;
+
+public:
+    using key_type = T;
+
+    int size() const { return n; }
+
+    int lower_bound(T key) const {
+        if (n == 0 || !(base < key))
+            return 0;
+        U d = static_cast<U>(static_cast<U>(key) - static_cast<U>(base));
+        switch (width) {
+        case 1:
+            return bound_in<uint8_t>(d);
+        case 2:
+            return bound_in<uint16_t>(d);
+        case 4:
+            return bound_in<uint32_t>(d);
+        default:
+            return bound_in<uint64_t>(d);
+        }
+    }
+
+    bool equals(int i, T key) const { return this->key(i) == key; }
+
+    T key(int i) const { return static_cast<T>(static_cast<U>(base) + static_cast<U>(delta(i))); }
+    void decode_into(int i, T& out) const { out = key(i); }
+
+    void insert(int i, T key) {
+        if (n > 0 && base < key) {
+            U d = static_cast<U>(static_cast<U>(key) - static_cast<U>(base));
+            if (width_for(d) <= width) {
+                data.insert(data.begin() + static_cast<std::ptrdiff_t>(i) * width, width, 0);
+                n++;
+                store(i, d);
+                return;
+            }
+        }
+        // 需要更换 base 或加宽差值: 解码后重新编码
+        std::vector<T> keys = decode_all();
+        keys.insert(keys.begin() + i, key);
+        assign(keys);
+    }
+
+    void erase(int i) {
+        if (i == 0) {
+            std::vector<T> keys = decode_all();
+            keys.erase(keys.begin());
+            assign(keys);
+            return;
+        }
+        data.erase(data.begin() + static_cast<std::ptrdiff_t>(i) * width,
+                   data.begin() + static_cast<std::ptrdiff_t>(i + 1) * width);
+        n--;
+    }
+
+    void split(int from, DeltaKeys& right) {
+        std::vector<T> keys = decode_all();
+        right.assign(std::vector<T>(keys.begin() + from, keys.end()));
+        keys.resize(from);
+        assign(keys);
+    }
+
+    void merge(DeltaKeys& right) {
+        std::vector<T> keys = decode_all();
+        std::vector<T> more = right.decode_all();
+        keys.insert(keys.end(), more.begin(), more.end());
+        assign(keys);
+        right.assign({});
+    }
+
+    static T separator(const DeltaKeys&, const DeltaKeys& right) { return right.key(0); }
+
+    std::size_t encoded_bytes() const { return sizeof(T) + data.size(); }
+
+    // 当前差值宽度 (字节)
+    int delta_width() const { return width; }
+
+private:
+    T base{};
+    int n = 0;
+    int width = 1;
+    std::vector<unsigned char> data;   // n 个差值, 每个 width 字节
+
+    static int width_for(U d) {
+        if (d <= 0xFFu)
+            return 1;
+        if (d <= 0xFFFFu)
+            return 2;
+        if (static_cast<uint64_t>(d) <= 0xFFFFFFFFu)
+            return 4;
+        return 8;
+    }
+
+    template <typename W>
+    const W* deltas() const {
+        return reinterpret_cast<const W*>(data.data());
+    }
+
+    template <typename W>
+    int bound_in(U d) const {
+        if (static_cast<uint64_t>(d) > std::numeric_limits<W>::max())
+            return n;
+        return btree_search::node_lower_bound(deltas<W>(), n, static_cast<W>(d));
+    }
+
+    uint64_t delta(int i) const {
+        switch (width) {
+        case 1:
+            return deltas<uint8_t>()[i];
+        case 2:
+            return deltas<uint16_t>()[i];
+        case 4:
+            return deltas<uint32_t>()[i];
+        default:
+            return deltas<uint64_t>()[i];
+        }
+    }
+
+    void store(int i, U d) {
+        unsigned char* p = data.data() + static_cast<std::size_t>(i) * width;
+        switch (width) {
+        case 1: {
+            uint8_t v = static_cast<uint8_t>(d);
+            std::memcpy(p, &v, 1);
+            break;
+        }
+        case 2: {
+            uint16_t v = static_cast<uint16_t>(d);
+            std::memcpy(p, &v, 2);
+            break;
+        }
+        case 4: {
+            uint32_t v = static_cast<uint32_t>(d);
+            std::memcpy(p, &v, 4);
+            break;
+        }
+        default: {
+            uint64_t v = static_cast<uint64_t>(d);
+            std::memcpy(p, &v, 8);
+        }
+        }
+    }
+
+    std::vector<T> decode_all() const {
+        std::vector<T> keys(n);
+        for (int i = 0; i < n; i++)
+            keys[i] = key(i);
+        return keys;
+    }
+
+    // 用有序键重新编码: base 取最小键, 宽度取最大差值需要的宽度
+    void assign(const std::vector<T>& keys) {
+        n = static_cast<int>(keys.size());
+        base = n ? keys[0] : T{};
+        width = n ? width_for(static_cast<U>(static_cast<U>(keys.back()) - static_cast<U>(base))) : 1;
+        data.assign(static_cast<std::size_t>(n) * width, 0);
+        for (int i = 0; i < n; i++)
+            store(i, static_cast<U>(static_cast<U>(keys[i]) - static_cast<U>(base)));
+    }
+};
+
+} // namespace btree_detail
+
+// 叶子键压缩的B+树, 键唯一; Block 决定叶子中键的编码 (见上面的接口说明)
+//
+//   PrefixBTree        std::string 键, 叶子做前缀压缩, 内部节点存放截断后的最短路由键
+//   DeltaBTree<T>      整数键, 叶子做 frame-of-reference 差值编码
+//
+// 独立的容器, 不是 BTree/BTreeMap 的选项: 结构与 BPlusTree 相同 (路由键 sep[i-1] <= k < sep[i],
+// 叶子串成双向链表, 插入时自顶向下预先分裂, 删除时自顶向下预先补足), 区别在于叶子中的键是变长的
+// 压缩表示, 节点用 std::vector 存放而不是固定大小的内联数组。
+// 迭代器解引用时解码出键的副本 (按值返回); 批量访问用 scan/for_each, 解码到同一个缓冲区中。
+// 键的顺序为 key_type 的 "<" (字符串按字节比较)。
+template <typename Block>
+class CompressedBTree {
+public:
+    using key_type = typename Block::key_type;
+
+private:
+    struct Node {
+        bool leaf;
+        explicit Node(bool leaf) : leaf(leaf) {}
+    };
+
+    struct Leaf : Node {
+        Block keys;
+        Leaf* prev = nullptr;
+        Leaf* next = nullptr;
+        Leaf() : Node(true) {}
+    };
+
+    struct Inner : Node {
+        std::vector<key_type> seps;    // 路由键
+        std::vector<Node*> children;
+        Inner() : Node(false) {}
+    };
+
+    Node* root;
+    Leaf* head;          // 最左叶子
+    Leaf* tail;          // 最右叶子
+    int t;
+    std::size_t count;
+
+    static Leaf* as_leaf(Node* node) { return static_cast<Leaf*>(node); }
+    static const Leaf* as_leaf(const Node* node) { return static_cast<const Leaf*>(node); }
+    static Inner* as_inner(Node* node) { return static_cast<Inner*>(node); }
+    static const Inner* as_inner(const Node* node) { return static_cast<const Inner*>(node); }
+
+    static int route(const Inner* node, const key_type& key) {
+        return btree_search::node_upper_bound(node->seps.data(), static_cast<int>(node->seps.size()), key);
+    }
+
+    // 叶子中的键数或内部节点中的路由键数
+    static int size_of(const Node* node) {
+        return node->leaf ? as_leaf(node)->keys.size() : static_cast<int>(as_inner(node)->seps.size());
+    }
+
+    bool is_full(const Node* node) const { return size_of(node) == 2 * t - 1; }
+
+    const Leaf* find_leaf(const key_type& key) const {
+        const Node* node = root;
+        while (!node->leaf)
+            node = as_inner(node)->children[route(as_inner(node), key)];
+        return as_leaf(node);
+    }
+
+    void reset_root() {
+        head = tail = new Leaf();
+        root = head;
+    }
+
+    // 分裂满子节点 children[index]
+    /*
+    叶子(t=3):    [A B C D E]  ->  [A B C] -> [D E],   路由键取 C 与 D 之间最短的键
+    内部节点:     [A B C D E]  ->  [A B]  C  [D E],     C 上移
+    */
+    void split_child(Inner* parent, int index) {
+        Node* child = parent->children[index];
+        Node* right;
+        key_type sep;
+        if (child->leaf) {
+            Leaf* left = as_leaf(child);
+            Leaf* new_leaf = new Leaf();
+            left->keys.split(t, new_leaf->keys);
+            new_leaf->prev = left;
+            new_leaf->next = left->next;
+            if (left->next)
+                left->next->prev = new_leaf;
+            else
+                tail = new_leaf;
+            left->next = new_leaf;
+            sep = Block::separator(left->keys, new_leaf->keys);
+            right = new_leaf;
+        } else {
+            Inner* left = as_inner(child);
+            Inner* new_inner = new Inner();
+            new_inner->seps.reserve(2 * t - 1);
+            new_inner->children.reserve(2 * t);
+            new_inner->seps.assign(std::make_move_iterator(left->seps.begin() + t),
+                                   std::make_move_iterator(left->seps.end()));
+            new_inner->children.assign(left->children.begin() + t, left->children.end());
+            sep = std::move(left->seps[t - 1]);
+            left->seps.resize(t - 1);
+            left->children.resize(t);
+            right = new_inner;
+        }
+        parent->seps.insert(parent->seps.begin() + index, std::move(sep));
+        parent->children.insert(parent->children.begin() + index + 1, right);
+    }
+
+    // 叶子之间移动键后, 路由键重新取两边之间最短的键
+    void borrow_from_prev(Inner* parent, int idx) {
+        Node* child = parent->children[idx];
+        Node* sibling = parent->children[idx - 1];
+        if (child->leaf) {
+            Block& from = as_leaf(sibling)->keys;
+            Block& to = as_leaf(child)->keys;
+            to.insert(0, from.key(from.size() - 1));
+            from.erase(from.size() - 1);
+            parent->seps[idx - 1] = Block::separator(from, to);
+        } else {
+            Inner* to = as_inner(child);
+            Inner* from = as_inner(sibling);
+            to->seps.insert(to->seps.begin(), std::move(parent->seps[idx - 1]));
+            to->children.insert(to->children.begin(), from->children.back());
+            parent->seps[idx - 1] = std::move(from->seps.back());
+            from->seps.pop_back();
+            from->children.pop_back();
+        }
+    }
+
+    void borrow_from_next(Inner* parent, int idx) {
+        Node* child = parent->children[idx];
+        Node* sibling = parent->children[idx + 1];
+        if (child->leaf) {
+            Block& from = as_leaf(sibling)->keys;
+            Block& to = as_leaf(child)->keys;
+            to.insert(to.size(), from.key(0));
+            from.erase(0);
+            parent->seps[idx] = Block::separator(to, from);
+        } else {
+            Inner* to = as_inner(child);
+            Inner* from = as_inner(sibling);
+            to->seps.push_back(std::move(parent->seps[idx]));
+            to->children.push_back(from->children.front());
+            parent->seps[idx] = std::move(from->seps.front());
+            from->seps.erase(from->seps.begin());
+            from->children.erase(from->children.begin());
+        }
+    }
+
+    // 合并 children[idx] 与 children[idx+1]
+    void merge(Inner* parent, int idx) {
+        Node* child = parent->children[idx];
+        Node* sibling = parent->children[idx + 1];
+        if (child->leaf) {
+            Leaf* left = as_leaf(child);
+            Leaf* right = as_leaf(sibling);
+            left->keys.merge(right->keys);
+            left->next = right->next;
+            if (right->next)
+                right->next->prev = left;
+            else
+                tail = left;
+            delete right;
+        } else {
+            Inner* left = as_inner(child);
+            Inner* right = as_inner(sibling);
+            left->seps.push_back(std::move(parent->seps[idx]));
+            left->seps.insert(left->seps.end(), std::make_move_iterator(right->seps.begin()),
+                              std::make_move_iterator(right->seps.end()));
+            left->children.insert(left->children.end(), right->children.begin(), right->children.end());
+            delete right;
+        }
+        parent->seps.erase(parent->seps.begin() + idx);
+        parent->children.erase(parent->children.begin() + idx + 1);
+    }
+
+    // 保证 children[idx] 至少有 t 个键, 返回之后应当下降的子节点下标
+    int fill(Inner* parent, int idx) {
+        int n = static_cast<int>(parent->seps.size());
+        if (idx != 0 && size_of(parent->children[idx - 1]) >= t) {
+            borrow_from_prev(parent, idx);
+        } else if (idx != n && size_of(parent->children[idx + 1]) >= t) {
+            borrow_from_next(parent, idx);
+        } else if (idx != n) {
+            merge(parent, idx);
+        } else {
+            merge(parent, idx - 1);
+            idx--;
+        }
+        return idx;
+    }
+
+    Inner* new_inner() {
+        Inner* node = new Inner();
+        node->seps.reserve(2 * t - 1);
+        node->children.reserve(2 * t);
+        return node;
+    }
+
+    static void destroy(Node* node) {
+        if (node->leaf) {
+            delete as_leaf(node);
+            return;
+        }
+        for (Node* child : as_inner(node)->children)
+            destroy(child);
+        delete as_inner(node);
+    }
+
+    void destroy_tree() {
+        if (root)
+            destroy(root);
+        root = head = tail = nullptr;
+        count = 0;
+    }
+
+    bool check_node(const Node* node, const key_type* lo, const key_type* hi, int depth, int& leaf_depth,
+                    std::size_t& keys_seen) const {
+        if (node->leaf) {
+            const Block& keys = as_leaf(node)->keys;
+            if (node != root && keys.size() < t - 1)
+                return false;
+            for (int i = 0; i < keys.size(); i++) {
+                key_type k = keys.key(i);
+                if ((i > 0 && !(keys.key(i - 1) < k)) || (lo && k < *lo) || (hi && !(k < *hi)))
+                    return false;
+                if (keys.lower_bound(k) != i || !keys.equals(i, k))
+                    return false;
+            }
+            keys_seen += keys.size();
+            if (leaf_depth < 0)
+                leaf_depth = depth;
+            return leaf_depth == depth;
+        }
+        const Inner* inner = as_inner(node);
+        int n = static_cast<int>(inner->seps.size());
+        if (inner->children.size() != inner->seps.size() + 1 || (node != root && n < t - 1) || n == 0)
+            return false;
+        for (int i = 0; i <= n; i++) {
+            if (i > 0 && i < n && !(inner->seps[i - 1] < inner->seps[i]))
+                return false;
+            const key_type* clo = i > 0 ? &inner->seps[i - 1] : lo;
+            const key_type* chi = i < n ? &inner->seps[i] : hi;
+            if (!check_node(inner->children[i], clo, chi, depth + 1, leaf_depth, keys_seen))
+                return false;
+        }
+        return true;
+    }
+
+    // 叶子链表与从根下降看到的叶子顺序一致
+    bool check_chain() const {
+        const Leaf* prev = nullptr;
+        const Node* node = root;
+        while (!node->leaf)
+            node = as_inner(node)->children.front();
+        if (node != head)
+            return false;
+        for (const Leaf* leaf = head; leaf; leaf = leaf->next) {
+            if (leaf->prev != prev)
+                return false;
+            prev = leaf;
+        }
+        return prev == tail;
+    }
+
+public:
+    // 双向迭代器: {叶子, 下标}, 沿叶子链表移动; leaf == nullptr 表示 end()
+    // 键不可修改, 解引用返回解码出的副本; 任何插入/删除之后, 已有的迭代器全部失效
+    class const_iterator {
+        friend class CompressedBTree;
+
+        const CompressedBTree* tree = nullptr;
+        const Leaf* leaf = nullptr;
+        int idx = 0;
+
+        const_iterator(const CompressedBTree* tree, const Leaf* leaf, int idx) : tree(tree), leaf(leaf), idx(idx) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = key_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = key_type;
+        using pointer = void;
+
+        const_iterator() = default;
+
+        key_type operator*() const { return leaf->keys.key(idx); }
+
+        // 解码到调用者的缓冲区, 不必每次构造新的键
+        void decode_into(key_type& out) const { leaf->keys.decode_into(idx, out); }
+
+        const_iterator& operator++() {
+            if (++idx == leaf->keys.size()) {
+                leaf = leaf->next;
+                idx = 0;
+            }
+            return *this;
+        }
+
+        const_iterator& operator--() {
+            if (!leaf) {
+                leaf = tree->tail;
+                idx = leaf->keys.size() - 1;
+            } else if (idx > 0) {
+                idx--;
+            } else {
+                leaf = leaf->prev;
+                idx = leaf->keys.size() - 1;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) {
+            return a.leaf == b.leaf && a.idx == b.idx;
+        }
+
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return !(a == b); }
+    };
+
+    using iterator = const_iterator;
+
+private:
+    // 非根叶子至少有 t-1 个键, 所以 leaf->next 不为空时它的第一个键就是下一个位置
+    const_iterator bound(const key_type& key, bool upper) const {
+        if (!root)
+            return end();
+        const Leaf* leaf = find_leaf(key);
+        int i = leaf->keys.lower_bound(key);
+        if (upper && i < leaf->keys.size() && leaf->keys.equals(i, key))
+            i++;
+        if (i == leaf->keys.size())
+            return const_iterator(this, leaf->next, 0);
+        return const_iterator(this, leaf, i);
+    }
+
+public:
+    explicit CompressedBTree(int min_degree)
+        : root(nullptr), head(nullptr), tail(nullptr), t(min_degree), count(0) {
+        if (min_degree < 2) {
+            throw std::invalid_argument("Minimum degree must be at least 2");
+        }
+        reset_root();
+    }
+
+    CompressedBTree(CompressedBTree&& other) noexcept
+        : root(std::exchange(other.root, nullptr)), head(std::exchange(other.head, nullptr)),
+          tail(std::exchange(other.tail, nullptr)), t(other.t), count(std::exchange(other.count, 0)) {}
+
+    CompressedBTree& operator=(CompressedBTree&& other) noexcept {
+        if (this != &other) {
+            destroy_tree();
+            root = std::exchange(other.root, nullptr);
+            head = std::exchange(other.head, nullptr);
+            tail = std::exchange(other.tail, nullptr);
+            t = other.t;
+            count = std::exchange(other.count, 0);
+        }
+        return *this;
+    }
+
+    CompressedBTree(const CompressedBTree&) = delete;
+    CompressedBTree& operator=(const CompressedBTree&) = delete;
+
+    ~CompressedBTree() { destroy_tree(); }
+
+    // 插入键, 已存在时返回 false
+    bool insert(const key_type& key) {
+        if (!root)
+            reset_root();
+        if (is_full(root)) {
+            Inner* new_root = new_inner();
+            new_root->children.push_back(root);
+            split_child(new_root, 0);
+            root = new_root;
+        }
+        Node* node = root;
+        while (!node->leaf) {
+            Inner* inner = as_inner(node);
+            int i = route(inner, key);
+            if (is_full(inner->children[i])) {
+                split_child(inner, i);
+                if (!(key < inner->seps[i]))
+                    i++;
+            }
+            node = inner->children[i];
+        }
+        Block& keys = as_leaf(node)->keys;
+        int i = keys.lower_bound(key);
+        if (i < keys.size() && keys.equals(i, key))
+            return false;
+        keys.insert(i, key);
+        count++;
+        return true;
+    }
+
+    bool contains(const key_type& key) const {
+        if (!root)
+            return false;
+        const Block& keys = find_leaf(key)->keys;
+        int i = keys.lower_bound(key);
+        return i < keys.size() && keys.equals(i, key);
+    }
+
+    std::optional<key_type> search(const key_type& key) const {
+        if (!contains(key))
+            return std::nullopt;
+        return key;
+    }
+
+    // 删除键, 不存在时返回 false; 下降时预先补足 (借键或合并), 根节点只剩一个子节点时收缩树高
+    bool erase(const key_type& key) {
+        if (!root)
+            return false;
+        Node* node = root;
+        while (!node->leaf) {
+            Inner* inner = as_inner(node);
+            int i = route(inner, key);
+            if (size_of(inner->children[i]) < t)
+                i = fill(inner, i);
+            node = inner->children[i];
+        }
+
+        bool removed = false;
+        Block& keys = as_leaf(node)->keys;
+        int i = keys.lower_bound(key);
+        if (i < keys.size() && keys.equals(i, key)) {
+            keys.erase(i);
+            count--;
+            removed = true;
+        }
+
+        if (!root->leaf && as_inner(root)->seps.empty()) {
+            Inner* old_root = as_inner(root);
+            root = old_root->children.front();
+            delete old_root;
+        }
+        return removed;
+    }
+
+    const_iterator begin() const { return const_iterator(this, count ? head : nullptr, 0); }
+    const_iterator end() const { return const_iterator(this, nullptr, 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // 第一个 >= key 的位置
+    const_iterator lower_bound(const key_type& key) const { return bound(key, false); }
+
+    // 第一个 > key 的位置
+    const_iterator upper_bound(const key_type& key) const { return bound(key, true); }
+
+    // 按顺序访问闭区间 [lo, hi] 内的所有键 (解码到同一个缓冲区中); fn 返回 bool 时, 返回 false 提前结束
+    template <typename F>
+    void scan(const key_type& lo, const key_type& hi, F&& fn) const {
+        const_iterator it = lower_bound(lo);
+        key_type key{};
+        for (const Leaf* leaf = it.leaf; leaf; leaf = leaf->next) {
+            for (int i = (leaf == it.leaf ? it.idx : 0); i < leaf->keys.size(); i++) {
+                leaf->keys.decode_into(i, key);
+                if (hi < key)
+                    return;
+                if constexpr (std::is_same_v<std::invoke_result_t<F&, const key_type&>, bool>) {
+                    if (!fn(static_cast<const key_type&>(key)))
+                        return;
+                } else {
+                    fn(static_cast<const key_type&>(key));
+                }
+            }
+        }
+    }
+
+    // 按顺序访问所有键
+    template <typename F>
+    void for_each(F&& fn) const {
+        key_type key{};
+        for (const Leaf* leaf = head; leaf; leaf = leaf->next) {
+            for (int i = 0; i < leaf->keys.size(); i++) {
+                leaf->keys.decode_into(i, key);
+                fn(static_cast<const key_type&>(key));
+            }
+        }
+    }
+
+    // 检查B+树性质: 键有序且落在路由键之间、节点键数不少于 t-1、所有叶子同一深度、
+    // 叶子链表完整、压缩形式上的查找与解码结果一致
+    bool check_invariants() const {
+        if (!root)
+            return count == 0;
+        int leaf_depth = -1;
+        std::size_t keys_seen = 0;
+        return check_node(root, nullptr, nullptr, 0, leaf_depth, keys_seen) && keys_seen == count && check_chain();
+    }
+
+    // 叶子中压缩后的键占用的字节数
+    std::size_t key_bytes() const {
+        std::size_t bytes = 0;
+        for (const Leaf* leaf = head; leaf; leaf = leaf->next)
+            bytes += leaf->keys.encoded_bytes();
+        return bytes;
+    }
+
+    int get_min_degree() const { return t; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+using PrefixBTree = CompressedBTree<btree_detail::PrefixKeys>;
+
+template <typename T>
+using DeltaBTree = CompressedBTree<btree_detail::DeltaKeys<T>>;
@@ -0,0 +1,776 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "epoch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace btree_detail {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// 自旋等待: 先忙等, 多次失败后让出CPU (持锁线程可能被调度出去, 线程数多于核数时尤其明显)
+class SpinWait {
+public:
+    void wait() {
+        if (++spins < kSpinLimit) {
+            cpu_relax();
+        } else {
+            spins = 0;
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    static constexpr int kSpinLimit = 64;
+    int spins = 0;
+};
+
+// 乐观锁(optimistic lock)
+//
+// 版本号: bit0 = 节点已废弃(obsolete), bit1 = 写锁, 其余位为修改计数
+//   读: read_lock 取版本号 -> 读数据 -> validate 检查版本号没有变化, 变化则重试; 读者不写共享内存
+//   写: upgrade 用 CAS 把读到的版本号加上写锁, 成功说明读之后节点没有被修改过
+//       write_unlock 去掉写锁并增加计数, 之前读到旧版本号的读者都会在 validate 时失败
+//
+// 读者读取的数据全部是 relaxed 原子变量; validate 前的 acquire fence 与写者加锁后的
+// release fence 配对, 保证读到写者的任何修改时, 一定也能看到加锁后的版本号。
+class OptLock {
+public:
+    static constexpr uint64_t kObsolete = 1;
+    static constexpr uint64_t kLocked = 2;
+
+    // 等待写锁释放后返回版本号; 节点已废弃时返回 false
+    bool read_lock(uint64_t& v) const {
+        v = version.load(std::memory_order_acquire);
+        SpinWait spin;
+        while (v & kLocked) {
+            spin.wait();
+            v = version.load(std::memory_order_acquire);
+        }
+        return !(v & kObsolete);
+    }
+
+    // 检查版本号从 read_lock 之后没有变化
+    bool validate(uint64_t v) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version.load(std::memory_order_relaxed) == v;
+    }
+
+    // 从读升级为写; 失败说明节点在读之后被修改(或正被修改)
+    bool upgrade(uint64_t v) {
+        if (!version.compare_exchange_strong(v, v + kLocked, std::memory_order_acquire)) {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    void write_unlock() {
+        version.fetch_add(kLocked, std::memory_order_release);
+    }
+
+    // 解锁并标记为废弃: 之后所有 read_lock/upgrade 都会失败
+    void write_unlock_obsolete() {
+        version.fetch_add(kLocked + kObsolete, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint64_t> version{0};
+};
+
+} // namespace btree_detail
+
+// 支持多线程并发读写的B树, 允许重复键 (语义同 BTree)
+//
+// 并发控制: 乐观锁耦合(optimistic lock coupling, OLC)
+//   每个节点一个 OptLock。下降时只记录版本号, 进入子节点前验证父节点版本没有变化;
+//   需要修改时才把读到的版本号升级为写锁, 任何验证/升级失败都从根重新开始。
+//   查找不加任何锁, 也不写共享内存, 多个读线程之间没有cache line争用。
+//
+// 插入/删除沿用 BTree 的单遍自顶向下算法:
+//   插入: 下降途中预先分裂满子节点, 修改只涉及父子两个节点
+//   删除: 下降途中预先补足只有 t-1 个键的子节点(借键或合并), 修改只涉及父节点和相邻的两个子节点
+// 加锁顺序总是从上到下, 兄弟节点只在持有父节点写锁时才加锁, 因此不会死锁。
+//
+// 内存回收: 合并/根收缩摘除的节点可能仍被无锁读者访问, 交给 EpochManager (见 epoch.h)
+// 等所有可能的读者离开后再批量释放; 每个操作开始时 pin 一次, 下降过程中不做任何原子读-改-写。
+//
+// 限制:
+//   - K 必须可平凡复制且 std::atomic<K> 无锁 (整数、指针、小的POD等)
+//   - size() 在并发修改时只是近似值
+template <typename K, typename Compare = std::less<K>>
+class ConcurrentBTree {
+    static_assert(std::is_trivially_copyable_v<K>, "ConcurrentBTree keys must be trivially copyable");
+    static_assert(std::atomic<K>::is_always_lock_free, "ConcurrentBTree keys must fit a lock-free atomic");
+
+    using OptLock = btree_detail::OptLock;
+
+public:
+    // 节点布局(一次分配): [Node头 | keys[2t-1] | children[2t] (仅内部节点)]
+    struct Node {
+        OptLock lock;
+        std::atomic<int> n;
+        const bool leaf;
+
+        explicit Node(bool leaf) : n(0), leaf(leaf) {}
+    };
+
+private:
+    std::atomic<Node*> root;
+    OptLock root_lock;                 // 保护 root 指针的替换 (根分裂/根收缩)
+    int t;
+    std::atomic<std::size_t> count;
+    std::size_t keys_offset;
+    std::size_t children_offset;
+    std::size_t leaf_bytes;
+    std::size_t internal_bytes;
+    Compare comp;
+
+    mutable EpochManager epochs;       // 回收被摘除的节点
+
+    enum class Result { Done, Restart };
+
+    static std::size_t align_up(std::size_t offset, std::size_t align) {
+        return (offset + align - 1) / align * align;
+    }
+
+    std::atomic<K>* keys(Node* node) const {
+        return reinterpret_cast<std::atomic<K>*>(reinterpret_cast<char*>(node) + keys_offset);
+    }
+    std::atomic<Node*>* children(Node* node) const {
+        return reinterpret_cast<std::atomic<Node*>*>(reinterpret_cast<char*>(node) + children_offset);
+    }
+
+    K key_at(Node* node, int i) const { return keys(node)[i].load(std::memory_order_relaxed); }
+    void set_key(Node* node, int i, K key) { keys(node)[i].store(key, std::memory_order_relaxed); }
+    // 子节点指针用 acquire/release: 读到新节点指针时, 新节点的初始化内容一定可见
+    Node* child_at(Node* node, int i) const { return children(node)[i].load(std::memory_order_acquire); }
+    void set_child(Node* node, int i, Node* child) { children(node)[i].store(child, std::memory_order_release); }
+    int size_of(Node* node) const { return node->n.load(std::memory_order_relaxed); }
+    void set_size(Node* node, int n) { node->n.store(n, std::memory_order_relaxed); }
+
+    Node* create_node(bool leaf) {
+        void* mem = ::operator new(leaf ? leaf_bytes : internal_bytes);
+        Node* node = new (mem) Node(leaf);
+        for (int i = 0; i < 2 * t - 1; i++)
+            new (&keys(node)[i]) std::atomic<K>(K{});
+        if (!leaf) {
+            for (int i = 0; i < 2 * t; i++)
+                new (&children(node)[i]) std::atomic<Node*>(nullptr);
+        }
+        return node;
+    }
+
+    static void free_node(Node* node) {
+        node->~Node();
+        ::operator delete(node);
+    }
+
+    void free_subtree(Node* node) {
+        if (!node->leaf) {
+            for (int i = 0; i <= size_of(node); i++)
+                free_subtree(child_at(node, i));
+        }
+        free_node(node);
+    }
+
+    // 解锁并废弃节点; 其他线程可能仍持有指向它的指针, 由 epochs 延迟释放
+    void retire(Node* node) {
+        node->lock.write_unlock_obsolete();
+        epochs.retire(node, [](void* p) { free_node(static_cast<Node*>(p)); });
+    }
+
+    // 节点内查找; 读者读到的 n 与键可能不一致, 结果由调用者验证版本号后才使用
+    int lower_bound_in(Node* node, int n, const K& key) const {
+        int lo = 0, hi = n;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (comp(key_at(node, mid), key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    int upper_bound_in(Node* node, int n, const K& key) const {
+        int lo = 0, hi = n;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (comp(key, key_at(node, mid)))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    // 读到的键数量, 限制在合法范围内, 防止读到正在修改的节点时越界
+    int read_size(Node* node) const {
+        int n = size_of(node);
+        return n < 0 ? 0 : (n > 2 * t - 1 ? 2 * t - 1 : n);
+    }
+
+    // ---- 持有写锁时的节点修改, 与 BTreeBase 中的同名操作一致 ----
+
+    // 分裂满子节点 child = children[i]; parent 与 child 均已加写锁, parent 未满
+    void split_child(Node* parent, int i, Node* child) {
+        Node* right = create_node(child->leaf);
+        for (int j = 0; j < t - 1; j++)
+            set_key(right, j, key_at(child, j + t));
+        if (!child->leaf) {
+            for (int j = 0; j < t; j++)
+                set_child(right, j, child_at(child, j + t));
+        }
+        set_size(right, t - 1);
+
+        int pn = size_of(parent);
+        for (int j = pn; j > i; j--)
+            set_child(parent, j + 1, child_at(parent, j));
+        for (int j = pn - 1; j >= i; j--)
+            set_key(parent, j + 1, key_at(parent, j));
+        set_child(parent, i + 1, right);
+        set_key(parent, i, key_at(child, t - 1));
+        set_size(parent, pn + 1);
+        set_size(child, t - 1);
+    }
+
+    void borrow_from_prev(Node* parent, int i, Node* child, Node* sibling) {
+        int cn = size_of(child), sn = size_of(sibling);
+        for (int j = cn - 1; j >= 0; j--)
+            set_key(child, j + 1, key_at(child, j));
+        if (!child->leaf) {
+            for (int j = cn; j >= 0; j--)
+                set_child(child, j + 1, child_at(child, j));
+            set_child(child, 0, child_at(sibling, sn));
+        }
+        set_key(child, 0, key_at(parent, i - 1));
+        set_key(parent, i - 1, key_at(sibling, sn - 1));
+        set_size(child, cn + 1);
+        set_size(sibling, sn - 1);
+    }
+
+    void borrow_from_next(Node* parent, int i, Node* child, Node* sibling) {
+        int cn = size_of(child), sn = size_of(sibling);
+        set_key(child, cn, key_at(parent, i));
+        if (!child->leaf)
+            set_child(child, cn + 1, child_at(sibling, 0));
+        set_key(parent, i, key_at(sibling, 0));
+        for (int j = 1; j < sn; j++)
+            set_key(sibling, j - 1, key_at(sibling, j));
+        if (!sibling->leaf) {
+            for (int j = 1; j <= sn; j++)
+                set_child(sibling, j - 1, child_at(sibling, j));
+        }
+        set_size(child, cn + 1);
+        set_size(sibling, sn - 1);
+    }
+
+    // 把 parent->keys[i] 和 right 合并进 left; right 由调用者废弃
+    void merge(Node* parent, int i, Node* left, Node* right) {
+        int ln = size_of(left), rn = size_of(right), pn = size_of(parent);
+        set_key(left, ln, key_at(parent, i));
+        for (int j = 0; j < rn; j++)
+            set_key(left, ln + 1 + j, key_at(right, j));
+        if (!left->leaf) {
+            for (int j = 0; j <= rn; j++)
+                set_child(left, ln + 1 + j, child_at(right, j));
+        }
+        set_size(left, ln + rn + 1);
+
+        for (int j = i + 1; j < pn; j++)
+            set_key(parent, j - 1, key_at(parent, j));
+        for (int j = i + 2; j <= pn; j++)
+            set_child(parent, j - 1, child_at(parent, j));
+        set_size(parent, pn - 1);
+    }
+
+    // 读取子节点版本号并加写锁
+    static bool lock_node(Node* node) {
+        uint64_t v;
+        return node->lock.read_lock(v) && node->lock.upgrade(v);
+    }
+
+    // 补足 children[i] (parent 与 child 已加写锁, child 有 t-1 个键)
+    // 成功时返回之后应当下降的子节点 (仍持有写锁), 其余节点已解锁; 失败返回 nullptr, 只有 parent 仍加锁
+    Node* fill(Node* parent, int i, Node* child) {
+        int pn = size_of(parent);
+        Node* left = i > 0 ? child_at(parent, i - 1) : nullptr;
+        Node* right = i < pn ? child_at(parent, i + 1) : nullptr;
+        if (left && !lock_node(left)) {
+            child->lock.write_unlock();
+            return nullptr;
+        }
+        if (right && !lock_node(right)) {
+            if (left)
+                left->lock.write_unlock();
+            child->lock.write_unlock();
+            return nullptr;
+        }
+
+        Node* target = child;
+        if (left && size_of(left) >= t) {
+            borrow_from_prev(parent, i, child, left);
+        } else if (right && size_of(right) >= t) {
+            borrow_from_next(parent, i, child, right);
+        } else if (right) {
+            merge(parent, i, child, right);
+            retire(right);
+            right = nullptr;
+        } else {
+            merge(parent, i - 1, left, child);
+            retire(child);
+            target = left;
+            left = nullptr;
+        }
+        if (left)
+            left->lock.write_unlock();
+        if (right)
+            right->lock.write_unlock();
+        return target;
+    }
+
+    // ---- 查找 ----
+
+    Result try_search(const K& key, std::optional<K>& found) const {
+        uint64_t rv, v;
+        if (!root_lock.read_lock(rv))
+            return Result::Restart;
+        Node* node = root.load(std::memory_order_acquire);
+        if (!node->lock.read_lock(v) || !root_lock.validate(rv))
+            return Result::Restart;
+
+        while (true) {
+            int n = read_size(node);
+            int i = lower_bound_in(node, n, key);
+            if (i < n) {
+                K k = key_at(node, i);
+                if (!comp(key, k)) {
+                    if (!node->lock.validate(v))
+                        return Result::Restart;
+                    found = k;
+                    return Result::Done;
+                }
+            }
+            if (node->leaf) {
+                if (!node->lock.validate(v))
+                    return Result::Restart;
+                found.reset();
+                return Result::Done;
+            }
+            Node* child = child_at(node, i);
+            if (!node->lock.validate(v))
+                return Result::Restart;
+            uint64_t cv;
+            if (!child->lock.read_lock(cv) || !node->lock.validate(v))
+                return Result::Restart;
+            node = child;
+            v = cv;
+        }
+    }
+
+    // ---- 插入 ----
+
+    // 根节点已满时分裂根节点
+    Result split_root(uint64_t rv, Node* node, uint64_t v) {
+        if (!root_lock.upgrade(rv))
+            return Result::Restart;
+        if (!node->lock.upgrade(v)) {
+            root_lock.write_unlock();
+            return Result::Restart;
+        }
+        Node* new_root = create_node(false);
+        set_child(new_root, 0, node);
+        split_child(new_root, 0, node);
+        root.store(new_root, std::memory_order_release);
+        node->lock.write_unlock();
+        root_lock.write_unlock();
+        return Result::Restart;
+    }
+
+    Result try_insert(const K& key) {
+        uint64_t rv, v;
+        if (!root_lock.read_lock(rv))
+            return Result::Restart;
+        Node* node = root.load(std::memory_order_acquire);
+        if (!node->lock.read_lock(v) || !root_lock.validate(rv))
+            return Result::Restart;
+        if (size_of(node) == 2 * t - 1)
+            return split_root(rv, node, v);
+        // 父节点 (根节点时为 root_lock) 及其版本号: 当前节点的键范围只有在父节点加写锁时才会改变
+        const OptLock* parent_lock = &root_lock;
+        uint64_t pv = rv;
+
+        while (true) {
+            // 插入到相等键之后
+            int i = upper_bound_in(node, read_size(node), key);
+            if (node->leaf) {
+                if (!node->lock.upgrade(v))
+                    return Result::Restart;
+                int n = size_of(node);
+                for (int j = n - 1; j >= i; j--)
+                    set_key(node, j + 1, key_at(node, j));
+                set_key(node, i, key);
+                set_size(node, n + 1);
+                node->lock.write_unlock();
+                return Result::Done;
+            }
+
+            Node* child = child_at(node, i);
+            if (!node->lock.validate(v))
+                return Result::Restart;
+            uint64_t cv;
+            if (!child->lock.read_lock(cv))
+                return Result::Restart;
+
+            if (size_of(child) == 2 * t - 1) {
+                // 预先分裂满子节点
+                if (!node->lock.upgrade(v))
+                    return Result::Restart;
+                if (!child->lock.upgrade(cv)) {
+                    node->lock.write_unlock();
+                    return Result::Restart;
+                }
+                split_child(node, i, child);
+                child->lock.write_unlock();
+                node->lock.write_unlock();
+                // 放开锁后其他线程可能分裂了当前节点或从它借走键 (键范围变了), 也可能又把它填满;
+                // 重新取版本号, 父节点没有变化且当前节点未满才能继续
+                if (!node->lock.read_lock(v) || !parent_lock->validate(pv) || size_of(node) == 2 * t - 1)
+                    return Result::Restart;
+                continue;
+            }
+
+            if (!node->lock.validate(v))
+                return Result::Restart;
+            parent_lock = &node->lock;
+            pv = v;
+            node = child;
+            v = cv;
+        }
+    }
+
+    // ---- 删除 ----
+
+    // 根节点为没有键的内部节点时(合并后的结果), 用唯一的子节点替换根节点
+    Result collapse_root(uint64_t rv, Node* node, uint64_t v) {
+        if (!root_lock.upgrade(rv))
+            return Result::Restart;
+        if (!node->lock.upgrade(v)) {
+            root_lock.write_unlock();
+            return Result::Restart;
+        }
+        root.store(child_at(node, 0), std::memory_order_release);
+        retire(node);
+        root_lock.write_unlock();
+        return Result::Restart;
+    }
+
+    // 用前驱(左子树最大键)替换 node->keys[i] 并从叶子中删除前驱
+    // node 与 w = children[i] 已加写锁, w 至少有 t 个键; 沿最右路径下降, 途中预先补足
+    Result replace_with_predecessor(Node* node, int i, Node* w) {
+        while (!w->leaf) {
+            int wn = size_of(w);
+            Node* c = child_at(w, wn);
+            if (!lock_node(c)) {
+                w->lock.write_unlock();
+                node->lock.write_unlock();
+                return Result::Restart;
+            }
+            if (size_of(c) < t) {
+                Node* left = child_at(w, wn - 1);
+                if (!lock_node(left)) {
+                    c->lock.write_unlock();
+                    w->lock.write_unlock();
+                    node->lock.write_unlock();
+                    return Result::Restart;
+                }
+                if (size_of(left) >= t) {
+                    borrow_from_prev(w, wn, c, left);
+                    left->lock.write_unlock();
+                } else {
+                    merge(w, wn - 1, left, c);
+                    retire(c);
+                    c = left;
+                }
+            }
+            w->lock.write_unlock();
+            w = c;
+        }
+        int wn = size_of(w);
+        set_key(node, i, key_at(w, wn - 1));
+        set_size(w, wn - 1);
+        w->lock.write_unlock();
+        node->lock.write_unlock();
+        return Result::Done;
+    }
+
+    // 用后继(右子树最小键)替换 node->keys[i]; w = children[i+1] 至少有 t 个键, 沿最左路径下降
+    Result replace_with_successor(Node* node, int i, Node* w) {
+        while (!w->leaf) {
+            Node* c = child_at(w, 0);
+            if (!lock_node(c)) {
+                w->lock.write_unlock();
+                node->lock.write_unlock();
+                return Result::Restart;
+            }
+            if (size_of(c) < t) {
+                Node* right = child_at(w, 1);
+                if (!lock_node(right)) {
+                    c->lock.write_unlock();
+                    w->lock.write_unlock();
+                    node->lock.write_unlock();
+                    return Result::Restart;
+                }
+                if (size_of(right) >= t) {
+                    borrow_from_next(w, 0, c, right);
+                    right->lock.write_unlock();
+                } else {
+                    merge(w, 0, c, right);
+                    retire(right);
+                }
+            }
+            w->lock.write_unlock();
+            w = c;
+        }
+        int wn = size_of(w);
+        set_key(node, i, key_at(w, 0));
+        for (int j = 1; j < wn; j++)
+            set_key(w, j - 1, key_at(w, j));
+        set_size(w, wn - 1);
+        w->lock.write_unlock();
+        node->lock.write_unlock();
+        return Result::Done;
+    }
+
+    Result try_remove(const K& key, bool& removed) {
+        uint64_t rv, v;
+        if (!root_lock.read_lock(rv))
+            return Result::Restart;
+        Node* node = root.load(std::memory_order_acquire);
+        if (!node->lock.read_lock(v) || !root_lock.validate(rv))
+            return Result::Restart;
+        if (!node->leaf && size_of(node) == 0)
+            return collapse_root(rv, node, v);
+        // 同 try_insert: 补足子节点后用父节点的版本号确认当前节点的键范围没有变化
+        const OptLock* parent_lock = &root_lock;
+        uint64_t pv = rv;
+
+        while (true) {
+            int n = read_size(node);
+            int i = lower_bound_in(node, n, key);
+            bool here = i < n && !comp(key, key_at(node, i));
+
+            if (node->leaf) {
+                if (!here) {
+                    if (!node->lock.validate(v))
+                        return Result::Restart;
+                    removed = false;
+                    return Result::Done;
+                }
+                if (!node->lock.upgrade(v))
+                    return Result::Restart;
+                n = size_of(node);
+                for (int j = i + 1; j < n; j++)
+                    set_key(node, j - 1, key_at(node, j));
+                set_size(node, n - 1);
+                node->lock.write_unlock();
+                removed = true;
+                return Result::Done;
+            }
+
+            // 内部节点只有一个子节点(空根): 交给 collapse_root 处理
+            if (n == 0)
+                return Result::Restart;
+
+            Node* child = child_at(node, i);
+            if (!node->lock.validate(v))
+                return Result::Restart;
+            uint64_t cv;
+            if (!child->lock.read_lock(cv))
+                return Result::Restart;
+
+            if (here) {
+                // 键在内部节点中
+                if (!node->lock.upgrade(v))
+                    return Result::Restart;
+                if (!child->lock.upgrade(cv)) {
+                    node->lock.write_unlock();
+                    return Result::Restart;
+                }
+                if (size_of(child) >= t) {
+                    removed = true;
+                    return replace_with_predecessor(node, i, child);
+                }
+                Node* right = child_at(node, i + 1);
+                if (!lock_node(right)) {
+                    child->lock.write_unlock();
+                    node->lock.write_unlock();
+                    return Result::Restart;
+                }
+                if (size_of(right) >= t) {
+                    child->lock.write_unlock();
+                    removed = true;
+                    return replace_with_successor(node, i, right);
+                }
+                // 两侧都只有 t-1 个键: 合并后键下沉到 child 中, 重新下降时在 child 中删除
+                merge(node, i, child, right);
+                retire(right);
+                child->lock.write_unlock();
+                node->lock.write_unlock();
+                return Result::Restart;
+            }
+
+            if (size_of(child) < t) {
+                // 预先补足
+                if (!node->lock.upgrade(v))
+                    return Result::Restart;
+                if (!child->lock.upgrade(cv)) {
+                    node->lock.write_unlock();
+                    return Result::Restart;
+                }
+                Node* target = fill(node, i, child);
+                if (target)
+                    target->lock.write_unlock();
+                node->lock.write_unlock();
+                // 放开锁后当前节点可能被其他线程的合并减少到 t-1 个键, 或者因为兄弟节点借键/父节点调整而
+                // 改变了键范围; 重新取版本号, 父节点没有变化且仍有 t 个键才能继续
+                // (根节点不满足时也从根重新开始, 只影响很少的情况)
+                if (!target || !node->lock.read_lock(v) || !parent_lock->validate(pv) || size_of(node) < t)
+                    return Result::Restart;
+                continue;
+            }
+
+            if (!node->lock.validate(v))
+                return Result::Restart;
+            parent_lock = &node->lock;
+            pv = v;
+            node = child;
+            v = cv;
+        }
+    }
+
+public:
+    explicit ConcurrentBTree(int min_degree, Compare compare = Compare())
+        : t(min_degree), count(0), comp(std::move(compare)) {
+        if (min_degree < 2) {
+            throw std::invalid_argument("Minimum degree must be at least 2");
+        }
+        keys_offset = align_up(sizeof(Node), alignof(std::atomic<K>));
+        std::size_t keys_end = keys_offset + (2 * t - 1) * sizeof(std::atomic<K>);
+        leaf_bytes = keys_end;
+        children_offset = align_up(keys_end, alignof(std::atomic<Node*>));
+        internal_bytes = children_offset + 2 * t * sizeof(std::atomic<Node*>);
+        root.store(create_node(true), std::memory_order_relaxed);
+    }
+
+    ConcurrentBTree(const ConcurrentBTree&) = delete;
+    ConcurrentBTree& operator=(const ConcurrentBTree&) = delete;
+
+    // 析构时不能有其他线程在访问这棵树
+    ~ConcurrentBTree() {
+        free_subtree(root.load(std::memory_order_relaxed));
+    }
+
+    std::optional<K> search(const K& key) const {
+        std::optional<K> found;
+        auto guard = epochs.pin();
+        btree_detail::SpinWait spin;
+        while (try_search(key, found) == Result::Restart)
+            spin.wait();
+        return found;
+    }
+
+    bool contains(const K& key) const {
+        return search(key).has_value();
+    }
+
+    void insert(const K& key) {
+        auto guard = epochs.pin();
+        btree_detail::SpinWait spin;
+        while (try_insert(key) == Result::Restart)
+            spin.wait();
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 删除一个等于 key 的键, 返回是否存在
+    bool remove(const K& key) {
+        bool removed = false;
+        auto guard = epochs.pin();
+        btree_detail::SpinWait spin;
+        while (try_remove(key, removed) == Result::Restart)
+            spin.wait();
+        if (removed)
+            count.fetch_sub(1, std::memory_order_relaxed);
+        return removed;
+    }
+
+    // 按顺序访问所有键; 调用期间不能有并发修改
+    template <typename F>
+    void for_each(F&& fn) const {
+        for_each_in(root.load(std::memory_order_acquire), fn);
+    }
+
+    // 检查B树性质(键数范围、有序、叶子同深度), 调用期间不能有并发修改
+    bool check_invariants() const {
+        int leaf_depth = -1;
+        Node* r = root.load(std::memory_order_acquire);
+        return check_node(r, true, 0, leaf_depth, nullptr, nullptr);
+    }
+
+    int get_min_degree() const { return t; }
+    std::size_t size() const { return count.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+private:
+    template <typename F>
+    void for_each_in(Node* node, F& fn) const {
+        int n = size_of(node);
+        for (int i = 0; i < n; i++) {
+            if (!node->leaf)
+                for_each_in(child_at(node, i), fn);
+            fn(key_at(node, i));
+        }
+        if (!node->leaf)
+            for_each_in(child_at(node, n), fn);
+    }
+
+    bool check_node(Node* node, bool is_root, int depth, int& leaf_depth, const K* lo, const K* hi) const {
+        int n = size_of(node);
+        if (n > 2 * t - 1 || (!is_root && n < t - 1))
+            return false;
+        for (int i = 0; i < n; i++) {
+            K k = key_at(node, i);
+            if ((i > 0 && comp(k, key_at(node, i - 1))) || (lo && comp(k, *lo)) || (hi && comp(*hi, k)))
+                return false;
+        }
+        if (node->leaf) {
+            if (leaf_depth < 0)
+                leaf_depth = depth;
+            return leaf_depth == depth;
+        }
+        for (int i = 0; i <= n; i++) {
+            K left = i > 0 ? key_at(node, i - 1) : K{};
+            K right = i < n ? key_at(node, i) : K{};
+            if (!check_node(child_at(node, i), false, depth + 1, leaf_depth,
+                            i > 0 ? &left : lo, i < n ? &right : hi))
+                return false;
+        }
+        return true;
+    }
+};
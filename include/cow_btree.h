@@ -0,0 +1,622 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include "btree_search.h"
+
+namespace btree_detail {
+
+// 写时复制(copy-on-write) B树的只读部分, CowBTree 与它的快照共用
+//
+// 节点带引用计数, 计数的是"有多少个父节点(或树/快照的根)指向它"。
+// 快照只是对根节点加一次引用, O(1); 之后写者沿途遇到引用数 > 1 的节点时先复制一份再修改,
+// 只有从根到被修改节点的路径会被复制, 其余子树继续共享:
+/*
+  snapshot() 之后插入 x (x 落在 C 中):
+
+     快照根 -> [R]                 [R'] <- 树根       R', B', C' 为复制出的新节点
+              / \                  / \
+           [A]  [B]   <---共享--- /  [B']            A 仍被两个根共享 (引用数 2)
+                / \             [A]  / \
+             [D]  [C]              [D] [C' + x]      D 被 B 与 B' 共享
+*/
+// 引用计数是原子的: 快照可以交给其他线程读取/析构, 与写者并行; 写者只修改引用数为 1 的节点,
+// 这些节点只能从树根经过一串引用数为 1 的节点到达, 任何快照都看不到它们。
+// 树本身(插入/删除/snapshot())仍然只能由一个线程修改。
+template <typename K, typename Compare>
+class CowTreeView {
+public:
+    struct Node {
+        std::atomic<uint32_t> refs;       // 指向该节点的父节点/根的个数
+        int n;                            // 当前键值数量
+        bool leaf;                        // 是否为叶子节点
+
+        explicit Node(bool leaf) : refs(1), n(0), leaf(leaf) {}
+
+        static constexpr std::size_t keys_offset() {
+            return (sizeof(Node) + alignof(K) - 1) / alignof(K) * alignof(K);
+        }
+
+        K* keys() {
+            return reinterpret_cast<K*>(reinterpret_cast<char*>(this) + keys_offset());
+        }
+        const K* keys() const {
+            return reinterpret_cast<const K*>(reinterpret_cast<const char*>(this) + keys_offset());
+        }
+    };
+
+    static_assert(alignof(K) <= alignof(std::max_align_t), "over-aligned key types are not supported");
+
+    // 树高上限: t>=2 时高度为40的树至少需要 2^39 个键
+    static constexpr int kMaxHeight = 40;
+
+protected:
+    Node* root;                  // 根节点 (持有一个引用), 空树为 nullptr
+    int t;                       // 最小度数(minimum degree)
+    std::size_t count;           // 键值总数
+    std::size_t children_offset; // 子节点指针数组在节点内的偏移
+    Compare comp;                // 键比较器
+
+    CowTreeView(Node* root, int t, std::size_t count, Compare comp)
+        : root(root), t(t), count(count),
+          children_offset((Node::keys_offset() + (2 * t - 1) * sizeof(K) + alignof(Node*) - 1) /
+                          alignof(Node*) * alignof(Node*)),
+          comp(std::move(comp)) {}
+
+    static K* keys(Node* node) { return node->keys(); }
+    static const K* keys(const Node* node) { return node->keys(); }
+
+    Node** children(Node* node) const {
+        return reinterpret_cast<Node**>(reinterpret_cast<char*>(node) + children_offset);
+    }
+    Node* const* children(const Node* node) const {
+        return reinterpret_cast<Node* const*>(reinterpret_cast<const char*>(node) + children_offset);
+    }
+
+    static void retain(Node* node) {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 放弃一个引用; 最后一个引用消失时析构键、释放子节点的引用并回收节点
+    void release(Node* node) const {
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++)
+                release(children(node)[i]);
+        }
+        std::destroy_n(keys(node), node->n);
+        node->~Node();
+        ::operator delete(node);
+    }
+
+    int lower_bound_in(const Node* node, const K& key) const {
+        return btree_search::node_lower_bound(node->keys(), node->n, key, comp);
+    }
+    int upper_bound_in(const Node* node, const K& key) const {
+        return btree_search::node_upper_bound(node->keys(), node->n, key, comp);
+    }
+
+    bool check_node(const Node* node, const K* lo, const K* hi, int depth, int& leaf_depth) const {
+        if (node->refs.load(std::memory_order_relaxed) == 0)
+            return false;
+        if (node != root && (node->n < t - 1 || node->n > 2 * t - 1))
+            return false;
+        for (int i = 0; i < node->n; i++) {
+            const K& k = keys(node)[i];
+            if ((i > 0 && comp(k, keys(node)[i - 1])) || (lo && comp(k, *lo)) || (hi && comp(*hi, k)))
+                return false;
+        }
+        if (node->leaf) {
+            if (leaf_depth < 0)
+                leaf_depth = depth;
+            return leaf_depth == depth;
+        }
+        for (int i = 0; i <= node->n; i++) {
+            const K* clo = i > 0 ? &keys(node)[i - 1] : lo;
+            const K* chi = i < node->n ? &keys(node)[i] : hi;
+            if (!check_node(children(node)[i], clo, chi, depth + 1, leaf_depth))
+                return false;
+        }
+        return true;
+    }
+
+public:
+    // 只读前向迭代器, 用路径栈定位 (节点没有父指针)
+    /*
+    栈中每一层 {node, idx}:
+      - 栈顶: 当前键 node->keys[idx]
+      - 祖先: 下降时进入的子节点下标 idx; 回到该层时下一个键就是 keys[idx]
+    depth == 0 表示 end()
+    树的迭代器在下一次插入/删除后失效; 快照的迭代器在快照析构前一直有效
+    */
+    class const_iterator {
+        friend class CowTreeView;
+
+        struct Frame {
+            const Node* node;
+            int idx;
+        };
+
+        const CowTreeView* view = nullptr;
+        int depth = 0;
+        Frame path[kMaxHeight];
+
+        explicit const_iterator(const CowTreeView* view) : view(view) {}
+
+        Frame& top() { return path[depth - 1]; }
+        const Frame& top() const { return path[depth - 1]; }
+
+        void push_leftmost(const Node* node) {
+            while (true) {
+                path[depth++] = Frame{node, 0};
+                if (node->leaf)
+                    break;
+                node = view->children(node)[0];
+            }
+        }
+
+        // 栈顶叶子已经走完: 向上回到第一个还有键没访问的祖先
+        void pop_exhausted() {
+            --depth;
+            while (depth > 0 && top().idx == top().node->n)
+                --depth;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = K;
+        using difference_type = std::ptrdiff_t;
+        using reference = const K&;
+        using pointer = const K*;
+
+        const_iterator() = default;
+
+        reference operator*() const { return top().node->keys()[top().idx]; }
+        pointer operator->() const { return &**this; }
+
+        const_iterator& operator++() {
+            Frame& f = top();
+            if (!f.node->leaf) {
+                // 下一个键是右侧子树 children[idx+1] 的最左键
+                f.idx++;
+                push_leftmost(view->children(f.node)[f.idx]);
+            } else if (++f.idx == f.node->n) {
+                pop_exhausted();
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) {
+            if (a.depth != b.depth)
+                return false;
+            return a.depth == 0 || (a.top().node == b.top().node && a.top().idx == b.top().idx);
+        }
+
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+            return !(a == b);
+        }
+    };
+
+    std::optional<K> search(const K& key) const {
+        const Node* node = root;
+        while (node) {
+            int i = lower_bound_in(node, key);
+            if (i < node->n && !comp(key, keys(node)[i]))
+                return keys(node)[i];
+            if (node->leaf)
+                break;
+            node = children(node)[i];
+        }
+        return std::nullopt;
+    }
+
+    bool contains(const K& key) const {
+        return search(key).has_value();
+    }
+
+    const_iterator begin() const {
+        const_iterator it(this);
+        if (root && root->n > 0)
+            it.push_leftmost(root);
+        return it;
+    }
+
+    const_iterator end() const {
+        return const_iterator(this);
+    }
+
+    // 第一个 >= key 的位置
+    const_iterator lower_bound(const K& key) const {
+        const_iterator it(this);
+        if (!root || root->n == 0)
+            return it;
+        const Node* node = root;
+        while (true) {
+            int i = lower_bound_in(node, key);
+            it.path[it.depth++] = {node, i};
+            if (node->leaf)
+                break;
+            node = children(node)[i];
+        }
+        if (it.top().idx == it.top().node->n)
+            it.pop_exhausted();
+        return it;
+    }
+
+    // 检查B树性质: 节点键数、键有序、所有叶子同一深度
+    bool check_invariants() const {
+        if (!root)
+            return count == 0;
+        int leaf_depth = -1;
+        return check_node(root, nullptr, nullptr, 0, leaf_depth);
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    int get_min_degree() const { return t; }
+};
+
+} // namespace btree_detail
+
+template <typename T, typename Compare>
+class CowBTree;
+
+// 只读快照: 创建快照时树的内容, 之后树的修改对它不可见
+// 拷贝/析构都是 O(1) (只调整根节点的引用数), 可以在其他线程中读取和析构
+template <typename T, typename Compare = std::less<T>>
+class CowSnapshot : public btree_detail::CowTreeView<T, Compare> {
+    using View = btree_detail::CowTreeView<T, Compare>;
+    using Node = typename View::Node;
+    friend class CowBTree<T, Compare>;
+
+    CowSnapshot(Node* root, int t, std::size_t count, const Compare& comp) : View(root, t, count, comp) {
+        if (root)
+            View::retain(root);
+    }
+
+public:
+    CowSnapshot(const CowSnapshot& other) : CowSnapshot(other.root, other.t, other.count, other.comp) {}
+
+    CowSnapshot(CowSnapshot&& other) noexcept : View(other.root, other.t, other.count, other.comp) {
+        other.root = nullptr;
+        other.count = 0;
+    }
+
+    CowSnapshot& operator=(CowSnapshot other) noexcept {
+        std::swap(this->root, other.root);
+        std::swap(this->count, other.count);
+        std::swap(this->t, other.t);
+        std::swap(this->children_offset, other.children_offset);
+        std::swap(this->comp, other.comp);
+        return *this;
+    }
+
+    ~CowSnapshot() {
+        if (this->root)
+            this->release(this->root);
+    }
+};
+
+// 支持 O(1) 快照的B树, 允许重复键 (语义与 BTree 相同)
+//
+// 插入/删除沿用 BTree 的单遍自顶向下算法 (预先分裂/预先补足); 每进入一个子节点之前
+// 先确保它只被当前路径引用 (mutable_child), 被快照共享时复制一份。
+// 没有打开的快照时所有节点引用数都为 1, 除了每层一次引用数检查外没有额外开销。
+//
+// 节点布局(一次分配): [Node头(refs, n, leaf) | keys[2t-1] | children[2t] (仅内部节点)]
+// 节点直接来自 operator new: 快照可能比树活得更久, 不能使用随树释放的 NodeArena。
+template <typename T, typename Compare = std::less<T>>
+class CowBTree : public btree_detail::CowTreeView<T, Compare> {
+    using View = btree_detail::CowTreeView<T, Compare>;
+    using Node = typename View::Node;
+    using View::children;
+    using View::keys;
+    using View::t;
+
+public:
+    using Snapshot = CowSnapshot<T, Compare>;
+
+private:
+    std::size_t leaf_bytes;      // 叶子节点的分配大小
+    std::size_t internal_bytes;  // 内部节点的分配大小
+
+    Node* create_node(bool leaf) {
+        void* mem = ::operator new(leaf ? leaf_bytes : internal_bytes);
+        return new (mem) Node(leaf);
+    }
+
+    // 复制一个被共享的节点: 拷贝键, 对所有子节点加一次引用
+    Node* clone(const Node* node) {
+        Node* copy = create_node(node->leaf);
+        std::uninitialized_copy_n(keys(node), node->n, keys(copy));
+        copy->n = node->n;
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++) {
+                Node* child = children(node)[i];
+                View::retain(child);
+                children(copy)[i] = child;
+            }
+        }
+        return copy;
+    }
+
+    // 引用数为 1 的节点只属于当前路径, 可以原地修改; 否则复制后替换 slot
+    Node* make_mutable(Node*& slot) {
+        Node* node = slot;
+        if (node->refs.load(std::memory_order_acquire) == 1)
+            return node;
+        Node* copy = clone(node);
+        slot = copy;
+        this->release(node);
+        return copy;
+    }
+
+    // parent 已可修改; 返回可修改的 children(parent)[i]
+    Node* mutable_child(Node* parent, int i) {
+        return make_mutable(children(parent)[i]);
+    }
+
+    // ---- 节点操作 (涉及的节点都已可修改) ----
+
+    void insert_key(Node* node, int idx, T key) {
+        T* k = keys(node);
+        if (idx == node->n) {
+            new (k + idx) T(std::move(key));
+        } else {
+            new (k + node->n) T(std::move(k[node->n - 1]));
+            std::move_backward(k + idx, k + node->n - 1, k + node->n);
+            k[idx] = std::move(key);
+        }
+        node->n++;
+    }
+
+    void erase_key(Node* node, int idx) {
+        T* k = keys(node);
+        std::move(k + idx + 1, k + node->n, k + idx);
+        std::destroy_at(k + node->n - 1);
+        node->n--;
+    }
+
+    // 在children[idx]处插入子节点指针 (调用时node->n仍为插入键之前的值)
+    void insert_child(Node* node, int idx, Node* child) {
+        Node** c = children(node);
+        std::memmove(c + idx + 1, c + idx, (node->n + 1 - idx) * sizeof(Node*));
+        c[idx] = child;
+    }
+
+    // 删除children[idx] (调用时node->n仍为删除键之前的值)
+    void erase_child(Node* node, int idx) {
+        Node** c = children(node);
+        std::memmove(c + idx, c + idx + 1, (node->n - idx) * sizeof(Node*));
+    }
+
+    // 分裂已满的 children[index] (已可修改), 子节点指针整体移交给新节点, 引用数不变
+    /*
+    分裂前:  [A B C D E]  (假设t=3，节点已满)
+    分裂后:  [C]
+           /     \
+        [A B]   [D E]
+    */
+    void split_child(Node* parent, int index, Node* child) {
+        Node* new_node = create_node(child->leaf);
+        std::uninitialized_move_n(keys(child) + t, t - 1, keys(new_node));
+        new_node->n = t - 1;
+        if (!child->leaf)
+            std::memcpy(children(new_node), children(child) + t, t * sizeof(Node*));
+
+        insert_child(parent, index + 1, new_node);
+        insert_key(parent, index, std::move(keys(child)[t - 1]));
+        std::destroy_n(keys(child) + t - 1, t);
+        child->n = t - 1;
+    }
+
+    void insert_non_full(Node* node, const T& key) {
+        while (true) {
+            // 插入到相等键之后: 第一个 > key 的位置
+            int i = this->upper_bound_in(node, key);
+            if (node->leaf) {
+                insert_key(node, i, key);
+                return;
+            }
+            Node* child = mutable_child(node, i);
+            if (child->n == 2 * t - 1) {
+                split_child(node, i, child);
+                if (this->comp(keys(node)[i], key))
+                    child = children(node)[i + 1];
+            }
+            node = child;
+        }
+    }
+
+    // 删除 (CLRS 单遍算法); node 已可修改
+    bool remove_internal(Node* node, const T& key) {
+        while (true) {
+            int idx = this->lower_bound_in(node, key);
+            bool here = idx < node->n && !this->comp(key, keys(node)[idx]);
+            if (node->leaf) {
+                if (here)
+                    erase_key(node, idx);
+                return here;
+            }
+            if (here) {
+                remove_from_non_leaf(node, idx);
+                return true;
+            }
+            if (children(node)[idx]->n < t)
+                idx = fill(node, idx);
+            node = mutable_child(node, idx);
+        }
+    }
+
+    void remove_from_non_leaf(Node* node, int idx) {
+        Node** c = children(node);
+        if (c[idx]->n >= t) {
+            // 用前驱替换, 再从左子树中删除前驱
+            const Node* leaf = c[idx];
+            while (!leaf->leaf)
+                leaf = children(leaf)[leaf->n];
+            T pred = keys(leaf)[leaf->n - 1];
+            keys(node)[idx] = pred;
+            remove_internal(mutable_child(node, idx), pred);
+        } else if (c[idx + 1]->n >= t) {
+            const Node* leaf = c[idx + 1];
+            while (!leaf->leaf)
+                leaf = children(leaf)[0];
+            T succ = keys(leaf)[0];
+            keys(node)[idx] = succ;
+            remove_internal(mutable_child(node, idx + 1), succ);
+        } else {
+            T key = keys(node)[idx];
+            merge(node, idx);
+            remove_internal(children(node)[idx], key);
+        }
+    }
+
+    // 补足只有 t-1 个键的 children[idx], 返回之后应当进入的子节点下标
+    int fill(Node* node, int idx) {
+        Node** c = children(node);
+        if (idx != 0 && c[idx - 1]->n >= t) {
+            borrow_from_prev(node, idx);
+        } else if (idx != node->n && c[idx + 1]->n >= t) {
+            borrow_from_next(node, idx);
+        } else if (idx != node->n) {
+            merge(node, idx);
+        } else {
+            merge(node, idx - 1);
+            idx--;
+        }
+        return idx;
+    }
+
+    void borrow_from_prev(Node* node, int idx) {
+        Node* child = mutable_child(node, idx);
+        Node* sibling = mutable_child(node, idx - 1);
+
+        if (!child->leaf)
+            insert_child(child, 0, children(sibling)[sibling->n]);
+        insert_key(child, 0, std::move(keys(node)[idx - 1]));
+        keys(node)[idx - 1] = std::move(keys(sibling)[sibling->n - 1]);
+        std::destroy_at(keys(sibling) + sibling->n - 1);
+        sibling->n--;
+    }
+
+    void borrow_from_next(Node* node, int idx) {
+        Node* child = mutable_child(node, idx);
+        Node* sibling = mutable_child(node, idx + 1);
+
+        if (!child->leaf)
+            children(child)[child->n + 1] = children(sibling)[0];
+        insert_key(child, child->n, std::move(keys(node)[idx]));
+        keys(node)[idx] = std::move(keys(sibling)[0]);
+        if (!sibling->leaf)
+            erase_child(sibling, 0);
+        erase_key(sibling, 0);
+    }
+
+    // 把 keys[idx] 与 children[idx+1] 合并进 children[idx]
+    // 右兄弟被快照共享时不必先复制它: 直接拷贝它的键并对它的子节点加引用, 然后放弃对它的引用
+    void merge(Node* node, int idx) {
+        Node* child = mutable_child(node, idx);
+        Node* sibling = children(node)[idx + 1];
+        bool shared = sibling->refs.load(std::memory_order_acquire) != 1;
+
+        new (keys(child) + child->n) T(std::move(keys(node)[idx]));
+        if (shared) {
+            std::uninitialized_copy_n(keys(sibling), sibling->n, keys(child) + child->n + 1);
+        } else {
+            std::uninitialized_move_n(keys(sibling), sibling->n, keys(child) + child->n + 1);
+        }
+        if (!child->leaf) {
+            for (int i = 0; i <= sibling->n; i++) {
+                Node* grandchild = children(sibling)[i];
+                if (shared)
+                    View::retain(grandchild);
+                children(child)[child->n + 1 + i] = grandchild;
+            }
+        }
+        child->n += sibling->n + 1;
+
+        erase_child(node, idx + 1);
+        erase_key(node, idx);
+
+        if (shared) {
+            this->release(sibling);
+        } else {
+            // 键已移走, 子节点已移交: 只回收节点本身
+            std::destroy_n(keys(sibling), sibling->n);
+            sibling->~Node();
+            ::operator delete(sibling);
+        }
+    }
+
+public:
+    explicit CowBTree(int min_degree, Compare compare = Compare())
+        : View(nullptr, min_degree, 0, std::move(compare)) {
+        if (min_degree < 2) {
+            throw std::invalid_argument("Minimum degree must be at least 2");
+        }
+        leaf_bytes = Node::keys_offset() + (2 * this->t - 1) * sizeof(T);
+        internal_bytes = this->children_offset + 2 * this->t * sizeof(Node*);
+    }
+
+    CowBTree(const CowBTree&) = delete;
+    CowBTree& operator=(const CowBTree&) = delete;
+
+    ~CowBTree() {
+        if (this->root)
+            this->release(this->root);
+    }
+
+    // 当前内容的只读快照, O(1)
+    Snapshot snapshot() const {
+        return Snapshot(this->root, this->t, this->count, this->comp);
+    }
+
+    void insert(const T& key) {
+        if (!this->root)
+            this->root = create_node(true);
+        Node* root = make_mutable(this->root);
+        if (root->n == 2 * t - 1) {
+            Node* new_root = create_node(false);
+            children(new_root)[0] = root;
+            this->root = new_root;
+            split_child(new_root, 0, root);
+            root = new_root;
+        }
+        insert_non_full(root, key);
+        this->count++;
+    }
+
+    // 删除一个等于 key 的键, 返回是否存在
+    bool remove(const T& key) {
+        if (!this->root)
+            return false;
+        Node* root = make_mutable(this->root);
+        bool removed = remove_internal(root, key);
+        if (removed)
+            this->count--;
+
+        // 根节点为空时收缩树高; 新根的引用由旧根移交
+        if (root->n == 0 && !root->leaf) {
+            this->root = children(root)[0];
+            root->~Node();
+            ::operator delete(root);
+        }
+        return removed;
+    }
+};
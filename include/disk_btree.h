@@ -0,0 +1,763 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "btree_search.h"
+#include "buffer_pool.h"
+#include "wal.h"
+
+// 磁盘上的B树: 每个节点占一个固定大小的页, 子节点用页号表示
+//
+// 文件布局:
+//   页 0:  元数据 (魔数、页大小、键大小、最小度数、根页号、键数、空闲页链表头)
+//   页 1+: 节点页或空闲页
+//
+// 节点页格式 (K 按原始字节存放, 因此要求可平凡复制):
+/*
+  +--------+------+----------+----------------------+------------------------+
+  | n (2B) | leaf | reserved | keys[2t-1] (K)       | children[2t] (uint32)  |
+  +--------+------+----------+----------------------+------------------------+
+  0        2      3          8                      children_offset (仅内部节点使用)
+*/
+// 最小度数 t 默认取一页能放下的最大值 (4K页、8字节键时 t = 170)。
+// 空闲页 (合并/根收缩释放的页) 串成链表, 下一页号存放在 reserved 之后的 4 字节中, 分配时优先复用。
+//
+// 插入/删除沿用 BTree 的单遍自顶向下算法 (预先分裂/预先补足, 借键/合并), 同一时刻只钉住
+// 当前节点、子节点和兄弟节点等几个页, 因此缓存池只需要很少的帧。
+// 修改只写入缓存池, flush() 或析构时才写回文件; 默认没有日志, 崩溃时未 flush 的修改可能丢失且文件可能不一致。
+//
+// 开启预写日志 (Options::wal) 后:
+//   - 每个 insert/remove 在内存中完成后追加一条逻辑日志 (操作类型 + 键), 按 sync_mode 刷盘
+//   - 缓存池工作在 no-steal 模式, 数据文件只在检查点时改变
+//   - 检查点: 把所有脏页和元数据页的映像写入日志并刷盘, 再写回数据文件, 最后清空日志;
+//     脏页快占满缓存池或日志超过 checkpoint_bytes 时自动进行, flush() 也会做一次
+//   - 打开时恢复: 重放最后一个完整检查点的页映像, 再重放它之后的逻辑日志
+/*
+  日志:  [insert][remove]...[page image]...[page image][checkpoint end][insert]...
+                             \______ 写回数据文件前的页映像 ______/      \_ 检查点之后的修改 _/
+*/
+// 所有公开方法由一把互斥锁串行化; PerOp 模式下在锁外等待日志刷盘, 并发写入者可以共用一次 fdatasync。
+// for_each 的回调在锁内执行, 不能再调用同一棵树的方法。
+template <typename K, typename Compare = std::less<K>>
+class DiskBTree {
+    static_assert(std::is_trivially_copyable_v<K>, "DiskBTree keys are stored as raw bytes");
+    static_assert(alignof(K) <= 8, "over-aligned key types are not supported");
+
+public:
+    using PageId = Pager::PageId;
+    using PageRef = BufferPool::PageRef;
+
+    struct Options {
+        std::size_t page_size = 4096;   // 页大小, [512, 64K] 内的2的幂
+        std::size_t pool_pages = 1024;  // 缓存池页数, 至少 kMinPoolPages; 开启日志时至少 2 * 树高 + 13
+        int min_degree = 0;             // 0: 一页能放下的最大值; 打开已有文件时必须与文件一致或为 0
+        bool wal = false;               // 预写日志, 日志文件为 path + "-wal"
+        SyncMode sync_mode = SyncMode::PerOp;
+        std::chrono::milliseconds sync_interval{10};   // Async 模式的刷盘间隔
+        std::size_t checkpoint_bytes = 64 << 20;       // 日志超过该大小时做检查点
+    };
+
+    static constexpr std::size_t kMinPoolPages = 8;
+
+private:
+    static constexpr uint64_t kMagic = 0x3147505245455442ull;   // "BTREEPG1"
+    static constexpr std::size_t kHeaderBytes = 8;
+    static constexpr PageId kMetaPage = 0;
+    static constexpr PageId kNoPage = 0;   // 页 0 是元数据页, 不会是节点
+
+    struct Meta {
+        uint64_t magic;
+        uint32_t page_size;
+        uint32_t key_size;
+        uint32_t min_degree;
+        PageId root;
+        uint64_t count;
+        PageId free_head;      // 空闲页链表
+        PageId page_count;     // 文件中的页数
+    };
+
+    struct PageHeader {
+        uint16_t n;
+        uint8_t leaf;
+        uint8_t reserved;
+        PageId next_free;      // 仅空闲页使用
+    };
+    static_assert(sizeof(PageHeader) == kHeaderBytes, "page header layout");
+
+    using RecordType = WriteAheadLog::RecordType;
+
+    Pager pager;
+    mutable BufferPool pool;
+    Meta meta;
+    int t;
+    std::size_t children_offset;
+    Compare comp;
+    int height = 1;                         // 树高 (只有根叶子时为 1), 用于估计一次操作最多弄脏的页数
+    std::unique_ptr<WriteAheadLog> wal;     // 未开启日志时为空
+    std::size_t checkpoint_bytes;
+    uint64_t checkpoints = 0;
+    mutable std::mutex mutex;
+
+    static std::size_t children_offset_for(std::size_t t) {
+        std::size_t end = kHeaderBytes + (2 * t - 1) * sizeof(K);
+        return (end + alignof(PageId) - 1) / alignof(PageId) * alignof(PageId);
+    }
+
+    static std::size_t node_bytes(std::size_t t) {
+        return children_offset_for(t) + 2 * t * sizeof(PageId);
+    }
+
+    static int max_degree_for(std::size_t page_size) {
+        std::size_t t = 2;
+        while (node_bytes(t + 1) <= page_size)
+            t++;
+        return static_cast<int>(t);
+    }
+
+    // ---- 页内访问 ----
+
+    static PageHeader* header(const PageRef& page) { return reinterpret_cast<PageHeader*>(page.data()); }
+    static int size_of(const PageRef& page) { return header(page)->n; }
+    static bool is_leaf(const PageRef& page) { return header(page)->leaf != 0; }
+    static void set_size(const PageRef& page, int n) { header(page)->n = static_cast<uint16_t>(n); }
+    static K* keys(const PageRef& page) { return reinterpret_cast<K*>(page.data() + kHeaderBytes); }
+    PageId* children(const PageRef& page) const {
+        return reinterpret_cast<PageId*>(page.data() + children_offset);
+    }
+
+    int lower_bound_in(const PageRef& page, const K& key) const {
+        return btree_search::node_lower_bound(keys(page), size_of(page), key, comp);
+    }
+    int upper_bound_in(const PageRef& page, const K& key) const {
+        return btree_search::node_upper_bound(keys(page), size_of(page), key, comp);
+    }
+
+    bool is_full(const PageRef& page) const { return size_of(page) == 2 * t - 1; }
+
+    // ---- 页分配 ----
+
+    PageRef new_node(bool leaf) {
+        PageRef page;
+        if (meta.free_head != kNoPage) {
+            page = pool.fetch(meta.free_head);
+            meta.free_head = header(page)->next_free;
+            std::memset(page.data(), 0, pager.page_size());
+        } else {
+            page = pool.create(pager.allocate());
+        }
+        header(page)->leaf = leaf ? 1 : 0;
+        page.mark_dirty();
+        return page;
+    }
+
+    // 把页放回空闲链表 (调用者不能再持有它)
+    void free_node(PageId id) {
+        PageRef page = pool.fetch(id);
+        set_size(page, 0);
+        header(page)->next_free = meta.free_head;
+        meta.free_head = id;
+        page.mark_dirty();
+    }
+
+    // ---- 节点操作 (与 BTreeBase 相同, 子节点为页号) ----
+
+    static void insert_key(const PageRef& page, int idx, const K& key) {
+        K* k = keys(page);
+        std::memmove(k + idx + 1, k + idx, (size_of(page) - idx) * sizeof(K));
+        k[idx] = key;
+        set_size(page, size_of(page) + 1);
+    }
+
+    static void erase_key(const PageRef& page, int idx) {
+        K* k = keys(page);
+        std::memmove(k + idx, k + idx + 1, (size_of(page) - idx - 1) * sizeof(K));
+        set_size(page, size_of(page) - 1);
+    }
+
+    // 在children[idx]处插入子节点页号 (调用时n仍为插入键之前的值)
+    void insert_child(const PageRef& page, int idx, PageId child) const {
+        PageId* c = children(page);
+        std::memmove(c + idx + 1, c + idx, (size_of(page) + 1 - idx) * sizeof(PageId));
+        c[idx] = child;
+    }
+
+    // 删除children[idx] (调用时n仍为删除键之前的值)
+    void erase_child(const PageRef& page, int idx) const {
+        PageId* c = children(page);
+        std::memmove(c + idx, c + idx + 1, (size_of(page) - idx) * sizeof(PageId));
+    }
+
+    // 分裂已满的 children[index]
+    /*
+    分裂前:  [A B C D E]  (假设t=3，节点已满)
+    分裂后:  [C]
+           /     \
+        [A B]   [D E]
+    */
+    void split_child(const PageRef& parent, int index, const PageRef& child) {
+        PageRef right = new_node(is_leaf(child));
+        std::memcpy(keys(right), keys(child) + t, (t - 1) * sizeof(K));
+        if (!is_leaf(child))
+            std::memcpy(children(right), children(child) + t, t * sizeof(PageId));
+        set_size(right, t - 1);
+
+        insert_child(parent, index + 1, right.id());
+        insert_key(parent, index, keys(child)[t - 1]);
+        set_size(child, t - 1);
+
+        parent.mark_dirty();
+        child.mark_dirty();
+        right.mark_dirty();
+    }
+
+    void borrow_from_prev(const PageRef& parent, int idx, const PageRef& child, const PageRef& sibling) {
+        int sn = size_of(sibling);
+        if (!is_leaf(child))
+            insert_child(child, 0, children(sibling)[sn]);
+        insert_key(child, 0, keys(parent)[idx - 1]);
+        keys(parent)[idx - 1] = keys(sibling)[sn - 1];
+        set_size(sibling, sn - 1);
+        parent.mark_dirty();
+        child.mark_dirty();
+        sibling.mark_dirty();
+    }
+
+    void borrow_from_next(const PageRef& parent, int idx, const PageRef& child, const PageRef& sibling) {
+        if (!is_leaf(child))
+            children(child)[size_of(child) + 1] = children(sibling)[0];
+        insert_key(child, size_of(child), keys(parent)[idx]);
+        keys(parent)[idx] = keys(sibling)[0];
+        if (!is_leaf(sibling))
+            erase_child(sibling, 0);
+        erase_key(sibling, 0);
+        parent.mark_dirty();
+        child.mark_dirty();
+        sibling.mark_dirty();
+    }
+
+    // 把 keys[idx] 与 children[idx+1] (right) 合并进 children[idx] (left), 释放 right 的页
+    void merge(const PageRef& parent, int idx, const PageRef& left, PageRef& right) {
+        int ln = size_of(left), rn = size_of(right);
+        keys(left)[ln] = keys(parent)[idx];
+        std::memcpy(keys(left) + ln + 1, keys(right), rn * sizeof(K));
+        if (!is_leaf(left))
+            std::memcpy(children(left) + ln + 1, children(right), (rn + 1) * sizeof(PageId));
+        set_size(left, ln + rn + 1);
+
+        erase_child(parent, idx + 1);
+        erase_key(parent, idx);
+        parent.mark_dirty();
+        left.mark_dirty();
+
+        PageId freed = right.id();
+        right.reset();
+        free_node(freed);
+    }
+
+    // 补足只有 t-1 个键的 children[idx] (child); 返回之后应当进入的子节点
+    PageRef fill(const PageRef& parent, int idx, PageRef child) {
+        int pn = size_of(parent);
+        PageRef left, right;
+        if (idx > 0) {
+            left = pool.fetch(children(parent)[idx - 1]);
+            if (size_of(left) >= t) {
+                borrow_from_prev(parent, idx, child, left);
+                return child;
+            }
+        }
+        if (idx < pn) {
+            right = pool.fetch(children(parent)[idx + 1]);
+            if (size_of(right) >= t) {
+                borrow_from_next(parent, idx, child, right);
+                return child;
+            }
+            merge(parent, idx, child, right);
+            return child;
+        }
+        merge(parent, idx - 1, left, child);
+        return left;
+    }
+
+    std::vector<char> meta_page() {
+        meta.page_count = pager.page_count();
+        std::vector<char> buf(pager.page_size(), 0);
+        std::memcpy(buf.data(), &meta, sizeof(meta));
+        return buf;
+    }
+
+    void write_meta() {
+        pager.write(kMetaPage, meta_page().data());
+    }
+
+    void flush_locked() {
+        if (wal) {
+            checkpoint_locked();
+            return;
+        }
+        pool.flush_all();
+        write_meta();
+        pager.sync();
+    }
+
+    // ---- 预写日志 ----
+
+    uint64_t log_op(RecordType type, const K& key) {
+        return wal ? wal->append(type, &key, sizeof(K)) : 0;
+    }
+
+    // PerOp 模式下等待该操作的日志刷盘 (在树的锁外调用)
+    void wait_durable(uint64_t lsn) {
+        if (lsn != 0 && wal->sync_mode() == SyncMode::PerOp)
+            wal->wait_durable(lsn);
+    }
+
+    // 把脏页和元数据页的映像写入日志, 以检查点结束记录收尾
+    void log_checkpoint() {
+        pool.for_each_dirty([&](PageId id, const char* data) {
+            wal->append(RecordType::PageImage, &id, sizeof(id), data, pager.page_size());
+        });
+        std::vector<char> buf = meta_page();
+        PageId meta_id = kMetaPage;
+        wal->append(RecordType::PageImage, &meta_id, sizeof(meta_id), buf.data(), buf.size());
+        wal->append(RecordType::CheckpointEnd, nullptr, 0);
+    }
+
+    // 检查点的页映像已持久化后, 写回数据文件
+    void apply_checkpoint() {
+        pool.flush_all();
+        write_meta();
+        pager.sync();
+    }
+
+    void checkpoint_locked() {
+        checkpoints++;
+        log_checkpoint();
+        wal->sync();
+        apply_checkpoint();
+        wal->reset();
+    }
+
+    // 高度为 h 的树上一次插入/删除最多需要的空闲帧: 根以下每层最多新弄脏子节点和兄弟节点 2 页,
+    // 加上根 (或根分裂时新的根) 共 2h+1 页, 另外同时最多钉住 4 个干净页
+    static std::size_t op_reserve(int h) { return 2 * static_cast<std::size_t>(h) + 5; }
+
+    // no-steal 模式下脏页不能被替换: 剩余的干净帧可能不够一次操作使用时先做检查点
+    bool needs_checkpoint() const {
+        std::size_t dirty = pool.dirty_count();
+        if (dirty > 0 && dirty + op_reserve(height) > pool.capacity())
+            return true;
+        return wal->size_bytes() > checkpoint_bytes;
+    }
+
+    // 开启日志时缓存池除了一次操作的预留, 至少还要能存放 kMinDirtyPages 个脏页, 否则几乎每个操作都要做检查点
+    static constexpr std::size_t kMinDirtyPages = 8;
+    static std::size_t min_wal_pool(int h) { return op_reserve(h) + kMinDirtyPages; }
+
+    void check_pool_for_wal() const {
+        if (pool.capacity() < min_wal_pool(height)) {
+            throw std::invalid_argument("buffer pool too small for the tree height with a write-ahead log: need " +
+                                        std::to_string(min_wal_pool(height)) + " pages");
+        }
+    }
+
+    void maybe_checkpoint() {
+        if (wal && needs_checkpoint())
+            checkpoint_locked();
+    }
+
+    // 把最后一个完整检查点的页映像写回数据文件, 返回需要重放的第一条记录的下标
+    std::size_t restore_checkpoint(const std::vector<WriteAheadLog::Record>& records) {
+        std::size_t end = records.size();
+        while (end > 0 && records[end - 1].type != RecordType::CheckpointEnd)
+            end--;
+        if (end == 0)
+            return 0;
+        for (std::size_t i = 0; i + 1 < end; i++) {
+            const auto& rec = records[i];
+            if (rec.type != RecordType::PageImage)
+                continue;
+            if (rec.payload.size() != sizeof(PageId) + pager.page_size()) {
+                throw std::runtime_error("write-ahead log has a page image of the wrong size");
+            }
+            PageId id;
+            std::memcpy(&id, rec.payload.data(), sizeof(id));
+            pager.write(id, rec.payload.data() + sizeof(id));
+        }
+        pager.sync();
+        return end;
+    }
+
+    // 重放检查点之后的逻辑日志; 中途需要检查点时把尚未重放的记录重新写到检查点之后
+    void replay(const std::vector<WriteAheadLog::Record>& records, std::size_t from) {
+        for (std::size_t i = from; i < records.size(); i++) {
+            const auto& rec = records[i];
+            if (rec.type != RecordType::Insert && rec.type != RecordType::Remove)
+                continue;   // 未完成的检查点留下的页映像
+            if (rec.payload.size() != sizeof(K)) {
+                throw std::runtime_error("write-ahead log was written for a different key size");
+            }
+            if (needs_checkpoint()) {
+                log_checkpoint();
+                for (std::size_t j = i; j < records.size(); j++) {
+                    if (records[j].type == RecordType::Insert || records[j].type == RecordType::Remove)
+                        wal->append(records[j].type, records[j].payload.data(), records[j].payload.size());
+                }
+                wal->sync();
+                apply_checkpoint();
+            }
+            K key;
+            std::memcpy(&key, rec.payload.data(), sizeof(K));
+            if (rec.type == RecordType::Insert)
+                insert_locked(key);
+            else
+                remove_locked(key);
+        }
+    }
+
+    int compute_height() const {
+        int h = 1;
+        PageRef page = pool.fetch(meta.root);
+        while (!is_leaf(page)) {
+            page = pool.fetch(children(page)[0]);
+            h++;
+        }
+        return h;
+    }
+
+    // ---- 插入/删除 (调用者持有锁) ----
+
+    void insert_locked(const K& key) {
+        PageRef node = pool.fetch(meta.root);
+        if (is_full(node)) {
+            PageRef new_root = new_node(false);
+            children(new_root)[0] = meta.root;
+            split_child(new_root, 0, node);
+            meta.root = new_root.id();
+            node = std::move(new_root);
+            height++;
+        }
+        while (true) {
+            int i = upper_bound_in(node, key);
+            if (is_leaf(node)) {
+                insert_key(node, i, key);
+                node.mark_dirty();
+                break;
+            }
+            PageRef child = pool.fetch(children(node)[i]);
+            if (is_full(child)) {
+                split_child(node, i, child);
+                if (comp(keys(node)[i], key))
+                    child = pool.fetch(children(node)[i + 1]);
+            }
+            node = std::move(child);
+        }
+        meta.count++;
+    }
+
+    bool remove_locked(const K& target) {
+        K key = target;
+        bool removed = false;
+        PageRef node = pool.fetch(meta.root);
+        while (true) {
+            int idx = lower_bound_in(node, key);
+            bool here = idx < size_of(node) && !comp(key, keys(node)[idx]);
+            if (is_leaf(node)) {
+                if (here) {
+                    erase_key(node, idx);
+                    node.mark_dirty();
+                    removed = true;
+                }
+                break;
+            }
+            if (here) {
+                removed = true;
+                PageRef left = pool.fetch(children(node)[idx]);
+                if (size_of(left) >= t) {
+                    // 用前驱替换, 再到左子树中删除前驱
+                    PageRef leaf = pool.fetch(left.id());
+                    while (!is_leaf(leaf))
+                        leaf = pool.fetch(children(leaf)[size_of(leaf)]);
+                    key = keys(leaf)[size_of(leaf) - 1];
+                    keys(node)[idx] = key;
+                    node.mark_dirty();
+                    node = std::move(left);
+                    continue;
+                }
+                PageRef right = pool.fetch(children(node)[idx + 1]);
+                if (size_of(right) >= t) {
+                    PageRef leaf = pool.fetch(right.id());
+                    while (!is_leaf(leaf))
+                        leaf = pool.fetch(children(leaf)[0]);
+                    key = keys(leaf)[0];
+                    keys(node)[idx] = key;
+                    node.mark_dirty();
+                    node = std::move(right);
+                    continue;
+                }
+                // 两侧都只有 t-1 个键: 合并后键下沉到 left 中
+                merge(node, idx, left, right);
+                node = std::move(left);
+                continue;
+            }
+            PageRef child = pool.fetch(children(node)[idx]);
+            if (size_of(child) < t)
+                child = fill(node, idx, std::move(child));
+            node = std::move(child);
+        }
+        node.reset();
+
+        if (removed)
+            meta.count--;
+
+        // 根节点为空时收缩树高
+        PageRef root = pool.fetch(meta.root);
+        if (size_of(root) == 0 && !is_leaf(root)) {
+            PageId old_root = meta.root;
+            meta.root = children(root)[0];
+            root.reset();
+            free_node(old_root);
+            height--;
+        }
+        return removed;
+    }
+
+    struct NodeCopy {
+        std::vector<K> keys;
+        std::vector<PageId> children;
+    };
+
+    // 递归遍历时先复制节点内容再解除钉住, 树高不受缓存池大小限制
+    NodeCopy copy_node(PageId id) const {
+        PageRef page = pool.fetch(id);
+        NodeCopy copy;
+        copy.keys.assign(keys(page), keys(page) + size_of(page));
+        if (!is_leaf(page))
+            copy.children.assign(children(page), children(page) + size_of(page) + 1);
+        return copy;
+    }
+
+    template <typename F>
+    void for_each_in(PageId id, F& fn) const {
+        NodeCopy node = copy_node(id);
+        for (std::size_t i = 0; i < node.keys.size(); i++) {
+            if (!node.children.empty())
+                for_each_in(node.children[i], fn);
+            fn(node.keys[i]);
+        }
+        if (!node.children.empty())
+            for_each_in(node.children.back(), fn);
+    }
+
+    bool check_node(PageId id, const K* lo, const K* hi, int depth, int& leaf_depth, std::size_t& keys_seen) const {
+        NodeCopy node = copy_node(id);
+        int n = static_cast<int>(node.keys.size());
+        if (id != meta.root && (n < t - 1 || n > 2 * t - 1))
+            return false;
+        for (int i = 0; i < n; i++) {
+            const K& k = node.keys[i];
+            if ((i > 0 && comp(k, node.keys[i - 1])) || (lo && comp(k, *lo)) || (hi && comp(*hi, k)))
+                return false;
+        }
+        keys_seen += n;
+        if (node.children.empty()) {
+            if (leaf_depth < 0)
+                leaf_depth = depth;
+            return leaf_depth == depth;
+        }
+        for (int i = 0; i <= n; i++) {
+            const K* clo = i > 0 ? &node.keys[i - 1] : lo;
+            const K* chi = i < n ? &node.keys[i] : hi;
+            if (!check_node(node.children[i], clo, chi, depth + 1, leaf_depth, keys_seen))
+                return false;
+        }
+        return true;
+    }
+
+public:
+    // 打开(不存在时创建)索引文件; 开启日志时先根据日志恢复
+    // 文件的页大小/键大小与参数不一致时抛出 std::runtime_error
+    explicit DiskBTree(const std::string& path, Options options = Options(), Compare compare = Compare())
+        : pager(path, options.page_size), pool(pager, std::max(options.pool_pages, kMinPoolPages)),
+          comp(std::move(compare)), checkpoint_bytes(options.checkpoint_bytes) {
+        if (options.pool_pages < kMinPoolPages) {
+            throw std::invalid_argument("buffer pool must hold at least 8 pages");
+        }
+        int max_degree = max_degree_for(options.page_size);
+        if (options.min_degree != 0 && (options.min_degree < 2 || options.min_degree > max_degree)) {
+            throw std::invalid_argument("minimum degree does not fit the page size");
+        }
+
+        std::vector<WriteAheadLog::Record> records;
+        std::size_t replay_from = 0;
+        if (options.wal) {
+            pool.set_no_steal(true);
+            wal = std::make_unique<WriteAheadLog>(path + "-wal", options.sync_mode, options.sync_interval);
+            records = wal->read_all();
+            replay_from = restore_checkpoint(records);
+        }
+
+        if (pager.page_count() == 0) {
+            t = options.min_degree != 0 ? options.min_degree : max_degree;
+            meta = Meta{kMagic, static_cast<uint32_t>(options.page_size), static_cast<uint32_t>(sizeof(K)),
+                        static_cast<uint32_t>(t), kNoPage, 0, kNoPage, 0};
+            pager.allocate();   // 页 0
+            children_offset = children_offset_for(t);
+            meta.root = new_node(true).id();
+            if (!wal)
+                flush_locked();
+        } else {
+            std::vector<char> buf(pager.page_size());
+            pager.read(kMetaPage, buf.data());
+            std::memcpy(&meta, buf.data(), sizeof(meta));
+            if (meta.magic != kMagic) {
+                throw std::runtime_error("not a DiskBTree file");
+            }
+            if (meta.page_size != options.page_size || meta.key_size != sizeof(K)) {
+                throw std::runtime_error("DiskBTree file has a different page or key size");
+            }
+            if (options.min_degree != 0 && static_cast<uint32_t>(options.min_degree) != meta.min_degree) {
+                throw std::runtime_error("DiskBTree file has a different minimum degree");
+            }
+            t = static_cast<int>(meta.min_degree);
+            children_offset = children_offset_for(t);
+            height = compute_height();
+        }
+
+        if (wal) {
+            check_pool_for_wal();
+            replay(records, replay_from);
+            checkpoint_locked();
+        }
+    }
+
+    DiskBTree(const DiskBTree&) = delete;
+    DiskBTree& operator=(const DiskBTree&) = delete;
+
+    ~DiskBTree() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    // 把所有修改写回文件并刷盘 (开启日志时做一次检查点)
+    void flush() {
+        std::lock_guard<std::mutex> guard(mutex);
+        flush_locked();
+    }
+
+    // 使之前的所有修改持久化: 开启日志时刷日志 (PerBatch 模式的提交点), 否则同 flush()
+    void commit() {
+        if (wal) {
+            wal->sync();
+            return;
+        }
+        flush();
+    }
+
+    std::optional<K> search(const K& key) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        PageRef page = pool.fetch(meta.root);
+        while (true) {
+            int i = lower_bound_in(page, key);
+            if (i < size_of(page) && !comp(key, keys(page)[i]))
+                return keys(page)[i];
+            if (is_leaf(page))
+                return std::nullopt;
+            page = pool.fetch(children(page)[i]);
+        }
+    }
+
+    bool contains(const K& key) const {
+        return search(key).has_value();
+    }
+
+    // 插入 (允许重复键, 插入到相等键之后)
+    void insert(const K& key) {
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            // 与打开时的要求相同: 这次插入会让树长高 (根节点已满), 长高之后缓存池就不够了时拒绝插入,
+            // 而不是之后每个操作都做检查点
+            if (wal && pool.capacity() < min_wal_pool(height + 1) && is_full(pool.fetch(meta.root))) {
+                throw std::runtime_error("buffer pool too small for a taller tree with a write-ahead log");
+            }
+            maybe_checkpoint();
+            insert_locked(key);
+            lsn = log_op(RecordType::Insert, key);
+        }
+        wait_durable(lsn);
+    }
+
+    // 删除一个等于 key 的键, 返回是否存在
+    bool remove(const K& key) {
+        uint64_t lsn = 0;
+        bool removed;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            maybe_checkpoint();
+            removed = remove_locked(key);
+            if (removed)
+                lsn = log_op(RecordType::Remove, key);
+        }
+        wait_durable(lsn);
+        return removed;
+    }
+
+    // 按顺序访问所有键
+    template <typename F>
+    void for_each(F&& fn) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        for_each_in(meta.root, fn);
+    }
+
+    // 检查B树性质: 节点键数、键有序、所有叶子同一深度、键总数
+    bool check_invariants() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        int leaf_depth = -1;
+        std::size_t keys_seen = 0;
+        return check_node(meta.root, nullptr, nullptr, 0, leaf_depth, keys_seen) && keys_seen == meta.count;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return meta.count;
+    }
+    bool empty() const { return size() == 0; }
+    int get_min_degree() const { return t; }
+    std::size_t page_count() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return pager.page_count();
+    }
+
+    // 缓存池统计 (命中/未命中/替换/写回)
+    const BufferPool::Stats& pool_stats() const { return pool.stats(); }
+    void reset_pool_stats() { pool.reset_stats(); }
+
+    // 日志刷盘 (fdatasync) 次数, 未开启日志时为 0
+    uint64_t log_sync_count() const { return wal ? wal->sync_count() : 0; }
+
+    // 检查点次数 (包括打开时和 flush() 做的), 未开启日志时为 0
+    uint64_t checkpoint_count() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return checkpoints;
+    }
+
+    // 清空缓存池并请求内核丢弃文件缓存, 之后的访问从磁盘读取 (用于冷缓存测试)
+    void drop_caches() {
+        std::lock_guard<std::mutex> guard(mutex);
+        flush_locked();
+        pool.clear();
+        pager.drop_os_cache();
+    }
+};
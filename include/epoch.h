@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// 基于纪元(epoch)的内存回收
+//
+// 无锁读者可能在节点被摘除之后仍持有它的指针, 因此被摘除的节点不能立即释放:
+//   - 读者进入临界区前调用 pin(), 把当前全局纪元登记到自己的记录中, 离开时撤销登记
+//   - 写者摘除节点后调用 retire(), 节点连同当时的全局纪元放入本线程的待回收列表
+//   - 只有所有登记中的线程都已看到当前纪元时, 全局纪元才能前进一步
+//   - 在纪元 e 废弃的对象, 全局纪元到达 e+2 后一定没有读者还能访问, 可以释放
+/*
+  全局纪元:   ... e ............ e+1 ............ e+2
+  retire(x):      ^ 记为 e
+  登记 <= e 的读者:  可能看到 x; 纪元推进到 e+2 之前必须等它们全部离开
+  登记 >= e+1 的读者: 登记发生在 x 被摘除之后, 不可能再找到 x
+*/
+// 读路径只有 pin/unpin 两次写本线程的记录 (不与其他线程共享cache line), 访问节点时没有任何原子读-改-写。
+// 释放是批量的: 每个线程攒够 kRetireBatch 个对象后才尝试推进纪元并释放已过期的部分。
+//
+// 每个 EpochManager 是一个独立的回收域 (例如每棵并发树一个), 析构时释放所有剩余对象,
+// 析构时不能有其他线程在使用它。
+class EpochManager {
+public:
+    using Deleter = void (*)(void*);
+
+private:
+    static constexpr uint64_t kInactive = ~uint64_t(0);
+    static constexpr std::size_t kRetireBatch = 64;
+
+    struct Retired {
+        void* ptr;
+        Deleter deleter;
+        uint64_t epoch;
+    };
+
+    // 每个线程一条记录; 线程退出后记录保留, 之后获得相同 thread::id 的线程会接管它(连同待回收列表)
+    struct alignas(64) Participant {
+        std::atomic<uint64_t> epoch{kInactive};   // 登记的纪元, 未进入临界区时为 kInactive
+        std::thread::id owner;
+        int depth = 0;                             // 嵌套 pin 的层数, 只有所属线程访问
+        std::vector<Retired> limbo;                // 按纪元递增排列, 只有所属线程访问
+        Participant* next = nullptr;
+    };
+
+    alignas(64) std::atomic<uint64_t> global_epoch{0};
+    std::atomic<Participant*> participants{nullptr};
+    const uint64_t id;
+
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    Participant* local() {
+        // 每个线程缓存最近使用的回收域, 同一棵树上的连续操作不用查找
+        thread_local uint64_t cached_id = 0;
+        thread_local Participant* cached = nullptr;
+        if (cached_id == id)
+            return cached;
+
+        std::thread::id self = std::this_thread::get_id();
+        Participant* p = participants.load(std::memory_order_acquire);
+        while (p && p->owner != self)
+            p = p->next;
+        if (!p) {
+            p = new Participant;
+            p->owner = self;
+            p->next = participants.load(std::memory_order_relaxed);
+            while (!participants.compare_exchange_weak(p->next, p, std::memory_order_release,
+                                                       std::memory_order_relaxed)) {
+            }
+        }
+        cached_id = id;
+        cached = p;
+        return p;
+    }
+
+    // 所有登记中的线程都已看到当前纪元时把全局纪元加一
+    void try_advance() {
+        uint64_t e = global_epoch.load(std::memory_order_seq_cst);
+        for (Participant* p = participants.load(std::memory_order_acquire); p; p = p->next) {
+            uint64_t pe = p->epoch.load(std::memory_order_seq_cst);
+            if (pe != kInactive && pe != e)
+                return;
+        }
+        global_epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+    }
+
+    // 释放本线程待回收列表中已经过期的对象
+    static void reclaim(Participant* p, uint64_t e) {
+        std::size_t done = 0;
+        while (done < p->limbo.size() && p->limbo[done].epoch + 2 <= e) {
+            p->limbo[done].deleter(p->limbo[done].ptr);
+            done++;
+        }
+        p->limbo.erase(p->limbo.begin(), p->limbo.begin() + done);
+    }
+
+    void pin(Participant* p) {
+        if (p->depth++ == 0) {
+            // release: 推进纪元的线程读到这次登记时, 本线程之前(上一个临界区)的读取都已完成
+            p->epoch.store(global_epoch.load(std::memory_order_relaxed), std::memory_order_release);
+            // 登记必须在读取任何节点之前对推进纪元的线程可见
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void unpin(Participant* p) {
+        if (--p->depth == 0)
+            p->epoch.store(kInactive, std::memory_order_release);
+    }
+
+public:
+    // 临界区守卫: 存在期间本线程读到的对象不会被释放
+    class Guard {
+    public:
+        Guard(Guard&& other) noexcept : manager(other.manager), p(other.p) { other.manager = nullptr; }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+        ~Guard() {
+            if (manager)
+                manager->unpin(p);
+        }
+
+    private:
+        friend class EpochManager;
+        Guard(EpochManager* manager, Participant* p) : manager(manager), p(p) { manager->pin(p); }
+
+        EpochManager* manager;
+        Participant* p;
+    };
+
+    EpochManager() : id(next_id()) {}
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    ~EpochManager() {
+        Participant* p = participants.load(std::memory_order_relaxed);
+        while (p) {
+            for (const Retired& r : p->limbo)
+                r.deleter(r.ptr);
+            Participant* next = p->next;
+            delete p;
+            p = next;
+        }
+    }
+
+    // 进入临界区; 可以嵌套
+    Guard pin() {
+        return Guard(this, local());
+    }
+
+    // 对象已从共享结构中摘除(其他线程再也无法新找到它), 等所有可能的读者离开后调用 deleter(ptr)
+    void retire(void* ptr, Deleter deleter) {
+        Participant* p = local();
+        // 摘除操作必须先于读取纪元
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        p->limbo.push_back({ptr, deleter, global_epoch.load(std::memory_order_relaxed)});
+        if (p->limbo.size() >= kRetireBatch) {
+            try_advance();
+            reclaim(p, global_epoch.load(std::memory_order_acquire));
+        }
+    }
+
+    // 尝试推进纪元并释放本线程已经过期的对象 (不必等攒够一批)
+    void collect() {
+        Participant* p = local();
+        try_advance();
+        reclaim(p, global_epoch.load(std::memory_order_acquire));
+    }
+
+    // 本线程等待释放的对象数
+    std::size_t pending() {
+        return local()->limbo.size();
+    }
+
+    uint64_t epoch() const {
+        return global_epoch.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,352 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "btree_search.h"
+
+// 冻结格式: 只读、不含指针的静态B+树文件, 由 BTree::freeze() 写出, FrozenBTree 用 mmap 直接使用
+//
+// 每个节点恰好 B 个键 (每层只有最后一个节点可能不满), 子节点位置由下标计算, 不需要存储:
+//   第 l 层节点 i 的第 j 个子节点 = 第 l-1 层节点 i*(B+1)+j
+//   内部节点的第 j 个键 = 第 j 个子树中的最大键, 最后一个子树没有键
+//   叶子层就是全部键的有序数组, 查找结果是数组中的下标, 范围扫描是顺序读
+/*
+  B = 2, 键 1..9:
+                      [6]                    层 2 (根)
+                 /          \
+           [2 4]              [8]            层 1: 子树最大键
+         /   |   \          /    \
+    [1 2] [3 4] [5 6]    [7 8]   [9]         层 0: 叶子 = 有序键数组
+
+  文件: [头部 | 根层 | ... | 层 1 | 叶子层], 每层连续存放并按 64 字节对齐
+*/
+// 头部记录各层的文件偏移和键数; 打开时只做 mmap 和头部校验, 与键数无关。
+// 映射是 MAP_SHARED 只读的, 多个进程打开同一文件时共用内核页缓存。
+// 键按原始字节存放, 因此要求可平凡复制; 文件不跨字节序/键类型使用 (打开时校验键大小)。
+
+namespace btree_detail {
+
+struct FrozenHeader {
+    static constexpr uint64_t kMagic = 0x314E5A4F52465442ull;   // "BTFROZN1"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr int kMaxLevels = 48;   // B = 2 时 2^64 个键也够用
+    static constexpr std::size_t kAlign = 64;
+
+    struct Level {
+        uint64_t offset;   // 该层第一个键在文件中的偏移
+        uint64_t keys;     // 该层的键数
+    };
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t key_size;
+    uint64_t count;        // 键总数 (= 叶子层键数)
+    uint32_t node_keys;    // 每个节点的键数 B
+    uint32_t levels;       // 层数, 叶子层为第 0 层; 空树为 0
+    Level level[kMaxLevels];
+
+    // 由键数和 B 推出各层的键数 (写入和打开时共用)
+    static uint32_t shape(uint64_t count, uint64_t b, uint64_t* keys_per_level) {
+        if (count == 0)
+            return 0;
+        uint64_t nodes = (count + b - 1) / b;
+        keys_per_level[0] = count;
+        uint32_t levels = 1;
+        while (nodes > 1) {
+            uint64_t parents = (nodes + b) / (b + 1);
+            // 每个父节点的键数 = 子节点数 - 1
+            keys_per_level[levels++] = nodes - parents;
+            nodes = parents;
+        }
+        return levels;
+    }
+
+    static uint64_t align_up(uint64_t offset) {
+        return (offset + kAlign - 1) / kAlign * kAlign;
+    }
+};
+
+// 写文件: 先写临时文件并 fsync, 再 rename 覆盖目标, 已经打开旧文件的 FrozenBTree 不受影响
+template <typename T, typename Compare>
+struct FrozenWriter {
+    static_assert(std::is_trivially_copyable_v<T>, "frozen keys are stored as raw bytes");
+
+    // [first, last) 为 count 个有序键; node_keys 为 0 时一个节点占 64 字节
+    template <typename It>
+    static void write(const std::string& path, It first, It last, std::size_t count, int node_keys) {
+        uint64_t b = node_keys > 0 ? static_cast<uint64_t>(node_keys) : std::max<uint64_t>(2, 64 / sizeof(T));
+        if (b < 2) {
+            throw std::invalid_argument("frozen nodes need at least two keys");
+        }
+
+        FrozenHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = FrozenHeader::kMagic;
+        header.version = FrozenHeader::kVersion;
+        header.key_size = static_cast<uint32_t>(sizeof(T));
+        header.count = count;
+        header.node_keys = static_cast<uint32_t>(b);
+        uint64_t keys_per_level[FrozenHeader::kMaxLevels];
+        header.levels = FrozenHeader::shape(count, b, keys_per_level);
+        // 根层在前, 叶子层在最后
+        uint64_t offset = FrozenHeader::align_up(sizeof(FrozenHeader));
+        for (uint32_t l = header.levels; l-- > 0;) {
+            header.level[l] = FrozenHeader::Level{offset, keys_per_level[l]};
+            offset = FrozenHeader::align_up(offset + keys_per_level[l] * sizeof(T));
+        }
+
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + tmp);
+        }
+        try {
+            write_at(fd, 0, &header, sizeof(header), tmp);
+            if (header.levels > 0) {
+                // 叶子层顺序写出, 同时记下每个叶子的最大键, 上层的键都取自其中
+                std::vector<T> leaf_max;
+                leaf_max.reserve((count + b - 1) / b);
+                std::vector<T> buffer;
+                buffer.reserve(std::min<std::size_t>(count, (1 << 20) / sizeof(T) + 1));
+                uint64_t written = 0;
+                std::size_t i = 0;
+                for (; first != last && i < count; ++first, ++i) {
+                    buffer.push_back(*first);
+                    if ((i + 1) % b == 0 || i + 1 == count)
+                        leaf_max.push_back(buffer.back());
+                    if (buffer.size() == buffer.capacity()) {
+                        write_at(fd, header.level[0].offset + written * sizeof(T), buffer.data(),
+                                 buffer.size() * sizeof(T), tmp);
+                        written += buffer.size();
+                        buffer.clear();
+                    }
+                }
+                if (i != count) {
+                    throw std::invalid_argument("frozen input is shorter than its count");
+                }
+                write_at(fd, header.level[0].offset + written * sizeof(T), buffer.data(), buffer.size() * sizeof(T),
+                         tmp);
+
+                // 第 l 层: 第 l-1 层的子节点 c 覆盖叶子 [c*(B+1)^(l-1), (c+1)*(B+1)^(l-1))
+                uint64_t span = 1;
+                uint64_t children = leaf_max.size();
+                for (uint32_t l = 1; l < header.levels; l++) {
+                    buffer.clear();
+                    for (uint64_t c = 0; c < children; c++) {
+                        if (c % (b + 1) == b || c + 1 == children)
+                            continue;   // 每个父节点的最后一个子节点没有键
+                        uint64_t last_leaf = std::min<uint64_t>((c + 1) * span, leaf_max.size()) - 1;
+                        buffer.push_back(leaf_max[last_leaf]);
+                    }
+                    write_at(fd, header.level[l].offset, buffer.data(), buffer.size() * sizeof(T), tmp);
+                    span *= b + 1;
+                    children = (children + b) / (b + 1);
+                }
+            }
+            if (::fsync(fd) != 0) {
+                throw std::system_error(errno, std::generic_category(), "fsync " + tmp);
+            }
+        } catch (...) {
+            ::close(fd);
+            std::remove(tmp.c_str());
+            throw;
+        }
+        ::close(fd);
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            int err = errno;
+            std::remove(tmp.c_str());
+            throw std::system_error(err, std::generic_category(), "rename " + tmp);
+        }
+    }
+
+    static void write_at(int fd, uint64_t offset, const void* data, std::size_t len, const std::string& path) {
+        const char* p = static_cast<const char*>(data);
+        std::size_t done = 0;
+        while (done < len) {
+            ssize_t w = ::pwrite(fd, p + done, len - done, static_cast<off_t>(offset + done));
+            if (w < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "pwrite " + path);
+            }
+            done += static_cast<std::size_t>(w);
+        }
+    }
+};
+
+} // namespace btree_detail
+
+// 冻结格式文件的只读视图; 所有数据直接从映射中读取, 不做反序列化
+// 迭代器就是指向叶子层数组的指针, 在视图存在期间有效。线程安全 (只读)。
+template <typename T, typename Compare = std::less<T>>
+class FrozenBTree {
+    static_assert(std::is_trivially_copyable_v<T>, "frozen keys are stored as raw bytes");
+
+    using Header = btree_detail::FrozenHeader;
+
+    const char* base = nullptr;
+    std::size_t mapped = 0;
+    std::size_t count = 0;
+    std::size_t b = 0;
+    int levels = 0;
+    const T* level_keys[Header::kMaxLevels] = {};
+    std::size_t level_size[Header::kMaxLevels] = {};
+    Compare comp;
+
+    void unmap() {
+        if (base)
+            ::munmap(const_cast<char*>(base), mapped);
+        base = nullptr;
+    }
+
+    // 自顶向下, 返回叶子层中第一个 >= key (upper: > key) 的下标
+    std::size_t bound(const T& key, bool upper) const {
+        if (count == 0)
+            return 0;
+        std::size_t node = 0;
+        for (int l = levels - 1; l >= 0; l--) {
+            std::size_t begin = node * b;
+            int n = static_cast<int>(std::min(b, level_size[l] - begin));
+            const T* keys = level_keys[l] + begin;
+            int i = upper ? btree_search::node_upper_bound(keys, n, key, comp)
+                          : btree_search::node_lower_bound(keys, n, key, comp);
+            if (l == 0)
+                return begin + static_cast<std::size_t>(i);
+            node = node * (b + 1) + static_cast<std::size_t>(i);
+        }
+        return count;
+    }
+
+public:
+    using const_iterator = const T*;
+
+    // 映射文件并校验头部; 文件不存在时抛出 std::system_error, 格式不对时抛出 std::runtime_error
+    explicit FrozenBTree(const std::string& path, Compare compare = Compare()) : comp(std::move(compare)) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + path);
+        }
+        mapped = static_cast<std::size_t>(st.st_size);
+        if (mapped < sizeof(Header)) {
+            ::close(fd);
+            throw std::runtime_error("not a frozen B-tree file");
+        }
+        void* p = ::mmap(nullptr, mapped, PROT_READ, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            throw std::system_error(err, std::generic_category(), "mmap " + path);
+        }
+        base = static_cast<const char*>(p);
+
+        const Header* header = reinterpret_cast<const Header*>(base);
+        uint64_t expected[Header::kMaxLevels];
+        if (header->magic != Header::kMagic || header->version != Header::kVersion || header->node_keys < 2 ||
+            header->levels != Header::shape(header->count, header->node_keys, expected)) {
+            unmap();
+            throw std::runtime_error("not a frozen B-tree file");
+        }
+        if (header->key_size != sizeof(T)) {
+            unmap();
+            throw std::runtime_error("frozen B-tree file has a different key size");
+        }
+        count = static_cast<std::size_t>(header->count);
+        b = header->node_keys;
+        levels = static_cast<int>(header->levels);
+        for (int l = 0; l < levels; l++) {
+            const Header::Level& level = header->level[l];
+            if (level.keys != expected[l] || level.offset % alignof(T) != 0 ||
+                level.offset > mapped || level.keys > (mapped - level.offset) / sizeof(T)) {
+                unmap();
+                throw std::runtime_error("frozen B-tree file is truncated or corrupt");
+            }
+            level_keys[l] = reinterpret_cast<const T*>(base + level.offset);
+            level_size[l] = static_cast<std::size_t>(level.keys);
+        }
+    }
+
+    FrozenBTree(FrozenBTree&& other) noexcept { *this = std::move(other); }
+
+    FrozenBTree& operator=(FrozenBTree&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            base = std::exchange(other.base, nullptr);
+            mapped = other.mapped;
+            count = std::exchange(other.count, 0);
+            b = other.b;
+            levels = std::exchange(other.levels, 0);
+            std::copy(std::begin(other.level_keys), std::end(other.level_keys), level_keys);
+            std::copy(std::begin(other.level_size), std::end(other.level_size), level_size);
+            comp = std::move(other.comp);
+        }
+        return *this;
+    }
+
+    FrozenBTree(const FrozenBTree&) = delete;
+    FrozenBTree& operator=(const FrozenBTree&) = delete;
+
+    ~FrozenBTree() { unmap(); }
+
+    std::optional<T> search(const T& key) const {
+        const T* it = lower_bound(key);
+        if (it != end() && !comp(key, *it))
+            return *it;
+        return std::nullopt;
+    }
+
+    bool contains(const T& key) const {
+        return search(key).has_value();
+    }
+
+    const_iterator begin() const { return level_keys[0]; }
+    const_iterator end() const { return level_keys[0] + count; }
+
+    // 第一个 >= key 的位置
+    const_iterator lower_bound(const T& key) const { return begin() + bound(key, false); }
+    // 第一个 > key 的位置
+    const_iterator upper_bound(const T& key) const { return begin() + bound(key, true); }
+
+    // 按顺序访问闭区间 [lo, hi] 内的所有键; fn 返回 bool 时, 返回 false 提前结束
+    template <typename F>
+    void scan(const T& lo, const T& hi, F&& fn) const {
+        for (const T* it = lower_bound(lo); it != end() && !comp(hi, *it); ++it) {
+            if constexpr (std::is_same_v<std::invoke_result_t<F&, const T&>, bool>) {
+                if (!fn(*it))
+                    break;
+            } else {
+                fn(*it);
+            }
+        }
+    }
+
+    // 第 i 小的键 (叶子层是有序数组, O(1))
+    const T& operator[](std::size_t i) const { return level_keys[0][i]; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    int height() const { return levels; }
+    int node_keys() const { return static_cast<int>(b); }
+    // 映射的字节数 (文件大小)
+    std::size_t mapped_bytes() const { return mapped; }
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// B树节点分配器
+//
+// BTree 通过模板参数 Allocator 获取节点内存, 要求的接口:
+//   void* allocate(std::size_t bytes);              // 至少按 alignof(std::max_align_t) 对齐
+//   void  deallocate(void* p, std::size_t bytes);
+//   static constexpr bool bulk_release;             // true: 分配器析构时一次性释放全部节点,
+//                                                   //       树析构时无需逐个归还节点
+// 拼接/拆分 (BTree::join / merge_with / split_at) 还需要:
+//   void share(Allocator& other);                   // 之后 other 也可以持有、归还由 *this 分配的节点
+// 可选, 有它时 BTree::bulk_load_parallel 在多个线程上分配节点:
+//   Allocator fork() const;                         // 一个独立的新分配器, 可以在另一个线程上使用
+
+// 直接使用全局 operator new/delete, 每个节点一次堆分配
+struct HeapNodeAllocator {
+    static constexpr bool bulk_release = false;
+
+    void* allocate(std::size_t bytes) {
+        return ::operator new(bytes);
+    }
+    void deallocate(void* p, std::size_t /*bytes*/) noexcept {
+        ::operator delete(p);
+    }
+
+    void share(HeapNodeAllocator&) {}
+    HeapNodeAllocator fork() const { return {}; }
+};
+
+// 按块(slab)批量申请内存的节点分配器
+//
+//   slab 0: [leaf][leaf][internal][leaf] ...
+//   slab 1: [leaf][internal] ...      <- cur/end 之间为尚未切分的空间
+//
+// - 节点从当前slab中顺序切分, slab用完再申请下一块
+// - 归还的节点按大小挂到对应的空闲链表, 下次同样大小的分配优先复用
+// - 析构时按slab释放, 代价为 O(#slabs) 而不是 O(#nodes)
+// - slab 由共享的 SlabList 持有: share 之后另一个 arena 也引用这些 slab, 两者都析构之后才释放
+//   (拼接/拆分后的树中可能混有来自多个 arena 的节点)
+class NodeArena {
+public:
+    static constexpr bool bulk_release = true;
+    static constexpr std::size_t kDefaultSlabBytes = 64 * 1024;
+
+    explicit NodeArena(std::size_t slab_bytes = kDefaultSlabBytes)
+        : slab_bytes(slab_bytes), cur(nullptr), end(nullptr) {}
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    NodeArena(NodeArena&& other) noexcept
+        : slab_bytes(other.slab_bytes), slabs(std::move(other.slabs)), shared(std::move(other.shared)),
+          classes(std::move(other.classes)), cur(other.cur), end(other.end) {
+        other.shared.clear();
+        other.classes.clear();
+        other.cur = other.end = nullptr;
+    }
+
+    NodeArena& operator=(NodeArena&& other) noexcept {
+        if (this != &other) {
+            release();
+            slab_bytes = other.slab_bytes;
+            slabs = std::move(other.slabs);
+            shared = std::move(other.shared);
+            classes = std::move(other.classes);
+            cur = other.cur;
+            end = other.end;
+            other.shared.clear();
+            other.classes.clear();
+            other.cur = other.end = nullptr;
+        }
+        return *this;
+    }
+
+    ~NodeArena() { release(); }
+
+    void* allocate(std::size_t bytes) {
+        bytes = round_up(bytes);
+        SizeClass& sc = size_class(bytes);
+        if (sc.free) {
+            FreeBlock* block = sc.free;
+            sc.free = block->next;
+            return block;
+        }
+        if (static_cast<std::size_t>(end - cur) < bytes) {
+            std::size_t n = bytes > slab_bytes ? bytes : slab_bytes;
+            if (!slabs)
+                slabs = std::make_shared<SlabList>();
+            cur = static_cast<char*>(::operator new(n));
+            end = cur + n;
+            slabs->push_back(cur);
+        }
+        void* p = cur;
+        cur += bytes;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t bytes) noexcept {
+        SizeClass& sc = size_class(round_up(bytes));
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = sc.free;
+        sc.free = block;
+    }
+
+    // 释放全部slab (被其他 arena 共享的 slab 在它们析构时才释放); 之前分配出去的节点全部失效
+    void release() noexcept {
+        slabs.reset();
+        shared.clear();
+        classes.clear();
+        cur = end = nullptr;
+    }
+
+    // 本 arena 申请的 slab 数
+    std::size_t slab_count() const { return slabs ? slabs->size() : 0; }
+
+    // other 之后也引用本 arena 的 slab (包括以后新申请的) 以及本 arena 引用的 slab, O(#shared^2)
+    // other 已经引用的不重复添加; 只剩一方引用且没有 slab 的列表 (原 arena 已经释放) 顺便丢掉
+    void share(NodeArena& other) {
+        if (this == &other)
+            return;
+        if (!slabs)
+            slabs = std::make_shared<SlabList>();
+        prune_shared();
+        other.prune_shared();
+        std::vector<std::shared_ptr<SlabList>>& dst = other.shared;
+        auto add = [&](const std::shared_ptr<SlabList>& list) {
+            if (list != other.slabs && std::find(dst.begin(), dst.end(), list) == dst.end())
+                dst.push_back(list);
+        };
+        add(slabs);
+        for (const std::shared_ptr<SlabList>& list : shared)
+            add(list);
+    }
+
+    NodeArena fork() const { return NodeArena(slab_bytes); }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct SlabList : std::vector<void*> {
+        SlabList() = default;
+        SlabList(const SlabList&) = delete;
+        SlabList& operator=(const SlabList&) = delete;
+        ~SlabList() {
+            for (void* slab : *this)
+                ::operator delete(slab);
+        }
+    };
+    void prune_shared() {
+        shared.erase(std::remove_if(shared.begin(), shared.end(),
+                                    [](const std::shared_ptr<SlabList>& list) {
+                                        return list.use_count() == 1 && list->empty();
+                                    }),
+                     shared.end());
+    }
+
+    struct SizeClass {
+        std::size_t bytes;
+        FreeBlock* free;
+    };
+
+    static std::size_t round_up(std::size_t bytes) {
+        constexpr std::size_t a = alignof(std::max_align_t);
+        bytes = bytes < sizeof(FreeBlock) ? sizeof(FreeBlock) : bytes;
+        return (bytes + a - 1) / a * a;
+    }
+
+    // 一棵树通常只有两种节点大小(叶子/内部), 线性查找即可
+    SizeClass& size_class(std::size_t bytes) noexcept {
+        for (SizeClass& sc : classes) {
+            if (sc.bytes == bytes)
+                return sc;
+        }
+        classes.push_back(SizeClass{bytes, nullptr});
+        return classes.back();
+    }
+
+    std::size_t slab_bytes;
+    std::shared_ptr<SlabList> slabs;                  // 本 arena 申请的 slab
+    std::vector<std::shared_ptr<SlabList>> shared;    // 通过 share 引用的其他 arena 的 slab
+    std::vector<SizeClass> classes;
+    char* cur;
+    char* end;
+};
+
+// 引用一个外部的 NodeArena, 让多棵小树共享同一个arena
+// arena 必须比所有使用它的树活得更久; 树析构时把节点归还给arena的空闲链表
+class NodeArenaRef {
+public:
+    static constexpr bool bulk_release = false;
+
+    NodeArenaRef(NodeArena& arena) : arena(&arena) {}
+
+    void* allocate(std::size_t bytes) {
+        return arena->allocate(bytes);
+    }
+    void deallocate(void* p, std::size_t bytes) noexcept {
+        arena->deallocate(p, bytes);
+    }
+
+    // 节点只能在引用同一个 arena 的树之间转移: 否则归还到另一个 arena 的空闲链表中,
+    // 原 arena 析构之后这些空闲块就悬空了
+    void share(NodeArenaRef& other) {
+        if (arena != other.arena)
+            throw std::invalid_argument("trees must share the same NodeArena");
+    }
+
+private:
+    NodeArena* arena;
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 页式文件: 把一个文件看作由固定大小页组成的数组, 页号从 0 开始, 页 i 位于偏移 i * page_size
+//
+// 只负责整页读写 (pread/pwrite), 不做缓存; 缓存由 BufferPool 负责。
+// I/O 错误抛出 std::system_error。
+class Pager {
+public:
+    using PageId = uint32_t;
+
+    static constexpr std::size_t kMinPageSize = 512;
+    static constexpr std::size_t kMaxPageSize = 64 * 1024;
+
+    // 打开(不存在时创建)文件; page_size 必须是 [512, 64K] 内的2的幂
+    Pager(const std::string& path, std::size_t page_size) : path(path), page_bytes(page_size) {
+        if (page_size < kMinPageSize || page_size > kMaxPageSize || (page_size & (page_size - 1)) != 0) {
+            throw std::invalid_argument("page size must be a power of two in [512, 65536]");
+        }
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + path);
+        }
+        pages = static_cast<PageId>((static_cast<std::size_t>(st.st_size) + page_size - 1) / page_size);
+    }
+
+    Pager(const Pager&) = delete;
+    Pager& operator=(const Pager&) = delete;
+
+    ~Pager() {
+        ::close(fd);
+    }
+
+    // 读取一页; 已分配但还没写过的页 (超出文件末尾的部分) 读为全 0
+    void read(PageId id, void* buf) {
+        char* dst = static_cast<char*>(buf);
+        std::size_t done = 0;
+        while (done < page_bytes) {
+            ssize_t r = ::pread(fd, dst + done, page_bytes - done, offset(id) + done);
+            if (r < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "pread " + path);
+            }
+            if (r == 0) {
+                std::memset(dst + done, 0, page_bytes - done);
+                break;
+            }
+            done += static_cast<std::size_t>(r);
+        }
+        reads++;
+    }
+
+    void write(PageId id, const void* buf) {
+        const char* src = static_cast<const char*>(buf);
+        std::size_t done = 0;
+        while (done < page_bytes) {
+            ssize_t w = ::pwrite(fd, src + done, page_bytes - done, offset(id) + done);
+            if (w < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "pwrite " + path);
+            }
+            done += static_cast<std::size_t>(w);
+        }
+        if (id >= pages)
+            pages = id + 1;
+        writes++;
+    }
+
+    // 在文件末尾分配一个新页号; 页内容在第一次写入前不占用磁盘
+    PageId allocate() {
+        return pages++;
+    }
+
+    // 把已写入的数据刷到磁盘
+    void sync() {
+        if (::fdatasync(fd) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fdatasync " + path);
+        }
+    }
+
+    // 请求内核丢弃该文件在页缓存中的内容 (用于冷缓存测试, 只对已刷盘的页有效)
+    void drop_os_cache() {
+#ifdef POSIX_FADV_DONTNEED
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    }
+
+    std::size_t page_size() const { return page_bytes; }
+    PageId page_count() const { return pages; }
+    uint64_t read_count() const { return reads; }
+    uint64_t write_count() const { return writes; }
+
+private:
+    off_t offset(PageId id) const {
+        return static_cast<off_t>(id) * static_cast<off_t>(page_bytes);
+    }
+
+    std::string path;
+    std::size_t page_bytes;
+    int fd;
+    PageId pages;          // 已分配的页数 (包括还没写入文件的页)
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// 只读的静态索引: 有序键按 Eytzinger (BFS / 堆) 顺序存放在一个数组中, 不需要指针
+//
+// 下标从 1 开始, 节点 k 的左右孩子是 2k 和 2k+1, 中序遍历即为有序序列:
+/*
+  有序: 1 2 3 4 5 6 7        数组: [_ 4 2 6 1 3 5 7]
+                                     1 2 3 4 5 6 7   <- 下标
+              4
+            /   \
+           2     6
+          / \   / \
+         1   3 5   7
+*/
+// 查找 lower_bound: k = 2k + (b[k] < key), 每层只有一次比较和一次数据相关的下标计算, 没有分支;
+// 走到数组之外后, 去掉 k 末尾连续的 1 (最后一次向左转之后的右转) 就得到答案的下标。
+// 前几层集中在数组开头, 一直留在cache中; 下一层的访问位置在本层就能算出, 每次迭代预取 k 往下
+// log2(64 / sizeof(T)) 层的孩子 (恰好连续占一个cache line), 把内存延迟重叠起来。
+//
+// 适合读多写少的快照: 建好之后不能修改, 源树的修改需要重新构建。
+template <typename T, typename Compare = std::less<T>>
+class StaticIndex {
+    static constexpr std::size_t kLine = 64;
+    // 一个cache line中的元素个数, 也是每次预取往下看的子树宽度
+    static constexpr std::size_t kBlock = sizeof(T) < kLine ? kLine / sizeof(T) : 1;
+
+    T* b = nullptr;           // b[0] 不使用; 数组按cache line对齐, b[k*kBlock ..] 落在同一行
+    std::size_t n = 0;
+    Compare comp;
+
+    static T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(kLine)));
+    }
+
+    void release() {
+        if (b) {
+            std::destroy_n(b + 1, n);
+            ::operator delete(b, std::align_val_t(kLine));
+        }
+        b = nullptr;
+        n = 0;
+    }
+
+    // 按中序把有序输入放到对应的堆下标上, built 记录已构造的个数
+    template <typename It>
+    void place(std::size_t k, It& it, std::size_t& built) {
+        if (k > n)
+            return;
+        place(2 * k, it, built);
+        new (b + k) T(*it);
+        built++;
+        ++it;
+        place(2 * k + 1, it, built);
+    }
+
+    // 构造中途抛出异常时, 按同样的中序析构已构造的前 remaining 个元素
+    void unplace(std::size_t k, std::size_t& remaining) {
+        if (k > n || remaining == 0)
+            return;
+        unplace(2 * k, remaining);
+        if (remaining == 0)
+            return;
+        std::destroy_at(b + k);
+        remaining--;
+        unplace(2 * k + 1, remaining);
+    }
+
+    // 返回第一个 >= key (Upper: > key) 的堆下标, 不存在时为 0
+    template <bool Upper>
+    std::size_t descend(const T& key) const {
+        std::size_t k = 1;
+        while (k <= n) {
+            __builtin_prefetch(b + k * kBlock);
+            if constexpr (Upper) {
+                k = 2 * k + static_cast<std::size_t>(!comp(key, b[k]));
+            } else {
+                k = 2 * k + static_cast<std::size_t>(comp(b[k], key));
+            }
+        }
+        // 去掉末尾的 1 以及最后一次向左转
+        k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+        return k;
+    }
+
+public:
+    StaticIndex() = default;
+
+    // 从 count 个有序键 [first, ...) 构建
+    template <typename It>
+    StaticIndex(It first, std::size_t count, Compare compare = Compare()) : n(count), comp(std::move(compare)) {
+        if (n == 0)
+            return;
+        b = allocate(n + 1);
+        std::size_t built = 0;
+        try {
+            place(1, first, built);
+        } catch (...) {
+            unplace(1, built);
+            ::operator delete(b, std::align_val_t(kLine));
+            throw;
+        }
+    }
+
+    StaticIndex(StaticIndex&& other) noexcept
+        : b(std::exchange(other.b, nullptr)), n(std::exchange(other.n, 0)), comp(std::move(other.comp)) {}
+
+    StaticIndex& operator=(StaticIndex&& other) noexcept {
+        if (this != &other) {
+            release();
+            b = std::exchange(other.b, nullptr);
+            n = std::exchange(other.n, 0);
+            comp = std::move(other.comp);
+        }
+        return *this;
+    }
+
+    StaticIndex(const StaticIndex&) = delete;
+    StaticIndex& operator=(const StaticIndex&) = delete;
+
+    ~StaticIndex() { release(); }
+
+    std::optional<T> search(const T& key) const {
+        const T* found = lower_bound(key);
+        if (found && !comp(key, *found))
+            return *found;
+        return std::nullopt;
+    }
+
+    bool contains(const T& key) const {
+        const T* found = lower_bound(key);
+        return found && !comp(key, *found);
+    }
+
+    // 最小的 >= key 的键, 不存在时返回 nullptr (数组按堆顺序存放, 返回的指针不能用于迭代)
+    const T* lower_bound(const T& key) const {
+        std::size_t k = descend<false>(key);
+        return k ? b + k : nullptr;
+    }
+
+    // 最小的 > key 的键, 不存在时返回 nullptr
+    const T* upper_bound(const T& key) const {
+        std::size_t k = descend<true>(key);
+        return k ? b + k : nullptr;
+    }
+
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    // 占用的字节数
+    std::size_t memory_usage() const { return n ? (n + 1) * sizeof(T) : 0; }
+};
@@ -0,0 +1,302 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 日志记录何时算"持久":
+//   PerOp:    每个修改返回前日志已刷盘; 多个线程同时等待时共用一次 fdatasync (group commit)
+//   PerBatch: 调用 commit() 时刷盘, 之前的修改在崩溃时可能丢失
+//   Async:    后台线程每隔固定时间刷盘, 崩溃时最多丢失最后一个间隔内的修改
+enum class SyncMode { PerOp, PerBatch, Async };
+
+namespace btree_detail {
+
+// CRC-32 (IEEE 802.3), 用于检测日志尾部不完整/损坏的记录
+inline uint32_t crc32(const void* data, std::size_t len, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; i++)
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+} // namespace btree_detail
+
+// 预写日志 (write-ahead log), 只追加
+//
+// 记录格式:
+/*
+  +-----------+-----------+----------+----------+-----------------+
+  | len (4B)  | crc (4B)  | lsn (8B) | type(1B) | payload (len B) |
+  +-----------+-----------+----------+----------+-----------------+
+  crc 覆盖 lsn、type 和 payload; 读取时遇到长度不足或校验失败的记录即认为日志到此结束
+*/
+// append() 只写入内存缓冲区; 刷盘由一个"领头"线程完成:
+//   第一个需要刷盘的线程取走整个缓冲区, 在锁外 write + fdatasync, 其余线程等待;
+//   领头线程完成后, 它刷盘时缓冲区中所有记录都已持久, 等待这些记录的线程直接返回。
+// 所有方法都是线程安全的。
+class WriteAheadLog {
+public:
+    enum class RecordType : uint8_t {
+        Insert = 1,          // payload: 键
+        Remove = 2,          // payload: 键
+        PageImage = 3,       // payload: 页号(4B) + 整页内容, 检查点的一部分
+        CheckpointEnd = 4,   // 之前的页映像构成一个完整的检查点
+    };
+
+    struct Record {
+        RecordType type;
+        uint64_t lsn;
+        std::vector<char> payload;
+    };
+
+    static constexpr std::size_t kRecordHeader = 17;
+
+    WriteAheadLog(const std::string& path, SyncMode mode,
+                  std::chrono::milliseconds async_interval = std::chrono::milliseconds(10))
+        : path(path), mode(mode) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + path);
+        }
+        file_bytes = static_cast<std::size_t>(st.st_size);
+        if (mode == SyncMode::Async) {
+            flusher = std::thread([this, async_interval] { flush_loop(async_interval); });
+        }
+    }
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    ~WriteAheadLog() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            flusher.join();
+        }
+        try {
+            sync();
+        } catch (...) {
+        }
+        ::close(fd);
+    }
+
+    // 读出文件中所有完整的记录; 丢弃第一条不完整/损坏的记录及其之后的内容
+    // 只能在 append 之前调用 (恢复阶段)
+    std::vector<Record> read_all() {
+        std::vector<char> data(file_bytes);
+        std::size_t done = 0;
+        while (done < data.size()) {
+            ssize_t r = ::pread(fd, data.data() + done, data.size() - done, static_cast<off_t>(done));
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r < 0)
+                throw std::system_error(errno, std::generic_category(), "pread " + path);
+            if (r == 0)
+                break;
+            done += static_cast<std::size_t>(r);
+        }
+
+        std::vector<Record> records;
+        std::size_t pos = 0;
+        while (pos + kRecordHeader <= done) {
+            uint32_t len, crc;
+            std::memcpy(&len, data.data() + pos, 4);
+            std::memcpy(&crc, data.data() + pos + 4, 4);
+            if (pos + kRecordHeader + len > done)
+                break;
+            if (btree_detail::crc32(data.data() + pos + 8, 9 + len) != crc)
+                break;
+            Record rec;
+            std::memcpy(&rec.lsn, data.data() + pos + 8, 8);
+            rec.type = static_cast<RecordType>(data[pos + 16]);
+            rec.payload.assign(data.data() + pos + kRecordHeader, data.data() + pos + kRecordHeader + len);
+            next_lsn = std::max(next_lsn, rec.lsn + 1);
+            records.push_back(std::move(rec));
+            pos += kRecordHeader + len;
+        }
+        // 截掉损坏的尾部, 之后追加的记录紧接在最后一条完整记录之后
+        if (pos != file_bytes) {
+            if (::ftruncate(fd, static_cast<off_t>(pos)) != 0)
+                throw std::system_error(errno, std::generic_category(), "ftruncate " + path);
+            file_bytes = pos;
+        }
+        durable_lsn = next_lsn - 1;
+        return records;
+    }
+
+    // 追加一条记录 (只写入缓冲区), 返回它的 LSN
+    uint64_t append(RecordType type, const void* payload, std::size_t len) {
+        return append(type, payload, len, nullptr, 0);
+    }
+
+    // payload 由两段拼接而成 (页号 + 页内容)
+    uint64_t append(RecordType type, const void* head, std::size_t head_len, const void* body, std::size_t body_len) {
+        uint32_t len = static_cast<uint32_t>(head_len + body_len);
+        std::lock_guard<std::mutex> guard(mutex);
+        uint64_t lsn = next_lsn++;
+        std::size_t start = buffer.size();
+        buffer.resize(start + kRecordHeader + len);
+        char* p = buffer.data() + start;
+        std::memcpy(p, &len, 4);
+        std::memcpy(p + 8, &lsn, 8);
+        p[16] = static_cast<char>(type);
+        if (head_len)
+            std::memcpy(p + kRecordHeader, head, head_len);
+        if (body_len)
+            std::memcpy(p + kRecordHeader + head_len, body, body_len);
+        uint32_t crc = btree_detail::crc32(p + 8, 9 + len);
+        std::memcpy(p + 4, &crc, 4);
+        return lsn;
+    }
+
+    // 等待 lsn 之前(含)的记录持久化; 与其他等待的线程共用一次刷盘
+    void wait_durable(uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (durable_lsn < lsn) {
+            if (flushing) {
+                cv.wait(lock);
+                continue;
+            }
+            flush_locked(lock);
+        }
+    }
+
+    // 所有已追加的记录持久化
+    void sync() {
+        uint64_t last;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            last = next_lsn - 1;
+        }
+        wait_durable(last);
+    }
+
+    // 检查点完成后清空日志 (调用者保证日志中的内容已经全部反映到数据文件中)
+    void reset() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !flushing; });
+        buffer.clear();
+        if (::ftruncate(fd, 0) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate " + path);
+        if (::fdatasync(fd) != 0)
+            throw std::system_error(errno, std::generic_category(), "fdatasync " + path);
+        file_bytes = 0;
+        durable_lsn = next_lsn - 1;
+    }
+
+    // 日志大小 (文件 + 缓冲区), 用于决定何时做检查点
+    std::size_t size_bytes() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return file_bytes + buffer.size();
+    }
+
+    SyncMode sync_mode() const { return mode; }
+
+    // fdatasync 次数
+    uint64_t sync_count() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return syncs;
+    }
+
+private:
+    // 作为领头线程刷盘: 取走缓冲区, 在锁外写入并 fdatasync; 失败时抛出 std::system_error, 记录留在缓冲区中
+    void flush_locked(std::unique_lock<std::mutex>& lock) {
+        flushing = true;
+        std::vector<char> batch;
+        batch.swap(buffer);
+        uint64_t upto = next_lsn - 1;
+        std::size_t offset = file_bytes;
+        file_bytes += batch.size();
+        lock.unlock();
+
+        int err = 0;
+        std::size_t done = 0;
+        while (done < batch.size() && err == 0) {
+            ssize_t w = ::pwrite(fd, batch.data() + done, batch.size() - done, static_cast<off_t>(offset + done));
+            if (w < 0 && errno != EINTR)
+                err = errno;
+            else if (w > 0)
+                done += static_cast<std::size_t>(w);
+        }
+        if (err == 0 && ::fdatasync(fd) != 0)
+            err = errno;
+
+        lock.lock();
+        flushing = false;
+        if (err == 0) {
+            durable_lsn = std::max(durable_lsn, upto);
+            syncs++;
+        } else {
+            // 失败时把这批记录放回缓冲区最前面, 文件位置退回到写入前: 下一次刷盘从 offset 重新 pwrite 整批
+            // (重新写入会再次弄脏页缓存, 之后的 fdatasync 才真正刷盘, 而不是依赖失败后再调用一次 fdatasync)
+            batch.insert(batch.end(), buffer.begin(), buffer.end());
+            buffer.swap(batch);
+            file_bytes = offset;
+        }
+        cv.notify_all();
+        if (err != 0)
+            throw std::system_error(err, std::generic_category(), "write-ahead log " + path);
+    }
+
+    void flush_loop(std::chrono::milliseconds interval) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            cv.wait_for(lock, interval, [this] { return stopping; });
+            if (!flushing && durable_lsn < next_lsn - 1) {
+                try {
+                    flush_locked(lock);
+                } catch (...) {
+                    // 记录已放回缓冲区, 下一轮或下一次 sync() 重试
+                }
+            }
+        }
+    }
+
+    std::string path;
+    SyncMode mode;
+    int fd;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<char> buffer;      // 已追加但还没写入文件的记录
+    std::size_t file_bytes = 0;
+    uint64_t next_lsn = 1;
+    uint64_t durable_lsn = 0;      // 该 LSN 及之前的记录已持久化
+    bool flushing = false;         // 是否有领头线程正在刷盘
+    bool stopping = false;
+    uint64_t syncs = 0;
+    std::thread flusher;           // Async 模式的后台刷盘线程
+};
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "../include/bplus_tree.h"
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(BPlusTreeTest, InsertIsUnique) {
+    BPlusTree<int> tree(2);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(tree.insert(i * 7 % 1000));
+    }
+    EXPECT_FALSE(tree.insert(5));
+    EXPECT_EQ(tree.size(), 1000u);
+
+    int expected = 0;
+    for (int key : tree) {
+        EXPECT_EQ(key, expected++);
+    }
+    EXPECT_EQ(expected, 1000);
+}
+
+TEST(BPlusTreeTest, EraseShrinksTree) {
+    BPlusTree<int> tree(2);
+    for (int i = 0; i < 1000; i++) {
+        tree.insert(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(tree.erase(i));
+    }
+    EXPECT_FALSE(tree.erase(0));
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(tree.contains(i), i % 2 == 1);
+    }
+    for (int i = 1; i < 1000; i += 2) {
+        EXPECT_TRUE(tree.erase(i));
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_TRUE(tree.get_root()->is_leaf());
+    EXPECT_TRUE(tree.begin() == tree.end());
+}
+
+// 叶子链表: 扫描跨越多个叶子, 返回闭区间 [lo, hi] 内的记录
+TEST(BPlusTreeTest, ScanFollowsLeafChain) {
+    BPlusTreeMap<int, std::string> map(3);
+    for (int i = 0; i < 2000; i++) {
+        map.insert_or_assign(i, std::to_string(i));
+    }
+    std::vector<int> keys;
+    map.scan(500, 599, [&](const int& key, std::string& value) {
+        EXPECT_EQ(value, std::to_string(key));
+        keys.push_back(key);
+    });
+    ASSERT_EQ(keys.size(), 100u);
+    EXPECT_EQ(keys.front(), 500);
+    EXPECT_EQ(keys.back(), 599);
+
+    int visited = 0;
+    map.scan(0, 1999, [&](const int&, std::string&) { return ++visited < 10; });
+    EXPECT_EQ(visited, 10);
+}
+
+// 值的构造抛出异常时叶子保持不变, 键和值仍然对齐
+TEST(BPlusTreeTest, ThrowingValueLeavesLeafIntact) {
+    struct Picky {
+        std::string text;
+        explicit Picky(int v) : text(std::to_string(v)) {
+            if (v < 0)
+                throw std::runtime_error("negative value");
+        }
+    };
+    BPlusTreeMap<std::string, Picky> map(2);
+    for (int i = 0; i < 300; i += 2)
+        map.try_emplace(std::to_string(i), i);
+    for (int i = 1; i < 300; i += 2)
+        EXPECT_THROW(map.try_emplace(std::to_string(i), -i), std::runtime_error);
+    EXPECT_EQ(map.size(), 150u);
+    int visited = 0;
+    for (auto it = map.begin(); it != map.end(); ++it, visited++)
+        EXPECT_EQ(it.value().text, it.key());
+    EXPECT_EQ(visited, 150);
+}
+
+// 随机插入/覆盖/删除, 与 std::map 对比: 点查、正反向遍历、lower/upper_bound、scan
+TEST(BPlusTreeTest, RandomOpsMatchStdMap) {
+    for (int t : {2, 3, 8}) {
+        BPlusTreeMap<std::string, int> map(t);
+        std::map<std::string, int> ref;
+        std::mt19937 rng(t);
+        for (int i = 0; i < 20000; i++) {
+            std::string key = std::to_string(rng() % 2000);
+            int op = static_cast<int>(rng() % 4);
+            if (op < 2) {
+                EXPECT_EQ(map.insert_or_assign(key, i).second, ref.insert_or_assign(key, i).second);
+            } else if (op == 2) {
+                map.upsert(key, [](int& v) { v++; });
+                ref[key]++;
+            } else {
+                EXPECT_EQ(map.erase(key), ref.erase(key) == 1);
+            }
+        }
+        ASSERT_EQ(map.size(), ref.size());
+
+        auto it = map.begin();
+        for (const auto& [key, value] : ref) {
+            ASSERT_NE(it, map.end());
+            EXPECT_EQ(it.key(), key);
+            EXPECT_EQ(it.value(), value);
+            ++it;
+        }
+        EXPECT_EQ(it, map.end());
+
+        auto rit = ref.rbegin();
+        for (auto back = map.end(); back != map.begin();) {
+            --back;
+            EXPECT_EQ(back.key(), rit->first);
+            ++rit;
+        }
+
+        for (int probe = 0; probe < 2000; probe += 37) {
+            std::string key = std::to_string(probe);
+            auto lb = map.lower_bound(key);
+            auto ref_lb = ref.lower_bound(key);
+            ASSERT_EQ(lb == map.end(), ref_lb == ref.end());
+            if (ref_lb != ref.end()) {
+                EXPECT_EQ(lb.key(), ref_lb->first);
+            }
+            auto ub = map.upper_bound(key);
+            auto ref_ub = ref.upper_bound(key);
+            ASSERT_EQ(ub == map.end(), ref_ub == ref.end());
+            if (ref_ub != ref.end()) {
+                EXPECT_EQ(ub.key(), ref_ub->first);
+            }
+        }
+
+        std::vector<std::string> scanned, expected;
+        map.scan("3", "5", [&](const std::string& key, int&) { scanned.push_back(key); });
+        for (auto r = ref.lower_bound("3"); r != ref.end() && r->first <= "5"; ++r)
+            expected.push_back(r->first);
+        EXPECT_EQ(scanned, expected);
+    }
+}
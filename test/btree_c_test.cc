@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include "../include/btree_c.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+int compare_int(const void* a, const void* b, void*) {
+    int x, y;
+    std::memcpy(&x, a, sizeof(x));
+    std::memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+std::vector<int> collect(const btree* T) {
+    std::vector<int> out;
+    btree_iter it;
+    btree_iter_first(T, &it);
+    for (const void* r; (r = btree_iter_next(&it)) != nullptr;) {
+        int v;
+        std::memcpy(&v, r, sizeof(v));
+        out.push_back(v);
+    }
+    return out;
+}
+
+// 带值的记录: 比较函数只看 id, 通过 ctx 统计比较次数
+struct Row {
+    int64_t id;
+    char name[12];
+};
+
+int compare_row(const void* a, const void* b, void* ctx) {
+    ++*static_cast<long*>(ctx);
+    int64_t x, y;
+    std::memcpy(&x, a, sizeof(x));
+    std::memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+} // namespace
+
+TEST(BTreeCTest, CreateRejectsBadArguments) {
+    EXPECT_EQ(btree_create(0, 2, compare_int, nullptr), nullptr);
+    EXPECT_EQ(btree_create(sizeof(int), 1, compare_int, nullptr), nullptr);
+    EXPECT_EQ(btree_create(sizeof(int), 2, nullptr, nullptr), nullptr);
+
+    btree* T = btree_create(sizeof(int), 2, compare_int, nullptr);
+    ASSERT_NE(T, nullptr);
+    EXPECT_EQ(btree_size(T), 0u);
+    EXPECT_EQ(btree_record_size(T), sizeof(int));
+    int key = 1;
+    EXPECT_EQ(btree_find(T, &key), nullptr);
+    EXPECT_EQ(btree_delete(T, &key), BTREE_NOT_FOUND);
+    EXPECT_TRUE(collect(T).empty());
+    btree_destroy(T);
+}
+
+// 随机插入/删除, 与 std::set 对照
+TEST(BTreeCTest, MatchesStdSet) {
+    std::mt19937 rng(23);
+    for (int t : {2, 3, 5, 32}) {
+        btree* T = btree_create(sizeof(int), t, compare_int, nullptr);
+        std::set<int> ref;
+        for (int i = 0; i < 20000; i++) {
+            int key = static_cast<int>(rng() % 2000);
+            if (rng() % 3 == 0) {
+                EXPECT_EQ(btree_delete(T, &key), ref.erase(key) ? BTREE_OK : BTREE_NOT_FOUND);
+            } else {
+                EXPECT_EQ(btree_insert(T, &key), ref.insert(key).second ? BTREE_OK : BTREE_EXISTS);
+            }
+        }
+        ASSERT_EQ(btree_size(T), ref.size());
+        EXPECT_EQ(collect(T), std::vector<int>(ref.begin(), ref.end()));
+        for (int key = 0; key < 2000; key++) {
+            const void* hit = btree_find(T, &key);
+            ASSERT_EQ(hit != nullptr, ref.count(key) == 1) << key;
+        }
+
+        // 全部删除, 根节点逐层收缩
+        std::vector<int> keys(ref.begin(), ref.end());
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (int key : keys)
+            ASSERT_EQ(btree_delete(T, &key), BTREE_OK);
+        EXPECT_EQ(btree_size(T), 0u);
+        EXPECT_TRUE(collect(T).empty());
+        btree_destroy(T);
+    }
+}
+
+TEST(BTreeCTest, RecordsCarryPayload) {
+    long comparisons = 0;
+    btree* T = btree_create(sizeof(Row), 4, compare_row, &comparisons);
+    for (int64_t id = 0; id < 1000; id++) {
+        Row r{id * 2, {}};
+        std::snprintf(r.name, sizeof(r.name), "row%lld", static_cast<long long>(id));
+        ASSERT_EQ(btree_insert(T, &r), BTREE_OK);
+    }
+    EXPECT_GT(comparisons, 0);
+
+    // insert 不覆盖, put 覆盖
+    Row r{10, "changed"};
+    EXPECT_EQ(btree_insert(T, &r), BTREE_EXISTS);
+    const Row* hit = static_cast<const Row*>(btree_find(T, &r));
+    ASSERT_NE(hit, nullptr);
+    EXPECT_STREQ(hit->name, "row5");
+    EXPECT_EQ(btree_put(T, &r), BTREE_EXISTS);
+    EXPECT_STREQ(static_cast<const Row*>(btree_find(T, &r))->name, "changed");
+    Row fresh{11, "new"};
+    EXPECT_EQ(btree_put(T, &fresh), BTREE_OK);
+    EXPECT_EQ(btree_size(T), 1001u);
+
+    int64_t missing = 13;
+    EXPECT_EQ(btree_find(T, &missing), nullptr);
+    btree_destroy(T);
+}
+
+TEST(BTreeCTest, SeekAndRange) {
+    btree* T = btree_create(sizeof(int), 3, compare_int, nullptr);
+    for (int i = 0; i < 500; i++) {
+        int key = i * 3;
+        btree_insert(T, &key);
+    }
+
+    // seek 定位到第一条 >= key 的记录, 包括落在内部节点和超出最大值的情况
+    for (int key = -1; key <= 1500; key++) {
+        btree_iter it;
+        btree_iter_seek(T, &it, &key);
+        const void* r = btree_iter_next(&it);
+        int expect = (key + 2) / 3 * 3;
+        if (key < 0)
+            expect = 0;
+        if (expect > 1497) {
+            EXPECT_EQ(r, nullptr) << key;
+            continue;
+        }
+        ASSERT_NE(r, nullptr) << key;
+        int got;
+        std::memcpy(&got, r, sizeof(got));
+        EXPECT_EQ(got, expect) << key;
+    }
+
+    std::vector<int> seen;
+    auto visit = [](const void* r, void* ctx) -> int {
+        int v;
+        std::memcpy(&v, r, sizeof(v));
+        static_cast<std::vector<int>*>(ctx)->push_back(v);
+        return 1;
+    };
+    int lo = 100, hi = 120;
+    EXPECT_EQ(btree_range(T, &lo, &hi, visit, &seen), 7u);
+    EXPECT_EQ(seen, (std::vector<int>{102, 105, 108, 111, 114, 117, 120}));
+
+    // 回调返回 0 时提前结束
+    auto stop_after_two = [](const void*, void* ctx) -> int { return ++*static_cast<int*>(ctx) < 2; };
+    int calls = 0;
+    EXPECT_EQ(btree_range(T, &lo, &hi, stop_after_two, &calls), 2u);
+
+    hi = 50;
+    EXPECT_EQ(btree_range(T, &lo, &hi, visit, &seen), 0u);
+    btree_destroy(T);
+}
+
+TEST(BTreeCTest, InsertBatch) {
+    std::mt19937 rng(24);
+    for (int t : {2, 16}) {
+        btree* T = btree_create(sizeof(int), t, compare_int, nullptr);
+        std::set<int> ref;
+        for (int round = 0; round < 5; round++) {
+            // 乱序、含重复、部分与已有记录相同
+            std::vector<int> batch(3000);
+            for (int& v : batch)
+                v = static_cast<int>(rng() % 10000);
+            std::size_t expect = 0;
+            for (int v : batch)
+                expect += ref.insert(v).second;
+            int err = -42;
+            EXPECT_EQ(btree_insert_batch(T, batch.data(), batch.size(), &err), expect);
+            EXPECT_EQ(err, BTREE_OK);
+            ASSERT_EQ(btree_size(T), ref.size());
+            ASSERT_EQ(collect(T), std::vector<int>(ref.begin(), ref.end()));
+        }
+        EXPECT_EQ(btree_insert_batch(T, nullptr, 0, nullptr), 0u);
+
+        // 批量插入之后的结构仍然可以正常删除
+        for (int key : ref)
+            ASSERT_EQ(btree_delete(T, &key), BTREE_OK);
+        EXPECT_EQ(btree_size(T), 0u);
+        btree_destroy(T);
+    }
+}
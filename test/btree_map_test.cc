@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+#include "../include/btree_map.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+TEST(BTreeMapTest, InsertOrAssignAndFind) {
+    BTreeMap<int, std::string> map(3);
+    EXPECT_EQ(map.find(1), nullptr);
+
+    auto [v, inserted] = map.insert_or_assign(1, std::string("one"));
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(*v, "one");
+
+    auto [v2, inserted2] = map.insert_or_assign(1, std::string("uno"));
+    EXPECT_FALSE(inserted2);
+    EXPECT_EQ(*v2, "uno");
+    EXPECT_EQ(*map.find(1), "uno");
+    EXPECT_EQ(map.size(), 1u);
+}
+
+TEST(BTreeMapTest, TryEmplaceDoesNotOverwrite) {
+    BTreeMap<int, std::string> map(2);
+    for (int i = 0; i < 100; i++) {
+        auto [v, inserted] = map.try_emplace(i, 3, static_cast<char>('a' + i % 26));
+        EXPECT_TRUE(inserted);
+        EXPECT_EQ(v->size(), 3u);
+    }
+    auto [v, inserted] = map.try_emplace(42, "changed");
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(*v, std::string(3, static_cast<char>('a' + 42 % 26)));
+    EXPECT_EQ(map.size(), 100u);
+}
+
+TEST(BTreeMapTest, UpsertCountsInPlace) {
+    BTreeMap<std::string, int> counts(2);
+    std::vector<std::string> words = {"a", "b", "a", "c", "b", "a"};
+    for (int round = 0; round < 50; round++) {
+        for (const auto& w : words) {
+            counts.upsert(w + std::to_string(round % 10), [](int& c) { c++; });
+        }
+    }
+    for (int r = 0; r < 10; r++) {
+        EXPECT_EQ(*counts.find("a" + std::to_string(r)), 15);
+        EXPECT_EQ(*counts.find("b" + std::to_string(r)), 10);
+        EXPECT_EQ(*counts.find("c" + std::to_string(r)), 5);
+    }
+    EXPECT_EQ(counts.size(), 30u);
+}
+
+TEST(BTreeMapTest, MoveOnlyValues) {
+    BTreeMap<int, std::unique_ptr<int>> map(2);
+    for (int i = 0; i < 200; i++) {
+        map.try_emplace(i, std::make_unique<int>(i * 10));
+    }
+    for (int i = 0; i < 200; i += 3) {
+        EXPECT_TRUE(map.erase(i));
+    }
+    for (int i = 0; i < 200; i++) {
+        auto* v = map.find(i);
+        if (i % 3 == 0) {
+            EXPECT_EQ(v, nullptr);
+        } else {
+            ASSERT_NE(v, nullptr);
+            EXPECT_EQ(**v, i * 10);
+        }
+    }
+}
+
+namespace {
+
+// 参数为负数时构造抛出异常
+struct ThrowingValue {
+    std::string text;
+    explicit ThrowingValue(int v) : text(std::to_string(v)) {
+        if (v < 0)
+            throw std::runtime_error("negative value");
+    }
+};
+
+} // namespace
+
+// 值的构造抛出异常时节点保持不变: 键和值仍然对齐, 没有丢失或泄漏的槽位
+TEST(BTreeMapTest, ThrowingValueLeavesTreeIntact) {
+    BTreeMap<std::string, ThrowingValue> map(2);
+    for (int i = 0; i < 300; i += 2)
+        map.try_emplace(std::to_string(i), i);
+    for (int i = 1; i < 300; i += 2)
+        EXPECT_THROW(map.try_emplace(std::to_string(i), -i), std::runtime_error);
+    ASSERT_TRUE(map.validate());
+    EXPECT_EQ(map.size(), 150u);
+    for (int i = 0; i < 300; i++) {
+        auto* v = map.find(std::to_string(i));
+        if (i % 2) {
+            EXPECT_EQ(v, nullptr);
+        } else {
+            ASSERT_NE(v, nullptr);
+            EXPECT_EQ(v->text, std::to_string(i));
+        }
+    }
+}
+
+TEST(BTreeMapTest, CustomComparator) {
+    BTreeMap<int, int, std::greater<int>> map(2);
+    for (int i = 0; i < 50; i++) {
+        map.insert_or_assign(i, -i);
+    }
+    for (int i = 0; i < 50; i++) {
+        ASSERT_NE(map.find(i), nullptr);
+        EXPECT_EQ(*map.find(i), -i);
+    }
+    EXPECT_FALSE(map.erase(100));
+    EXPECT_TRUE(map.erase(10));
+    EXPECT_EQ(map.find(10), nullptr);
+}
+
+// 随机插入/覆盖/删除, 与 std::map 对比; 值跟随键经过分裂/合并/借键后必须保持对应
+TEST(BTreeMapTest, RandomOpsMatchStdMap) {
+    for (int t : {2, 3, 8}) {
+        BTreeMap<int, std::string> map(t);
+        std::map<int, std::string> ref;
+        std::mt19937 rng(t);
+        for (int i = 0; i < 20000; i++) {
+            int key = static_cast<int>(rng() % 2000);
+            int op = static_cast<int>(rng() % 4);
+            if (op < 2) {
+                std::string value = std::to_string(key) + "#" + std::to_string(i);
+                map.insert_or_assign(key, value);
+                ref[key] = value;
+            } else if (op == 2) {
+                map.upsert(key, [](std::string& v) { v += "!"; });
+                ref[key] += "!";
+            } else {
+                EXPECT_EQ(map.erase(key), ref.erase(key) == 1);
+            }
+        }
+        ASSERT_EQ(map.size(), ref.size());
+        for (int key = 0; key < 2000; key++) {
+            auto it = ref.find(key);
+            const std::string* v = map.find(key);
+            if (it == ref.end()) {
+                EXPECT_EQ(v, nullptr);
+            } else {
+                ASSERT_NE(v, nullptr);
+                EXPECT_EQ(*v, it->second);
+            }
+        }
+    }
+}
+
+TEST(BTreeMapTest, IteratorsAndScan) {
+    BTreeMap<int, int> map(2);
+    for (int i = 0; i < 500; i++) {
+        map.insert_or_assign(i * 2, i);
+    }
+
+    int expected = 0;
+    for (auto [key, value] : map) {
+        EXPECT_EQ(key, expected * 2);
+        EXPECT_EQ(value, expected);
+        value = -value; // 通过迭代器修改值
+        expected++;
+    }
+    EXPECT_EQ(expected, 500);
+    EXPECT_EQ(*map.find(10), -5);
+
+    auto it = map.lower_bound(101);
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it.key(), 102);
+    EXPECT_EQ(map.upper_bound(998), map.end());
+
+    const auto& cmap = map;
+    std::vector<int> keys;
+    cmap.scan(10, 20, [&](const int& key, const int&) { keys.push_back(key); });
+    EXPECT_EQ(keys, (std::vector<int>{10, 12, 14, 16, 18, 20}));
+}
+
+TEST(BTreeMapTest, BulkAndMergeLoad) {
+    std::map<int, std::string> ref;
+    for (int i = 0; i < 3000; i++) {
+        ref[i * 2] = std::to_string(i);
+    }
+    BTreeMap<int, std::string> map(4);
+    map.bulk_load(ref.begin(), ref.end(), 0.8);
+    ASSERT_EQ(map.size(), ref.size());
+    EXPECT_EQ(*map.find(100), "50");
+
+    // 批量中的值覆盖已有键
+    std::vector<std::pair<int, std::string>> batch;
+    for (int i = -5; i < 7000; i += 5) {
+        batch.emplace_back(i, "batch");
+        ref[i] = "batch";
+    }
+    map.merge_load(batch.begin(), batch.end());
+    ASSERT_EQ(map.size(), ref.size());
+    auto it = map.begin();
+    for (const auto& [key, value] : ref) {
+        EXPECT_EQ(it.key(), key);
+        EXPECT_EQ(it.value(), value);
+        ++it;
+    }
+
+    std::vector<std::pair<int, int>> duplicate = {{1, 1}, {1, 2}};
+    BTreeMap<int, int> other(2);
+    EXPECT_THROW(other.bulk_load(duplicate.begin(), duplicate.end()), std::invalid_argument);
+}
+
+TEST(BTreeMapTest, BatchInsertAndFind) {
+    BTreeMap<int, int> map(4);
+    std::map<int, int> ref;
+    std::mt19937 rng(11);
+    for (int round = 0; round < 10; round++) {
+        std::vector<std::pair<int, int>> entries(2000);
+        for (auto& entry : entries) {
+            entry = {static_cast<int>(rng() % 8000), static_cast<int>(rng())};
+        }
+        std::unique_ptr<bool[]> inserted(new bool[entries.size()]);
+        map.insert_batch(entries.data(), entries.size(), inserted.get());
+        // 与 try_emplace 语义一致: 批量内的重复键只有第一个生效
+        for (size_t i = 0; i < entries.size(); i++) {
+            EXPECT_EQ(inserted[i], ref.insert(entries[i]).second);
+        }
+    }
+    ASSERT_EQ(map.size(), ref.size());
+
+    std::vector<int> keys(3000);
+    for (int& key : keys) {
+        key = static_cast<int>(rng() % 9000);
+    }
+    std::vector<int*> values(keys.size());
+    map.find_batch(keys.data(), keys.size(), values.data());
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto it = ref.find(keys[i]);
+        if (it == ref.end()) {
+            EXPECT_EQ(values[i], nullptr);
+        } else {
+            ASSERT_NE(values[i], nullptr);
+            EXPECT_EQ(*values[i], it->second);
+        }
+    }
+}
+
+TEST(BTreeMapTest, HeterogeneousLookup) {
+    BTreeMap<std::string, int, std::less<>> map(3);
+    for (int i = 0; i < 500; i++)
+        map.try_emplace("user:" + std::to_string(i), i);
+    std::string_view key("user:42,user:999");
+    ASSERT_NE(map.find(key.substr(0, 7)), nullptr);
+    EXPECT_EQ(*map.find(key.substr(0, 7)), 42);
+    EXPECT_FALSE(map.contains(key.substr(8)));
+    EXPECT_TRUE(map.erase(key.substr(0, 7)));
+    EXPECT_FALSE(map.erase(key.substr(0, 7)));
+    EXPECT_EQ(map.size(), 499u);
+
+    const auto& cmap = map;
+    EXPECT_EQ(*cmap.find(std::string_view("user:7")), 7);
+    EXPECT_EQ(cmap.lower_bound(std::string_view("user:42")).key(), "user:420");
+}
+
+// 顺序统计: 删除后 rank/select/count_range 仍然正确, select 得到的迭代器可以取值
+TEST(BTreeMapTest, OrderStatistic) {
+    BTreeMap<int, std::string, std::less<int>, NodeArena, OrderStatistic> map(2);
+    for (int i = 0; i < 1000; i++)
+        map.try_emplace(i * 2, std::to_string(i));
+    for (int i = 0; i < 1000; i += 3)
+        map.erase(i * 2);
+    // 剩下的键: 2, 4, 8, 10, 14, ... (每 3 个删去 1 个)
+    EXPECT_EQ(map.count_range(0, 99), 33u);
+    auto it = map.select(1);
+    EXPECT_EQ(it.key(), 4);
+    EXPECT_EQ(it.value(), "2");
+    EXPECT_EQ(map.rank(7), 2u);
+    EXPECT_EQ(map.select(map.size()), map.end());
+}
+
+// 值的区间和: 覆盖写入和 upsert 都会更新聚合值
+TEST(BTreeMapTest, ReduceValues) {
+    BTreeMap<int64_t, double, std::less<int64_t>, NodeArena, SumOf<double>> map(3);
+    std::map<int64_t, double> ref;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 5000; i++) {
+        int64_t key = static_cast<int64_t>(rng() % 3000);
+        double value = static_cast<double>(rng() % 100);
+        switch (i % 4) {
+        case 0:
+            map.insert_or_assign(key, value);
+            ref[key] = value;
+            break;
+        case 1:
+            map.upsert(key, [&](double& v) { v += value; });
+            ref[key] += value;
+            break;
+        case 2:
+            map.try_emplace(key, value);
+            ref.emplace(key, value);
+            break;
+        default:
+            map.erase(key);
+            ref.erase(key);
+        }
+    }
+    for (int64_t lo = 0; lo < 3000; lo += 97) {
+        int64_t hi = lo + static_cast<int64_t>(rng() % 1500);
+        double expected = 0;
+        for (auto it = ref.lower_bound(lo); it != ref.upper_bound(hi); ++it)
+            expected += it->second;
+        ASSERT_EQ(map.reduce(lo, hi), expected) << lo << " " << hi;
+    }
+    EXPECT_EQ(map.count_range(0, 2999), ref.size());
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "../include/btree_multiset.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// 随机插入/删除 (大量重复键), 与 std::multiset 对照
+TEST(BTreeMultisetTest, MatchesStdMultiset) {
+    std::mt19937 rng(20);
+    for (int t : {2, 3, 16}) {
+        BTreeMultiset<int> set(t);
+        std::multiset<int> ref;
+        for (int i = 0; i < 20000; i++) {
+            // 偏斜分布: 一半的操作落在 8 个热点键上
+            int key = rng() % 2 ? static_cast<int>(rng() % 8) : static_cast<int>(rng() % 1000);
+            switch (rng() % 6) {
+            case 0: {
+                auto it = ref.find(key);
+                EXPECT_EQ(set.erase(key), it != ref.end());
+                if (it != ref.end())
+                    ref.erase(it);
+                break;
+            }
+            case 1:
+                if (rng() % 8 == 0) {
+                    EXPECT_EQ(set.erase_all(key), ref.erase(key));
+                }
+                break;
+            default:
+                EXPECT_EQ(set.insert(key), ref.count(key) + 1);
+                ref.insert(key);
+            }
+        }
+        ASSERT_EQ(set.size(), ref.size());
+        EXPECT_LE(set.distinct_size(), 1000u);
+        EXPECT_TRUE(std::equal(set.begin(), set.end(), ref.begin(), ref.end()));
+        // 反向遍历
+        std::vector<int> reversed;
+        for (auto it = set.end(); it != set.begin();)
+            reversed.push_back(*--it);
+        EXPECT_TRUE(std::equal(reversed.begin(), reversed.end(), ref.rbegin(), ref.rend()));
+
+        for (int key = -1; key <= 1000; key++) {
+            ASSERT_EQ(set.count(key), ref.count(key)) << "t=" << t << " key=" << key;
+            auto [first, last] = set.equal_range(key);
+            ASSERT_EQ(static_cast<std::size_t>(std::distance(first, last)), ref.count(key));
+            EXPECT_EQ(std::distance(set.begin(), set.lower_bound(key)),
+                      std::distance(ref.begin(), ref.lower_bound(key)));
+            EXPECT_EQ(std::distance(set.begin(), set.upper_bound(key)),
+                      std::distance(ref.begin(), ref.upper_bound(key)));
+        }
+    }
+}
+
+// 重复次数很多的键只占一个槽位
+TEST(BTreeMultisetTest, RunsStayCompact) {
+    BTreeMultiset<int> set(4);
+    for (int i = 0; i < 100000; i++)
+        set.insert(i % 3);
+    set.insert(7, 1000000);
+    EXPECT_EQ(set.size(), 1100000u);
+    EXPECT_EQ(set.distinct_size(), 4u);
+    EXPECT_EQ(set.count(1), 33333u);
+    EXPECT_EQ(set.count(7), 1000000u);
+    EXPECT_EQ(set.insert(7, 0), 1000000u);
+
+    EXPECT_EQ(set.erase_all(7), 1000000u);
+    EXPECT_EQ(set.erase_all(7), 0u);
+    EXPECT_FALSE(set.contains(7));
+    EXPECT_TRUE(set.erase(2));
+    EXPECT_EQ(set.count(2), 33332u);
+    EXPECT_EQ(set.size(), 99999u);
+
+    std::vector<std::pair<int, std::size_t>> runs;
+    set.for_each_run([&](int key, std::size_t n) { runs.emplace_back(key, n); });
+    EXPECT_EQ(runs, (std::vector<std::pair<int, std::size_t>>{{0, 33334}, {1, 33333}, {2, 33332}}));
+    EXPECT_EQ(set.lower_bound(1).run_length(), 33333u);
+}
+
+// 只比较部分字段的键: 相等的键合并到第一次插入的键对象, 次数累加
+TEST(BTreeMultisetTest, EquivalentKeysShareFirstRepresentative) {
+    struct Event {
+        int priority;
+        std::string name;
+    };
+    struct ByPriority {
+        bool operator()(const Event& a, const Event& b) const { return a.priority < b.priority; }
+    };
+    BTreeMultiset<Event, ByPriority> events(2);
+    events.insert({2, "b"});
+    events.insert({1, "a"});
+    events.insert({2, "c"});
+    EXPECT_EQ(events.count({2, ""}), 2u);
+    auto [first, last] = events.equal_range({2, ""});
+    ASSERT_NE(first, last);
+    EXPECT_EQ(first->name, "b");
+    EXPECT_EQ(std::next(first)->name, "b");
+    EXPECT_EQ(std::next(first, 2), last);
+    EXPECT_EQ(last, events.end());
+}
+
+// 有序输入先合并成游程再批量构建
+TEST(BTreeMultisetTest, BulkLoad) {
+    std::vector<int> keys;
+    for (int i = 0; i < 5000; i++)
+        keys.insert(keys.end(), static_cast<std::size_t>(i % 5 + 1), i);
+    BTreeMultiset<int> set(8);
+    set.insert(-1);
+    set.bulk_load(keys.begin(), keys.end(), 0.7);
+    EXPECT_EQ(set.size(), keys.size());
+    EXPECT_EQ(set.distinct_size(), 5000u);
+    EXPECT_FALSE(set.contains(-1));
+    EXPECT_EQ(set.count(4), 5u);
+    EXPECT_TRUE(std::equal(set.begin(), set.end(), keys.begin(), keys.end()));
+
+    std::vector<int> unsorted = {1, 1, 0};
+    EXPECT_THROW(set.bulk_load(unsorted.begin(), unsorted.end()), std::invalid_argument);
+}
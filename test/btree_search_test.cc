@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "../include/btree_search.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// 对比 std::lower_bound/std::upper_bound 验证节点内查找
+template <typename T, typename Gen>
+static void check_bounds(Gen gen) {
+    std::mt19937_64 rng(7);
+    for (int n : {0, 1, 2, 3, 7, 8, 9, 31, 32, 33, 63, 99, 255, 511}) {
+        std::vector<T> keys;
+        for (int i = 0; i < n; i++) {
+            keys.push_back(gen(rng));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<T> probes = keys;
+        for (int i = 0; i < 64; i++) {
+            probes.push_back(gen(rng));
+        }
+        for (const T& key : probes) {
+            int lower = static_cast<int>(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+            int upper = static_cast<int>(std::upper_bound(keys.begin(), keys.end(), key) - keys.begin());
+            ASSERT_EQ(btree_search::node_lower_bound(keys.data(), n, key), lower) << "n=" << n;
+            ASSERT_EQ(btree_search::node_upper_bound(keys.data(), n, key), upper) << "n=" << n;
+            ASSERT_EQ(btree_search::branchless_bound<false>(keys.data(), n, key), lower) << "n=" << n;
+            ASSERT_EQ(btree_search::branchless_bound<true>(keys.data(), n, key), upper) << "n=" << n;
+        }
+    }
+}
+
+TEST(NodeSearchTest, Int32) {
+    check_bounds<int32_t>([](std::mt19937_64& r) { return static_cast<int32_t>(r() % 200) - 100; });
+    check_bounds<int32_t>([](std::mt19937_64& r) { return static_cast<int32_t>(r()); });
+}
+
+TEST(NodeSearchTest, UInt32) {
+    // 覆盖最高位为1的值, 验证无符号比较的符号位翻转
+    check_bounds<uint32_t>([](std::mt19937_64& r) { return static_cast<uint32_t>(r()); });
+    check_bounds<uint32_t>([](std::mt19937_64& r) {
+        return std::numeric_limits<uint32_t>::max() - static_cast<uint32_t>(r() % 50);
+    });
+}
+
+TEST(NodeSearchTest, Int64) {
+    check_bounds<int64_t>([](std::mt19937_64& r) { return static_cast<int64_t>(r()); });
+    check_bounds<int64_t>([](std::mt19937_64& r) { return static_cast<int64_t>(r() % 100) - 50; });
+}
+
+TEST(NodeSearchTest, UInt64) {
+    check_bounds<uint64_t>([](std::mt19937_64& r) { return r(); });
+}
+
+TEST(NodeSearchTest, FloatingPoint) {
+    check_bounds<float>([](std::mt19937_64& r) { return static_cast<float>(r() % 1000) / 8.0f - 60.0f; });
+    check_bounds<double>([](std::mt19937_64& r) { return static_cast<double>(r() % 1000) / 8.0 - 60.0; });
+}
+
+TEST(NodeSearchTest, FallbackTypes) {
+    check_bounds<int16_t>([](std::mt19937_64& r) { return static_cast<int16_t>(r()); });
+    check_bounds<std::string>([](std::mt19937_64& r) { return std::to_string(r() % 500); });
+}
+
+#ifdef BTREE_SEARCH_X86
+// 分别验证各个指令集的计数核心, 不依赖运行时选择的结果
+template <typename T>
+static void check_kernels(const std::vector<T>& keys, T key) {
+    int n = static_cast<int>(keys.size());
+    int lower = btree_search::scalar_count<false>(keys.data(), n, key);
+    int upper = btree_search::scalar_count<true>(keys.data(), n, key);
+    EXPECT_EQ(btree_search::sse2_count<false>(keys.data(), n, key), lower);
+    EXPECT_EQ(btree_search::sse2_count<true>(keys.data(), n, key), upper);
+    if (btree_search::cpu_has_avx2()) {
+        EXPECT_EQ(btree_search::avx2_count<false>(keys.data(), n, key), lower);
+        EXPECT_EQ(btree_search::avx2_count<true>(keys.data(), n, key), upper);
+    }
+}
+
+TEST(NodeSearchTest, KernelsAgree) {
+    std::vector<int32_t> i32;
+    std::vector<uint32_t> u32;
+    std::vector<int64_t> i64;
+    std::vector<uint64_t> u64;
+    std::vector<float> f32;
+    std::vector<double> f64;
+    for (int i = 0; i < 37; i++) {
+        i32.push_back(i * 3 - 50);
+        u32.push_back(0x7ffffff0u + static_cast<uint32_t>(i) * 2);
+        i64.push_back(static_cast<int64_t>(i) * 3 - 50);
+        u64.push_back(0x7ffffffffffffff0ull + static_cast<uint64_t>(i) * 2);
+        f32.push_back(static_cast<float>(i) * 0.5f - 3.0f);
+        f64.push_back(static_cast<double>(i) * 0.5 - 3.0);
+    }
+    for (int d = -2; d < 40; d++) {
+        check_kernels<int32_t>(i32, d * 3 - 51);
+        check_kernels<int32_t>(i32, d * 3 - 50);
+        check_kernels<uint32_t>(u32, 0x7ffffff0u + static_cast<uint32_t>(d) * 2);
+        check_kernels<int64_t>(i64, static_cast<int64_t>(d) * 3 - 50);
+        check_kernels<uint64_t>(u64, 0x7ffffffffffffff0ull + static_cast<uint64_t>(d) * 2 + 1);
+        check_kernels<float>(f32, static_cast<float>(d) * 0.5f - 3.0f);
+        check_kernels<double>(f64, static_cast<double>(d) * 0.5 - 3.25);
+    }
+}
+#endif
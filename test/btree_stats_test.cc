@@ -0,0 +1,78 @@
+#define BTREE_STATS 1
+#include <gtest/gtest.h>
+#include "../include/btree.h"
+#include "../include/btree_map.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+// 顺序插入: 每次分裂都在最右路径上, 根节点分裂时树高加一
+TEST(BTreeStatsTest, CountsStructuralEvents) {
+    BTree<int> tree(2);
+    for (int i = 0; i < 1000; i++)
+        tree.insert(i);
+    BTreeStats s = tree.stats();
+    EXPECT_TRUE(s.enabled);
+    EXPECT_EQ(s.size, 1000u);
+    EXPECT_EQ(s.root_grows + 1, s.height);
+    // 每次分裂多一个节点, 根节点分裂时再多一个新根
+    EXPECT_EQ(1 + s.splits + s.root_grows, s.nodes);
+    EXPECT_EQ(s.merges, 0u);
+
+    std::size_t histogram_total = 0;
+    for (std::size_t n : s.fill_histogram)
+        histogram_total += n;
+    EXPECT_EQ(histogram_total, s.nodes);
+    EXPECT_GT(s.bytes, s.nodes * sizeof(int));
+
+    for (int i = 0; i < 1000; i++)
+        tree.remove(i);
+    s = tree.stats();
+    EXPECT_GT(s.merges, 0u);
+    EXPECT_GT(s.borrows_next, 0u);
+    EXPECT_EQ(s.root_shrinks, s.root_grows);
+    EXPECT_EQ(s.height, 1u);
+    EXPECT_EQ(s.nodes, 1u);
+}
+
+TEST(BTreeStatsTest, CountsSearches) {
+    BTreeMap<int, std::string> map(16);
+    for (int i = 0; i < 10000; i++)
+        map.try_emplace(i, "v");
+    std::size_t height = map.stats().height;
+    for (int i = 0; i < 100; i++)
+        map.find(i * 7);
+    BTreeStats s = map.stats();
+    EXPECT_EQ(s.searches, 100u);
+    EXPECT_LE(s.search_nodes, 100 * height);
+    EXPECT_GT(s.comparisons_per_search(), 1.0);
+    EXPECT_LT(s.comparisons_per_search(), 7.0 * height);
+
+    std::string json = s.to_json();
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"searches\":100,"), std::string::npos);
+    EXPECT_NE(json.find("\"fill_histogram\":["), std::string::npos);
+}
+
+// 多个线程同时查找, 各自的计数在读取时加总
+TEST(BTreeStatsTest, PerThreadCountersAreAggregated) {
+    BTree<int> tree(8);
+    for (int i = 0; i < 5000; i++)
+        tree.insert(i);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; r++) {
+        readers.emplace_back([&tree] {
+            for (int i = 0; i < 2500; i++)
+                tree.contains(i * 2);
+        });
+    }
+    for (auto& th : readers)
+        th.join();
+    EXPECT_EQ(tree.stats().searches, 10000u);
+
+    // 移动后计数随树一起转移
+    BTree<int> moved = std::move(tree);
+    EXPECT_EQ(moved.stats().searches, 10000u);
+    EXPECT_EQ(moved.stats().size, 5000u);
+}
@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 #include "../include/btree.h"
 #include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <random>
+#include <set>
+#include <string>
+#include <thread>
 class BTreeTest : public ::testing::Test {
 protected:
     BTree<int> btree{3}; // 度数为3的B树
@@ -64,7 +70,7 @@ TEST_F(BTreeTest, RandomInsertionDeletionTest) {
     }
 
     // Verify the tree is empty
-    EXPECT_TRUE(btree.get_root() == nullptr || btree.get_root()->keys.empty());
+    EXPECT_TRUE(btree.get_root() == nullptr || btree.get_root()->num_keys() == 0);
 }
 
 TEST_F(BTreeTest, DeletionFromLeafTest) {
@@ -105,7 +111,7 @@ TEST_F(BTreeTest, SplitTest) {
         btree.insert(i);
         auto root = btree.get_root();
         ASSERT_TRUE(root != nullptr);
-        EXPECT_LE(root->keys.size(), 2 * btree.get_min_degree() - 1);
+        EXPECT_LE(root->num_keys(), 2 * btree.get_min_degree() - 1);
         
         // 验证插入的数是否存在
         auto result = btree.search(i);
@@ -131,4 +137,935 @@ TEST_F(BTreeTest, StressTest) {
         EXPECT_TRUE(result.has_value());
         EXPECT_EQ(result.value(), i);
     }
-}
\ No newline at end of file
+}
+TEST(BTreeLayoutTest, StringKeysTest) {
+    // 非平凡类型的键: 验证节点内联数组中键的构造/移动/析构
+    BTree<std::string> tree(2);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 200; i++) {
+        keys.push_back("key-" + std::to_string(i) + std::string(32, 'x'));
+    }
+    std::mt19937 g(42);
+    std::shuffle(keys.begin(), keys.end(), g);
+    for (const auto& k : keys) {
+        tree.insert(k);
+    }
+    for (const auto& k : keys) {
+        auto result = tree.search(k);
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ(result.value(), k);
+    }
+
+    std::shuffle(keys.begin(), keys.end(), g);
+    for (size_t i = 0; i < keys.size() / 2; i++) {
+        tree.remove(keys[i]);
+        EXPECT_FALSE(tree.search(keys[i]).has_value());
+    }
+    for (size_t i = keys.size() / 2; i < keys.size(); i++) {
+        EXPECT_TRUE(tree.search(keys[i]).has_value());
+    }
+}
+
+TEST(BTreeLayoutTest, MoveTest) {
+    BTree<int> a(3);
+    for (int i = 0; i < 100; i++) {
+        a.insert(i);
+    }
+    BTree<int> b(std::move(a));
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(b.search(i).has_value());
+    }
+    EXPECT_FALSE(a.search(1).has_value());
+
+    // 被移动后的树仍然可以继续使用
+    a.insert(7);
+    EXPECT_TRUE(a.search(7).has_value());
+
+    a = std::move(b);
+    EXPECT_TRUE(a.search(99).has_value());
+    EXPECT_FALSE(a.search(100).has_value());
+}
+
+TEST(NodeArenaTest, RecyclesFreedNodes) {
+    BTree<int> tree(3);
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 2000; i++) {
+            tree.insert(i);
+        }
+        for (int i = 0; i < 2000; i++) {
+            tree.remove(i);
+        }
+    }
+    size_t slabs = tree.get_allocator().slab_count();
+    // 再来一轮同样规模的插入/删除, 节点全部来自空闲链表, 不再申请新的slab
+    for (int i = 0; i < 2000; i++) {
+        tree.insert(i);
+    }
+    for (int i = 0; i < 2000; i++) {
+        tree.remove(i);
+    }
+    EXPECT_EQ(tree.get_allocator().slab_count(), slabs);
+}
+
+TEST(NodeArenaTest, SharedArenaAcrossTrees) {
+    NodeArena arena(4096);
+    {
+        std::vector<BTree<int, std::less<int>, NodeArenaRef>> trees;
+        for (int i = 0; i < 16; i++) {
+            trees.emplace_back(2, NodeArenaRef(arena));
+        }
+        for (int k = 0; k < 100; k++) {
+            for (size_t i = 0; i < trees.size(); i++) {
+                trees[i].insert(k * 16 + static_cast<int>(i));
+            }
+        }
+        for (size_t i = 0; i < trees.size(); i++) {
+            for (int k = 0; k < 100; k++) {
+                EXPECT_TRUE(trees[i].search(k * 16 + static_cast<int>(i)).has_value());
+                EXPECT_FALSE(trees[i].search(k * 16 + static_cast<int>(i) + 1).has_value());
+            }
+        }
+    }
+    EXPECT_GT(arena.slab_count(), 0u);
+
+    // 树析构时节点已归还给arena, 新树复用这些节点
+    size_t slabs = arena.slab_count();
+    BTree<int, std::less<int>, NodeArenaRef> tree(2, NodeArenaRef(arena));
+    for (int i = 0; i < 100; i++) {
+        tree.insert(i);
+    }
+    EXPECT_EQ(arena.slab_count(), slabs);
+}
+
+TEST(NodeArenaTest, HeapAllocatorTree) {
+    BTree<std::string, std::less<std::string>, HeapNodeAllocator> tree(3);
+    for (int i = 0; i < 300; i++) {
+        tree.insert(std::to_string(i));
+    }
+    for (int i = 0; i < 300; i += 2) {
+        tree.remove(std::to_string(i));
+    }
+    for (int i = 0; i < 300; i++) {
+        EXPECT_EQ(tree.search(std::to_string(i)).has_value(), i % 2 == 1);
+    }
+}
+
+TEST(BTreeCompareTest, CustomComparator) {
+    BTree<int, std::greater<int>> tree(2);
+    for (int i = 0; i < 100; i++) {
+        tree.insert(i);
+    }
+    EXPECT_EQ(tree.size(), 100u);
+    for (int i = 0; i < 100; i += 2) {
+        tree.remove(i);
+    }
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(tree.contains(i), i % 2 == 1);
+    }
+    EXPECT_EQ(tree.size(), 50u);
+}
+
+// 迭代器正反向遍历与 std::multiset 一致 (含重复键)
+TEST(BTreeIteratorTest, OrderedTraversalWithDuplicates) {
+    BTree<int> tree(2);
+    std::multiset<int> ref;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 3000; i++) {
+        int key = static_cast<int>(rng() % 500);
+        tree.insert(key);
+        ref.insert(key);
+    }
+    for (int i = 0; i < 500; i += 3) {
+        tree.remove(i);
+        auto it = ref.find(i);
+        if (it != ref.end())
+            ref.erase(it);
+    }
+
+    std::vector<int> forward(tree.begin(), tree.end());
+    EXPECT_EQ(forward, std::vector<int>(ref.begin(), ref.end()));
+
+    std::vector<int> backward;
+    for (auto it = tree.end(); it != tree.begin();) {
+        backward.push_back(*--it);
+    }
+    EXPECT_EQ(backward, std::vector<int>(ref.rbegin(), ref.rend()));
+
+    for (int key : {-1, 0, 1, 250, 499, 500}) {
+        auto lb = tree.lower_bound(key);
+        auto ub = tree.upper_bound(key);
+        EXPECT_EQ(std::distance(tree.begin(), lb), std::distance(ref.begin(), ref.lower_bound(key)));
+        EXPECT_EQ(std::distance(lb, ub), static_cast<long>(ref.count(key)));
+    }
+}
+
+TEST(BTreeIteratorTest, ScanClosedRange) {
+    BTree<int> tree(3);
+    for (int i = 0; i < 1000; i++) {
+        tree.insert(i);
+    }
+    std::vector<int> seen;
+    tree.scan(100, 199, [&](int key) { seen.push_back(key); });
+    ASSERT_EQ(seen.size(), 100u);
+    EXPECT_EQ(seen.front(), 100);
+    EXPECT_EQ(seen.back(), 199);
+
+    // 回调返回 false 时提前结束
+    int visited = 0;
+    tree.scan(0, 999, [&](int) { return ++visited < 10; });
+    EXPECT_EQ(visited, 10);
+
+    BTree<int> empty(2);
+    EXPECT_TRUE(empty.begin() == empty.end());
+    empty.scan(0, 10, [&](int) { ADD_FAILURE(); });
+}
+
+TEST(BTreeBulkLoadTest, BuildsSortedTree) {
+    for (double fill : {0.5, 0.75, 1.0}) {
+        BTree<int> tree(3);
+        tree.insert(-1); // bulk_load 替换原有内容
+        std::vector<int> keys;
+        for (int i = 0; i < 5000; i++) {
+            keys.push_back(i / 3); // 允许重复键
+        }
+        tree.bulk_load(keys.begin(), keys.end(), fill);
+        EXPECT_EQ(tree.size(), keys.size());
+        EXPECT_EQ(std::vector<int>(tree.begin(), tree.end()), keys);
+        EXPECT_FALSE(tree.contains(-1));
+        EXPECT_LE(tree.get_root()->num_keys(), tree.get_max_keys());
+
+        // 构建后的树可以继续正常插入/删除
+        for (int i = 0; i < 2000; i++) {
+            tree.insert(i);
+            tree.remove(i / 3);
+        }
+        EXPECT_EQ(tree.size(), keys.size());
+    }
+}
+
+TEST(BTreeBulkLoadTest, MergeLoadKeepsAllKeys) {
+    BTree<int> tree(2);
+    std::multiset<int> ref;
+    for (int i = 0; i < 1000; i += 2) {
+        tree.insert(i);
+        ref.insert(i);
+    }
+    std::vector<int> batch;
+    for (int i = 0; i < 1500; i += 3) {
+        batch.push_back(i);
+        ref.insert(i);
+    }
+    tree.merge_load(batch.begin(), batch.end(), 0.7);
+    EXPECT_EQ(tree.size(), ref.size());
+    EXPECT_EQ(std::vector<int>(tree.begin(), tree.end()), std::vector<int>(ref.begin(), ref.end()));
+}
+
+TEST(BTreeBulkLoadTest, RejectsInvalidInput) {
+    BTree<int> tree(2);
+    std::vector<int> unsorted = {1, 3, 2};
+    EXPECT_THROW(tree.bulk_load(unsorted.begin(), unsorted.end()), std::invalid_argument);
+    std::vector<int> sorted = {1, 2, 3};
+    EXPECT_THROW(tree.bulk_load(sorted.begin(), sorted.end(), 0.0), std::invalid_argument);
+    EXPECT_THROW(tree.bulk_load(sorted.begin(), sorted.end(), 1.5), std::invalid_argument);
+}
+
+TEST(BTreeBatchTest, InsertAndSearchBatch) {
+    for (int t : {2, 5, 50}) {
+        BTree<int> tree(t);
+        std::multiset<int> ref;
+        std::mt19937 rng(t);
+        for (int round = 0; round < 20; round++) {
+            std::vector<int> batch(1000);
+            for (int& key : batch) {
+                key = static_cast<int>(rng() % 10000) - 5000; // 含负数和重复键
+            }
+            tree.insert_batch(batch.data(), batch.size());
+            ref.insert(batch.begin(), batch.end());
+            ASSERT_EQ(tree.size(), ref.size());
+
+            std::vector<int> queries(500);
+            for (int& key : queries) {
+                key = static_cast<int>(rng() % 12000) - 6000;
+            }
+            std::unique_ptr<bool[]> found(new bool[queries.size()]);
+            tree.search_batch(queries.data(), queries.size(), found.get());
+            for (size_t i = 0; i < queries.size(); i++) {
+                EXPECT_EQ(found[i], ref.count(queries[i]) > 0) << queries[i];
+            }
+        }
+        EXPECT_EQ(std::vector<int>(tree.begin(), tree.end()), std::vector<int>(ref.begin(), ref.end()));
+    }
+}
+
+TEST(BTreeBatchTest, StringKeys) {
+    BTree<std::string> tree(3);
+    std::vector<std::string> batch = {"pear", "apple", "fig", "apple", "kiwi"};
+    tree.insert_batch(batch.data(), batch.size());
+    std::vector<std::string> sorted(tree.begin(), tree.end());
+    EXPECT_EQ(sorted, (std::vector<std::string>{"apple", "apple", "fig", "kiwi", "pear"}));
+
+    std::vector<std::string> queries = {"fig", "grape", "pear"};
+    bool found[3];
+    tree.search_batch(queries.data(), queries.size(), found);
+    EXPECT_TRUE(found[0]);
+    EXPECT_FALSE(found[1]);
+    EXPECT_TRUE(found[2]);
+}
+
+// 静态索引的上下界与有序序列一致 (包括各种大小的不完全二叉树和重复键)
+TEST(BTreeStaticIndexTest, MatchesTreeBounds) {
+    std::mt19937 rng(11);
+    for (int n : {0, 1, 2, 3, 7, 8, 100, 1000, 4097}) {
+        BTree<int> tree(3);
+        std::vector<int> ref;
+        for (int i = 0; i < n; i++) {
+            int key = static_cast<int>(rng() % (2 * n + 1));
+            tree.insert(key);
+            ref.push_back(key);
+        }
+        std::sort(ref.begin(), ref.end());
+        StaticIndex<int> index = tree.build_static_index();
+        ASSERT_EQ(index.size(), ref.size());
+        for (int key = -1; key <= 2 * n + 1; key++) {
+            auto lo = std::lower_bound(ref.begin(), ref.end(), key);
+            auto hi = std::upper_bound(ref.begin(), ref.end(), key);
+            const int* lo_found = index.lower_bound(key);
+            const int* hi_found = index.upper_bound(key);
+            ASSERT_EQ(lo_found == nullptr, lo == ref.end()) << "n=" << n << " key=" << key;
+            ASSERT_EQ(hi_found == nullptr, hi == ref.end()) << "n=" << n << " key=" << key;
+            if (lo_found) {
+                EXPECT_EQ(*lo_found, *lo);
+            }
+            if (hi_found) {
+                EXPECT_EQ(*hi_found, *hi);
+            }
+            EXPECT_EQ(index.contains(key), lo != hi);
+        }
+    }
+}
+
+TEST(BTreeStaticIndexTest, StringKeysAndCustomCompare) {
+    BTree<std::string, std::greater<std::string>> tree(2);
+    for (const char* word : {"pear", "apple", "fig", "kiwi", "banana"})
+        tree.insert(word);
+    auto index = tree.build_static_index();
+    EXPECT_EQ(index.search("fig"), std::optional<std::string>("fig"));
+    EXPECT_FALSE(index.contains("grape"));
+    // 降序: 第一个 "<= grape" 的键
+    EXPECT_EQ(*index.lower_bound("grape"), "fig");
+    EXPECT_EQ(index.lower_bound("aardvark"), nullptr);
+
+    // 构建之后树的修改不影响索引
+    tree.insert("grape");
+    EXPECT_FALSE(index.contains("grape"));
+    StaticIndex<std::string, std::greater<std::string>> moved = std::move(index);
+    EXPECT_TRUE(moved.contains("pear"));
+    EXPECT_TRUE(index.empty());
+}
+
+// 透明比较器: 用 std::string_view / const char* 查找、删除和范围扫描, 不需要先构造 std::string
+TEST(BTreeHeterogeneousTest, StringViewLookup) {
+    BTree<std::string, std::less<>> tree(3);
+    std::set<std::string, std::less<>> ref;
+    std::mt19937 rng(13);
+    for (int i = 0; i < 3000; i++) {
+        std::string key = "key:" + std::to_string(rng() % 2000);
+        if (ref.insert(key).second)
+            tree.insert(key);
+    }
+    char buffer[] = "key:1234|key:77|key:none";
+    std::string_view packet(buffer);
+    for (std::string_view key : {packet.substr(0, 8), packet.substr(9, 6), packet.substr(16)}) {
+        bool present = ref.count(key) != 0;
+        EXPECT_EQ(tree.contains(key), present) << key;
+        EXPECT_EQ(tree.search(key).has_value(), present);
+        auto it = tree.lower_bound(key);
+        auto expected = ref.lower_bound(key);
+        if (expected == ref.end())
+            EXPECT_EQ(it, tree.end());
+        else
+            EXPECT_EQ(*it, *expected);
+    }
+    EXPECT_EQ(*tree.upper_bound(std::string_view("key:1")), *ref.upper_bound("key:1"));
+
+    std::vector<std::string> scanned;
+    tree.scan(std::string_view("key:10"), std::string_view("key:11"), [&](const std::string& k) { scanned.push_back(k); });
+    EXPECT_EQ(scanned, std::vector<std::string>(ref.lower_bound("key:10"), ref.upper_bound("key:11")));
+
+    // 删除一半的键
+    for (auto it = ref.begin(); it != ref.end();) {
+        tree.remove(std::string_view(*it));
+        it = ref.erase(it);
+        if (it != ref.end())
+            ++it;
+    }
+    EXPECT_EQ(tree.size(), ref.size());
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), ref.begin(), ref.end()));
+    EXPECT_FALSE(tree.contains("key:zzz"));
+}
+
+namespace {
+
+// 记录复制次数的键
+struct CopyCounted {
+    static inline int copies = 0;
+    int value;
+    explicit CopyCounted(int v) : value(v) {}
+    CopyCounted(const CopyCounted& other) : value(other.value) { copies++; }
+    CopyCounted(CopyCounted&&) noexcept = default;
+    CopyCounted& operator=(const CopyCounted& other) {
+        value = other.value;
+        copies++;
+        return *this;
+    }
+    CopyCounted& operator=(CopyCounted&&) noexcept = default;
+};
+
+struct CopyCountedLess {
+    using is_transparent = void;
+    bool operator()(const CopyCounted& a, const CopyCounted& b) const { return a.value < b.value; }
+    bool operator()(const CopyCounted& a, int b) const { return a.value < b; }
+    bool operator()(int a, const CopyCounted& b) const { return a < b.value; }
+};
+
+} // namespace
+
+// 右值插入和 emplace 在整个下降和分裂过程中不复制键; 用 int 查找不构造键
+TEST(BTreeHeterogeneousTest, MoveInsertAndEmplaceDoNotCopy) {
+    BTree<CopyCounted, CopyCountedLess> tree(2);
+    CopyCounted::copies = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 2)
+            tree.insert(CopyCounted((i * 37) % 1000));
+        else
+            tree.emplace((i * 37) % 1000);
+    }
+    EXPECT_EQ(CopyCounted::copies, 0);
+    EXPECT_EQ(tree.size(), 1000u);
+    EXPECT_TRUE(tree.contains(500));
+    EXPECT_FALSE(tree.contains(1000));
+    EXPECT_EQ(tree.lower_bound(998).key().value, 998);
+    tree.remove(500);
+    EXPECT_FALSE(tree.contains(500));
+    int expected = 0;
+    for (const CopyCounted& key : tree) {
+        if (expected == 500)
+            expected++;
+        EXPECT_EQ(key.value, expected++);
+    }
+}
+
+// 随机插入/删除 (大量重复键), 每轮与 std::multiset 对照;
+// 覆盖删除时前驱/后继替换、借键、合并以及在同一次下降中连续合并的情况
+TEST(BTreeRemoveTest, RandomWithDuplicatesMatchesMultiset) {
+    std::mt19937 rng(17);
+    for (int t : {2, 3, 5}) {
+        BTree<int> tree(t);
+        std::multiset<int> ref;
+        for (int round = 0; round < 20; round++) {
+            for (int i = 0; i < 400; i++) {
+                int key = static_cast<int>(rng() % 300);
+                tree.insert(key);
+                ref.insert(key);
+            }
+            for (int i = 0; i < 380; i++) {
+                int key = static_cast<int>(rng() % 320);
+                tree.remove(key);
+                auto it = ref.find(key);
+                if (it != ref.end())
+                    ref.erase(it);
+            }
+            ASSERT_EQ(tree.size(), ref.size()) << "t=" << t << " round=" << round;
+            ASSERT_TRUE(std::equal(tree.begin(), tree.end(), ref.begin(), ref.end())) << "t=" << t;
+        }
+        for (int key = 0; key < 300; key++) {
+            while (ref.count(key)) {
+                tree.remove(key);
+                ref.erase(ref.find(key));
+            }
+            EXPECT_FALSE(tree.contains(key));
+        }
+        EXPECT_TRUE(tree.empty());
+        EXPECT_EQ(tree.get_root()->num_keys(), 0);
+        EXPECT_TRUE(tree.get_root()->is_leaf());
+    }
+}
+
+// 顺序统计: 随机插入/删除/批量插入之后, rank/select/count_range 与有序数组一致
+TEST(BTreeOrderStatisticTest, RankSelectCountRange) {
+    std::mt19937 rng(19);
+    for (int t : {2, 3, 8}) {
+        BTree<int, std::less<int>, NodeArena, OrderStatistic> tree(t);
+        std::multiset<int> ref;
+        for (int round = 0; round < 8; round++) {
+            for (int i = 0; i < 500; i++) {
+                int key = static_cast<int>(rng() % 1000);
+                tree.insert(key);
+                ref.insert(key);
+            }
+            std::vector<int> batch(200);
+            for (int& key : batch)
+                key = static_cast<int>(rng() % 1000);
+            tree.insert_batch(batch.data(), batch.size());
+            ref.insert(batch.begin(), batch.end());
+            for (int i = 0; i < 450; i++) {
+                int key = static_cast<int>(rng() % 1000);
+                tree.remove(key);
+                auto it = ref.find(key);
+                if (it != ref.end())
+                    ref.erase(it);
+            }
+
+            std::vector<int> sorted(ref.begin(), ref.end());
+            ASSERT_EQ(tree.size(), sorted.size());
+            for (int key = -1; key <= 1000; key += 7) {
+                auto lo = std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+                ASSERT_EQ(tree.rank(key), static_cast<std::size_t>(lo)) << "t=" << t << " key=" << key;
+            }
+            for (std::size_t k = 0; k < sorted.size(); k += 13) {
+                auto it = tree.select(k);
+                ASSERT_NE(it, tree.end());
+                ASSERT_EQ(*it, sorted[k]) << "t=" << t << " k=" << k;
+            }
+            EXPECT_EQ(tree.select(sorted.size()), tree.end());
+            // select 返回的迭代器可以继续向后遍历
+            std::vector<int> tail(tree.select(sorted.size() / 2), tree.end());
+            EXPECT_TRUE(std::equal(tail.begin(), tail.end(), sorted.begin() + sorted.size() / 2, sorted.end()));
+
+            for (int i = 0; i < 50; i++) {
+                int a = static_cast<int>(rng() % 1000), b = static_cast<int>(rng() % 1000);
+                auto expected = a <= b ? std::upper_bound(sorted.begin(), sorted.end(), b) -
+                                             std::lower_bound(sorted.begin(), sorted.end(), a)
+                                       : 0;
+                ASSERT_EQ(tree.count_range(a, b), static_cast<std::size_t>(expected));
+            }
+        }
+    }
+}
+
+// 批量构建、合并构建和移动之后计数仍然正确
+TEST(BTreeOrderStatisticTest, BulkLoadAndMap) {
+    BTree<int, std::less<int>, NodeArena, OrderStatistic> tree(4);
+    std::vector<int> keys(10000);
+    std::iota(keys.begin(), keys.end(), 0);
+    tree.bulk_load(keys.begin(), keys.end(), 0.7);
+    EXPECT_EQ(tree.rank(5000), 5000u);
+    EXPECT_EQ(*tree.select(9999), 9999);
+    std::vector<int> more = {-5, 100, 20000};
+    tree.merge_load(more.begin(), more.end());
+    auto moved = std::move(tree);
+    EXPECT_EQ(moved.rank(101), 103u);
+    EXPECT_EQ(moved.count_range(0, 100), 102u);
+    EXPECT_EQ(*moved.select(moved.size() - 1), 20000);
+    // p99
+    EXPECT_EQ(*moved.select(moved.size() * 99 / 100), 9900);
+}
+
+// 区间聚合: 随机插入/批量插入/删除 (含重复键) 之后与逐个累加的结果对照
+TEST(BTreeAggregateTest, ReduceMatchesBruteForce) {
+    std::mt19937 rng(23);
+    for (int t : {2, 3, 8}) {
+        BTree<int, std::less<int>, NodeArena, SumOf<long long>> sums(t);
+        BTree<int, std::less<int>, NodeArena, MinOf<int>> mins(t);
+        std::multiset<int> ref;
+        for (int round = 0; round < 6; round++) {
+            for (int i = 0; i < 500; i++) {
+                int key = static_cast<int>(rng() % 2000) - 1000;
+                sums.insert(key);
+                mins.insert(key);
+                ref.insert(key);
+            }
+            std::vector<int> batch(200);
+            for (int& key : batch)
+                key = static_cast<int>(rng() % 2000) - 1000;
+            sums.insert_batch(batch.data(), batch.size());
+            mins.insert_batch(batch.data(), batch.size());
+            ref.insert(batch.begin(), batch.end());
+            for (int i = 0; i < 450; i++) {
+                int key = static_cast<int>(rng() % 2000) - 1000;
+                sums.remove(key);
+                mins.remove(key);
+                auto it = ref.find(key);
+                if (it != ref.end())
+                    ref.erase(it);
+            }
+
+            EXPECT_EQ(sums.aggregate(), std::accumulate(ref.begin(), ref.end(), 0LL));
+            for (int i = 0; i < 60; i++) {
+                int a = static_cast<int>(rng() % 2200) - 1100, b = static_cast<int>(rng() % 2200) - 1100;
+                long long sum = 0;
+                int min = std::numeric_limits<int>::max();
+                if (a <= b) {
+                    for (auto it = ref.lower_bound(a); it != ref.upper_bound(b); ++it) {
+                        sum += *it;
+                        min = std::min(min, *it);
+                    }
+                }
+                ASSERT_EQ(sums.reduce(a, b), sum) << "t=" << t << " [" << a << ", " << b << "]";
+                ASSERT_EQ(mins.reduce(a, b), min) << "t=" << t << " [" << a << ", " << b << "]";
+            }
+            // 聚合树同样支持 rank
+            EXPECT_EQ(sums.rank(0), static_cast<std::size_t>(std::distance(ref.begin(), ref.lower_bound(0))));
+        }
+    }
+}
+
+// 批量构建与移动之后聚合值仍然正确
+TEST(BTreeAggregateTest, BulkLoadAndMove) {
+    BTree<int, std::less<int>, NodeArena, MaxOf<int>> tree(4);
+    std::vector<int> keys(10000);
+    std::iota(keys.begin(), keys.end(), 0);
+    tree.bulk_load(keys.begin(), keys.end(), 0.7);
+    EXPECT_EQ(tree.reduce(100, 5000), 5000);
+    EXPECT_EQ(tree.reduce(20000, 30000), std::numeric_limits<int>::lowest());
+    auto moved = std::move(tree);
+    moved.insert(20000);
+    EXPECT_EQ(moved.aggregate(), 20000);
+    EXPECT_EQ(moved.reduce(-5, 9998), 9998);
+    EXPECT_EQ(moved.reduce(7, 3), std::numeric_limits<int>::lowest());
+}
+
+// 默认不打开 BTREE_STATS: 没有事件计数, 结构信息仍然可用
+TEST(BTreeStatsTest, StructureWithoutCounters) {
+    BTree<int> tree(3);
+    for (int i = 0; i < 500; i++)
+        tree.insert(i);
+    tree.contains(42);
+    BTreeStats s = tree.stats();
+    EXPECT_EQ(s.enabled, BTREE_STATS != 0);
+    if (!s.enabled) {
+        EXPECT_EQ(s.splits, 0u);
+        EXPECT_EQ(s.searches, 0u);
+    }
+    EXPECT_EQ(s.size, 500u);
+    EXPECT_GE(s.height, 2u);
+    EXPECT_GT(s.nodes, s.leaves);
+}
+
+// 编译期度数: 与运行时度数的 BTree 执行相同的操作, 结构 (节点数、高度) 和内容都一致
+TEST(BTreeFixedDegreeTest, MatchesRuntimeDegree) {
+    std::mt19937 rng(24);
+    FixedBTree<int, 3> fixed;
+    BTree<int> runtime(3);
+    for (int round = 0; round < 10; round++) {
+        std::vector<int> batch(200);
+        for (int& key : batch)
+            key = static_cast<int>(rng() % 2000);
+        fixed.insert_batch(batch.data(), batch.size());
+        runtime.insert_batch(batch.data(), batch.size());
+        for (int i = 0; i < 500; i++) {
+            int key = static_cast<int>(rng() % 2000);
+            if (rng() % 2) {
+                fixed.insert(key);
+                runtime.insert(key);
+            } else {
+                fixed.remove(key);
+                runtime.remove(key);
+            }
+        }
+        ASSERT_EQ(fixed.size(), runtime.size());
+        ASSERT_TRUE(std::equal(fixed.begin(), fixed.end(), runtime.begin(), runtime.end()));
+        BTreeStats a = fixed.stats(), b = runtime.stats();
+        EXPECT_EQ(a.nodes, b.nodes);
+        EXPECT_EQ(a.height, b.height);
+        EXPECT_EQ(a.bytes, b.bytes);
+    }
+
+    FixedBTree<int, 3> moved(std::move(fixed));
+    EXPECT_EQ(moved.size(), runtime.size());
+    EXPECT_EQ(moved.get_max_keys(), 5);
+    EXPECT_THROW((FixedBTree<int, 3>(4)), std::invalid_argument);
+    EXPECT_NO_THROW((FixedBTree<int, 3>(3)));
+}
+
+TEST(BTreeFixedDegreeTest, DegreeFromNodeBytes) {
+    // 叶子: 8 字节节点头 + (2t-1) 个键
+    static_assert(degree_for_node_bytes<int>(256) == 31);
+    static_assert(degree_for_node_bytes<int64_t>(4096) == 256);
+    static_assert(degree_for_node_bytes<int64_t>(16) == 2);
+
+    CacheSizedBTree<int64_t, 256> tree;
+    EXPECT_EQ(tree.get_min_degree(), 16);
+    for (int64_t i = 0; i < 10000; i++)
+        tree.insert(i * 7 % 10000);
+    EXPECT_EQ(tree.size(), 10000u);
+    for (int64_t i = 0; i < 10000; i++)
+        ASSERT_TRUE(tree.contains(i));
+}
+
+namespace {
+
+template <typename Tree>
+std::vector<int> contents(const Tree& tree) {
+    return std::vector<int>(tree.begin(), tree.end());
+}
+
+} // namespace
+
+// 拆分后两边的内容与按 key 划分的结果相同; 原树先析构, 返回的树仍然可用 (节点所在的 slab 被共同持有)
+TEST(BTreeJoinSplitTest, SplitMatchesPartition) {
+    std::mt19937 rng(25);
+    for (int t : {2, 3, 16}) {
+        std::vector<int> keys(5000);
+        for (int& key : keys)
+            key = static_cast<int>(rng() % 3000);
+        std::vector<int> sorted = keys;
+        std::sort(sorted.begin(), sorted.end());
+        for (int pivot : {-1, 0, 1, 777, 1500, 2999, 5000}) {
+            auto tree = std::make_unique<BTree<int>>(t);
+            tree->insert_batch(keys.data(), keys.size());
+            BTree<int> right = tree->split_at(pivot);
+            auto mid = std::lower_bound(sorted.begin(), sorted.end(), pivot);
+            ASSERT_TRUE(tree->validate()) << t << " " << pivot;
+            ASSERT_TRUE(right.validate()) << t << " " << pivot;
+            EXPECT_EQ(contents(*tree), std::vector<int>(sorted.begin(), mid));
+            EXPECT_EQ(contents(right), std::vector<int>(mid, sorted.end()));
+            EXPECT_EQ(right.size(), static_cast<std::size_t>(sorted.end() - mid));
+
+            tree.reset();
+            for (int i = 0; i < 200; i++) {
+                int key = static_cast<int>(rng() % 3000);
+                if (i % 2)
+                    right.insert(key);
+                else
+                    right.remove(key);
+            }
+            ASSERT_TRUE(right.validate());
+        }
+    }
+}
+
+// 高度不同的树从两个方向拼接, 包括空树
+TEST(BTreeJoinSplitTest, JoinAndMergeWith) {
+    for (int t : {2, 5}) {
+        for (int left_n : {0, 1, 10, 3000}) {
+            for (int right_n : {0, 1, 50, 4000}) {
+                BTree<int> left(t), right(t);
+                std::vector<int> expect;
+                for (int i = 0; i < left_n; i++) {
+                    left.insert(i);
+                    expect.push_back(i);
+                }
+                expect.push_back(left_n);
+                for (int i = 0; i < right_n; i++) {
+                    right.insert(left_n + 1 + i);
+                    expect.push_back(left_n + 1 + i);
+                }
+                BTree<int> joined = BTree<int>::join(std::move(left), left_n, std::move(right));
+                ASSERT_TRUE(joined.validate()) << t << " " << left_n << " " << right_n;
+                EXPECT_EQ(contents(joined), expect);
+                EXPECT_EQ(joined.size(), expect.size());
+                EXPECT_TRUE(right.empty());
+
+                // 拆开再用 merge_with 从另一个方向合并回去
+                BTree<int> upper = joined.split_at(left_n / 2);
+                upper.merge_with(std::move(joined));
+                ASSERT_TRUE(upper.validate()) << t << " " << left_n << " " << right_n;
+                EXPECT_EQ(contents(upper), expect);
+                EXPECT_TRUE(joined.empty());
+                for (int key : expect)
+                    upper.remove(key);
+                EXPECT_TRUE(upper.empty());
+            }
+        }
+    }
+
+    // 反复拆分再合并回去
+    BTree<int, std::less<int>, NodeArena, OrderStatistic> tree(3);
+    for (int i = 0; i < 10000; i++)
+        tree.insert(i);
+    std::mt19937 rng(25);
+    for (int i = 0; i < 2000; i++) {
+        auto upper = tree.split_at(static_cast<int>(rng() % 10001));
+        if (i % 2) {
+            tree.merge_with(std::move(upper));
+        } else {
+            upper.merge_with(std::move(tree));
+            tree = std::move(upper);
+        }
+    }
+    ASSERT_TRUE(tree.validate());
+    EXPECT_EQ(tree.size(), 10000u);
+    EXPECT_EQ(tree.rank(5000), 5000u);
+
+    BTree<int> a(3), b(3), c(4);
+    for (int i = 0; i < 100; i++) {
+        a.insert(i);
+        b.insert(i + 50);
+        c.insert(i + 1000);
+    }
+    EXPECT_THROW(a.merge_with(std::move(b)), std::invalid_argument);
+    EXPECT_EQ(a.size(), 100u);
+    EXPECT_EQ(b.size(), 100u);
+    EXPECT_THROW(a.merge_with(std::move(c)), std::invalid_argument);
+    EXPECT_THROW(BTree<int>::join(std::move(a), 10, BTree<int>(3)), std::invalid_argument);
+
+    // NodeArenaRef 只能在引用同一个 arena 的树之间转移节点
+    NodeArena arena1, arena2;
+    BTree<int, std::less<int>, NodeArenaRef> x(2, NodeArenaRef(arena1)), y(2, NodeArenaRef(arena2)),
+        z(2, NodeArenaRef(arena1));
+    for (int i = 0; i < 100; i++) {
+        x.insert(i);
+        y.insert(i + 100);
+        z.insert(i + 200);
+    }
+    EXPECT_THROW(x.merge_with(std::move(y)), std::invalid_argument);
+    x.merge_with(std::move(z));
+    EXPECT_EQ(x.size(), 200u);
+    ASSERT_TRUE(x.validate());
+}
+
+// NoAugment 的树拆分后不数键数: 之后的插入/删除/拼接照常进行, 第一次 size() 时得到正确的键数
+TEST(BTreeJoinSplitTest, SizeAfterSplitWithoutCounts) {
+    std::mt19937 rng(28);
+    BTree<int> tree(3);
+    std::set<int> expect;
+    for (int i = 0; i < 10000; i++) {
+        tree.insert(i);
+        expect.insert(i);
+    }
+    for (int round = 0; round < 500; round++) {
+        BTree<int> upper = tree.split_at(static_cast<int>(rng() % 10001));
+        for (int i = 0; i < 10; i++) {
+            int key = static_cast<int>(rng() % 10000);
+            BTree<int>& side = upper.empty() || (!tree.empty() && key < *upper.begin()) ? tree : upper;
+            if (i % 2) {
+                if (expect.insert(key).second)
+                    side.insert(key);
+            } else if (side.contains(key)) {
+                side.remove(key);
+                expect.erase(key);
+            }
+        }
+        if (round % 2) {
+            tree.merge_with(std::move(upper));
+        } else {
+            upper.merge_with(std::move(tree));
+            tree = std::move(upper);
+        }
+    }
+    EXPECT_EQ(tree.size(), expect.size());
+    ASSERT_TRUE(tree.validate());
+    EXPECT_EQ(contents(tree), std::vector<int>(expect.begin(), expect.end()));
+
+    BTree<int> upper = tree.split_at(20000);
+    EXPECT_TRUE(upper.empty());
+    EXPECT_EQ(upper.size(), 0u);
+    EXPECT_EQ(tree.size(), expect.size());
+    upper = tree.split_at(-1);
+    EXPECT_TRUE(tree.empty());
+    EXPECT_FALSE(upper.empty());
+    EXPECT_EQ(upper.size(), expect.size());
+}
+
+// 拆分后键数未知的树: 多个线程同时调用 const 的 size() 得到相同的结果 (在 TSan 下没有数据竞争)
+TEST(BTreeJoinSplitTest, ConcurrentSizeAfterSplit) {
+    BTree<int> tree(4);
+    for (int i = 0; i < 50000; i++)
+        tree.insert(i);
+    for (int round = 0; round < 20; round++) {
+        int pivot = round * 2500;
+        BTree<int> upper = tree.split_at(pivot);
+        const BTree<int>& lower = tree;
+        const BTree<int>& higher = upper;
+        std::vector<std::thread> threads;
+        std::vector<std::size_t> sizes(8);
+        for (int i = 0; i < 8; i++)
+            threads.emplace_back([&, i] { sizes[i] = i % 2 ? lower.size() : higher.size(); });
+        for (auto& th : threads)
+            th.join();
+        for (int i = 0; i < 8; i++)
+            EXPECT_EQ(sizes[i], static_cast<std::size_t>(i % 2 ? pivot : 50000 - pivot));
+        tree.merge_with(std::move(upper));
+    }
+    EXPECT_EQ(tree.size(), 50000u);
+    ASSERT_TRUE(tree.validate());
+}
+
+// 拆分/拼接之后子树计数和聚合值仍然正确
+TEST(BTreeJoinSplitTest, KeepsAugmentation) {
+    std::mt19937 rng(26);
+    for (int t : {2, 4}) {
+        BTree<int, std::less<int>, NodeArena, OrderStatistic> ranks(t);
+        BTree<int, std::less<int>, NodeArena, SumOf<long long>> sums(t);
+        std::vector<int> keys(4000);
+        for (int& key : keys)
+            key = static_cast<int>(rng() % 10000);
+        ranks.insert_batch(keys.data(), keys.size());
+        sums.insert_batch(keys.data(), keys.size());
+        std::sort(keys.begin(), keys.end());
+
+        auto ranks_hi = ranks.split_at(6000);
+        auto sums_hi = sums.split_at(6000);
+        std::size_t below = std::lower_bound(keys.begin(), keys.end(), 6000) - keys.begin();
+        ASSERT_TRUE(ranks.validate());
+        ASSERT_TRUE(ranks_hi.validate());
+        EXPECT_EQ(ranks.size(), below);
+        EXPECT_EQ(ranks_hi.rank(8000), std::lower_bound(keys.begin(), keys.end(), 8000) - keys.begin() - below);
+        EXPECT_EQ(*ranks_hi.select(0), keys[below]);
+        EXPECT_EQ(sums.aggregate(), std::accumulate(keys.begin(), keys.begin() + below, 0LL));
+        EXPECT_EQ(sums_hi.reduce(7000, 9000), sums_hi.reduce(7000, 9000));
+        long long expect = 0;
+        for (int key : keys)
+            if (key >= 7000 && key <= 9000)
+                expect += key;
+        EXPECT_EQ(sums_hi.reduce(7000, 9000), expect);
+
+        ranks.merge_with(std::move(ranks_hi));
+        sums = decltype(sums)::join(std::move(sums), 6000, std::move(sums_hi));
+        ASSERT_TRUE(ranks.validate());
+        ASSERT_TRUE(sums.validate());
+        EXPECT_EQ(ranks.size(), keys.size());
+        for (std::size_t k = 0; k < keys.size(); k += 97)
+            ASSERT_EQ(*ranks.select(k), keys[k]);
+        EXPECT_EQ(sums.aggregate(), std::accumulate(keys.begin(), keys.end(), 0LL) + 6000);
+    }
+}
+
+// 并行构建的结果与排序后 bulk_load 相同 (键和节点结构都相同)
+TEST(BTreeParallelBuildTest, MatchesSequentialBulkLoad) {
+    std::mt19937 rng(27);
+    for (int n : {0, 1, 100, 100000}) {
+        std::vector<int> keys(n);
+        for (int& key : keys)
+            key = static_cast<int>(rng() % (n + 1));
+        std::vector<int> sorted = keys;
+        std::sort(sorted.begin(), sorted.end());
+        for (double fill : {1.0, 0.7}) {
+            BTree<int> expect(3);
+            expect.bulk_load(sorted.begin(), sorted.end(), fill);
+            for (unsigned threads : {1u, 2u, 3u, 8u}) {
+                BTree<int> tree(3);
+                tree.insert(-5);
+                tree.bulk_load_parallel(keys, threads, fill);
+                ASSERT_TRUE(tree.validate()) << n << " " << threads;
+                ASSERT_EQ(contents(tree), sorted);
+                BTreeStats a = tree.stats(), b = expect.stats();
+                EXPECT_EQ(a.nodes, b.nodes);
+                EXPECT_EQ(a.height, b.height);
+            }
+        }
+    }
+
+    // 构建之后可以继续修改; 没有 fork() 的分配器退回顺序构建
+    std::vector<int> keys(50000);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    BTree<int, std::less<int>, NodeArena, OrderStatistic> counted(4);
+    counted.bulk_load_parallel(keys, 4);
+    NodeArena arena;
+    BTree<int, std::less<int>, NodeArenaRef> shared(4, NodeArenaRef(arena));
+    shared.bulk_load_parallel(keys, 4);
+    BTree<int, std::less<int>, HeapNodeAllocator> heap(4);
+    heap.bulk_load_parallel(keys, 4);
+    for (int i = 0; i < 50000; i += 3) {
+        counted.remove(i);
+        shared.remove(i);
+        heap.remove(i);
+    }
+    ASSERT_TRUE(counted.validate());
+    ASSERT_TRUE(shared.validate());
+    ASSERT_TRUE(heap.validate());
+    EXPECT_EQ(counted.rank(30000), 20000u);
+    EXPECT_EQ(contents(shared), contents(heap));
+}
@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+#include "../include/compressed_btree.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 带公共前缀的 URL 键
+std::string url_key(std::mt19937& rng) {
+    static const char* hosts[] = {"https://example.com/", "https://example.com/api/v1/", "https://example.org/"};
+    std::string key = hosts[rng() % 3];
+    key += "item/" + std::to_string(rng() % 5000);
+    if (rng() % 4 == 0)
+        key += "/detail";
+    return key;
+}
+
+template <typename Tree, typename T>
+std::vector<T> keys_of(const Tree& tree) {
+    std::vector<T> keys;
+    tree.for_each([&](const T& key) { keys.push_back(key); });
+    return keys;
+}
+
+} // namespace
+
+// 随机插入/删除, 与 std::set 对照 (前缀在两端插入时缩短, 分裂后变长)
+TEST(CompressedBTreeTest, PrefixKeysMatchSet) {
+    std::mt19937 rng(11);
+    for (int t : {2, 3, 16}) {
+        PrefixBTree tree(t);
+        std::set<std::string> ref;
+        for (int i = 0; i < 6000; i++) {
+            std::string key = url_key(rng);
+            if (rng() % 4 == 0) {
+                EXPECT_EQ(tree.erase(key), ref.erase(key) == 1);
+            } else {
+                EXPECT_EQ(tree.insert(key), ref.insert(key).second);
+            }
+        }
+        ASSERT_TRUE(tree.check_invariants());
+        EXPECT_EQ(tree.size(), ref.size());
+        EXPECT_EQ((keys_of<PrefixBTree, std::string>(tree)), std::vector<std::string>(ref.begin(), ref.end()));
+        for (int i = 0; i < 2000; i++) {
+            std::string key = url_key(rng);
+            EXPECT_EQ(tree.contains(key), ref.count(key) == 1) << key;
+        }
+        // 不以块前缀开头、比所有键都小/大的键
+        EXPECT_FALSE(tree.contains(""));
+        EXPECT_FALSE(tree.contains("https://"));
+        EXPECT_FALSE(tree.contains("zzz"));
+
+        std::vector<std::string> scanned;
+        tree.scan("https://example.com/api", "https://example.com/b",
+                  [&](const std::string& key) { scanned.push_back(key); });
+        std::vector<std::string> expected(ref.lower_bound("https://example.com/api"),
+                                          ref.upper_bound("https://example.com/b"));
+        EXPECT_EQ(scanned, expected);
+    }
+}
+
+// 空串, 互为前缀的键, 以及字节值大于 0x7f 的字符
+TEST(CompressedBTreeTest, PrefixKeysEdgeCases) {
+    PrefixBTree tree(2);
+    std::set<std::string> ref;
+    std::vector<std::string> keys = {"", "a", "aa", "aaa", "ab", "a\xff", "\x80", "b", "ba", "aab", "aaaa"};
+    for (const auto& key : keys) {
+        EXPECT_TRUE(tree.insert(key));
+        ref.insert(key);
+        ASSERT_TRUE(tree.check_invariants()) << key;
+    }
+    EXPECT_FALSE(tree.insert("aa"));
+    EXPECT_EQ((keys_of<PrefixBTree, std::string>(tree)), std::vector<std::string>(ref.begin(), ref.end()));
+    for (const auto& key : keys) {
+        EXPECT_TRUE(tree.contains(key));
+        EXPECT_TRUE(tree.erase(key));
+        EXPECT_FALSE(tree.contains(key));
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_TRUE(tree.check_invariants());
+}
+
+// 整数键: 负数、跨度超过 32 位的键, 以及倒序插入 (每次都更换 base)
+TEST(CompressedBTreeTest, DeltaKeysMatchSet) {
+    std::mt19937_64 rng(5);
+    for (int t : {2, 4, 32}) {
+        DeltaBTree<int64_t> tree(t);
+        std::set<int64_t> ref;
+        for (int i = 0; i < 8000; i++) {
+            int64_t key;
+            switch (i % 3) {
+            case 0:
+                key = static_cast<int64_t>(rng() % 100000) - 50000;
+                break;
+            case 1:
+                key = static_cast<int64_t>(rng());
+                break;
+            default:
+                key = 1000000 - i;
+            }
+            if (rng() % 5 == 0) {
+                EXPECT_EQ(tree.erase(key), ref.erase(key) == 1);
+            } else {
+                EXPECT_EQ(tree.insert(key), ref.insert(key).second);
+            }
+        }
+        ASSERT_TRUE(tree.check_invariants());
+        EXPECT_EQ((keys_of<DeltaBTree<int64_t>, int64_t>(tree)), std::vector<int64_t>(ref.begin(), ref.end()));
+        for (int64_t key : {INT64_MIN, INT64_MAX, int64_t(0), int64_t(-50000), int64_t(999999)})
+            EXPECT_EQ(tree.contains(key), ref.count(key) == 1);
+
+        std::vector<int64_t> scanned;
+        tree.scan(-100, 100, [&](int64_t key) {
+            scanned.push_back(key);
+            return scanned.size() < 10;
+        });
+        std::vector<int64_t> expected(ref.lower_bound(-100), ref.upper_bound(100));
+        if (expected.size() > 10)
+            expected.resize(10);
+        EXPECT_EQ(scanned, expected);
+    }
+}
+
+// 反复插入后全部删除: 叶子借键/合并, 空出的节点被释放, 树高收缩, 键占用的字节回到空树的大小
+TEST(CompressedBTreeTest, EraseRebalancesAndFreesLeaves) {
+    std::mt19937_64 rng(15);
+    for (int t : {2, 3, 16}) {
+        DeltaBTree<long> tree(t);
+        const std::size_t empty_bytes = tree.key_bytes();
+        for (int round = 0; round < 4; round++) {
+            std::vector<long> keys;
+            for (int i = 0; i < 20000; i++) {
+                long key = static_cast<long>(rng() % 1000000);
+                if (tree.insert(key))
+                    keys.push_back(key);
+            }
+            std::shuffle(keys.begin(), keys.end(), rng);
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                ASSERT_TRUE(tree.erase(keys[i]));
+                if (i % 4999 == 0) {
+                    ASSERT_TRUE(tree.check_invariants()) << t << " " << i;
+                }
+            }
+            EXPECT_TRUE(tree.empty());
+            EXPECT_TRUE(tree.check_invariants());
+            EXPECT_EQ(tree.key_bytes(), empty_bytes);
+            EXPECT_TRUE(tree.begin() == tree.end());
+        }
+    }
+
+    PrefixBTree urls(2);
+    std::mt19937 srng(16);
+    std::set<std::string> ref;
+    for (int i = 0; i < 3000; i++) {
+        std::string key = url_key(srng);
+        urls.insert(key);
+        ref.insert(key);
+    }
+    for (const std::string& key : ref) {
+        ASSERT_TRUE(urls.erase(key));
+        if (urls.size() % 500 == 0) {
+            ASSERT_TRUE(urls.check_invariants());
+        }
+    }
+    EXPECT_TRUE(urls.empty());
+    EXPECT_TRUE(urls.check_invariants());
+}
+
+// 迭代器、lower_bound/upper_bound 与 std::set 一致; 移动赋值
+TEST(CompressedBTreeTest, IteratorsAndBounds) {
+    std::mt19937 rng(17);
+    PrefixBTree tree(3);
+    std::set<std::string> ref;
+    for (int i = 0; i < 4000; i++) {
+        std::string key = url_key(rng);
+        if (rng() % 3 == 0) {
+            tree.erase(key);
+            ref.erase(key);
+        } else {
+            tree.insert(key);
+            ref.insert(key);
+        }
+    }
+    EXPECT_EQ(std::vector<std::string>(tree.begin(), tree.end()), std::vector<std::string>(ref.begin(), ref.end()));
+    std::vector<std::string> backward;
+    for (auto it = tree.end(); it != tree.begin();)
+        backward.push_back(*--it);
+    EXPECT_EQ(backward, std::vector<std::string>(ref.rbegin(), ref.rend()));
+
+    for (int i = 0; i < 2000; i++) {
+        std::string key = url_key(rng);
+        if (i % 5 == 0)
+            key.pop_back();
+        auto lo = tree.lower_bound(key);
+        auto hi = tree.upper_bound(key);
+        auto rlo = ref.lower_bound(key);
+        auto rhi = ref.upper_bound(key);
+        if (rlo == ref.end()) {
+            EXPECT_TRUE(lo == tree.end()) << key;
+        } else {
+            ASSERT_TRUE(lo != tree.end()) << key;
+            EXPECT_EQ(*lo, *rlo);
+        }
+        if (rhi == ref.end()) {
+            EXPECT_TRUE(hi == tree.end()) << key;
+        } else {
+            ASSERT_TRUE(hi != tree.end()) << key;
+            EXPECT_EQ(*hi, *rhi);
+        }
+    }
+    EXPECT_TRUE(tree.lower_bound("zzz") == tree.end());
+    EXPECT_EQ(*tree.lower_bound(""), *ref.begin());
+
+    DeltaBTree<int> numbers(2);
+    for (int i = 0; i < 100; i++)
+        numbers.insert(i * 10);
+    DeltaBTree<int> other(4);
+    other.insert(7);
+    other = std::move(numbers);
+    EXPECT_EQ(other.size(), 100u);
+    EXPECT_EQ(*other.lower_bound(15), 20);
+    EXPECT_EQ(*other.upper_bound(20), 30);
+    EXPECT_TRUE(other.upper_bound(990) == other.end());
+    EXPECT_TRUE(other.check_invariants());
+    EXPECT_TRUE(numbers.empty());
+    EXPECT_FALSE(numbers.contains(10));
+    EXPECT_TRUE(numbers.check_invariants());
+}
+
+// 稠密整数键每个只占 1 个字节的差值
+TEST(CompressedBTreeTest, DenseIntegersUseNarrowDeltas) {
+    DeltaBTree<uint32_t> tree(64);
+    for (uint32_t i = 0; i < 100000; i++)
+        tree.insert(4000000000u + i * 3);
+    EXPECT_TRUE(tree.check_invariants());
+    EXPECT_LT(tree.key_bytes(), tree.size() * 2);
+    EXPECT_TRUE(tree.contains(4000000000u + 300));
+    EXPECT_FALSE(tree.contains(4000000000u + 301));
+
+    btree_detail::DeltaKeys<int> block;
+    block.insert(0, 10);
+    block.insert(1, 200);
+    EXPECT_EQ(block.delta_width(), 1);
+    block.insert(2, 70000);
+    EXPECT_EQ(block.delta_width(), 4);
+    block.erase(2);
+    block.insert(0, -10);
+    EXPECT_EQ(block.key(0), -10);
+    EXPECT_EQ(block.lower_bound(11), 2);
+    EXPECT_EQ(block.lower_bound(-100), 0);
+    EXPECT_EQ(block.lower_bound(201), 3);
+}
+
+// 叶子分裂产生截断后的路由键
+TEST(CompressedBTreeTest, SeparatorsAreTruncated) {
+    btree_detail::PrefixKeys left, right;
+    left.insert(0, "user:1001");
+    left.insert(1, "user:1077");
+    right.insert(0, "user:2001");
+    right.insert(1, "user:2002");
+    EXPECT_EQ(btree_detail::PrefixKeys::separator(left, right), "user:2");
+
+    PrefixBTree tree(2);
+    for (const char* key : {"user:1001", "user:1077", "user:2001", "user:2002"})
+        tree.insert(key);
+    EXPECT_TRUE(tree.check_invariants());
+    EXPECT_TRUE(tree.contains("user:2001"));
+    EXPECT_FALSE(tree.contains("user:2"));
+}
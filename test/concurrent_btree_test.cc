@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include "../include/concurrent_btree.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+// 单线程下与 std::multiset 一致 (允许重复键)
+TEST(ConcurrentBTreeTest, SequentialMatchesMultiset) {
+    for (int t : {2, 3, 8}) {
+        ConcurrentBTree<int> tree(t);
+        std::multiset<int> ref;
+        std::mt19937 rng(t);
+        for (int i = 0; i < 20000; i++) {
+            int key = static_cast<int>(rng() % 2000);
+            int op = static_cast<int>(rng() % 3);
+            if (op == 0) {
+                tree.insert(key);
+                ref.insert(key);
+            } else if (op == 1) {
+                auto it = ref.find(key);
+                bool present = it != ref.end();
+                if (present)
+                    ref.erase(it);
+                EXPECT_EQ(tree.remove(key), present);
+            } else {
+                EXPECT_EQ(tree.contains(key), ref.count(key) > 0);
+            }
+        }
+        EXPECT_TRUE(tree.check_invariants());
+        EXPECT_EQ(tree.size(), ref.size());
+        std::vector<int> keys;
+        tree.for_each([&](int key) { keys.push_back(key); });
+        EXPECT_EQ(keys, std::vector<int>(ref.begin(), ref.end()));
+    }
+}
+
+TEST(ConcurrentBTreeTest, ParallelDisjointInserts) {
+    ConcurrentBTree<long> tree(4);
+    const int kThreads = 4;
+    const long kPerThread = 5000;
+    std::vector<std::thread> threads;
+    for (int id = 0; id < kThreads; id++) {
+        threads.emplace_back([&, id] {
+            for (long i = 0; i < kPerThread; i++) {
+                tree.insert(i * kThreads + id);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_TRUE(tree.check_invariants());
+    EXPECT_EQ(tree.size(), static_cast<size_t>(kThreads * kPerThread));
+    long expected = 0;
+    tree.for_each([&](long key) { EXPECT_EQ(key, expected++); });
+}
+
+// 多个写线程在重叠的键上随机插入/删除: 分裂和补足之后会放开锁再继续下降, 期间其他线程可能改变当前节点的键范围,
+// 没有重新验证时键会落到错误的子树里 (结构检查失败或遍历结果无序)。每轮的内容必须等于各线程净插入次数之和
+TEST(ConcurrentBTreeTest, RandomMultiWriterStress) {
+    const int kThreads = 8;
+    const int kOps = 20000;
+    for (int round = 0; round < 30; round++) {
+        ConcurrentBTree<int> tree(2);
+        std::vector<std::map<int, long>> net(kThreads);
+        std::vector<std::thread> threads;
+        for (int id = 0; id < kThreads; id++) {
+            threads.emplace_back([&, id] {
+                std::mt19937 rng(round * kThreads + id);
+                for (int i = 0; i < kOps; i++) {
+                    int key = static_cast<int>(rng() % 50000);
+                    if (rng() % 3 == 0) {
+                        if (tree.remove(key))
+                            net[id][key]--;
+                    } else {
+                        tree.insert(key);
+                        net[id][key]++;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::map<int, long> total;
+        for (const auto& mine : net) {
+            for (const auto& [key, delta] : mine)
+                total[key] += delta;
+        }
+        std::vector<int> expected;
+        for (const auto& [key, copies] : total) {
+            ASSERT_GE(copies, 0) << "key " << key;
+            expected.insert(expected.end(), copies, key);
+        }
+        std::vector<int> keys;
+        tree.for_each([&](int key) { keys.push_back(key); });
+        ASSERT_TRUE(tree.check_invariants()) << "round " << round;
+        ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end())) << "round " << round;
+        ASSERT_EQ(keys, expected) << "round " << round;
+        EXPECT_EQ(tree.size(), expected.size());
+    }
+}
+
+// 写线程各自插入/删除自己的键, 读线程同时查找一组永远不会被删除的键, 必须每次都能找到
+TEST(ConcurrentBTreeTest, ReadersSeeStableKeysDuringWrites) {
+    for (int t : {2, 8}) {
+        ConcurrentBTree<long> tree(t);
+        const long kStable = 500;
+        for (long i = 0; i < kStable; i++) {
+            tree.insert(i * 1000);
+        }
+
+        std::atomic<bool> stop{false};
+        std::atomic<long> errors{0};
+        std::vector<std::thread> threads;
+        for (int id = 0; id < 3; id++) {
+            threads.emplace_back([&, id] {
+                std::mt19937 rng(id);
+                std::multiset<long> mine;
+                for (int i = 0; i < 10000; i++) {
+                    long key = static_cast<long>(rng() % 3000) * 1000 + id + 1;
+                    if (rng() % 2) {
+                        tree.insert(key);
+                        mine.insert(key);
+                    } else {
+                        auto it = mine.find(key);
+                        bool present = it != mine.end();
+                        if (present)
+                            mine.erase(it);
+                        if (tree.remove(key) != present)
+                            errors++;
+                    }
+                }
+                for (long key : mine) {
+                    if (!tree.remove(key))
+                        errors++;
+                }
+            });
+        }
+        std::thread reader([&] {
+            std::mt19937 rng(42);
+            while (!stop.load()) {
+                if (!tree.contains(static_cast<long>(rng() % kStable) * 1000))
+                    errors++;
+            }
+        });
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        stop = true;
+        reader.join();
+
+        EXPECT_EQ(errors.load(), 0);
+        EXPECT_TRUE(tree.check_invariants());
+        EXPECT_EQ(tree.size(), static_cast<size_t>(kStable));
+    }
+}
+
+// 小范围键上高频插入/删除, 不断触发合并与根收缩, 读线程同时下降;
+// 被摘除的节点由纪元回收释放, 用 -DBTREE_SANITIZE=address/thread 构建时可以检查 use-after-free 和数据竞争
+TEST(ConcurrentBTreeTest, ReclamationStress) {
+    ConcurrentBTree<int> tree(2);
+    const int kWriters = 4;
+    std::atomic<bool> stop{false};
+    std::atomic<long> net{0};
+    std::vector<std::thread> threads;
+    for (int id = 0; id < kWriters; id++) {
+        threads.emplace_back([&, id] {
+            std::mt19937 rng(id);
+            long mine = 0;
+            for (int i = 0; i < 30000; i++) {
+                int key = static_cast<int>(rng() % 256);
+                if (rng() % 2) {
+                    tree.insert(key);
+                    mine++;
+                } else if (tree.remove(key)) {
+                    mine--;
+                }
+            }
+            net += mine;
+        });
+    }
+    std::atomic<long> hits{0};
+    for (int id = 0; id < 2; id++) {
+        threads.emplace_back([&, id] {
+            std::mt19937 rng(100 + id);
+            while (!stop.load()) {
+                if (tree.contains(static_cast<int>(rng() % 256)))
+                    hits++;
+            }
+        });
+    }
+    for (int id = 0; id < kWriters; id++) {
+        threads[id].join();
+    }
+    stop = true;
+    for (std::size_t i = kWriters; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    EXPECT_TRUE(tree.check_invariants());
+    EXPECT_EQ(static_cast<long>(tree.size()), net.load());
+    long remaining = 0;
+    tree.for_each([&](int) { remaining++; });
+    EXPECT_EQ(remaining, net.load());
+}
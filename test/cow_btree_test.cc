@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../include/cow_btree.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 随机插入/删除, 途中不断打开快照; 每个快照必须一直等于打开时的内容
+TEST(CowBTreeTest, SnapshotsKeepPointInTimeContents) {
+    for (int t : {2, 3, 8}) {
+        CowBTree<int> tree(t);
+        std::multiset<int> ref;
+        std::vector<std::pair<CowBTree<int>::Snapshot, std::multiset<int>>> snapshots;
+        std::mt19937 rng(t);
+        for (int i = 0; i < 20000; i++) {
+            int key = static_cast<int>(rng() % 500);
+            if (rng() % 2) {
+                tree.insert(key);
+                ref.insert(key);
+            } else {
+                auto it = ref.find(key);
+                bool present = it != ref.end();
+                if (present)
+                    ref.erase(it);
+                EXPECT_EQ(tree.remove(key), present);
+            }
+            if (i % 1000 == 0) {
+                snapshots.emplace_back(tree.snapshot(), ref);
+            }
+        }
+        EXPECT_TRUE(tree.check_invariants());
+        EXPECT_TRUE(std::equal(tree.begin(), tree.end(), ref.begin(), ref.end()));
+        for (auto& [snapshot, expected] : snapshots) {
+            EXPECT_TRUE(snapshot.check_invariants());
+            EXPECT_EQ(snapshot.size(), expected.size());
+            EXPECT_TRUE(std::equal(snapshot.begin(), snapshot.end(), expected.begin(), expected.end()));
+            for (int key = 0; key < 500; key += 7) {
+                EXPECT_EQ(snapshot.contains(key), expected.count(key) > 0);
+                auto it = snapshot.lower_bound(key);
+                auto rit = expected.lower_bound(key);
+                ASSERT_EQ(it == snapshot.end(), rit == expected.end());
+                if (rit != expected.end()) {
+                    EXPECT_EQ(*it, *rit);
+                }
+            }
+        }
+    }
+}
+
+// 快照比树活得更久, 拷贝出的快照与原快照相互独立
+TEST(CowBTreeTest, SnapshotOutlivesTree) {
+    std::vector<std::string> expected;
+    CowBTree<std::string>::Snapshot copy = [&] {
+        CowBTree<std::string> tree(3);
+        for (int i = 0; i < 1000; i++) {
+            tree.insert(std::to_string(i));
+            expected.push_back(std::to_string(i));
+        }
+        auto snapshot = tree.snapshot();
+        for (int i = 0; i < 1000; i += 2)
+            tree.remove(std::to_string(i));
+        EXPECT_EQ(tree.size(), 500u);
+        return snapshot;
+    }();
+    std::sort(expected.begin(), expected.end());
+    EXPECT_TRUE(std::equal(copy.begin(), copy.end(), expected.begin(), expected.end()));
+
+    auto other = copy;
+    copy = CowBTree<std::string>::Snapshot(std::move(other));
+    EXPECT_EQ(copy.size(), 1000u);
+    EXPECT_TRUE(copy.contains("998"));
+}
+
+// 写线程持续修改并发布快照, 读线程在各自的快照上做完整遍历
+TEST(CowBTreeTest, ReadersScanSnapshotsWhileWriting) {
+    CowBTree<long> tree(4);
+    std::mutex published_mutex;
+    CowBTree<long>::Snapshot published = tree.snapshot();
+    std::atomic<bool> stop{false};
+    std::atomic<long> errors{0};
+
+    std::vector<std::thread> readers;
+    for (int id = 0; id < 2; id++) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                CowBTree<long>::Snapshot snapshot = [&] {
+                    std::lock_guard<std::mutex> guard(published_mutex);
+                    return published;
+                }();
+                std::size_t n = 0;
+                long prev = -1;
+                for (long key : snapshot) {
+                    if (key < prev)
+                        errors++;
+                    prev = key;
+                    n++;
+                }
+                if (n != snapshot.size())
+                    errors++;
+            }
+        });
+    }
+
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; i++) {
+        long key = static_cast<long>(rng() % 4000);
+        if (rng() % 3)
+            tree.insert(key);
+        else
+            tree.remove(key);
+        if (i % 100 == 0) {
+            auto snapshot = tree.snapshot();
+            std::lock_guard<std::mutex> guard(published_mutex);
+            published = std::move(snapshot);
+        }
+    }
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_TRUE(tree.check_invariants());
+}
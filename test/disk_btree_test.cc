@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "../include/disk_btree.h"
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 每个测试使用自己的临时文件, 结束时删除
+struct TempFile {
+    std::string path;
+    explicit TempFile(const std::string& name) : path(::testing::TempDir() + name) { std::remove(path.c_str()); }
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+} // namespace
+
+// 缓存池容量小于页数时, 被替换的脏页必须写回, 之后能重新读回
+TEST(BufferPoolTest, EvictsAndWritesBack) {
+    TempFile file("buffer_pool_test.db");
+    Pager pager(file.path, 512);
+    BufferPool pool(pager, 4);
+    for (int i = 0; i < 32; i++) {
+        auto page = pool.create(pager.allocate());
+        std::snprintf(page.data(), 512, "page %d", i);
+    }
+    EXPECT_GT(pool.stats().evictions, 0u);
+    for (int i = 31; i >= 0; i--) {
+        auto page = pool.fetch(static_cast<Pager::PageId>(i));
+        EXPECT_EQ(std::string(page.data()), "page " + std::to_string(i));
+    }
+
+    // 所有帧都被钉住时无法再取页
+    std::vector<BufferPool::PageRef> pinned;
+    for (int i = 0; i < 4; i++)
+        pinned.push_back(pool.fetch(static_cast<Pager::PageId>(i)));
+    EXPECT_THROW(pool.fetch(10), std::runtime_error);
+    pinned.pop_back();
+    EXPECT_NO_THROW(pool.fetch(10));
+}
+
+// 小页(最小度数小) + 小缓存池, 随机操作与 std::multiset 一致
+TEST(DiskBTreeTest, MatchesMultisetWithSmallPool) {
+    TempFile file("disk_btree_ops.db");
+    DiskBTree<int>::Options options;
+    options.page_size = 512;
+    options.pool_pages = 8;
+    options.min_degree = 3;
+    DiskBTree<int> tree(file.path, options);
+    EXPECT_EQ(tree.get_min_degree(), 3);
+
+    std::multiset<int> ref;
+    std::mt19937 rng(1);
+    for (int i = 0; i < 20000; i++) {
+        int key = static_cast<int>(rng() % 2000);
+        int op = static_cast<int>(rng() % 3);
+        if (op == 0) {
+            tree.insert(key);
+            ref.insert(key);
+        } else if (op == 1) {
+            auto it = ref.find(key);
+            bool present = it != ref.end();
+            if (present)
+                ref.erase(it);
+            EXPECT_EQ(tree.remove(key), present);
+        } else {
+            EXPECT_EQ(tree.contains(key), ref.count(key) > 0);
+        }
+    }
+    EXPECT_TRUE(tree.check_invariants());
+    EXPECT_EQ(tree.size(), ref.size());
+    std::vector<int> keys;
+    tree.for_each([&](int key) { keys.push_back(key); });
+    EXPECT_EQ(keys, std::vector<int>(ref.begin(), ref.end()));
+    EXPECT_GT(tree.pool_stats().evictions, 0u);
+}
+
+// 关闭后重新打开内容不变; 删除释放的页在之后的插入中被复用
+TEST(DiskBTreeTest, PersistsAcrossReopenAndReusesPages) {
+    TempFile file("disk_btree_reopen.db");
+    DiskBTree<long>::Options options;
+    options.page_size = 1024;
+    options.pool_pages = 16;
+    std::size_t pages;
+    {
+        DiskBTree<long> tree(file.path, options);
+        for (long i = 0; i < 50000; i++)
+            tree.insert(i * 3);
+        pages = tree.page_count();
+    }
+    {
+        DiskBTree<long> tree(file.path, options);
+        EXPECT_EQ(tree.size(), 50000u);
+        EXPECT_TRUE(tree.check_invariants());
+        EXPECT_TRUE(tree.contains(3 * 12345));
+        EXPECT_FALSE(tree.contains(3 * 12345 + 1));
+        for (long i = 0; i < 50000; i += 2)
+            EXPECT_TRUE(tree.remove(i * 3));
+        for (long i = 0; i < 50000; i += 2)
+            tree.insert(i * 3);
+        EXPECT_LE(tree.page_count(), pages);
+        EXPECT_TRUE(tree.check_invariants());
+    }
+    DiskBTree<long> tree(file.path, options);
+    EXPECT_EQ(tree.size(), 50000u);
+    long expected = 0;
+    tree.for_each([&](long key) {
+        EXPECT_EQ(key, expected);
+        expected += 3;
+    });
+}
+
+TEST(DiskBTreeTest, RejectsMismatchedFiles) {
+    TempFile file("disk_btree_mismatch.db");
+    {
+        DiskBTree<int> tree(file.path);
+        tree.insert(1);
+    }
+    DiskBTree<int>::Options other_page;
+    other_page.page_size = 8192;
+    EXPECT_THROW(DiskBTree<int>(file.path, other_page), std::runtime_error);
+    EXPECT_THROW(DiskBTree<long>(file.path), std::runtime_error);
+
+    DiskBTree<int>::Options bad;
+    bad.page_size = 1000;
+    EXPECT_THROW(DiskBTree<int>(file.path, bad), std::invalid_argument);
+    bad.page_size = 4096;
+    bad.pool_pages = 2;
+    EXPECT_THROW(DiskBTree<int>(file.path, bad), std::invalid_argument);
+}
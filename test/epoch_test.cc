@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "../include/epoch.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+std::atomic<int> freed{0};
+
+void count_free(void* p) {
+    delete static_cast<int*>(p);
+    freed++;
+}
+
+} // namespace
+
+// 其他线程处于临界区时, 之后废弃的对象不能被释放; 离开临界区后才能回收
+TEST(EpochTest, RetiredObjectsWaitForPinnedReaders) {
+    freed = 0;
+    EpochManager epochs;
+    std::atomic<bool> pinned{false}, release{false};
+    std::thread reader([&] {
+        auto guard = epochs.pin();
+        pinned = true;
+        while (!release)
+            std::this_thread::yield();
+    });
+    while (!pinned)
+        std::this_thread::yield();
+
+    for (int i = 0; i < 200; i++)
+        epochs.retire(new int(i), count_free);
+    for (int i = 0; i < 10; i++)
+        epochs.collect();
+    EXPECT_EQ(freed, 0);
+    EXPECT_EQ(epochs.pending(), 200u);
+
+    release = true;
+    reader.join();
+    for (int i = 0; i < 3; i++)
+        epochs.collect();
+    EXPECT_EQ(freed, 200);
+    EXPECT_EQ(epochs.pending(), 0u);
+}
+
+// 没有读者时按批释放, 待回收列表不会无限增长; 析构时释放剩余对象
+TEST(EpochTest, BatchedReclaimAndDestructor) {
+    freed = 0;
+    {
+        EpochManager epochs;
+        for (int i = 0; i < 10000; i++) {
+            auto guard = epochs.pin();
+            auto nested = epochs.pin();
+            epochs.retire(new int(i), count_free);
+            EXPECT_LT(epochs.pending(), 256u);
+        }
+        EXPECT_GT(freed, 9000);
+    }
+    EXPECT_EQ(freed, 10000);
+}
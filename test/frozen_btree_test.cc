@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "../include/btree.h"
+#include "../include/frozen_btree.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TempFile {
+    std::string path;
+    explicit TempFile(const std::string& name) : path(::testing::TempDir() + name) { std::remove(path.c_str()); }
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+} // namespace
+
+// 不同大小和节点键数下, 查找/上下界/范围扫描与有序数组一致 (包含重复键)
+TEST(FrozenBTreeTest, MatchesSortedKeys) {
+    TempFile file("frozen_match.idx");
+    std::mt19937 rng(3);
+    for (int node_keys : {0, 2, 3, 7}) {
+        for (int n : {0, 1, 2, 5, 9, 100, 1000, 20000}) {
+            BTree<int> tree(3);
+            std::vector<int> ref;
+            for (int i = 0; i < n; i++) {
+                int key = static_cast<int>(rng() % (2 * n + 1));
+                tree.insert(key);
+                ref.push_back(key);
+            }
+            std::sort(ref.begin(), ref.end());
+            tree.freeze(file.path, node_keys);
+
+            FrozenBTree<int> frozen(file.path);
+            ASSERT_EQ(frozen.size(), ref.size());
+            EXPECT_TRUE(std::equal(frozen.begin(), frozen.end(), ref.begin(), ref.end()));
+            for (int key = -1; key <= 2 * n + 1; key++) {
+                auto lo = std::lower_bound(ref.begin(), ref.end(), key) - ref.begin();
+                auto hi = std::upper_bound(ref.begin(), ref.end(), key) - ref.begin();
+                ASSERT_EQ(frozen.lower_bound(key) - frozen.begin(), lo) << "n=" << n << " key=" << key;
+                ASSERT_EQ(frozen.upper_bound(key) - frozen.begin(), hi) << "n=" << n << " key=" << key;
+                EXPECT_EQ(frozen.contains(key), lo != hi);
+            }
+
+            std::vector<int> scanned;
+            frozen.scan(n / 4, n / 2, [&](int key) { scanned.push_back(key); });
+            std::vector<int> expected(std::lower_bound(ref.begin(), ref.end(), n / 4),
+                                      std::upper_bound(ref.begin(), ref.end(), n / 2));
+            EXPECT_EQ(scanned, expected);
+        }
+    }
+}
+
+TEST(FrozenBTreeTest, ScanStopsEarlyAndCustomCompare) {
+    TempFile file("frozen_desc.idx");
+    BTree<long, std::greater<long>> tree(4);
+    for (long i = 0; i < 5000; i++)
+        tree.insert(i);
+    tree.freeze(file.path);
+
+    FrozenBTree<long, std::greater<long>> frozen(file.path);
+    EXPECT_EQ(*frozen.begin(), 4999);
+    EXPECT_EQ(frozen[4999], 0);
+    EXPECT_EQ(frozen.search(1234), std::optional<long>(1234));
+    EXPECT_FALSE(frozen.contains(5000));
+
+    std::vector<long> seen;
+    frozen.scan(3000, 0, [&](long key) {
+        seen.push_back(key);
+        return seen.size() < 3;
+    });
+    EXPECT_EQ(seen, (std::vector<long>{3000, 2999, 2998}));
+}
+
+// 重新 freeze 到同一路径是 rename 替换: 已打开的视图继续看到旧内容
+TEST(FrozenBTreeTest, ReplacingFileKeepsOpenViews) {
+    TempFile file("frozen_replace.idx");
+    BTree<int> tree(8);
+    for (int i = 0; i < 1000; i++)
+        tree.insert(i);
+    tree.freeze(file.path);
+    FrozenBTree<int> old_view(file.path);
+
+    for (int i = 1000; i < 3000; i++)
+        tree.insert(i);
+    tree.freeze(file.path);
+    FrozenBTree<int> new_view(file.path);
+
+    EXPECT_EQ(old_view.size(), 1000u);
+    EXPECT_FALSE(old_view.contains(2000));
+    EXPECT_EQ(new_view.size(), 3000u);
+    EXPECT_TRUE(new_view.contains(2000));
+
+    FrozenBTree<int> moved(std::move(new_view));
+    EXPECT_TRUE(moved.contains(2999));
+    EXPECT_TRUE(new_view.empty());
+}
+
+TEST(FrozenBTreeTest, RejectsInvalidFiles) {
+    TempFile file("frozen_bad.idx");
+    EXPECT_THROW(FrozenBTree<int>(file.path), std::system_error);
+    {
+        std::ofstream out(file.path);
+        out << "definitely not a frozen tree, but long enough to hold a header............................";
+    }
+    EXPECT_THROW(FrozenBTree<int>(file.path), std::runtime_error);
+
+    BTree<int> tree(3);
+    for (int i = 0; i < 10000; i++)
+        tree.insert(i);
+    tree.freeze(file.path);
+    EXPECT_THROW(FrozenBTree<long>(file.path), std::runtime_error);
+
+    // 截断的文件
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size() / 2));
+    }
+    EXPECT_THROW(FrozenBTree<int>(file.path), std::runtime_error);
+}
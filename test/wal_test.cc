@@ -0,0 +1,318 @@
+#include <gtest/gtest.h>
+#include "../include/disk_btree.h"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// 数据文件和日志文件, 测试开始和结束时删除
+struct TempTree {
+    std::string path;
+    explicit TempTree(const std::string& name) : path(::testing::TempDir() + name) { remove_files(); }
+    ~TempTree() { remove_files(); }
+    std::string wal_path() const { return path + "-wal"; }
+    void remove_files() {
+        std::remove(path.c_str());
+        std::remove(wal_path().c_str());
+    }
+};
+
+DiskBTree<int>::Options small_options(std::size_t checkpoint_bytes) {
+    DiskBTree<int>::Options options;
+    options.page_size = 512;
+    options.pool_pages = 32;
+    options.min_degree = 3;
+    options.wal = true;
+    options.checkpoint_bytes = checkpoint_bytes;
+    return options;
+}
+
+// 第 i 个操作: 2/3 插入, 1/3 删除
+struct Op {
+    bool insert;
+    int key;
+};
+
+std::vector<Op> make_ops(unsigned seed, int count) {
+    std::mt19937 rng(seed);
+    std::vector<Op> ops;
+    for (int i = 0; i < count; i++) {
+        int key = static_cast<int>(rng() % 1000);
+        ops.push_back({rng() % 3 != 0, key});
+    }
+    return ops;
+}
+
+// 执行前 k 个操作之后的内容
+std::vector<int> expected_after(const std::vector<Op>& ops, std::size_t k) {
+    std::multiset<int> ref;
+    for (std::size_t i = 0; i < k && i < ops.size(); i++) {
+        if (ops[i].insert) {
+            ref.insert(ops[i].key);
+        } else {
+            auto it = ref.find(ops[i].key);
+            if (it != ref.end())
+                ref.erase(it);
+        }
+    }
+    return std::vector<int>(ref.begin(), ref.end());
+}
+
+// 子进程执行操作, 每个操作返回 (日志已刷盘) 后把已完成的个数写入管道;
+// 父进程读到 kill_after 之后 SIGKILL 子进程, 再读完管道中剩下的计数
+std::size_t run_and_kill(const std::string& path, const DiskBTree<int>::Options& options,
+                         const std::vector<Op>& ops, std::size_t kill_after) {
+    int fds[2];
+    if (::pipe(fds) != 0)
+        return 0;
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(fds[0]);
+        DiskBTree<int> tree(path, options);
+        for (std::size_t i = 0; i < ops.size(); i++) {
+            if (ops[i].insert)
+                tree.insert(ops[i].key);
+            else
+                tree.remove(ops[i].key);
+            uint32_t done = static_cast<uint32_t>(i + 1);
+            if (::write(fds[1], &done, sizeof(done)) != sizeof(done))
+                ::_exit(2);
+        }
+        ::pause();
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+    uint32_t acked = 0, value;
+    while (acked < kill_after && ::read(fds[0], &value, sizeof(value)) == sizeof(value))
+        acked = value;
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    while (::read(fds[0], &value, sizeof(value)) == sizeof(value))
+        acked = value;
+    ::close(fds[0]);
+    return acked;
+}
+
+} // namespace
+
+TEST(WriteAheadLogTest, ReadsBackRecordsAndStopsAtTornTail) {
+    TempTree file("wal_records.log");
+    {
+        WriteAheadLog wal(file.path, SyncMode::PerBatch);
+        EXPECT_TRUE(wal.read_all().empty());
+        for (int i = 0; i < 100; i++)
+            wal.append(WriteAheadLog::RecordType::Insert, &i, sizeof(i));
+        wal.sync();
+    }
+    {
+        // 模拟写了一半的记录
+        std::ofstream out(file.path, std::ios::binary | std::ios::app);
+        out.write("\x20\x00\x00\x00garbage", 11);
+    }
+    WriteAheadLog wal(file.path, SyncMode::PerOp);
+    auto records = wal.read_all();
+    ASSERT_EQ(records.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        int key;
+        std::memcpy(&key, records[i].payload.data(), sizeof(key));
+        EXPECT_EQ(key, i);
+        EXPECT_EQ(records[i].lsn, static_cast<uint64_t>(i + 1));
+    }
+    // 新记录接在最后一条完整记录之后
+    int key = 100;
+    wal.wait_durable(wal.append(WriteAheadLog::RecordType::Insert, &key, sizeof(key)));
+    WriteAheadLog reopened(file.path, SyncMode::PerOp);
+    EXPECT_EQ(reopened.read_all().size(), 101u);
+}
+
+// group commit: 所有线程都追加完之后才开始等待, 第一个等待的线程一次刷盘带上全部记录, 其余线程不再 fdatasync
+TEST(WriteAheadLogTest, GroupCommitSharesOneSync) {
+    TempTree file("wal_group_commit.log");
+    WriteAheadLog wal(file.path, SyncMode::PerOp);
+    constexpr int kThreads = 8;
+    std::atomic<int> appended{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            uint64_t lsn = wal.append(WriteAheadLog::RecordType::Insert, &t, sizeof(t));
+            appended++;
+            while (appended.load() < kThreads)
+                std::this_thread::yield();
+            wal.wait_durable(lsn);
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    EXPECT_EQ(wal.sync_count(), 1u);
+
+    WriteAheadLog reopened(file.path, SyncMode::PerOp);
+    EXPECT_EQ(reopened.read_all().size(), static_cast<std::size_t>(kThreads));
+}
+
+// 刷盘失败 (这里用文件大小上限让 pwrite 返回 EFBIG) 时记录留在缓冲区, 放开限制后重试, 文件中没有空洞
+TEST(WriteAheadLogTest, FailedFlushKeepsRecordsForRetry) {
+    TempTree file("wal_retry.log");
+    std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit saved;
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &saved), 0);
+    char payload[100] = {};
+    {
+        WriteAheadLog wal(file.path, SyncMode::PerBatch);
+        for (int i = 0; i < 10; i++)
+            wal.append(WriteAheadLog::RecordType::Insert, payload, sizeof(payload));
+        wal.sync();
+        std::size_t synced = wal.size_bytes();
+
+        struct rlimit limit = saved;
+        limit.rlim_cur = synced + 50;
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0);
+        for (int i = 0; i < 10; i++)
+            wal.append(WriteAheadLog::RecordType::Insert, payload, sizeof(payload));
+        EXPECT_THROW(wal.sync(), std::system_error);
+        EXPECT_THROW(wal.sync(), std::system_error);
+        EXPECT_EQ(wal.size_bytes(), 2 * synced);
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &saved), 0);
+
+        wal.append(WriteAheadLog::RecordType::Insert, payload, sizeof(payload));
+        wal.sync();
+    }
+    std::signal(SIGXFSZ, SIG_DFL);
+    WriteAheadLog wal(file.path, SyncMode::PerOp);
+    auto records = wal.read_all();
+    ASSERT_EQ(records.size(), 21u);
+    for (std::size_t i = 0; i < records.size(); i++)
+        EXPECT_EQ(records[i].lsn, i + 1);
+}
+
+// 不 flush 直接退出 (析构前 SIGKILL) 后, 已返回的修改都能从日志恢复
+TEST(DiskBTreeWalTest, RecoversAfterKillAtRandomPoints) {
+    std::mt19937 rng(7);
+    // 第二组使用很小的 checkpoint_bytes, 让检查点频繁发生 (包括在检查点中途被杀)
+    for (std::size_t checkpoint_bytes : {std::size_t(64) << 20, std::size_t(16) << 10}) {
+        for (int round = 0; round < 3; round++) {
+            TempTree file("wal_kill.db");
+            auto options = small_options(checkpoint_bytes);
+            auto ops = make_ops(rng(), 4000);
+            std::size_t kill_after = 200 + rng() % 1500;
+            std::size_t acked = run_and_kill(file.path, options, ops, kill_after);
+            ASSERT_GE(acked, kill_after);
+
+            DiskBTree<int> tree(file.path, options);
+            EXPECT_TRUE(tree.check_invariants());
+            std::vector<int> keys;
+            tree.for_each([&](int key) { keys.push_back(key); });
+            // 被杀时最后一个操作可能已写入日志但还没来得及报告
+            bool matches = keys == expected_after(ops, acked) || keys == expected_after(ops, acked + 1);
+            EXPECT_TRUE(matches) << "acked " << acked << " ops, recovered " << keys.size() << " keys";
+
+            // 恢复之后可以继续使用, 再次打开内容不变
+            tree.insert(-1);
+            tree.flush();
+            EXPECT_EQ(tree.size(), keys.size() + 1);
+        }
+    }
+}
+
+// 多个线程同时写入: 每个 insert 返回时已持久化, 重新打开后全部存在
+// (是否共用 fdatasync 取决于线程的调度, 由 WriteAheadLogTest.GroupCommitSharesOneSync 确定地检查)
+TEST(DiskBTreeWalTest, ConcurrentWritersPersist) {
+    TempTree file("wal_group_commit.db");
+    auto options = small_options(std::size_t(64) << 20);
+    options.pool_pages = 256;
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 300;
+    {
+        DiskBTree<int> tree(file.path, options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&tree, t] {
+                for (int i = 0; i < kPerThread; i++)
+                    tree.insert(i * kThreads + t);
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        EXPECT_TRUE(tree.check_invariants());
+    }
+    DiskBTree<int> tree(file.path, options);
+    EXPECT_EQ(tree.size(), static_cast<std::size_t>(kThreads * kPerThread));
+    int expected = 0;
+    tree.for_each([&](int key) { EXPECT_EQ(key, expected++); });
+}
+
+// PerBatch / Async 模式: commit() 或关闭之后修改持久化; 日志中的记录在重新打开时重放
+TEST(DiskBTreeWalTest, BatchAndAsyncModesPersist) {
+    for (SyncMode mode : {SyncMode::PerBatch, SyncMode::Async}) {
+        TempTree file("wal_modes.db");
+        auto options = small_options(std::size_t(64) << 20);
+        options.sync_mode = mode;
+        options.sync_interval = std::chrono::milliseconds(1);
+        {
+            DiskBTree<int> tree(file.path, options);
+            for (int i = 0; i < 2000; i++)
+                tree.insert(i);
+            for (int i = 0; i < 2000; i += 2)
+                EXPECT_TRUE(tree.remove(i));
+            tree.commit();
+        }
+        DiskBTree<int> tree(file.path, options);
+        EXPECT_EQ(tree.size(), 1000u);
+        EXPECT_TRUE(tree.check_invariants());
+        EXPECT_FALSE(tree.contains(10));
+        EXPECT_TRUE(tree.contains(11));
+    }
+}
+
+// 检查点只在脏页占满缓存池 (减去一次操作的预留) 时发生, 不是每个操作一次; 缓存池太小时拒绝打开
+TEST(DiskBTreeWalTest, CheckpointsOnlyWhenPoolFills) {
+    TempTree file("wal_checkpoints.db");
+    auto options = small_options(std::size_t(64) << 20);
+    options.sync_mode = SyncMode::Async;
+    constexpr int kOps = 3000;
+    {
+        DiskBTree<int> tree(file.path, options);
+        uint64_t before = tree.checkpoint_count();
+        std::mt19937 rng(1);
+        for (int i = 0; i < kOps; i++)
+            tree.insert(static_cast<int>(rng() % 100000));
+        // 32 页的缓存池, 树高 6 时预留 17 页, 每次检查点之后可以容纳 15 个脏页; 随机插入几乎每次弄脏一个新叶子
+        // (旧的预留 3*(树高+1)+4 只剩 7 个, 约每 6 个操作一次检查点)
+        EXPECT_LT(tree.checkpoint_count() - before, static_cast<uint64_t>(kOps / 8));
+        EXPECT_TRUE(tree.check_invariants());
+
+        options.pool_pages = 256;
+        TempTree other("wal_checkpoints_large.db");
+        DiskBTree<int> large(other.path, options);
+        before = large.checkpoint_count();
+        for (int i = 0; i < kOps; i++)
+            large.insert(static_cast<int>(rng() % 100000));
+        EXPECT_LT(large.checkpoint_count() - before, 20u);
+    }
+
+    TempTree small("wal_checkpoints_small.db");
+    options.pool_pages = DiskBTree<int>::kMinPoolPages;
+    EXPECT_THROW(DiskBTree<int>(small.path, options), std::invalid_argument);
+    options.wal = false;
+    EXPECT_NO_THROW(DiskBTree<int>(small.path, options));
+
+    // 16 页够一层的树 (预留 7 页 + 8 个脏页), 根叶子满了之后不能再长高
+    TempTree tiny("wal_checkpoints_tiny.db");
+    options.wal = true;
+    options.pool_pages = 16;
+    DiskBTree<int> tree(tiny.path, options);
+    for (int i = 0; i < 2 * tree.get_min_degree() - 1; i++)
+        tree.insert(i);
+    EXPECT_THROW(tree.insert(100), std::runtime_error);
+    EXPECT_EQ(tree.size(), static_cast<std::size_t>(2 * tree.get_min_degree() - 1));
+    EXPECT_TRUE(tree.check_invariants());
+}